@@ -297,6 +297,9 @@ typedef struct OutputFilterOptions {
 
     // Codec used for encoding, may be NULL
     const AVCodec      *enc;
+    // Video encoder to allocate output frames from with enc_get_frame_buffer(),
+    // may be NULL
+    struct Encoder     *encoder;
 
     int64_t             trim_start_us;
     int64_t             trim_duration_us;
@@ -757,6 +760,7 @@ extern int copy_ts;
 extern int start_at_zero;
 extern int copy_tb;
 extern int debug_ts;
+extern int low_latency;
 extern int exit_on_error;
 extern int abort_on_flags;
 extern int print_stats;
@@ -767,6 +771,7 @@ extern float max_error_rate;
 
 extern char *filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern int filter_frame_threads;
 extern int filter_buffered_frames;
 extern int vstats_version;
 extern int print_graphs;
@@ -905,6 +910,13 @@ void enc_free(Encoder **penc);
 
 int enc_open(void *opaque, const AVFrame *frame);
 
+/*
+ * Allocate a video frame in the memory layout of the encoder's input, may be
+ * called from any thread. Returns AVERROR(EAGAIN) when the encoder is not
+ * open or has no preferred layout.
+ */
+int enc_get_frame_buffer(Encoder *enc, AVFrame *frame);
+
 int enc_loopback(Encoder *enc);
 
 /*
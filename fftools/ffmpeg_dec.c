@@ -1545,7 +1545,7 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
                     const DecoderOpts *o, AVFrame *param_out)
 {
     const AVCodec *codec = o->codec;
-    int ret;
+    int threads_manual, ret;
 
     dp->flags      = o->flags;
     dp->log_parent = o->log_parent;
@@ -1592,7 +1592,8 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
     dp->dec_ctx->get_buffer2           = get_buffer;
     dp->dec_ctx->pkt_timebase          = o->time_base;
 
-    if (!av_dict_get(*dec_opts, "threads", NULL, 0))
+    threads_manual = !!av_dict_get(*dec_opts, "threads", NULL, 0);
+    if (!threads_manual)
         av_dict_set(dec_opts, "threads", "auto", 0);
 
     ret = hw_device_setup_for_decode(dp, codec, o->hwaccel_device);
@@ -1613,6 +1614,17 @@ static int dec_open(DecoderPriv *dp, AVDictionary **dec_opts,
     if (ret < 0)
         return ret;
 
+    // share the threads of the thread budget, which only run slice threading;
+    // decoders with their own threading are limited to the budget instead
+    if (!threads_manual && sch_thread_pool(dp->sch)) {
+        AVThreadPool *pool = sch_thread_pool(dp->sch);
+
+        dp->dec_ctx->thread_pool = pool;
+        dp->dec_ctx->thread_type = FF_THREAD_SLICE;
+        if (codec->capabilities & AV_CODEC_CAP_OTHER_THREADS)
+            dp->dec_ctx->thread_count = av_thread_pool_get_nb_threads(pool);
+    }
+
     dp->dec_ctx->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
     if (o->flags & DECODER_FLAG_BITEXACT)
         dp->dec_ctx->flags |= AV_CODEC_FLAG_BITEXACT;
@@ -34,6 +34,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/rational.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -57,6 +58,11 @@ typedef struct EncoderPriv {
 
     Scheduler      *sch;
     unsigned        sch_idx;
+
+    // input frame pool of the currently opened encoder, used by the filtering
+    // thread through enc_get_frame_buffer()
+    pthread_mutex_t      frame_pool_lock;
+    AVEncoderFramePool  *frame_pool;
 } EncoderPriv;
 
 static EncoderPriv *ep_from_enc(Encoder *enc)
@@ -73,15 +79,20 @@ typedef struct EncoderThread {
 void enc_free(Encoder **penc)
 {
     Encoder *enc = *penc;
+    EncoderPriv *ep;
 
     if (!enc)
         return;
+    ep = ep_from_enc(enc);
 
     if (enc->enc_ctx)
         av_freep(&enc->enc_ctx->stats_in);
     avcodec_free_context(&enc->enc_ctx);
     av_dict_free(&enc->encoder_opts);
 
+    avcodec_encoder_frame_pool_free(&ep->frame_pool);
+    pthread_mutex_destroy(&ep->frame_pool_lock);
+
     av_freep(penc);
 }
 
@@ -99,11 +110,35 @@ static const AVClass enc_class = {
     .item_name                 = enc_item_name,
 };
 
+static void enc_set_frame_pool(EncoderPriv *ep, AVEncoderFramePool *pool)
+{
+    pthread_mutex_lock(&ep->frame_pool_lock);
+    avcodec_encoder_frame_pool_free(&ep->frame_pool);
+    ep->frame_pool = pool;
+    pthread_mutex_unlock(&ep->frame_pool_lock);
+}
+
+int enc_get_frame_buffer(Encoder *enc, AVFrame *frame)
+{
+    EncoderPriv *ep = ep_from_enc(enc);
+    int ret = AVERROR(EAGAIN);
+
+    pthread_mutex_lock(&ep->frame_pool_lock);
+    if (ep->frame_pool)
+        ret = avcodec_encoder_frame_pool_get_buffer(ep->frame_pool, frame);
+    pthread_mutex_unlock(&ep->frame_pool_lock);
+
+    return ret;
+}
+
 static int enc_realloc(Encoder *enc, const AVCodec *codec)
 {
     EncoderPriv *ep = ep_from_enc(enc);
     char *stats_in = NULL;
 
+    // the filtering thread must not allocate frames for the old encoder
+    enc_set_frame_pool(ep, NULL);
+
     if (enc->enc_ctx)
         stats_in = enc->enc_ctx->stats_in;
     avcodec_free_context(&enc->enc_ctx);
@@ -134,6 +169,12 @@ int enc_alloc(Encoder **penc, const AVCodec *codec,
     if (!ep)
         return AVERROR(ENOMEM);
 
+    ret = pthread_mutex_init(&ep->frame_pool_lock, NULL);
+    if (ret) {
+        av_free(ep);
+        return AVERROR(ret);
+    }
+
     ep->e.class    = &enc_class;
     ep->log_parent = log_parent;
 
@@ -261,6 +302,17 @@ static int enc_reopen(void *opaque, const AVFrame *frame,
     if (!threads_manual)
         enc_ctx->thread_count = 0;
 
+    // share the threads of the thread budget, which only run slice threading;
+    // encoders with their own threading are limited to the budget instead
+    if (!threads_manual && sch_thread_pool(ep->sch)) {
+        AVThreadPool *pool = sch_thread_pool(ep->sch);
+
+        enc_ctx->thread_pool = pool;
+        enc_ctx->thread_type = FF_THREAD_SLICE;
+        if (enc->capabilities & AV_CODEC_CAP_OTHER_THREADS)
+            enc_ctx->thread_count = av_thread_pool_get_nb_threads(pool);
+    }
+
     // frame is always non-NULL for audio and video
     av_assert0(frame || (enc->type != AVMEDIA_TYPE_VIDEO && enc->type != AVMEDIA_TYPE_AUDIO));
 
@@ -413,6 +465,15 @@ static int enc_reopen(void *opaque, const AVFrame *frame,
 
     ep->opened = 1;
 
+    if (enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+        AVEncoderFramePool *pool;
+
+        ret = avcodec_get_encoder_frame_pool(enc_ctx, &pool);
+        if (ret < 0)
+            return ret;
+        enc_set_frame_pool(ep, pool);
+    }
+
     if (enc_ctx->bit_rate && enc_ctx->bit_rate < 1000 &&
         enc_ctx->codec_id != AV_CODEC_ID_CODEC2 /* don't complain about 700 bit/s modes */)
         av_log(e, AV_LOG_WARNING, "The bitrate parameter is set too low."
@@ -217,6 +217,8 @@ typedef struct OutputFilterPriv {
     AVFrameSideData       **side_data;
     int                     nb_side_data;
 
+    Encoder                *encoder;
+
     // time base in which the output is sent to our downstream
     // does not need to match the filtersink's timebase
     AVRational              tb_out;
@@ -977,6 +979,8 @@ int ofilter_bind_enc(OutputFilter *ofilter, unsigned sched_idx_enc,
 
         fgp->disable_conversions |= !!(ofp->flags & OFILTER_FLAG_DISABLE_CONVERT);
 
+        ofp->encoder = opts->encoder;
+
         ofp->fps.last_frame = av_frame_alloc();
         if (!ofp->fps.last_frame)
             return AVERROR(ENOMEM);
@@ -1072,7 +1076,7 @@ static int ifilter_bind_fg(InputFilterPriv *ifp, FilterGraph *fg_src, int out_id
     if (ret < 0)
         return ret;
 
-    ret = sch_connect(fgp->sch, SCH_FILTER_OUT(fg_src->index, out_idx),
+    ret = sch_connect(fgp->sch, SCH_FILTER_OUT(fgp_from_fg(fg_src)->sch_idx, out_idx),
                                 SCH_FILTER_IN(fgp->sch_idx, ifp->ifilter.index));
     if (ret < 0)
         return ret;
@@ -1710,6 +1714,11 @@ static int insert_filter(AVFilterContext **last_filter, int *pad_idx,
     return 0;
 }
 
+static int enc_get_buffer(void *opaque, AVFrame *frame)
+{
+    return enc_get_frame_buffer(opaque, frame);
+}
+
 static int configure_output_video_filter(FilterGraphPriv *fgp, AVFilterGraph *graph,
                                          OutputFilter *ofilter, AVFilterInOut *out)
 {
@@ -1728,6 +1737,10 @@ static int configure_output_video_filter(FilterGraphPriv *fgp, AVFilterGraph *gr
     if (ret < 0)
         return ret;
 
+    if (ofp->encoder)
+        av_buffersink_set_get_video_buffer(ofilter->filter, enc_get_buffer,
+                                           ofp->encoder);
+
     if (ofp->flags & OFILTER_FLAG_CROP) {
         char crop_buf[64];
         snprintf(crop_buf, sizeof(crop_buf), "w=iw-%u-%u:h=ih-%u-%u:x=%u:y=%u",
@@ -2181,6 +2194,8 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             ret = av_opt_set_int(fgt->graph, "threads", fgp->nb_threads, 0);
             if (ret < 0)
                 return ret;
+        } else {
+            fgt->graph->thread_pool = sch_thread_pool(fgp->sch);
         }
 
         if (av_dict_count(ofp->sws_opts)) {
@@ -2201,6 +2216,8 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
         }
     } else {
         fgt->graph->nb_threads = filter_complex_nbthreads;
+        if (!filter_complex_nbthreads)
+            fgt->graph->thread_pool = sch_thread_pool(fgp->sch);
     }
 
     if (filter_buffered_frames) {
@@ -2209,6 +2226,12 @@ static int configure_filtergraph(FilterGraph *fg, FilterGraphThread *fgt)
             return ret;
     }
 
+    if (filter_frame_threads) {
+        ret = av_opt_set_int(fgt->graph, "frame_threads", filter_frame_threads, 0);
+        if (ret < 0)
+            return ret;
+    }
+
     hw_device = hw_device_for_filter();
 
     ret = graph_parse(fg, fgt->graph, graph_desc, &inputs, &outputs, hw_device);
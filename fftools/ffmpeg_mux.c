@@ -61,19 +61,20 @@ static int64_t filesize(AVIOContext *pb)
     return ret;
 }
 
+static const char *const latency_desc[] = {
+    [LATENCY_PROBE_DEMUX]       = "demux",
+    [LATENCY_PROBE_DEC_PRE]     = "decode",
+    [LATENCY_PROBE_DEC_POST]    = "decode",
+    [LATENCY_PROBE_FILTER_PRE]  = "filter",
+    [LATENCY_PROBE_FILTER_POST] = "filter",
+    [LATENCY_PROBE_ENC_PRE]     = "encode",
+    [LATENCY_PROBE_ENC_POST]    = "encode",
+    [LATENCY_PROBE_NB]          = "mux",
+};
+
 static void mux_log_debug_ts(OutputStream *ost, const AVPacket *pkt)
 {
-    static const char *desc[] = {
-        [LATENCY_PROBE_DEMUX]       = "demux",
-        [LATENCY_PROBE_DEC_PRE]     = "decode",
-        [LATENCY_PROBE_DEC_POST]    = "decode",
-        [LATENCY_PROBE_FILTER_PRE]  = "filter",
-        [LATENCY_PROBE_FILTER_POST] = "filter",
-        [LATENCY_PROBE_ENC_PRE]     = "encode",
-        [LATENCY_PROBE_ENC_POST]    = "encode",
-        [LATENCY_PROBE_NB]          = "mux",
-    };
-
+    const char *const *desc = latency_desc;
     char latency[512];
 
     *latency = 0;
@@ -135,6 +136,36 @@ static void mux_log_debug_ts(OutputStream *ost, const AVPacket *pkt)
            pkt->size, *latency ? latency : "N/A");
 }
 
+/* accumulate the time between consecutive latency probes of a packet */
+static void mux_update_latency(MuxStream *ms, const AVPacket *pkt)
+{
+    const FrameData *fd;
+    int64_t now;
+    int prev = -1;
+
+    if (!pkt->opaque_ref)
+        return;
+
+    fd  = (const FrameData*)pkt->opaque_ref->data;
+    now = av_gettime_relative();
+
+    for (int i = 0; i <= LATENCY_PROBE_NB; i++) {
+        int64_t val = i < LATENCY_PROBE_NB ? fd->wallclock[i] : now;
+        int64_t diff;
+
+        if (val == INT64_MIN)
+            continue;
+
+        if (prev >= 0) {
+            diff = val - fd->wallclock[prev];
+            ms->latency_sum[prev] += diff;
+            ms->latency_max[prev]  = FFMAX(ms->latency_max[prev], diff);
+            ms->latency_nb[prev]++;
+        }
+        prev = i;
+    }
+}
+
 static int mux_fixup_ts(Muxer *mux, MuxStream *ms, AVPacket *pkt)
 {
     OutputStream *ost = &ms->ost;
@@ -197,6 +228,8 @@ static int mux_fixup_ts(Muxer *mux, MuxStream *ms, AVPacket *pkt)
 
     if (debug_ts)
         mux_log_debug_ts(ost, pkt);
+    if (low_latency)
+        mux_update_latency(ms, pkt);
 
     return 0;
 }
@@ -416,9 +449,10 @@ int muxer_thread(void *arg)
 
     while (1) {
         OutputStream *ost;
-        int stream_idx, stream_eof = 0;
+        int stream_idx, stream_eof = 0, in_eof;
 
         ret = sch_mux_receive(mux->sch, of->index, mt.pkt);
+        in_eof     = ret < 0;
         stream_idx = mt.pkt->stream_index;
         if (stream_idx < 0) {
             av_log(mux, AV_LOG_VERBOSE, "All streams finished\n");
@@ -430,8 +464,17 @@ int muxer_thread(void *arg)
         mt.pkt->stream_index = ost->index;
         mt.pkt->flags       &= ~AV_PKT_FLAG_TRUSTED;
 
-        ret = mux_packet_filter(mux, &mt, ost, ret < 0 ? NULL : mt.pkt, &stream_eof);
+        ret = mux_packet_filter(mux, &mt, ost, in_eof ? NULL : mt.pkt, &stream_eof);
         av_packet_unref(mt.pkt);
+        if (mux->shortest_eof && (stream_eof || in_eof) &&
+            (ret >= 0 || ret == AVERROR_EOF)) {
+            av_log(mux, AV_LOG_VERBOSE,
+                   "Stream #%d finished, ending the output (-shortest)\n",
+                   ost->index);
+            ret = 0;
+            break;
+        }
+
         if (ret == AVERROR_EOF) {
             if (stream_eof) {
                 sch_mux_receive_finish(mux->sch, of->index, stream_idx);
@@ -683,6 +726,37 @@ static int check_written(OutputFile *of)
     return ret;
 }
 
+static void mux_latency_stats(OutputFile *of, const MuxStream *ms)
+{
+    char buf[512];
+
+    *buf = 0;
+    for (int i = 0; i < LATENCY_PROBE_NB; i++) {
+        int next;
+
+        if (!ms->latency_nb[i])
+            continue;
+
+        // find the stage that follows this one
+        for (next = i + 1; next < LATENCY_PROBE_NB && !ms->latency_nb[next]; next++)
+            ;
+
+        av_strlcat(buf, *buf ? ", " : "", sizeof(buf));
+        if (!strcmp(latency_desc[i], latency_desc[next]))
+            av_strlcat(buf, latency_desc[i], sizeof(buf));
+        else
+            av_strlcatf(buf, sizeof(buf), "%s-%s", latency_desc[i],
+                        latency_desc[next]);
+        av_strlcatf(buf, sizeof(buf), ": %.1f/%.1fms",
+                    ms->latency_sum[i] / 1e3 / ms->latency_nb[i],
+                    ms->latency_max[i] / 1e3);
+    }
+
+    if (*buf)
+        av_log(of, AV_LOG_INFO, "  Output stream #%d:%d latency (avg/max): %s\n",
+               of->index, ms->ost.index, buf);
+}
+
 static void mux_final_stats(Muxer *mux)
 {
     OutputFile *of = &mux->of;
@@ -728,6 +802,9 @@ static void mux_final_stats(Muxer *mux)
                atomic_load(&ost->packets_written), s);
 
         av_log(of, AV_LOG_VERBOSE, "\n");
+
+        if (low_latency)
+            mux_latency_stats(of, ms);
     }
 
     av_log(of, AV_LOG_VERBOSE, "  Total: %"PRIu64" packets (%"PRIu64" bytes) muxed\n",
@@ -78,6 +78,12 @@ typedef struct MuxStream {
     // combined size of all the packets sent to the muxer
     uint64_t        data_size_mux;
 
+    /* time spent between each latency probe and the next one, in
+     * microseconds, accumulated with -low_latency */
+    int64_t         latency_sum[LATENCY_PROBE_NB];
+    int64_t         latency_max[LATENCY_PROBE_NB];
+    uint64_t        latency_nb[LATENCY_PROBE_NB];
+
     int             copy_initial_nonkeyframes;
     int             copy_prior_start;
     int             streamcopy_started;
@@ -116,6 +122,10 @@ typedef struct Muxer {
 
     SyncQueue              *sq_mux;
     AVPacket               *sq_pkt;
+
+    /* -shortest without sync queues (-low_latency): the output ends as soon
+     * as any of its streams ends */
+    int                     shortest_eof;
 } Muxer;
 
 int mux_check_init(void *arg);
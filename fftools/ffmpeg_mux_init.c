@@ -906,6 +906,8 @@ ost_bind_filter(const Muxer *mux, MuxStream *ms, OutputFilter *ofilter,
     snprintf(name, sizeof(name), "#%d:%d", mux->of.index, ost->index);
 
     if (ost->type == AVMEDIA_TYPE_VIDEO) {
+        opts.encoder = ost->enc;
+
         if (!keep_pix_fmt) {
             ret = avcodec_get_supported_config(enc_ctx, NULL,
                                                AV_CODEC_CONFIG_PIX_FORMAT, 0,
@@ -2089,6 +2091,14 @@ static int setup_sync_queues(Muxer *mux, AVFormatContext *oc,
           nb_audio_fs))
         return 0;
 
+    /* with -low_latency, -shortest alone is handled without sync queues:
+     * the muxer ends the whole output when the first of its streams ends,
+     * instead of holding frames back until the other streams catch up */
+    if (low_latency && !limit_frames && !nb_audio_fs) {
+        mux->shortest_eof = 1;
+        return 0;
+    }
+
     /* we use a sync queue before encoding when:
      * - 'shortest' is in effect and we have two or more encoded audio/video
      *   streams
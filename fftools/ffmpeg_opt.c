@@ -65,6 +65,7 @@ int copy_ts           = 0;
 int start_at_zero     = 0;
 int copy_tb           = -1;
 int debug_ts          = 0;
+int low_latency       = 0;
 int exit_on_error     = 0;
 int abort_on_flags    = 0;
 int print_stats       = -1;
@@ -72,6 +73,7 @@ int stdin_interaction = 1;
 float max_error_rate  = 2.0/3;
 char *filter_nbthreads;
 int filter_complex_nbthreads = 0;
+int filter_frame_threads = 0;
 int filter_buffered_frames = 0;
 int vstats_version = 2;
 int print_graphs = 0;
@@ -137,7 +139,7 @@ static void init_options(OptionsContext *o)
     memset(o, 0, sizeof(*o));
 
     o->stop_time = INT64_MAX;
-    o->mux_max_delay  = 0.7;
+    o->mux_max_delay  = low_latency ? 0.0 : 0.7;
     o->start_time     = AV_NOPTS_VALUE;
     o->start_time_eof = AV_NOPTS_VALUE;
     o->recording_time = INT64_MAX;
@@ -147,7 +149,7 @@ static void init_options(OptionsContext *o)
     o->thread_queue_size = 0;
     o->input_sync_ref = -1;
     o->find_stream_info = 1;
-    o->shortest_buf_duration = 10.f;
+    o->shortest_buf_duration = low_latency ? 0.f : 10.f;
 }
 
 static int show_hwaccels(void *optctx, const char *opt, const char *arg)
@@ -696,6 +698,19 @@ static int opt_sdp_file(void *optctx, const char *opt, const char *arg)
     return sch_sdp_filename(go->sch, arg);
 }
 
+static int opt_threads_budget(void *optctx, const char *opt, const char *arg)
+{
+    GlobalOptionsContext *go = optctx;
+    double nb_threads;
+    int ret;
+
+    ret = parse_number(opt, arg, OPT_TYPE_INT, 0, INT_MAX, &nb_threads);
+    if (ret < 0)
+        return ret;
+
+    return sch_threads_budget(go->sch, nb_threads);
+}
+
 #if CONFIG_VAAPI
 static int opt_vaapi_device(void *optctx, const char *opt, const char *arg)
 {
@@ -1445,6 +1460,8 @@ int ffmpeg_parse_options(int argc, char **argv, Scheduler *sch)
         goto fail;
     }
 
+    sch_low_latency(sch, low_latency);
+
     /* configure terminal and setup signal handlers */
     term_init();
 
@@ -1746,6 +1763,9 @@ const OptionDef options[] = {
     { "filter_threads",         OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
         { .func_arg = opt_filter_threads },
         "number of non-complex filter threads" },
+    { "filter_frame_threads",   OPT_TYPE_INT, OPT_EXPERT,
+        { &filter_frame_threads },
+        "number of threads filtering frames concurrently in each filter graph", "nb_threads" },
     { "filter_buffered_frames", OPT_TYPE_INT, OPT_EXPERT,
         { &filter_buffered_frames },
         "maximum number of buffered frames in a filter graph" },
@@ -1761,6 +1781,9 @@ const OptionDef options[] = {
     { "filter_complex_threads", OPT_TYPE_INT, OPT_EXPERT,
         { &filter_complex_nbthreads },
         "number of threads for -filter_complex" },
+    { "threads_budget",         OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
+        { .func_arg = opt_threads_budget },
+        "total number of codec and filter threads shared by all components", "nb_threads" },
     { "lavfi",               OPT_TYPE_FUNC, OPT_FUNC_ARG | OPT_EXPERT,
         { .func_arg = opt_filter_complex },
         "create a complex filtergraph", "graph_description" },
@@ -1793,6 +1816,9 @@ const OptionDef options[] = {
     { "debug_ts",            OPT_TYPE_BOOL, OPT_EXPERT,
         { &debug_ts },
         "print timestamp debugging info" },
+    { "low_latency",         OPT_TYPE_BOOL, OPT_EXPERT,
+        { &low_latency },
+        "minimize buffering between processing stages and report per-stage latency" },
     { "max_error_rate",      OPT_TYPE_FLOAT, OPT_EXPERT,
         { &max_error_rate },
         "ratio of decoding errors (0.0: no errors, 1.0: 100% errors) above which ffmpeg returns an error instead of success.", "maximum error rate" },
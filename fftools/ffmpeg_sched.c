@@ -303,6 +303,13 @@ struct Scheduler {
     char               *sdp_filename;
     int                 sdp_auto;
 
+    // shared by all codecs and filtergraphs with automatic threading,
+    // NULL when no thread budget was set
+    AVThreadPool       *thread_pool;
+
+    // bound all queues to LOW_LATENCY_THREAD_QUEUE_SIZE by default
+    int                 low_latency;
+
     enum SchedulerState state;
     atomic_int          terminate;
 
@@ -369,13 +376,16 @@ static void waiter_uninit(SchWaiter *w)
     pthread_cond_destroy(&w->cond);
 }
 
-static int queue_alloc(ThreadQueue **ptq, unsigned nb_streams, unsigned queue_size,
+static int queue_alloc(const Scheduler *sch, ThreadQueue **ptq,
+                       unsigned nb_streams, unsigned queue_size,
                        enum QueueType type)
 {
     ThreadQueue *tq;
 
     if (queue_size <= 0) {
-        if (type == QUEUE_FRAMES)
+        if (sch->low_latency)
+            queue_size = LOW_LATENCY_THREAD_QUEUE_SIZE;
+        else if (type == QUEUE_FRAMES)
             queue_size = DEFAULT_FRAME_THREAD_QUEUE_SIZE;
         else
             queue_size = DEFAULT_PACKET_THREAD_QUEUE_SIZE;
@@ -597,6 +607,8 @@ void sch_free(Scheduler **psch)
 
     av_freep(&sch->sdp_filename);
 
+    av_thread_pool_free(&sch->thread_pool);
+
     pthread_mutex_destroy(&sch->schedule_lock);
 
     pthread_mutex_destroy(&sch->mux_ready_lock);
@@ -653,6 +665,30 @@ int sch_sdp_filename(Scheduler *sch, const char *sdp_filename)
     return sch->sdp_filename ? 0 : AVERROR(ENOMEM);
 }
 
+int sch_threads_budget(Scheduler *sch, int nb_threads)
+{
+    av_assert0(sch->state == SCH_STATE_UNINIT);
+
+    if (nb_threads < 0)
+        return AVERROR(EINVAL);
+
+    av_thread_pool_free(&sch->thread_pool);
+    if (!nb_threads)
+        return 0;
+
+    return av_thread_pool_alloc(&sch->thread_pool, nb_threads);
+}
+
+AVThreadPool *sch_thread_pool(Scheduler *sch)
+{
+    return sch->thread_pool;
+}
+
+void sch_low_latency(Scheduler *sch, int enable)
+{
+    sch->low_latency = !!enable;
+}
+
 static const AVClass sch_mux_class = {
     .class_name                = "SchMux",
     .version                   = LIBAVUTIL_VERSION_INT,
@@ -799,7 +835,7 @@ int sch_add_dec(Scheduler *sch, SchThreadFunc func, void *ctx, int send_end_ts)
     if (ret < 0)
         return ret;
 
-    ret = queue_alloc(&dec->queue, 1, 0, QUEUE_PACKETS);
+    ret = queue_alloc(sch, &dec->queue, 1, 0, QUEUE_PACKETS);
     if (ret < 0)
         return ret;
 
@@ -843,7 +879,7 @@ int sch_add_enc(Scheduler *sch, SchThreadFunc func, void *ctx,
     if (!enc->send_pkt)
         return AVERROR(ENOMEM);
 
-    ret = queue_alloc(&enc->queue, 1, 0, QUEUE_FRAMES);
+    ret = queue_alloc(sch, &enc->queue, 1, 0, QUEUE_FRAMES);
     if (ret < 0)
         return ret;
 
@@ -891,7 +927,7 @@ int sch_add_filtergraph(Scheduler *sch, unsigned nb_inputs, unsigned nb_outputs,
     if (ret < 0)
         return ret;
 
-    ret = queue_alloc(&fg->queue, fg->nb_inputs + 1, 0, QUEUE_FRAMES);
+    ret = queue_alloc(sch, &fg->queue, fg->nb_inputs + 1, 0, QUEUE_FRAMES);
     if (ret < 0)
         return ret;
 
@@ -1700,8 +1736,8 @@ static int start_prepare(Scheduler *sch)
             }
         }
 
-        ret = queue_alloc(&mux->queue, mux->nb_streams, mux->queue_size,
-                          QUEUE_PACKETS);
+        ret = queue_alloc(sch, &mux->queue, mux->nb_streams,
+                          mux->queue_size, QUEUE_PACKETS);
         if (ret < 0)
             return ret;
     }
@@ -1747,6 +1783,7 @@ int sch_start(Scheduler *sch)
         return ret;
 
     av_assert0(sch->state == SCH_STATE_UNINIT);
+
     sch->state = SCH_STATE_STARTED;
 
     for (unsigned i = 0; i < sch->nb_mux; i++) {
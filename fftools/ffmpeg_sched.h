@@ -27,6 +27,9 @@
 
 #include "ffmpeg_utils.h"
 
+#include "libavutil/avutil.h"
+#include "libavutil/threadpool.h"
+
 /*
  * This file contains the API for the transcode scheduler.
  *
@@ -136,6 +139,33 @@ void sch_free(Scheduler **sch);
 int sch_start(Scheduler *sch);
 int sch_stop(Scheduler *sch, int64_t *finish_ts);
 
+/**
+ * Set the total number of worker threads that may be used by all decoders,
+ * encoders and filtergraphs with automatic threading, combined. A thread pool
+ * with this many threads is created immediately, so this must be called
+ * before any components are opened. By default (0), every such component
+ * creates its own threads.
+ */
+int sch_threads_budget(Scheduler *sch, int nb_threads);
+
+/**
+ * Get the thread pool created by sch_threads_budget(), to be attached to
+ * decoders, encoders and filtergraphs whose thread count was not set
+ * explicitly.
+ *
+ * @return the pool, or NULL if no thread budget was set
+ */
+AVThreadPool *sch_thread_pool(Scheduler *sch);
+
+/**
+ * Enable or disable low-latency mode. In this mode all thread queues whose
+ * size was not set explicitly hold at most LOW_LATENCY_THREAD_QUEUE_SIZE
+ * entries, so that no component can run far ahead of the next one.
+ *
+ * Must be called before any components are added.
+ */
+void sch_low_latency(Scheduler *sch, int enable);
+
 /**
  * Wait until transcoding terminates or the specified timeout elapses.
  *
@@ -261,6 +291,12 @@ int sch_add_mux(Scheduler *sch, SchThreadFunc func, int (*init)(void *),
  */
 #define DEFAULT_FRAME_THREAD_QUEUE_SIZE 2
 
+/**
+ * Size of all packet and frame thread queues in low-latency mode, unless
+ * overridden.
+ */
+#define LOW_LATENCY_THREAD_QUEUE_SIZE 2
+
 /**
  * Add a muxed stream for a previously added muxer.
  *
@@ -16,15 +16,14 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
 
 #include "libavutil/avassert.h"
-#include "libavutil/container_fifo.h"
+#include "libavutil/common.h"
 #include "libavutil/error.h"
-#include "libavutil/fifo.h"
 #include "libavutil/frame.h"
-#include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
 
@@ -37,18 +36,43 @@ enum {
     FINISHED_RECV = (1 << 1),
 };
 
+/*
+ * The queue is a bounded multi-producer/single-consumer ring buffer, where
+ * each slot carries a sequence number that tells whether it is free for the
+ * producer claiming position pos (seq == pos) or holds an item for the
+ * consumer reading position pos (seq == pos + 1).
+ *
+ * Producers claim positions by advancing tail, the (only) consumer advances
+ * head. The mutex and condition variables are only touched by a thread that
+ * has to wait for the queue to become non-empty/non-full, and by the thread
+ * waking it up.
+ */
+typedef struct ThreadQueueSlot {
+    atomic_size_t   seq;
+    unsigned int    stream_idx;
+    void           *item;
+} ThreadQueueSlot;
+
 struct ThreadQueue {
-    int             choked;
-    int              *finished;
+    ThreadQueueSlot *slots;
+    size_t          mask;
+    size_t          queue_size;
+
+    atomic_size_t   tail;
+    atomic_size_t   head;
+
+    atomic_int      choked;
+    atomic_int     *finished;
     unsigned int    nb_streams;
 
     enum ThreadQueueType type;
 
-    AVContainerFifo *fifo;
-    AVFifo          *fifo_stream_index;
+    atomic_int      nb_send_waiting;
+    atomic_int      nb_recv_waiting;
 
     pthread_mutex_t lock;
-    pthread_cond_t  cond;
+    pthread_cond_t  cond_send;
+    pthread_cond_t  cond_recv;
 };
 
 void tq_free(ThreadQueue **ptq)
@@ -58,12 +82,21 @@ void tq_free(ThreadQueue **ptq)
     if (!tq)
         return;
 
-    av_container_fifo_free(&tq->fifo);
-    av_fifo_freep2(&tq->fifo_stream_index);
+    for (size_t i = 0; tq->slots && i <= tq->mask; i++) {
+        if (tq->type == THREAD_QUEUE_FRAMES) {
+            AVFrame *frame = tq->slots[i].item;
+            av_frame_free(&frame);
+        } else {
+            AVPacket *pkt = tq->slots[i].item;
+            av_packet_free(&pkt);
+        }
+    }
+    av_freep(&tq->slots);
 
     av_freep(&tq->finished);
 
-    pthread_cond_destroy(&tq->cond);
+    pthread_cond_destroy(&tq->cond_recv);
+    pthread_cond_destroy(&tq->cond_send);
     pthread_mutex_destroy(&tq->lock);
 
     av_freep(ptq);
@@ -73,40 +106,69 @@ ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
                       enum ThreadQueueType type)
 {
     ThreadQueue *tq;
+    size_t nb_slots = 1;
     int ret;
 
+    if (!queue_size || queue_size > SIZE_MAX / 4)
+        return NULL;
+    while (nb_slots < queue_size)
+        nb_slots <<= 1;
+
     tq = av_mallocz(sizeof(*tq));
     if (!tq)
         return NULL;
 
-    ret = pthread_cond_init(&tq->cond, NULL);
+    ret = pthread_cond_init(&tq->cond_send, NULL);
+    if (ret) {
+        av_freep(&tq);
+        return NULL;
+    }
+
+    ret = pthread_cond_init(&tq->cond_recv, NULL);
     if (ret) {
+        pthread_cond_destroy(&tq->cond_send);
         av_freep(&tq);
         return NULL;
     }
 
     ret = pthread_mutex_init(&tq->lock, NULL);
     if (ret) {
-        pthread_cond_destroy(&tq->cond);
+        pthread_cond_destroy(&tq->cond_recv);
+        pthread_cond_destroy(&tq->cond_send);
         av_freep(&tq);
         return NULL;
     }
 
+    tq->type = type;
+
     tq->finished = av_calloc(nb_streams, sizeof(*tq->finished));
     if (!tq->finished)
         goto fail;
+    for (unsigned int i = 0; i < nb_streams; i++)
+        atomic_init(&tq->finished[i], 0);
     tq->nb_streams = nb_streams;
 
-    tq->type = type;
-
-    tq->fifo = (type == THREAD_QUEUE_FRAMES) ?
-               av_container_fifo_alloc_avframe(0) : av_container_fifo_alloc_avpacket(0);
-    if (!tq->fifo)
+    tq->slots = av_calloc(nb_slots, sizeof(*tq->slots));
+    if (!tq->slots)
         goto fail;
+    tq->mask       = nb_slots - 1;
+    tq->queue_size = queue_size;
 
-    tq->fifo_stream_index = av_fifo_alloc2(queue_size, sizeof(unsigned), 0);
-    if (!tq->fifo_stream_index)
-        goto fail;
+    for (size_t i = 0; i < nb_slots; i++) {
+        ThreadQueueSlot *slot = &tq->slots[i];
+
+        atomic_init(&slot->seq, i);
+        slot->item = (type == THREAD_QUEUE_FRAMES) ? (void*)av_frame_alloc() :
+                                                     (void*)av_packet_alloc();
+        if (!slot->item)
+            goto fail;
+    }
+
+    atomic_init(&tq->tail, 0);
+    atomic_init(&tq->head, 0);
+    atomic_init(&tq->choked, 0);
+    atomic_init(&tq->nb_send_waiting, 0);
+    atomic_init(&tq->nb_recv_waiting, 0);
 
     return tq;
 fail:
@@ -114,77 +176,204 @@ fail:
     return NULL;
 }
 
-int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
+static void item_move(const ThreadQueue *tq, void *dst, void *src)
 {
-    int *finished;
-    int ret;
+    if (tq->type == THREAD_QUEUE_FRAMES)
+        av_frame_move_ref(dst, src);
+    else
+        av_packet_move_ref(dst, src);
+}
 
-    av_assert0(stream_idx < tq->nb_streams);
-    finished = &tq->finished[stream_idx];
+static void item_unref(const ThreadQueue *tq, void *item)
+{
+    if (tq->type == THREAD_QUEUE_FRAMES)
+        av_frame_unref(item);
+    else
+        av_packet_unref(item);
+}
+
+/**
+ * Wake up threads waiting on cond, if there are any. Must be called after
+ * the state change they wait for has been published.
+ *
+ * @param all wake up all waiting threads rather than just one of them
+ */
+static void wake(ThreadQueue *tq, atomic_int *nb_waiting, pthread_cond_t *cond,
+                 int all)
+{
+    // pairs with the fence in wait_begin()
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!atomic_load_explicit(nb_waiting, memory_order_relaxed))
+        return;
 
     pthread_mutex_lock(&tq->lock);
+    if (all)
+        pthread_cond_broadcast(cond);
+    else
+        pthread_cond_signal(cond);
+    pthread_mutex_unlock(&tq->lock);
+}
+
+/**
+ * Register as a waiter. The caller must hold the lock and re-check the
+ * condition it is waiting for before calling pthread_cond_wait().
+ */
+static void wait_begin(atomic_int *nb_waiting)
+{
+    atomic_fetch_add_explicit(nb_waiting, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+static void wait_end(atomic_int *nb_waiting)
+{
+    atomic_fetch_sub_explicit(nb_waiting, 1, memory_order_relaxed);
+}
+
+static int ring_write(ThreadQueue *tq, unsigned int stream_idx, void *data)
+{
+    size_t pos = atomic_load_explicit(&tq->tail, memory_order_relaxed);
+    ThreadQueueSlot *slot;
 
-    if (*finished & FINISHED_SEND) {
-        ret = AVERROR(EINVAL);
-        goto finish;
+    while (1) {
+        size_t head = atomic_load_explicit(&tq->head, memory_order_acquire);
+        size_t seq;
+
+        if (pos - head >= tq->queue_size)
+            return 0;
+
+        slot = &tq->slots[pos & tq->mask];
+        seq  = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+        if (seq == pos) {
+            if (atomic_compare_exchange_weak_explicit(&tq->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if ((ptrdiff_t)(seq - pos) < 0) {
+            // slot not yet released by the consumer
+            return 0;
+        } else
+            pos = atomic_load_explicit(&tq->tail, memory_order_relaxed);
     }
 
-    while (!(*finished & FINISHED_RECV) && !av_fifo_can_write(tq->fifo_stream_index))
-        pthread_cond_wait(&tq->cond, &tq->lock);
+    item_move(tq, slot->item, data);
+    slot->stream_idx = stream_idx;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
 
-    if (*finished & FINISHED_RECV) {
-        ret = AVERROR_EOF;
-        *finished |= FINISHED_SEND;
-    } else {
-        ret = av_fifo_write(tq->fifo_stream_index, &stream_idx, 1);
-        if (ret < 0)
-            goto finish;
+    return 1;
+}
 
-        ret = av_container_fifo_write(tq->fifo, data, 0);
-        if (ret < 0)
-            goto finish;
+static int ring_full(ThreadQueue *tq)
+{
+    return atomic_load_explicit(&tq->tail, memory_order_relaxed) -
+           atomic_load_explicit(&tq->head, memory_order_relaxed) >= tq->queue_size;
+}
+
+/**
+ * @return 1 if an item was read, 0 if the ring is empty, AVERROR(EAGAIN) if
+ *         the next item has been claimed by a producer but not written yet
+ */
+static int ring_read(ThreadQueue *tq, unsigned int *stream_idx, void *data)
+{
+    size_t pos = atomic_load_explicit(&tq->head, memory_order_relaxed);
+    ThreadQueueSlot *slot = &tq->slots[pos & tq->mask];
 
-        pthread_cond_broadcast(&tq->cond);
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) {
+        return atomic_load_explicit(&tq->tail, memory_order_acquire) == pos ?
+               0 : AVERROR(EAGAIN);
     }
 
-finish:
-    pthread_mutex_unlock(&tq->lock);
+    item_move(tq, data, slot->item);
+    *stream_idx = slot->stream_idx;
 
-    return ret;
+    atomic_store_explicit(&slot->seq, pos + tq->mask + 1, memory_order_release);
+    atomic_store_explicit(&tq->head, pos + 1, memory_order_release);
+
+    return 1;
 }
 
-static int receive_locked(ThreadQueue *tq, int *stream_idx,
-                          void *data)
+int tq_send(ThreadQueue *tq, unsigned int stream_idx, void *data)
+{
+    atomic_int *finished;
+
+    av_assert0(stream_idx < tq->nb_streams);
+    finished = &tq->finished[stream_idx];
+
+    if (atomic_load(finished) & FINISHED_SEND)
+        return AVERROR(EINVAL);
+
+    while (1) {
+        if (atomic_load(finished) & FINISHED_RECV) {
+            atomic_fetch_or(finished, FINISHED_SEND);
+            return AVERROR_EOF;
+        }
+
+        if (ring_write(tq, stream_idx, data))
+            break;
+
+        pthread_mutex_lock(&tq->lock);
+        wait_begin(&tq->nb_send_waiting);
+        if (!(atomic_load(finished) & FINISHED_RECV) && ring_full(tq))
+            pthread_cond_wait(&tq->cond_send, &tq->lock);
+        wait_end(&tq->nb_send_waiting);
+        pthread_mutex_unlock(&tq->lock);
+    }
+
+    wake(tq, &tq->nb_recv_waiting, &tq->cond_recv, 0);
+
+    return 0;
+}
+
+/**
+ * Same as tq_receive() without blocking. Sets *released when producers
+ * waiting for the queue to drain need to be woken up.
+ */
+static int receive_nonblock(ThreadQueue *tq, int *stream_idx, void *data,
+                            int *released)
 {
     unsigned int nb_finished = 0;
+    int ret;
 
-    if (tq->choked)
+    if (atomic_load(&tq->choked))
         return AVERROR(EAGAIN);
 
-    while (av_container_fifo_read(tq->fifo, data, 0) >= 0) {
+retry:
+    while (1) {
         unsigned idx;
-        int ret;
 
-        ret = av_fifo_read(tq->fifo_stream_index, &idx, 1);
-        av_assert0(ret >= 0);
-        if (tq->finished[idx] & FINISHED_RECV) {
-            (tq->type == THREAD_QUEUE_FRAMES) ?
-            av_frame_unref(data) : av_packet_unref(data);
+        ret = ring_read(tq, &idx, data);
+        if (ret <= 0)
+            break;
+
+        *released = 1;
+
+        if (atomic_load(&tq->finished[idx]) & FINISHED_RECV) {
+            item_unref(tq, data);
             continue;
         }
 
         *stream_idx = idx;
         return 0;
     }
+    if (ret < 0)
+        return ret;
 
     for (unsigned int i = 0; i < tq->nb_streams; i++) {
-        if (!tq->finished[i])
+        int finished = atomic_load(&tq->finished[i]);
+
+        if (!finished)
             continue;
 
         /* return EOF to the consumer at most once for each stream */
-        if (!(tq->finished[i] & FINISHED_RECV)) {
-            tq->finished[i] |= FINISHED_RECV;
-            *stream_idx   = i;
+        if (!(finished & FINISHED_RECV)) {
+            /* the producer may have sent more items before finishing the
+             * stream, those must be returned before EOF */
+            if (atomic_load(&tq->tail) != atomic_load_explicit(&tq->head, memory_order_relaxed))
+                goto retry;
+
+            atomic_fetch_or(&tq->finished[i], FINISHED_RECV);
+            *released = 1;
+            *stream_idx = i;
             return AVERROR_EOF;
         }
 
@@ -196,30 +385,35 @@ static int receive_locked(ThreadQueue *tq, int *stream_idx,
 
 int tq_receive(ThreadQueue *tq, int *stream_idx, void *data, int flags)
 {
+    int released = 0;
     int ret;
 
     *stream_idx = -1;
 
-    pthread_mutex_lock(&tq->lock);
-
     while (1) {
-        size_t can_read = av_container_fifo_can_read(tq->fifo);
-
-        ret = receive_locked(tq, stream_idx, data);
-
-        // signal other threads if the fifo state changed
-        if (can_read != av_container_fifo_can_read(tq->fifo))
-            pthread_cond_broadcast(&tq->cond);
-
-        if (ret == AVERROR(EAGAIN) && !(flags & THREAD_QUEUE_FLAG_NO_BLOCK)) {
-            pthread_cond_wait(&tq->cond, &tq->lock);
-            continue;
+        ret = receive_nonblock(tq, stream_idx, data, &released);
+        if (ret != AVERROR(EAGAIN) || (flags & THREAD_QUEUE_FLAG_NO_BLOCK))
+            break;
+
+        pthread_mutex_lock(&tq->lock);
+        wait_begin(&tq->nb_recv_waiting);
+        ret = receive_nonblock(tq, stream_idx, data, &released);
+        if (ret == AVERROR(EAGAIN) && !released)
+            pthread_cond_wait(&tq->cond_recv, &tq->lock);
+        wait_end(&tq->nb_recv_waiting);
+        pthread_mutex_unlock(&tq->lock);
+
+        if (released) {
+            wake(tq, &tq->nb_send_waiting, &tq->cond_send, 0);
+            released = 0;
         }
 
-        break;
+        if (ret != AVERROR(EAGAIN))
+            break;
     }
 
-    pthread_mutex_unlock(&tq->lock);
+    if (released)
+        wake(tq, &tq->nb_send_waiting, &tq->cond_send, 0);
 
     return ret;
 }
@@ -228,41 +422,31 @@ void tq_send_finish(ThreadQueue *tq, unsigned int stream_idx)
 {
     av_assert0(stream_idx < tq->nb_streams);
 
-    pthread_mutex_lock(&tq->lock);
-
     /* mark the stream as send-finished;
      * next time the consumer thread tries to read this stream it will get
      * an EOF and recv-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_SEND;
-    tq->choked = 0;
-    pthread_cond_broadcast(&tq->cond);
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_SEND);
+    atomic_store(&tq->choked, 0);
 
-    pthread_mutex_unlock(&tq->lock);
+    wake(tq, &tq->nb_recv_waiting, &tq->cond_recv, 0);
 }
 
 void tq_receive_finish(ThreadQueue *tq, unsigned int stream_idx)
 {
     av_assert0(stream_idx < tq->nb_streams);
 
-    pthread_mutex_lock(&tq->lock);
-
     /* mark the stream as recv-finished;
      * next time the producer thread tries to send for this stream, it will
      * get an EOF and send-finished flag will be set */
-    tq->finished[stream_idx] |= FINISHED_RECV;
-    pthread_cond_broadcast(&tq->cond);
+    atomic_fetch_or(&tq->finished[stream_idx], FINISHED_RECV);
 
-    pthread_mutex_unlock(&tq->lock);
+    wake(tq, &tq->nb_send_waiting, &tq->cond_send, 1);
 }
 
 void tq_choke(ThreadQueue *tq, int choked)
 {
-    pthread_mutex_lock(&tq->lock);
+    int prev_choked = atomic_exchange(&tq->choked, choked);
 
-    int prev_choked = tq->choked;
-    tq->choked = choked;
-    if (choked != prev_choked)
-        pthread_cond_broadcast(&tq->cond);
-
-    pthread_mutex_unlock(&tq->lock);
+    if (prev_choked && !choked)
+        wake(tq, &tq->nb_recv_waiting, &tq->cond_recv, 0);
 }
@@ -41,6 +41,10 @@ typedef struct ThreadQueue ThreadQueue;
  *                   maintained
  * @param queue_size number of items that can be stored in the queue without
  *                   blocking
+ *
+ * Any number of threads may send to the queue concurrently, but only one
+ * thread may receive from it at a time. Sending and receiving do not take
+ * any locks unless the queue is full or empty, respectively.
  */
 ThreadQueue *tq_alloc(unsigned int nb_streams, size_t queue_size,
                       enum ThreadQueueType type);
@@ -54,7 +58,6 @@ void         tq_free(ThreadQueue **tq);
  *             untouched
  * @return
  * - 0 the item was successfully sent
- * - AVERROR(ENOMEM) could not allocate an item for writing to the FIFO
  * - AVERROR(EINVAL) the sending side has previously been marked as finished
  * - AVERROR_EOF the receiving side has marked the given stream as finished
  */
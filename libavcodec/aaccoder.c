@@ -91,6 +91,7 @@ static av_always_inline float quantize_and_encode_band_cost_template(
     const int dim = BT_PAIR ? 2 : 4;
     int resbits = 0;
     int off;
+    LOCAL_ALIGNED_32(int, qcoefs, [96]);
 
     if (BT_ZERO || BT_NOISE || BT_STEREO) {
         for (int i = 0; i < size; i++)
@@ -110,7 +111,7 @@ static av_always_inline float quantize_and_encode_band_cost_template(
         s->aacdsp.abs_pow34(s->scoefs, in, size);
         scaled = s->scoefs;
     }
-    s->aacdsp.quant_bands(s->qcoefs, in, scaled, size, !BT_UNSIGNED, aac_cb_maxval[cb], Q34, ROUNDING);
+    s->aacdsp.quant_bands(qcoefs, in, scaled, size, !BT_UNSIGNED, aac_cb_maxval[cb], Q34, ROUNDING);
     if (BT_UNSIGNED) {
         off = 0;
     } else {
@@ -118,7 +119,7 @@ static av_always_inline float quantize_and_encode_band_cost_template(
     }
     for (int i = 0; i < size; i += dim) {
         const float *vec;
-        int *quants = s->qcoefs + i;
+        int *quants = qcoefs + i;
         int curidx = 0;
         int curbits;
         float quantized, rd = 0.0f;
@@ -223,6 +223,43 @@ static int nmr_band_curve(AACEncContext *s, SingleChannelElement *sce, int w, in
     return ncand;
 }
 
+typedef struct NMRCurveJob {
+    AACEncContext *s;
+    NMRSlot *t;
+    float (*nd)[NMR_NCAND];
+    int   (*nb)[NMR_NCAND];
+    int step, maxn;
+} NMRCurveJob;
+
+static int nmr_band_curve_job(AVCodecContext *avctx, void *arg, int b, int threadnr)
+{
+    const NMRCurveJob *job = arg;
+    NMRSlot *t = job->t;
+    const int i = t->bidx[b];
+    int ncand = nmr_band_curve(job->s, t->sce, t->bw[b], t->bg[b], t->bst[b], t->blo[b],
+                               job->step, job->maxn, 1.0f / FFMAX(t->thr[i], 1e-9f),
+                               t->maxvals[i], job->nd[b], job->nb[b]);
+    if (t->tnsg[i] > 1.0f)
+        for (int o = 0; o < ncand; o++)
+            job->nd[b][o] *= t->tnsg[i];
+    t->bnc[b] = ncand;
+    return 0;
+}
+
+/* Build the curves of bands [0,nbnd) of a slot from blo[] into bnc[].
+ * Bands only touch their own rows and quantize cache entries, so they are
+ * independent slice-thread jobs and the result does not depend on the
+ * thread count. s->scoefs and the cache must be set up for the channel. */
+static void nmr_build_curves(AVCodecContext *avctx, AACEncContext *s, NMRSlot *t,
+                             float (*nd)[NMR_NCAND], int (*nb)[NMR_NCAND],
+                             int nbnd, int step, int maxn)
+{
+    NMRCurveJob job = { s, t, nd, nb, step, maxn };
+
+    if (nbnd > 0)
+        avctx->execute2(avctx, nmr_band_curve_job, &job, NULL, nbnd);
+}
+
 /* Zero a channel with nothing codeable; stale band_types would resurrect
  * bands with chain-illegal scalefactors. */
 static void nmr_bail_channel(SingleChannelElement *sce)
@@ -415,35 +452,43 @@ static int nmr_setup_channel(AVCodecContext *avctx, AACEncContext *s,
     /* PASS 1: coarse candidate curves per coded band
      * (the lambda search runs on this cheap grid, PASS 2 refines the winner) */
     {
+        int n = 0;
         for (int w = 0; w < sce->ics.num_windows; w += sce->ics.group_len[w]) {
             int start = w*128;
             for (int g = 0; g < sce->ics.num_swb; g++) {
                 if (!sce->zeroes[w*16+g] && t->maxvals[w*16+g] > 0 && nbnd < 128) {
-                    int lo = av_clip(t->minsf[w*16+g], 0, SCALE_MAX_POS);
-                    float invthr = 1.0f / FFMAX(t->thr[w*16+g], 1e-9f);
-                    int ncand = nmr_band_curve(s, sce, w, g, start, lo, cstep, NMR_NCAND,
-                                               invthr, t->maxvals[w*16+g], nd[nbnd], nb[nbnd]);
-                    if (t->tnsg[w*16+g] > 1.0f)
-                        for (int o = 0; o < ncand; o++)
-                            nd[nbnd][o] *= t->tnsg[w*16+g];
-                    if (ncand == 0) {
-                        /* nothing codeable: drop the group band incl. subwindow
-                         * flags (group flag is re-derived by ANDing) */
-                        for (int w2 = 0; w2 < sce->ics.group_len[w]; w2++)
-                            sce->zeroes[(w+w2)*16+g] = 1;
-                    } else {
-                        t->bidx[nbnd] = w*16+g;
-                        t->bw[nbnd] = w;
-                        t->bg[nbnd] = g;
-                        t->bst[nbnd] = start;
-                        t->blo[nbnd] = lo;
-                        t->bnc[nbnd] = ncand;
-                        nbnd++;
-                    }
+                    t->bidx[nbnd] = w*16+g;
+                    t->bw[nbnd] = w;
+                    t->bg[nbnd] = g;
+                    t->bst[nbnd] = start;
+                    t->blo[nbnd] = av_clip(t->minsf[w*16+g], 0, SCALE_MAX_POS);
+                    nbnd++;
                 }
                 start += sce->ics.swb_sizes[g];
             }
         }
+        nmr_build_curves(avctx, s, t, nd, nb, nbnd, cstep, NMR_NCAND);
+        for (int b = 0; b < nbnd; b++) {
+            if (!t->bnc[b]) {
+                /* nothing codeable: drop the group band incl. subwindow
+                 * flags (group flag is re-derived by ANDing) */
+                for (int w2 = 0; w2 < sce->ics.group_len[t->bw[b]]; w2++)
+                    sce->zeroes[(t->bw[b]+w2)*16+t->bg[b]] = 1;
+                continue;
+            }
+            if (n != b) {
+                t->bidx[n] = t->bidx[b];
+                t->bw[n]   = t->bw[b];
+                t->bg[n]   = t->bg[b];
+                t->bst[n]  = t->bst[b];
+                t->blo[n]  = t->blo[b];
+                t->bnc[n]  = t->bnc[b];
+                memcpy(nd[n], nd[b], sizeof(nd[n]));
+                memcpy(nb[n], nb[b], sizeof(nb[n]));
+            }
+            n++;
+        }
+        nbnd = n;
     }
     t->nbnd = nbnd;
     for (int b = 0; b < nbnd; b++) {
@@ -691,17 +736,12 @@ static void nmr_solve_group(AVCodecContext *avctx, AACEncContext *s,
             ff_quantize_band_cost_cache_init(s);
             for (int b = 0; b < t->nbnd; b++) {
                 int center = t->blo[b] + t->chosen[b]*cstep;
-                int flo    = av_clip(center - win, av_clip(t->minsf[t->bidx[b]], 0, SCALE_MAX_POS), SCALE_MAX_POS);
-                int maxn   = FFMIN(NMR_NCAND, 2*win/NMR_STEP + 1);
-                float invthr = 1.0f / FFMAX(t->thr[t->bidx[b]], 1e-9f);
-                int ncand  = nmr_band_curve(s, t->sce, t->bw[b], t->bg[b], t->bst[b], flo, NMR_STEP, maxn,
-                                            invthr, t->maxvals[t->bidx[b]], ndk[b], nbk[b]);
-                if (t->tnsg[t->bidx[b]] > 1.0f)
-                    for (int o = 0; o < ncand; o++)
-                        ndk[b][o] *= t->tnsg[t->bidx[b]];
-                t->blo[b] = flo;
-                t->bnc[b] = FFMAX(1, ncand);
+                t->blo[b] = av_clip(center - win, av_clip(t->minsf[t->bidx[b]], 0, SCALE_MAX_POS), SCALE_MAX_POS);
             }
+            nmr_build_curves(avctx, s, t, ndk, nbk, t->nbnd, NMR_STEP,
+                             FFMIN(NMR_NCAND, 2*win/NMR_STEP + 1));
+            for (int b = 0; b < t->nbnd; b++)
+                t->bnc[b] = FFMAX(1, t->bnc[b]);
         }
         /* fine pass: narrow corridor around the coarse solve */
         if (rc_global)
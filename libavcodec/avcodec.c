@@ -470,6 +470,8 @@ av_cold void ff_codec_close(AVCodecContext *avctx)
         av_refstruct_pool_uninit(&avci->progress_frame_pool);
         if (av_codec_is_decoder(avctx->codec))
             ff_decode_internal_uninit(avctx);
+        else
+            ff_encode_internal_uninit(avctx);
 
         ff_hwaccel_uninit(avctx);
 
@@ -37,6 +37,7 @@
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/rational.h"
+#include "libavutil/threadpool.h"
 
 #include "codec.h"
 #include "codec_id.h"
@@ -1935,6 +1936,24 @@ typedef struct AVCodecContext {
      * - decoding: Set by libavcodec
      */
     enum AVAlphaMode alpha_mode;
+
+    /**
+     * Thread pool to run slice threading jobs on, instead of creating
+     * dedicated threads for this context. The same pool may be shared by
+     * any number of codec contexts and filtergraphs. With thread_count
+     * set to 0, up to the number of pool threads + 1 threads are used.
+     *
+     * Frame threading does not use the pool, set thread_type to
+     * FF_THREAD_SLICE to avoid it. Decoders whose slice threads must all run
+     * at the same time (e.g. vp8 and vp9) ignore the pool as well.
+     *
+     * - encoding: May be set by the user before avcodec_open2().
+     * - decoding: May be set by the user before avcodec_open2().
+     *
+     * libavcodec takes its own reference to the pool in avcodec_open2(),
+     * the caller may free the pool at any time afterwards.
+     */
+    AVThreadPool *thread_pool;
 } AVCodecContext;
 
 /**
@@ -2259,6 +2278,58 @@ int avcodec_open2(AVCodecContext *avctx, const AVCodec *codec, AVDictionary **op
  */
 int avcodec_encode_reconfigure(AVCodecContext *avctx, AVDictionary **options);
 
+/**
+ * A pool of video frames in the memory layout an encoder consumes without
+ * copying their data. Opaque, see avcodec_get_encoder_frame_pool().
+ */
+typedef struct AVEncoderFramePool AVEncoderFramePool;
+
+/**
+ * Get the pool of input frames that an opened video encoder can consume
+ * without copying their data.
+ *
+ * Some encoders only use input frames with a specific memory layout, e.g.
+ * matching the line sizes of their internal pictures, as they are, and copy
+ * all other frames. Allocating input frames from this pool lets the producer
+ * of the input, like a scaler, write to encoder memory directly.
+ *
+ * The pool does not reference avctx: it may be used from any thread, also
+ * while the encoder is used from another thread, and stays valid after avctx
+ * is closed or freed. It describes the encoder as it is currently opened; after
+ * reopening the encoder, a new pool must be retrieved. Frames from an old pool
+ * are still valid input, but may be copied.
+ *
+ * @param avctx an opened video encoder context
+ * @param pool  set to a new reference to the pool, to be released with
+ *              avcodec_encoder_frame_pool_free(), or to NULL if the encoder has
+ *              no preferred layout
+ * @retval 0               success
+ * @retval AVERROR(EINVAL) avctx is not an opened video encoder
+ */
+int avcodec_get_encoder_frame_pool(AVCodecContext *avctx, AVEncoderFramePool **pool);
+
+/**
+ * Allocate the buffers of a video frame from an encoder frame pool.
+ * This function is thread-safe.
+ *
+ * The following fields must be set in frame, and match those of the encoder
+ * the pool was retrieved from:
+ * - format
+ * - width
+ * - height
+ *
+ * @retval 0               success
+ * @retval AVERROR(EINVAL) the frame parameters do not match the pool
+ * @retval "another negative error code" other errors
+ */
+int avcodec_encoder_frame_pool_get_buffer(AVEncoderFramePool *pool, AVFrame *frame);
+
+/**
+ * Release a reference to an encoder frame pool and set *pool to NULL.
+ * Frames allocated from it stay valid.
+ */
+void avcodec_encoder_frame_pool_free(AVEncoderFramePool **pool);
+
 /**
  * Free all allocated data in the given subtitle struct.
  *
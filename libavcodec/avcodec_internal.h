@@ -74,6 +74,7 @@ void ff_decode_internal_sync(struct AVCodecContext *dst,
 void ff_decode_internal_uninit(struct AVCodecContext *avctx);
 
 struct AVCodecInternal *ff_encode_internal_alloc(void);
+void ff_encode_internal_uninit(struct AVCodecContext *avctx);
 
 void ff_codec_close(struct AVCodecContext *avctx);
 
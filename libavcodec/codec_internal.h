@@ -88,6 +88,13 @@
  * encoders do.
  */
 #define FF_CODEC_CAP_EOF_FLUSH              (1 << 10)
+/**
+ * The slice threading jobs of the codec wait on jobs started after them
+ * (or on each other), so all of them must run at the same time. Such codecs
+ * always use dedicated threads, never the threads of a shared AVThreadPool.
+ * Codecs with FF_CODEC_CAP_SLICE_THREAD_HAS_MF are treated the same.
+ */
+#define FF_CODEC_CAP_SLICE_THREAD_SYNC      (1 << 11)
 
 /**
  * FFCodec.codec_tags termination value
@@ -22,11 +22,13 @@
 #include "libavutil/channel_layout.h"
 #include "libavutil/emms.h"
 #include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/refstruct.h"
 #include "libavutil/samplefmt.h"
 
 #include "avcodec.h"
@@ -52,8 +54,22 @@ typedef struct EncodeContext {
      * potentially padded with silence). Reject all subsequent frames.
      */
     int last_audio_frame;
+
+    /**
+     * Pool of input frames returned by avcodec_get_encoder_frame_pool(),
+     * set during init if the encoder prefers a specific layout.
+     * RefStruct reference.
+     */
+    AVEncoderFramePool *frame_pool;
 } EncodeContext;
 
+struct AVEncoderFramePool {
+    enum AVPixelFormat format;
+    int                width, height;
+    int                linesize[4];
+    AVBufferPool      *pools[4];
+};
+
 static EncodeContext *encode_ctx(AVCodecInternal *avci)
 {
     return (EncodeContext*)avci;
@@ -1008,6 +1024,92 @@ int ff_encode_alloc_frame(AVCodecContext *avctx, AVFrame *frame)
     return 0;
 }
 
+static void frame_pool_free(AVRefStructOpaque unused, void *obj)
+{
+    AVEncoderFramePool *fp = obj;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(fp->pools); i++)
+        av_buffer_pool_uninit(&fp->pools[i]);
+}
+
+int ff_encode_set_input_linesizes(AVCodecContext *avctx, const ptrdiff_t linesize[4])
+{
+    EncodeContext *ec = encode_ctx(avctx->internal);
+    AVEncoderFramePool *fp;
+    size_t size[4];
+    int ret;
+
+    av_assert0(avctx->codec_type == AVMEDIA_TYPE_VIDEO && !ec->frame_pool);
+
+    ret = av_image_fill_plane_sizes(size, avctx->pix_fmt, avctx->height, linesize);
+    if (ret < 0)
+        return ret;
+
+    fp = av_refstruct_alloc_ext(sizeof(*fp), 0, NULL, frame_pool_free);
+    if (!fp)
+        return AVERROR(ENOMEM);
+    ec->frame_pool = fp;
+
+    fp->format = avctx->pix_fmt;
+    fp->width  = avctx->width;
+    fp->height = avctx->height;
+
+    for (int i = 0; i < 4 && size[i]; i++) {
+        if (linesize[i] > INT_MAX || size[i] > INT_MAX - (16 + STRIDE_ALIGN - 1))
+            return AVERROR(EINVAL);
+
+        fp->pools[i] = av_buffer_pool_init(size[i] + 16 + STRIDE_ALIGN - 1, NULL);
+        if (!fp->pools[i])
+            return AVERROR(ENOMEM);
+        fp->linesize[i] = linesize[i];
+    }
+
+    return 0;
+}
+
+int avcodec_get_encoder_frame_pool(AVCodecContext *avctx, AVEncoderFramePool **pool)
+{
+    EncodeContext *ec;
+
+    *pool = NULL;
+
+    if (!avcodec_is_open(avctx) || !av_codec_is_encoder(avctx->codec) ||
+        avctx->codec_type != AVMEDIA_TYPE_VIDEO)
+        return AVERROR(EINVAL);
+
+    ec = encode_ctx(avctx->internal);
+    if (ec->frame_pool)
+        *pool = av_refstruct_ref(ec->frame_pool);
+
+    return 0;
+}
+
+int avcodec_encoder_frame_pool_get_buffer(AVEncoderFramePool *fp, AVFrame *frame)
+{
+    if (frame->format != fp->format ||
+        frame->width  != fp->width  ||
+        frame->height != fp->height)
+        return AVERROR(EINVAL);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(fp->pools) && fp->pools[i]; i++) {
+        frame->buf[i] = av_buffer_pool_get(fp->pools[i]);
+        if (!frame->buf[i]) {
+            av_frame_unref(frame);
+            return AVERROR(ENOMEM);
+        }
+        frame->data[i]     = (uint8_t *)FFALIGN((uintptr_t)frame->buf[i]->data, STRIDE_ALIGN);
+        frame->linesize[i] = fp->linesize[i];
+    }
+    frame->extended_data = frame->data;
+
+    return 0;
+}
+
+void avcodec_encoder_frame_pool_free(AVEncoderFramePool **pool)
+{
+    av_refstruct_unref(pool);
+}
+
 int ff_encode_receive_frame(AVCodecContext *avctx, AVFrame *frame)
 {
     AVCodecInternal *avci = avctx->internal;
@@ -1036,6 +1138,13 @@ AVCodecInternal *ff_encode_internal_alloc(void)
     return av_mallocz(sizeof(EncodeContext));
 }
 
+void ff_encode_internal_uninit(AVCodecContext *avctx)
+{
+    EncodeContext *ec = encode_ctx(avctx->internal);
+
+    av_refstruct_unref(&ec->frame_pool);
+}
+
 AVCPBProperties *ff_encode_add_cpb_side_data(AVCodecContext *avctx)
 {
     AVPacketSideData *tmp;
@@ -56,6 +56,13 @@ int ff_get_encode_buffer(AVCodecContext *avctx, AVPacket *avpkt, int64_t size, i
  */
 int ff_encode_alloc_frame(AVCodecContext *avctx, AVFrame *frame);
 
+/**
+ * Set the line sizes of input frames the encoder can use without copying.
+ * The pool from avcodec_get_encoder_frame_pool() will allocate frames with
+ * this layout. May only be called from the encoder's init function.
+ */
+int ff_encode_set_input_linesizes(AVCodecContext *avctx, const ptrdiff_t linesize[4]);
+
 /**
  * Check AVPacket size and allocate data.
  *
@@ -399,14 +399,28 @@ static const uint8_t diag_scan8x8_inv[8][8] = {
     { 28, 36, 43, 49, 54, 58, 61, 63, },
 };
 
+/**
+ * @return the horizontal position of the CTB in its tile, in CTBs; the width
+ *         of the tile is returned in tile_width
+ */
+static int ctb_x_in_tile(const HEVCPPS *pps, const HEVCSPS *sps,
+                         int ctb_addr_ts, int *tile_width)
+{
+    int tile_x = pps->tile_id[ctb_addr_ts] % pps->num_tile_columns;
+
+    *tile_width = pps->column_width[tile_x];
+    return pps->ctb_addr_ts_to_rs[ctb_addr_ts] % sps->ctb_width - pps->col_bd[tile_x];
+}
+
 void ff_hevc_save_states(HEVCLocalContext *lc, const HEVCPPS *pps,
                          int ctb_addr_ts)
 {
     const HEVCSPS *const sps = pps->sps;
+    int tile_width;
+
+    // the state after the second CTB of a CTB row in a tile is stored
     if (pps->entropy_coding_sync_enabled_flag &&
-        (ctb_addr_ts % sps->ctb_width == 2 ||
-         (sps->ctb_width == 2 &&
-          ctb_addr_ts % sps->ctb_width == 0))) {
+        ctb_x_in_tile(pps, sps, ctb_addr_ts - 1, &tile_width) == 1) {
         memcpy(lc->common_cabac_state->state, lc->cabac_state, HEVC_CONTEXTS);
         if (sps->persistent_rice_adaptation_enabled) {
             memcpy(lc->common_cabac_state->stat_coeff, lc->stat_coeff, HEVC_STAT_COEFFS);
@@ -457,28 +471,28 @@ int ff_hevc_cabac_init(HEVCLocalContext *lc, const HEVCPPS *pps,
 {
     const HEVCContext *const s = lc->parent;
     const HEVCSPS   *const sps = pps->sps;
+    int tile_start = pps->tiles_enabled_flag && ctb_addr_ts &&
+                     pps->tile_id[ctb_addr_ts] != pps->tile_id[ctb_addr_ts - 1];
+    int tile_width;
+    // start of a CTB row in a tile, other than its first one
+    int sync = pps->entropy_coding_sync_enabled_flag && !tile_start &&
+               !ctb_x_in_tile(pps, sps, ctb_addr_ts, &tile_width);
 
     if (ctb_addr_ts == pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs]) {
         int ret = ff_init_cabac_decoder(&lc->cc, data, size);
         if (ret < 0)
             return ret;
-        if (s->sh.dependent_slice_segment_flag == 0 ||
-            (pps->tiles_enabled_flag &&
-             pps->tile_id[ctb_addr_ts] != pps->tile_id[ctb_addr_ts - 1]))
+        if (s->sh.dependent_slice_segment_flag == 0 || tile_start)
             cabac_init_state(lc, s);
 
-        if (!s->sh.first_slice_in_pic_flag &&
-            pps->entropy_coding_sync_enabled_flag) {
-            if (ctb_addr_ts % sps->ctb_width == 0) {
-                if (sps->ctb_width == 1)
-                    cabac_init_state(lc, s);
-                else if (s->sh.dependent_slice_segment_flag == 1)
-                    load_states(lc, sps);
-            }
+        if (!s->sh.first_slice_in_pic_flag && sync) {
+            if (tile_width == 1)
+                cabac_init_state(lc, s);
+            else if (s->sh.dependent_slice_segment_flag == 1)
+                load_states(lc, sps);
         }
     } else {
-        if (pps->tiles_enabled_flag &&
-            pps->tile_id[ctb_addr_ts] != pps->tile_id[ctb_addr_ts - 1]) {
+        if (tile_start) {
             int ret;
             if (!is_wpp)
                 ret = cabac_reinit(lc);
@@ -489,23 +503,21 @@ int ff_hevc_cabac_init(HEVCLocalContext *lc, const HEVCPPS *pps,
                 return ret;
             cabac_init_state(lc, s);
         }
-        if (pps->entropy_coding_sync_enabled_flag) {
-            if (ctb_addr_ts % sps->ctb_width == 0) {
-                int ret;
-                get_cabac_terminate(&lc->cc);
-                if (!is_wpp)
-                    ret = cabac_reinit(lc);
-                else {
-                    ret = ff_init_cabac_decoder(&lc->cc, data, size);
-                }
-                if (ret < 0)
-                    return ret;
-
-                if (sps->ctb_width == 1)
-                    cabac_init_state(lc, s);
-                else
-                    load_states(lc, sps);
+        if (sync) {
+            int ret;
+            get_cabac_terminate(&lc->cc);
+            if (!is_wpp)
+                ret = cabac_reinit(lc);
+            else {
+                ret = ff_init_cabac_decoder(&lc->cc, data, size);
             }
+            if (ret < 0)
+                return ret;
+
+            if (tile_width == 1)
+                cabac_init_state(lc, s);
+            else
+                load_states(lc, sps);
         }
     }
     return 0;
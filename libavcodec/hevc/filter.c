@@ -739,9 +739,11 @@ static int boundary_strength(const HEVCContext *s, const MvField *curr, const Mv
     return 1;
 }
 
-void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayerContext *l,
-                                           const HEVCPPS *pps,
-                                           int x0, int y0, int log2_trafo_size)
+static av_always_inline
+void deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayerContext *l,
+                                   const HEVCPPS *pps,
+                                   int x0, int y0, int log2_trafo_size,
+                                   int tile_edges)
 {
     const HEVCSPS *const sps = pps->sps;
     const HEVCContext *s = lc->parent;
@@ -752,9 +754,16 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
     int min_tu_width     = sps->min_tb_width;
     int is_intra = tab_mvf[(y0 >> log2_min_pu_size) * min_pu_width +
                            (x0 >> log2_min_pu_size)].pred_flag == PF_INTRA;
+    int width  = 1 << log2_trafo_size;
+    int height = 1 << log2_trafo_size;
     int boundary_upper, boundary_left;
     int i, j, bs;
 
+    if (tile_edges) {
+        width  = FFMIN(width,  sps->width  - x0);
+        height = FFMIN(height, sps->height - y0);
+    }
+
     boundary_upper = y0 > 0 && !(y0 & 7);
     if (boundary_upper &&
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
@@ -765,6 +774,12 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
           (y0 % (1 << sps->log2_ctb_size)) == 0)))
         boundary_upper = 0;
 
+    if (tile_edges)
+        boundary_upper &= !!(lc->boundary_flags & BOUNDARY_UPPER_TILE);
+    else if (lc->defer_tile_edges && lc->boundary_flags & BOUNDARY_UPPER_TILE &&
+             (y0 % (1 << sps->log2_ctb_size)) == 0)
+        boundary_upper = 0;
+
     if (boundary_upper) {
         const RefPicList *rpl_top = (lc->boundary_flags & BOUNDARY_UPPER_SLICE) ?
                                     ff_hevc_get_ref_list(s->cur_frame, x0, y0 - 1) :
@@ -774,7 +789,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
         int yp_tu = (y0 - 1) >> log2_min_tu_size;
         int yq_tu =  y0      >> log2_min_tu_size;
 
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
+            for (i = 0; i < width; i += 4) {
                 int x_pu = (x0 + i) >> log2_min_pu_size;
                 int x_tu = (x0 + i) >> log2_min_tu_size;
                 const MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
@@ -803,6 +818,12 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
           (x0 % (1 << sps->log2_ctb_size)) == 0)))
         boundary_left = 0;
 
+    if (tile_edges)
+        boundary_left &= !!(lc->boundary_flags & BOUNDARY_LEFT_TILE);
+    else if (lc->defer_tile_edges && lc->boundary_flags & BOUNDARY_LEFT_TILE &&
+             (x0 % (1 << sps->log2_ctb_size)) == 0)
+        boundary_left = 0;
+
     if (boundary_left) {
         const RefPicList *rpl_left = (lc->boundary_flags & BOUNDARY_LEFT_SLICE) ?
                                      ff_hevc_get_ref_list(s->cur_frame, x0 - 1, y0) :
@@ -812,7 +833,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
         int xp_tu = (x0 - 1) >> log2_min_tu_size;
         int xq_tu =  x0      >> log2_min_tu_size;
 
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
+            for (i = 0; i < height; i += 4) {
                 int y_pu      = (y0 + i) >> log2_min_pu_size;
                 int y_tu      = (y0 + i) >> log2_min_tu_size;
                 const MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
@@ -830,6 +851,9 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
             }
     }
 
+    if (tile_edges)
+        return;
+
     if (log2_trafo_size > log2_min_pu_size && !is_intra) {
         const RefPicList *rpl = s->cur_frame->refPicList;
 
@@ -865,6 +889,22 @@ void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayer
     }
 }
 
+void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayerContext *l,
+                                           const HEVCPPS *pps,
+                                           int x0, int y0, int log2_trafo_size)
+{
+    deblocking_boundary_strengths(lc, l, pps, x0, y0, log2_trafo_size, 0);
+}
+
+void ff_hevc_deblocking_boundary_strengths_tile_edges(HEVCLocalContext *lc,
+                                                      const HEVCLayerContext *l,
+                                                      const HEVCPPS *pps,
+                                                      int x_ctb, int y_ctb)
+{
+    deblocking_boundary_strengths(lc, l, pps, x_ctb, y_ctb,
+                                  pps->sps->log2_ctb_size, 1);
+}
+
 #undef LUMA
 #undef CB
 #undef CR
@@ -2712,13 +2712,12 @@ static void hls_decode_neighbour(HEVCLocalContext *lc,
     int ctb_addr_rs       = pps->ctb_addr_ts_to_rs[ctb_addr_ts];
     int ctb_addr_in_slice = ctb_addr_rs - s->sh.slice_addr;
 
-    l->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
+    // may already be set when decoding tiles in parallel, in which case
+    // other threads read it
+    if (l->tab_slice_address[ctb_addr_rs] != s->sh.slice_addr)
+        l->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
 
-    if (pps->entropy_coding_sync_enabled_flag) {
-        if (x_ctb == 0 && (y_ctb & (ctb_size - 1)) == 0)
-            lc->first_qp_group = 1;
-        lc->end_of_tiles_x = sps->width;
-    } else if (pps->tiles_enabled_flag) {
+    if (pps->tiles_enabled_flag) {
         if (ctb_addr_ts && pps->tile_id[ctb_addr_ts] != pps->tile_id[ctb_addr_ts - 1]) {
             int idxX = pps->col_idxX[x_ctb >> sps->log2_ctb_size];
             lc->end_of_tiles_x   = x_ctb + (pps->column_width[idxX] << sps->log2_ctb_size);
@@ -2728,6 +2727,12 @@ static void hls_decode_neighbour(HEVCLocalContext *lc,
         lc->end_of_tiles_x = sps->width;
     }
 
+    // with WPP, each CTB row of a tile starts a new quantization group
+    if (pps->entropy_coding_sync_enabled_flag &&
+        (x_ctb == 0 ||
+         pps->tile_id[ctb_addr_ts] != pps->tile_id[pps->ctb_addr_rs_to_ts[ctb_addr_rs - 1]]))
+        lc->first_qp_group = 1;
+
     lc->end_of_tiles_y = FFMIN(y_ctb + ctb_size, sps->height);
 
     lc->boundary_flags = 0;
@@ -2928,24 +2933,17 @@ static int wpp_progress_init(HEVCContext *s, unsigned count)
     return 0;
 }
 
-static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
+/**
+ * Allocate a local context for every slice thread and locate the entry
+ * points of the current slice segment in nal.
+ */
+static int slice_data_entry_points(HEVCContext *s, const H2645NAL *nal)
 {
-    const HEVCPPS *const pps = s->pps;
-    const HEVCSPS *const sps = pps->sps;
     const uint8_t *data = nal->data;
     int length          = nal->size;
-    int *ret;
     int64_t offset;
     int64_t startheader, cmpt = 0;
-    int j, res = 0;
-
-    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * (int64_t)sps->ctb_width >= sps->ctb_width * (int64_t)sps->ctb_height) {
-        av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
-            s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
-            sps->ctb_width, sps->ctb_height
-        );
-        return AVERROR_INVALIDDATA;
-    }
+    int j;
 
     if (s->avctx->thread_count > s->nb_local_ctx) {
         HEVCLocalContext *tmp = av_malloc_array(s->avctx->thread_count, sizeof(*s->local_ctx));
@@ -3006,6 +3004,28 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 
     s->data = data;
 
+    return 0;
+}
+
+static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
+{
+    const HEVCPPS *const pps = s->pps;
+    const HEVCSPS *const sps = pps->sps;
+    int *ret;
+    int res = 0;
+
+    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * (int64_t)sps->ctb_width >= sps->ctb_width * (int64_t)sps->ctb_height) {
+        av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
+            s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
+            sps->ctb_width, sps->ctb_height
+        );
+        return AVERROR_INVALIDDATA;
+    }
+
+    res = slice_data_entry_points(s, nal);
+    if (res < 0)
+        return res;
+
     for (unsigned i = 1; i < s->nb_local_ctx; i++) {
         s->local_ctx[i].first_qp_group = 1;
         s->local_ctx[i].qp_y = s->local_ctx[0].qp_y;
@@ -3030,6 +3050,212 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
     return res;
 }
 
+static int hls_decode_entry_tile(AVCodecContext *avctx, void *hevc_lclist,
+                                 int job, int thread)
+{
+    HEVCLocalContext *lc = &((HEVCLocalContext*)hevc_lclist)[thread];
+    const HEVCContext *const s = lc->parent;
+    const HEVCLayerContext *const l = &s->layers[s->cur_layer];
+    const HEVCPPS   *const pps = s->pps;
+    const HEVCSPS   *const sps = pps->sps;
+    int tile_x      = job % pps->num_tile_columns;
+    int tile_y      = job / pps->num_tile_columns;
+    int ctb_addr_rs = pps->row_bd[tile_y] * sps->ctb_width + pps->col_bd[tile_x];
+    int ctb_addr_ts = pps->ctb_addr_rs_to_ts[ctb_addr_rs];
+    int ctb_addr_ts_end = ctb_addr_ts + pps->column_width[tile_x] * pps->row_height[tile_y];
+    int more_data   = 1;
+    int entry       = job;
+    int ret;
+
+    const uint8_t *data      = s->data + s->sh.offset[job];
+    size_t         data_size = s->sh.size[job];
+
+    // with WPP, each CTB row of a tile has its own entry point
+    if (pps->entropy_coding_sync_enabled_flag)
+        entry = pps->row_bd[tile_y] * pps->num_tile_columns + tile_x * pps->row_height[tile_y];
+
+    lc->end_of_tiles_x = (pps->col_bd[tile_x] + pps->column_width[tile_x]) << sps->log2_ctb_size;
+    lc->first_qp_group = 1;
+
+    while (ctb_addr_ts < ctb_addr_ts_end) {
+        int x_ctb, y_ctb;
+
+        ctb_addr_rs = pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb = (ctb_addr_rs % sps->ctb_width) << sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / sps->ctb_width) << sps->log2_ctb_size;
+
+        if (!more_data) {
+            av_log(avctx, AV_LOG_ERROR, "Slice segment ended inside tile %d\n", job);
+            ret = AVERROR_INVALIDDATA;
+            goto error;
+        }
+
+        if (pps->entropy_coding_sync_enabled_flag &&
+            x_ctb >> sps->log2_ctb_size == pps->col_bd[tile_x]) {
+            int row = entry + (y_ctb >> sps->log2_ctb_size) - pps->row_bd[tile_y];
+            data      = s->data + s->sh.offset[row];
+            data_size = s->sh.size[row];
+        }
+
+        hls_decode_neighbour(lc, l, pps, sps, x_ctb, y_ctb, ctb_addr_ts);
+
+        ret = ff_hevc_cabac_init(lc, pps, ctb_addr_ts, data, data_size, 1);
+        if (ret < 0)
+            goto error;
+
+        hls_sao_param(lc, l, pps, sps,
+                      x_ctb >> sps->log2_ctb_size, y_ctb >> sps->log2_ctb_size);
+
+        l->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+        l->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+        l->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+        more_data = hls_coding_quadtree(lc, l, pps, sps, x_ctb, y_ctb, sps->log2_ctb_size, 0);
+        if (more_data < 0) {
+            ret = more_data;
+            goto error;
+        }
+
+        ctb_addr_ts++;
+        ff_hevc_save_states(lc, pps, ctb_addr_ts);
+    }
+
+    return 0;
+error:
+    l->tab_slice_address[ctb_addr_rs] = -1;
+    return ret;
+}
+
+/**
+ * Apply the in-loop filters to one CTB row of a picture whose tiles have been
+ * decoded in parallel. The filters of a CTB need the CTBs above and to the
+ * right of it to be filtered first, so the rows are processed as a wavefront,
+ * in the same way as while decoding with WPP.
+ */
+static int hls_filter_entry_tiles(AVCodecContext *avctx, void *hevc_lclist,
+                                  int job, int thread)
+{
+    HEVCLocalContext *lc = &((HEVCLocalContext*)hevc_lclist)[thread];
+    const HEVCContext *const s = lc->parent;
+    const HEVCLayerContext *const l = &s->layers[s->cur_layer];
+    const HEVCPPS   *const pps = s->pps;
+    const HEVCSPS   *const sps = pps->sps;
+    int ctb_size = 1 << sps->log2_ctb_size;
+    int y_ctb    = job << sps->log2_ctb_size;
+
+    for (int x = 0; x < sps->ctb_width; x++) {
+        int x_ctb = x << sps->log2_ctb_size;
+
+        if (job)
+            ff_thread_progress_await(&s->wpp_progress[job - 1], x + SHIFT_CTB_WPP);
+
+        if (pps->loop_filter_across_tiles_enabled_flag) {
+            int ctb_addr_rs = job * sps->ctb_width + x;
+            int tile_id     = pps->tile_id[pps->ctb_addr_rs_to_ts[ctb_addr_rs]];
+
+            lc->boundary_flags = 0;
+            if (x > 0 && tile_id != pps->tile_id[pps->ctb_addr_rs_to_ts[ctb_addr_rs - 1]])
+                lc->boundary_flags |= BOUNDARY_LEFT_TILE;
+            if (job > 0 && tile_id != pps->tile_id[pps->ctb_addr_rs_to_ts[ctb_addr_rs - sps->ctb_width]])
+                lc->boundary_flags |= BOUNDARY_UPPER_TILE;
+
+            if (lc->boundary_flags)
+                ff_hevc_deblocking_boundary_strengths_tile_edges(lc, l, pps, x_ctb, y_ctb);
+        }
+
+        ff_hevc_hls_filters(lc, l, pps, x_ctb, y_ctb, ctb_size);
+        ff_thread_progress_report(&s->wpp_progress[job], x + 1);
+    }
+
+    if (job == sps->ctb_height - 1)
+        ff_hevc_hls_filter(lc, l, pps, (sps->ctb_width - 1) << sps->log2_ctb_size,
+                           y_ctb, ctb_size);
+    ff_thread_progress_report(&s->wpp_progress[job], INT_MAX);
+
+    return 0;
+}
+
+/**
+ * @return 1 if no further slice segment of the current picture follows nal
+ *         in the current packet
+ */
+static int is_last_slice_segment(const HEVCContext *s, const H2645NAL *nal)
+{
+    for (int i = nal - s->pkt.nals + 1; i < s->pkt.nb_nals; i++) {
+        const H2645NAL *next = &s->pkt.nals[i];
+
+        if (next->type > HEVC_NAL_RSV_VCL31 || next->nuh_layer_id != nal->nuh_layer_id)
+            continue;
+
+        // first_slice_segment_in_pic_flag
+        return next->size > 2 && next->data[2] >> 7;
+    }
+
+    return 1;
+}
+
+/**
+ * Decode all tiles of a picture consisting of a single slice segment in
+ * parallel, one job per tile. Since tiles may depend on each other only
+ * through the in-loop filters, those are applied to the whole picture
+ * afterwards.
+ */
+static int hls_slice_data_tiles(HEVCContext *s, const HEVCLayerContext *l,
+                                const H2645NAL *nal)
+{
+    const HEVCPPS *const pps = s->pps;
+    const HEVCSPS *const sps = pps->sps;
+    int nb_tiles = pps->num_tile_columns * pps->num_tile_rows;
+    int *ret;
+    int res;
+
+    res = slice_data_entry_points(s, nal);
+    if (res < 0)
+        return res;
+
+    res = wpp_progress_init(s, sps->ctb_height);
+    if (res < 0)
+        return res;
+
+    for (unsigned i = 0; i < s->nb_local_ctx; i++) {
+        s->local_ctx[i].qp_y = s->local_ctx[0].qp_y;
+        s->local_ctx[i].tu.cu_qp_offset_cb = 0;
+        s->local_ctx[i].tu.cu_qp_offset_cr = 0;
+        s->local_ctx[i].defer_tile_edges   = 1;
+        // a tile is decoded by a single thread, which keeps its own WPP state
+        s->local_ctx[i].common_cabac_state = &s->local_ctx[i].tile_cabac_state;
+    }
+
+    // set in advance, so that threads only read the entries of other tiles
+    for (int i = 0; i < sps->ctb_width * sps->ctb_height; i++)
+        l->tab_slice_address[i] = s->sh.slice_addr;
+
+    ret = av_calloc(FFMAX(nb_tiles, sps->ctb_height), sizeof(*ret));
+    if (!ret)
+        return AVERROR(ENOMEM);
+
+    s->avctx->execute2(s->avctx, hls_decode_entry_tile, s->local_ctx, ret, nb_tiles);
+
+    for (unsigned i = 0; i < s->nb_local_ctx; i++) {
+        s->local_ctx[i].defer_tile_edges   = 0;
+        s->local_ctx[i].common_cabac_state = &s->cabac;
+    }
+
+    res = 0;
+    for (int i = 0; i < nb_tiles; i++)
+        res = FFMIN(res, ret[i]);
+
+    if (res >= 0)
+        s->avctx->execute2(s->avctx, hls_filter_entry_tiles, s->local_ctx, ret,
+                           sps->ctb_height);
+    av_free(ret);
+
+    if (res < 0)
+        return res;
+
+    return sps->ctb_width * sps->ctb_height;
+}
+
 static int decode_slice_data(HEVCContext *s, const HEVCLayerContext *l,
                              const H2645NAL *nal, GetBitContext *gb)
 {
@@ -3077,9 +3303,17 @@ static int decode_slice_data(HEVCContext *s, const HEVCLayerContext *l,
     s->local_ctx[0].tu.cu_qp_offset_cr = 0;
 
     if (s->avctx->active_thread_type == FF_THREAD_SLICE  &&
-        s->sh.num_entry_point_offsets > 0                &&
-        pps->num_tile_rows == 1 && pps->num_tile_columns == 1)
-        return hls_slice_data_wpp(s, nal);
+        s->sh.num_entry_point_offsets > 0) {
+        if (pps->num_tile_rows == 1 && pps->num_tile_columns == 1)
+            return hls_slice_data_wpp(s, nal);
+
+        // one entry point per tile, or per CTB row of each tile with WPP
+        if (s->sh.first_slice_in_pic_flag &&
+            s->sh.num_entry_point_offsets + 1 == pps->num_tile_columns *
+            (pps->entropy_coding_sync_enabled_flag ? pps->sps->ctb_height : pps->num_tile_rows) &&
+            is_last_slice_segment(s, nal))
+            return hls_slice_data_tiles(s, l, nal);
+    }
 
     return hls_decode_entry(s, gb);
 }
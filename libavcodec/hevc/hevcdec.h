@@ -412,6 +412,12 @@ typedef struct HEVCLocalContext {
      */
     HEVCCABACState *common_cabac_state;
 
+    /**
+     * The target for common_cabac_state while tiles are decoded in parallel,
+     * when the CTB rows of a tile are all decoded by the same thread.
+     */
+    HEVCCABACState tile_cabac_state;
+
     int8_t qp_y;
     int8_t curr_qp_y;
 
@@ -444,6 +450,10 @@ typedef struct HEVCLocalContext {
      * of the deblocking filter */
     int boundary_flags;
 
+    /* set while tiles are decoded in parallel; boundary strengths of the
+     * edges between tiles are then derived once all tiles are decoded */
+    int defer_tile_edges;
+
     // an array of these structs is used for per-thread state - pad its size
     // to avoid false sharing
     char padding[128];
@@ -706,6 +716,14 @@ void ff_hevc_set_qPy(HEVCLocalContext *lc,
 void ff_hevc_deblocking_boundary_strengths(HEVCLocalContext *lc, const HEVCLayerContext *l,
                                            const HEVCPPS *pps,
                                            int x0, int y0, int log2_trafo_size);
+/**
+ * Derive the boundary strengths of the left and upper edges of the CTB at
+ * (x_ctb, y_ctb) that lie on tile boundaries, as given by lc->boundary_flags.
+ */
+void ff_hevc_deblocking_boundary_strengths_tile_edges(HEVCLocalContext *lc,
+                                                      const HEVCLayerContext *l,
+                                                      const HEVCPPS *pps,
+                                                      int x_ctb, int y_ctb);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCLocalContext *lc);
 int ff_hevc_cu_qp_delta_abs(HEVCLocalContext *lc);
 int ff_hevc_cu_chroma_qp_offset_flag(HEVCLocalContext *lc);
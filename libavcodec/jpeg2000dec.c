@@ -1086,6 +1086,7 @@ static int init_tile(Jpeg2000DecoderContext *s, int tileno)
                                              s->cbps[compno], s->cdx[compno],
                                              s->cdy[compno], s->avctx))
             return ret;
+        comp->dwt.lift_x4 = s->dsp.dwt_lift_x4[comp->dwt.type];
     }
     return 0;
 }
@@ -2188,7 +2189,6 @@ static void dequantization_int_97(int x, int y, Jpeg2000Cblk *cblk,
     fscale *= (float)(1 << PRESCALE);
     fscale *= (float)(1 << (16 + I_PRESHIFT));
     scale = (int)(fscale + 0.5);
-    band->i_stepsize = scale;
     for (j = 0; j < (cblk->coord[1][1] - cblk->coord[1][0]); ++j) {
         int32_t *datap = &comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * (y + j) + x];
         int *src = t1->data + j*t1->stride;
@@ -2198,39 +2198,89 @@ static void dequantization_int_97(int x, int y, Jpeg2000Cblk *cblk,
                 val = -(val & INT32_MAX);
             // Shifting down to prevent overflow in dequantization
             val = (val + (1LL << (PRESCALE - 1))) >> PRESCALE;
-            datap[i] = RSHIFT(val * (int64_t)band->i_stepsize, 16);
+            datap[i] = RSHIFT(val * (int64_t)scale, 16);
         }
     }
 }
 
-static inline void mct_decode(const Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
+static int mct_check(const Jpeg2000DecoderContext *s, const Jpeg2000Tile *tile)
 {
-    int i, csize = 1;
-    void *src[3];
-
-    for (i = 1; i < 3; i++) {
+    for (int i = 1; i < 3; i++) {
         if (tile->codsty[0].transform != tile->codsty[i].transform) {
             av_log(s->avctx, AV_LOG_ERROR, "Transforms mismatch, MCT not supported\n");
-            return;
+            return AVERROR_PATCHWELCOME;
         }
         if (memcmp(tile->comp[0].coord, tile->comp[i].coord, sizeof(tile->comp[0].coord))) {
             av_log(s->avctx, AV_LOG_ERROR, "Coords mismatch, MCT not supported\n");
-            return;
+            return AVERROR_PATCHWELCOME;
         }
     }
+    return 0;
+}
 
-    for (i = 0; i < 3; i++)
+static int mct_size(const Jpeg2000Tile *tile)
+{
+    int csize = 1;
+
+    for (int i = 0; i < 2; i++)
+        csize *= tile->comp[0].coord[i][1] - tile->comp[0].coord[i][0];
+    return csize;
+}
+
+/* inverse MCT of the samples [start, start + len) of the components */
+static void mct_decode_range(const Jpeg2000DecoderContext *s, Jpeg2000Tile *tile,
+                             int start, int len)
+{
+    void *src[3];
+
+    for (int i = 0; i < 3; i++)
         if (tile->codsty[0].transform == FF_DWT97)
-            src[i] = tile->comp[i].f_data;
+            src[i] = tile->comp[i].f_data + start;
         else
-            src[i] = tile->comp[i].i_data;
+            src[i] = tile->comp[i].i_data + start;
 
-    for (i = 0; i < 2; i++)
-        csize *= tile->comp[0].coord[i][1] - tile->comp[0].coord[i][0];
+    s->dsp.mct_decode[tile->codsty[0].transform](src[0], src[1], src[2], len);
+}
 
-    s->dsp.mct_decode[tile->codsty[0].transform](src[0], src[1], src[2], csize);
+static inline void mct_decode(const Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
+{
+    if (mct_check(s, tile) < 0)
+        return;
+    mct_decode_range(s, tile, 0, mct_size(tile));
 }
 
+/* Decode and dequantize a code-block, returns whether it has coded data. */
+static int decode_cblk_dequant(const Jpeg2000DecoderContext *s,
+                               Jpeg2000CodingStyle *codsty, Jpeg2000Component *comp,
+                               Jpeg2000Band *band, Jpeg2000Cblk *cblk,
+                               Jpeg2000T1Context *t1, int bandpos, int M_b)
+{
+    int x, y, ret;
+
+    if (cblk->modes & JPEG2000_CTSY_HTJ2K_F)
+        ret = ff_jpeg2000_decode_htj2k(s, codsty, t1, cblk,
+                                       cblk->coord[0][1] - cblk->coord[0][0],
+                                       cblk->coord[1][1] - cblk->coord[1][0],
+                                       M_b, comp->roi_shift);
+    else
+        ret = decode_cblk(s, codsty, t1, cblk,
+                          cblk->coord[0][1] - cblk->coord[0][0],
+                          cblk->coord[1][1] - cblk->coord[1][0],
+                          bandpos, comp->roi_shift, M_b);
+    if (!ret)
+        return 0;
+
+    x = cblk->coord[0][0] - band->coord[0][0];
+    y = cblk->coord[1][0] - band->coord[1][0];
+
+    if (codsty->transform == FF_DWT97)
+        dequantization_float(x, y, cblk, comp, t1, band, M_b);
+    else if (codsty->transform == FF_DWT97_INT)
+        dequantization_int_97(x, y, cblk, comp, t1, band, M_b);
+    else
+        dequantization_int(x, y, cblk, comp, t1, band, M_b);
+    return 1;
+}
 
 static inline int tile_codeblocks(const Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
 {
@@ -2280,34 +2330,11 @@ static inline int tile_codeblocks(const Jpeg2000DecoderContext *s, Jpeg2000Tile
                     for (cblkno = 0;
                          cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height;
                          cblkno++) {
-                        int x, y, ret;
-
                         Jpeg2000Cblk *cblk = prec->cblk + cblkno;
 
-                        if (cblk->modes & JPEG2000_CTSY_HTJ2K_F)
-                            ret = ff_jpeg2000_decode_htj2k(s, codsty, &t1, cblk,
-                                                           cblk->coord[0][1] - cblk->coord[0][0],
-                                                           cblk->coord[1][1] - cblk->coord[1][0],
-                                                           M_b, comp->roi_shift);
-                        else
-                            ret = decode_cblk(s, codsty, &t1, cblk,
-                                              cblk->coord[0][1] - cblk->coord[0][0],
-                                              cblk->coord[1][1] - cblk->coord[1][0],
-                                              bandpos, comp->roi_shift, M_b);
-
-                        if (ret)
+                        if (decode_cblk_dequant(s, codsty, comp, band, cblk, &t1,
+                                                bandpos, M_b))
                             coded = 1;
-                        else
-                            continue;
-                        x = cblk->coord[0][0] - band->coord[0][0];
-                        y = cblk->coord[1][0] - band->coord[1][0];
-
-                        if (codsty->transform == FF_DWT97)
-                            dequantization_float(x, y, cblk, comp, &t1, band, M_b);
-                        else if (codsty->transform == FF_DWT97_INT)
-                            dequantization_int_97(x, y, cblk, comp, &t1, band, M_b);
-                        else
-                            dequantization_int(x, y, cblk, comp, &t1, band, M_b);
                    } /* end cblk */
                 } /*end prec */
             } /* end band */
@@ -2420,6 +2447,143 @@ static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
     return 0;
 }
 
+static int decode_cblk_job(AVCodecContext *avctx, void *arg,
+                           int jobnr, int threadnr)
+{
+    const Jpeg2000DecoderContext *s = avctx->priv_data;
+    Jpeg2000CblkJob *job = (Jpeg2000CblkJob *)arg + jobnr;
+    Jpeg2000T1Context t1;
+
+    t1.stride  = (1 << job->codsty->log2_cblk_width) + 2;
+    job->coded = decode_cblk_dequant(s, job->codsty, job->comp, job->band,
+                                     job->cblk, &t1, job->bandpos, job->M_b);
+    return 0;
+}
+
+static int dwt_decode_job(AVCodecContext *avctx, void *arg,
+                          int jobnr, int threadnr)
+{
+    Jpeg2000Tile *tile = arg;
+    Jpeg2000Component *comp     = tile->comp   + jobnr;
+    Jpeg2000CodingStyle *codsty = tile->codsty + jobnr;
+
+    if (tile->coded[jobnr])
+        ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
+    return 0;
+}
+
+#define MCT_JOB_ALIGN 16
+
+static int mct_decode_job(AVCodecContext *avctx, void *arg,
+                          int jobnr, int threadnr)
+{
+    const Jpeg2000DecoderContext *s = avctx->priv_data;
+    Jpeg2000Tile *tile = arg;
+    int csize  = mct_size(tile);
+    int nb_jobs = FFMIN(avctx->thread_count, (csize + MCT_JOB_ALIGN - 1) / MCT_JOB_ALIGN);
+    /* keep every range start aligned for the SIMD versions */
+    int start = FFALIGN((int64_t)csize *  jobnr      / nb_jobs, MCT_JOB_ALIGN);
+    int end   = FFALIGN((int64_t)csize * (jobnr + 1) / nb_jobs, MCT_JOB_ALIGN);
+
+    end = FFMIN(end, csize);
+    if (start < end)
+        mct_decode_range(s, tile, start, end - start);
+    return 0;
+}
+
+/*
+ * Decode a tile with the code-blocks, the inverse DWT of each component and
+ * the inverse MCT spread over the slice threads. Used when there are fewer
+ * tiles than threads, the output is identical to jpeg2000_decode_tile().
+ */
+static int decode_tile_cblk_threads(AVCodecContext *avctx, Jpeg2000Tile *tile,
+                                    AVFrame *picture)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+    int nb_jobs = 0;
+
+    for (int compno = 0; compno < s->ncomponents; compno++) {
+        Jpeg2000Component *comp      = tile->comp   + compno;
+        Jpeg2000CodingStyle *codsty  = tile->codsty + compno;
+        Jpeg2000QuantStyle *quantsty = tile->qntsty + compno;
+        int subbandno = 0;
+
+        for (int reslevelno = 0; reslevelno < codsty->nreslevels2decode; reslevelno++) {
+            Jpeg2000ResLevel *rlevel = comp->reslevel + reslevelno;
+            for (int bandno = 0; bandno < rlevel->nbands; bandno++, subbandno++) {
+                Jpeg2000Band *band = rlevel->band + bandno;
+                int M_b = quantsty->expn[subbandno] + quantsty->nguardbits - 1;
+                int nb_precincts = rlevel->num_precincts_x * rlevel->num_precincts_y;
+
+                if (band->coord[0][0] == band->coord[0][1] ||
+                    band->coord[1][0] == band->coord[1][1])
+                    continue;
+
+                if (M_b > 31) {
+                    avpriv_request_sample(avctx, "M_b (%d) > 31", M_b);
+                    return AVERROR_PATCHWELCOME;
+                }
+
+                for (int precno = 0; precno < nb_precincts; precno++) {
+                    Jpeg2000Prec *prec = band->prec + precno;
+                    int nb_cblks = prec->nb_codeblocks_width * prec->nb_codeblocks_height;
+                    Jpeg2000CblkJob *jobs;
+
+                    if (nb_cblks > INT_MAX / sizeof(*jobs) - nb_jobs)
+                        return AVERROR(ENOMEM);
+                    jobs = av_fast_realloc(s->cblk_jobs, &s->cblk_jobs_size,
+                                           (nb_jobs + nb_cblks) * sizeof(*jobs));
+                    if (!jobs)
+                        return AVERROR(ENOMEM);
+                    s->cblk_jobs = jobs;
+
+                    for (int cblkno = 0; cblkno < nb_cblks; cblkno++) {
+                        Jpeg2000CblkJob *job = &jobs[nb_jobs++];
+
+                        job->cblk    = prec->cblk + cblkno;
+                        job->band    = band;
+                        job->comp    = comp;
+                        job->codsty  = codsty;
+                        job->compno  = compno;
+                        job->bandpos = bandno + (reslevelno > 0);
+                        job->M_b     = M_b;
+                        job->coded   = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    avctx->execute2(avctx, decode_cblk_job, s->cblk_jobs, NULL, nb_jobs);
+
+    memset(tile->coded, 0, sizeof(tile->coded));
+    for (int i = 0; i < nb_jobs; i++)
+        tile->coded[s->cblk_jobs[i].compno] |= s->cblk_jobs[i].coded;
+
+    /* inverse DWT */
+    avctx->execute2(avctx, dwt_decode_job, tile, NULL, s->ncomponents);
+
+    /* inverse MCT transformation */
+    if (tile->codsty[0].mct && mct_check(s, tile) >= 0) {
+        int csize = mct_size(tile);
+        avctx->execute2(avctx, mct_decode_job, tile, NULL,
+                        FFMIN(avctx->thread_count, (csize + MCT_JOB_ALIGN - 1) / MCT_JOB_ALIGN));
+    }
+
+    if (s->precision <= 8) {
+        write_frame_8(s, tile, picture, 8);
+    } else {
+        int precision = picture->format == AV_PIX_FMT_XYZ12 ||
+                        picture->format == AV_PIX_FMT_RGB48 ||
+                        picture->format == AV_PIX_FMT_RGBA64 ||
+                        picture->format == AV_PIX_FMT_GRAY16 ? 16 : s->precision;
+
+        write_frame_16(s, tile, picture, precision);
+    }
+
+    return 0;
+}
+
 static void jpeg2000_dec_cleanup(Jpeg2000DecoderContext *s)
 {
     int tileno, compno;
@@ -2854,6 +3018,16 @@ static av_cold int jpeg2000_decode_init(AVCodecContext *avctx)
     return 0;
 }
 
+static av_cold int jpeg2000_decode_close(AVCodecContext *avctx)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+
+    av_freep(&s->cblk_jobs);
+    s->cblk_jobs_size = 0;
+
+    return 0;
+}
+
 static int jpeg2000_decode_frame(AVCodecContext *avctx, AVFrame *picture,
                                  int *got_frame, AVPacket *avpkt)
 {
@@ -2916,7 +3090,17 @@ static int jpeg2000_decode_frame(AVCodecContext *avctx, AVFrame *picture,
         if (++x == s->ncomponents)
             picture->flags |= AV_FRAME_FLAG_LOSSLESS;
 
-    avctx->execute2(avctx, jpeg2000_decode_tile, picture, NULL, s->numXtiles * s->numYtiles);
+    if ((avctx->active_thread_type & FF_THREAD_SLICE) &&
+        s->numXtiles * s->numYtiles < avctx->thread_count) {
+        for (int tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++) {
+            /* as with execute2() below, a tile that cannot be decoded is
+             * left out of the picture instead of failing the frame */
+            ret = decode_tile_cblk_threads(avctx, s->tile + tileno, picture);
+            if (ret == AVERROR(ENOMEM))
+                goto end;
+        }
+    } else
+        avctx->execute2(avctx, jpeg2000_decode_tile, picture, NULL, s->numXtiles * s->numYtiles);
 
     jpeg2000_dec_cleanup(s);
 
@@ -2957,6 +3141,7 @@ const FFCodec ff_jpeg2000_decoder = {
     .priv_data_size   = sizeof(Jpeg2000DecoderContext),
     .init             = jpeg2000_decode_init,
     FF_CODEC_DECODE_CB(jpeg2000_decode_frame),
+    .close            = jpeg2000_decode_close,
     .p.priv_class     = &jpeg2000_class,
     .p.max_lowres     = 5,
     .p.profiles       = NULL_IF_CONFIG_SMALL(ff_jpeg2000_profiles),
@@ -53,6 +53,17 @@ typedef struct Jpeg2000TilePart {
     GetByteContext tpg;                 // bit stream in tile-part
 } Jpeg2000TilePart;
 
+/* A code-block of a tile, decoded as one job when the tile is decoded
+ * with code-block parallelism */
+typedef struct Jpeg2000CblkJob {
+    Jpeg2000Cblk        *cblk;
+    Jpeg2000Band        *band;
+    Jpeg2000Component   *comp;
+    Jpeg2000CodingStyle *codsty;
+    int compno, bandpos, M_b;
+    int coded;                          // set by the job
+} Jpeg2000CblkJob;
+
 /* RMK: For JPEG2000 DCINEMA 3 tile-parts in a tile
  * one per component, so tile_part elements have a size of 3 */
 typedef struct Jpeg2000Tile {
@@ -60,6 +71,7 @@ typedef struct Jpeg2000Tile {
     uint8_t             properties[4];
     Jpeg2000CodingStyle codsty[4];
     Jpeg2000QuantStyle  qntsty[4];
+    uint8_t             coded[4];               // whether a component has coded code-blocks
     Jpeg2000POC         poc;
     Jpeg2000TilePart    tile_part[32];
     uint8_t             has_ppt;                // whether this tile has a ppt marker
@@ -111,6 +123,9 @@ typedef struct Jpeg2000DecoderContext {
     Jpeg2000Tile    *tile;
     Jpeg2000DSPContext dsp;
 
+    Jpeg2000CblkJob *cblk_jobs;
+    unsigned        cblk_jobs_size;
+
     uint8_t         isHT; // HTJ2K?
     uint8_t         Ccap15_b14_15; // HTONLY(= 0) or HTDECLARED(= 1) or MIXED(= 3) ?
     uint8_t         Ccap15_b12; // RGNFREE(= 0) or RGN(= 1)?
@@ -20,6 +20,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <stddef.h>
+
 #include "config.h"
 #include "libavutil/attributes.h"
 #include "jpeg2000dsp.h"
@@ -90,12 +92,48 @@ static void rct_int(void *_src0, void *_src1, void *_src2, int csize)
     }
 }
 
+static void dwt_lift97_float_x4(void *_p, int i0, int i1)
+{
+    float *p = _p;
+    int i, k;
+
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 2; i++)
+        for (k = 0; k < 4; k++)
+            p[4 * (2 * i) + k]     -= F_LFTG_DELTA * (p[4 * (2 * i - 1) + k] + p[4 * (2 * i + 1) + k]);
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 1; i++)
+        for (k = 0; k < 4; k++)
+            p[4 * (2 * i + 1) + k] -= F_LFTG_GAMMA * (p[4 * (2 * i)     + k] + p[4 * (2 * i + 2) + k]);
+    for (i = (i0 >> 1); i < (i1 >> 1) + 1; i++)
+        for (k = 0; k < 4; k++)
+            p[4 * (2 * i) + k]     += F_LFTG_BETA  * (p[4 * (2 * i - 1) + k] + p[4 * (2 * i + 1) + k]);
+    for (i = (i0 >> 1); i < (i1 >> 1); i++)
+        for (k = 0; k < 4; k++)
+            p[4 * (2 * i + 1) + k] += F_LFTG_ALPHA * (p[4 * (2 * i)     + k] + p[4 * (2 * i + 2) + k]);
+}
+
+static void dwt_lift53_x4(void *_p, int i0, int i1)
+{
+    uint32_t *p = _p;
+    int i, k;
+
+    for (i = (i0 >> 1); i < (i1 >> 1) + 1; i++)
+        for (k = 0; k < 4; k++)
+            p[4 * (2 * i) + k]     -= (int32_t)(p[4 * (2 * i - 1) + k] + p[4 * (2 * i + 1) + k] + 2) >> 2;
+    for (i = (i0 >> 1); i < (i1 >> 1); i++)
+        for (k = 0; k < 4; k++)
+            p[4 * (2 * i + 1) + k] += (int32_t)(p[4 * (2 * i)     + k] + p[4 * (2 * i + 2) + k]) >> 1;
+}
+
 av_cold void ff_jpeg2000dsp_init(Jpeg2000DSPContext *c)
 {
     c->mct_decode[FF_DWT97]     = ict_float;
     c->mct_decode[FF_DWT53]     = rct_int;
     c->mct_decode[FF_DWT97_INT] = ict_int;
 
+    c->dwt_lift_x4[FF_DWT97]     = dwt_lift97_float_x4;
+    c->dwt_lift_x4[FF_DWT53]     = dwt_lift53_x4;
+    c->dwt_lift_x4[FF_DWT97_INT] = NULL;
+
 #if ARCH_RISCV
     ff_jpeg2000dsp_init_riscv(c);
 #elif ARCH_X86 && HAVE_X86ASM
@@ -28,6 +28,13 @@
 
 typedef struct Jpeg2000DSPContext {
     void (*mct_decode[FF_DWT_NB])(void *src0, void *src1, void *src2, int csize);
+    /**
+     * Inverse lifting steps of the wavelet on 4 interleaved lines: sample n
+     * of line k is p[4 * n + k], p is 16-byte aligned and the samples
+     * outside [i0, i1) are already symmetrically extended. i1 > i0 + 1.
+     * NULL for FF_DWT97_INT.
+     */
+    void (*dwt_lift_x4[FF_DWT_NB])(void *p, int i0, int i1);
 } Jpeg2000DSPContext;
 
 extern const float ff_jpeg2000_f_ict_params[4];
@@ -25,18 +25,13 @@
  * Discrete wavelet transform
  */
 
+#include <string.h>
+
 #include "libavutil/error.h"
 #include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "jpeg2000dwt.h"
 
-/* Defines for 9/7 DWT lifting parameters.
- * Parameters are in float. */
-#define F_LFTG_ALPHA  1.586134342059924f
-#define F_LFTG_BETA   0.052980118572961f
-#define F_LFTG_GAMMA  0.882911075530934f
-#define F_LFTG_DELTA  0.443506852043971f
-
 /* Lifting parameters in integer format.
  * Computed as param = (float param) * (1 << 16) */
 #define I_LFTG_ALPHA_PRIME   38413ll // = 103949 - 65536, (= alpha - 1.0)
@@ -74,6 +69,25 @@ static inline void extend97_int(int32_t *p, int i0, int i1)
     }
 }
 
+/* Same as extend53() and extend97_float() on 4 interleaved lines. */
+static inline void extend53_x4(int32_t *p, int i0, int i1)
+{
+    memcpy(&p[4 * (i0 - 1)], &p[4 * (i0 + 1)], 4 * sizeof(*p));
+    memcpy(&p[4 *  i1     ], &p[4 * (i1 - 2)], 4 * sizeof(*p));
+    memcpy(&p[4 * (i0 - 2)], &p[4 * (i0 + 2)], 4 * sizeof(*p));
+    memcpy(&p[4 * (i1 + 1)], &p[4 * (i1 - 3)], 4 * sizeof(*p));
+}
+
+static inline void extend97_float_x4(float *p, int i0, int i1)
+{
+    int i;
+
+    for (i = 1; i <= 4; i++) {
+        memcpy(&p[4 * (i0 - i)],     &p[4 * (i0 + i)],     4 * sizeof(*p));
+        memcpy(&p[4 * (i1 + i - 1)], &p[4 * (i1 - i - 1)], 4 * sizeof(*p));
+    }
+}
+
 static void sd_1d53(int *p, int i0, int i1)
 {
     int i;
@@ -356,8 +370,27 @@ static void dwt_decode53(DWTContext *s, int *t)
         }
 
         // VER_SD
+        lp = 0;
+        if (s->lift_x4 && lv > 1) {
+            // 4 columns at a time, interleaved in the line buffer
+            int32_t *line4 = s->i_linebuf + 4 * 3;
+            l = line4 + 4 * mv;
+            for (; lp + 4 <= lh; lp += 4) {
+                int i, j = 0;
+                for (i = mv; i < lv; i += 2, j++)
+                    memcpy(&l[4 * i], &t[w * j + lp], 4 * sizeof(*t));
+                for (i = 1 - mv; i < lv; i += 2, j++)
+                    memcpy(&l[4 * i], &t[w * j + lp], 4 * sizeof(*t));
+
+                extend53_x4(line4, mv, mv + lv);
+                s->lift_x4(line4, mv, mv + lv);
+
+                for (i = 0; i < lv; i++)
+                    memcpy(&t[w * i + lp], &l[4 * i], 4 * sizeof(*t));
+            }
+        }
         l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
+        for (; lp < lh; lp++) {
             int i, j = 0;
             // copy with interleaving
             for (i = mv; i < lv; i += 2, j++)
@@ -433,8 +466,27 @@ static void dwt_decode97_float(DWTContext *s, float *t)
         }
 
         // VER_SD
+        lp = 0;
+        if (s->lift_x4 && lv > 1) {
+            // 4 columns at a time, interleaved in the line buffer
+            float *line4 = s->f_linebuf + 4 * 5;
+            l = line4 + 4 * mv;
+            for (; lp + 4 <= lh; lp += 4) {
+                int i, j = 0;
+                for (i = mv; i < lv; i += 2, j++)
+                    memcpy(&l[4 * i], &data[w * j + lp], 4 * sizeof(*data));
+                for (i = 1 - mv; i < lv; i += 2, j++)
+                    memcpy(&l[4 * i], &data[w * j + lp], 4 * sizeof(*data));
+
+                extend97_float_x4(line4, mv, mv + lv);
+                s->lift_x4(line4, mv, mv + lv);
+
+                for (i = 0; i < lv; i++)
+                    memcpy(&data[w * i + lp], &l[4 * i], 4 * sizeof(*data));
+            }
+        }
         l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
+        for (; lp < lh; lp++) {
             int i, j = 0;
             // copy with interleaving
             for (i = mv; i < lv; i += 2, j++)
@@ -544,6 +596,7 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
 
     s->ndeclevels = decomp_levels;
     s->type       = type;
+    s->lift_x4    = NULL;
 
     for (i = 0; i < 2; i++)
         for (j = 0; j < 2; j++)
@@ -558,9 +611,10 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
             for (j = 0; j < 2; j++)
                 b[i][j] = (b[i][j] + 1) >> 1;
         }
+    /* FF_DWT97 and FF_DWT53 lines hold 4 interleaved columns with lift_x4 */
     switch (type) {
     case FF_DWT97:
-        s->f_linebuf = av_malloc_array((maxlen + 12), sizeof(*s->f_linebuf));
+        s->f_linebuf = av_malloc_array((maxlen + 12) * 4, sizeof(*s->f_linebuf));
         if (!s->f_linebuf)
             return AVERROR(ENOMEM);
         break;
@@ -570,7 +624,7 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
             return AVERROR(ENOMEM);
         break;
     case FF_DWT53:
-        s->i_linebuf = av_malloc_array((maxlen +  6), sizeof(*s->i_linebuf));
+        s->i_linebuf = av_malloc_array((maxlen +  6) * 4, sizeof(*s->i_linebuf));
         if (!s->i_linebuf)
             return AVERROR(ENOMEM);
         break;
@@ -30,6 +30,12 @@
 #include <stdint.h>
 
 #define FF_DWT_MAX_DECLVLS 32 ///< max number of decomposition levels
+/* Defines for 9/7 DWT lifting parameters.
+ * Parameters are in float. */
+#define F_LFTG_ALPHA  1.586134342059924f
+#define F_LFTG_BETA   0.052980118572961f
+#define F_LFTG_GAMMA  0.882911075530934f
+#define F_LFTG_DELTA  0.443506852043971f
 #define F_LFTG_K      1.230174104914001f
 #define F_LFTG_X      0.812893066115961f
 #define I_PRESHIFT 8
@@ -49,6 +55,11 @@ typedef struct DWTContext {
     uint8_t type;                        ///< 0 for 9/7; 1 for 5/3
     int32_t *i_linebuf;                  ///< int buffer used by transform
     float   *f_linebuf;                  ///< float buffer used by transform
+    /**
+     * Inverse lifting of 4 interleaved columns, used by the vertical pass
+     * of ff_dwt_decode() when set. See Jpeg2000DSPContext.dwt_lift_x4.
+     */
+    void (*lift_x4)(void *p, int i0, int i1);
 } DWTContext;
 
 /**
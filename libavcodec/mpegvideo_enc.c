@@ -38,6 +38,7 @@
 
 #include "libavutil/attributes.h"
 #include "libavutil/emms.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/intmath.h"
 #include "libavutil/mathematics.h"
@@ -551,6 +552,50 @@ static av_cold int init_slice_buffers(MPVMainEncContext *const m)
 }
 
 /* init video encoder */
+/**
+ * Settle the line sizes of the internal pictures and export them, so that
+ * input frames from avcodec_get_encoder_frame_pool() can be used without
+ * copying by load_input_picture().
+ */
+static av_cold int init_input_layout(MPVEncContext *const s)
+{
+    AVCodecContext *const avctx = s->c.avctx;
+    int stride_align[AV_NUM_DATA_POINTERS], linesizes[4], unaligned, ret;
+    int w = avctx->width  + 2 * EDGE_WIDTH;
+    int h = avctx->height + 2 * EDGE_WIDTH;
+    ptrdiff_t linesize[4];
+    size_t size[4];
+
+    /* Compute the layout ff_encode_alloc_frame() gives the pictures of
+     * alloc_picture(), which checks that they match. */
+    avcodec_align_dimensions2(avctx, &w, &h, stride_align);
+    do {
+        ret = av_image_fill_linesizes(linesizes, avctx->pix_fmt, w);
+        if (ret < 0)
+            return ret;
+        w += w & ~(w - 1);
+
+        unaligned = 0;
+        for (int i = 0; i < 4; i++)
+            unaligned |= linesizes[i] % stride_align[i];
+    } while (unaligned);
+
+    for (int i = 0; i < 4; i++)
+        linesize[i] = linesizes[i];
+    ret = av_image_fill_plane_sizes(size, avctx->pix_fmt, h, linesize);
+    if (ret < 0)
+        return ret;
+
+    s->c.linesize   = linesize[0];
+    s->c.uvlinesize = linesize[1];
+
+    if ((s->c.width & 15) || (s->c.height & 15) ||
+        (s->c.linesize & (STRIDE_ALIGN - 1)))
+        return 0;
+
+    return ff_encode_set_input_linesizes(avctx, linesize);
+}
+
 av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
 {
     MPVMainEncContext *const m = avctx->priv_data;
@@ -1075,6 +1120,10 @@ av_cold int ff_mpv_encode_init(AVCodecContext *avctx)
         }
     }
 
+    ret = init_input_layout(s);
+    if (ret < 0)
+        return ret;
+
     cpb_props = ff_encode_add_cpb_side_data(avctx);
     if (!cpb_props)
         return AVERROR(ENOMEM);
@@ -1486,31 +1535,134 @@ static int encode_frame(AVCodecContext *c, const AVFrame *frame, AVPacket *pkt)
     return size;
 }
 
-static int estimate_best_b_count(MPVMainEncContext *const m)
+typedef struct BCountContext {
+    MPVMainEncContext *m;
+    int width, height;
+    int p_lambda, b_lambda, lambda2;
+    int64_t rd[MPVENC_MAX_B_FRAMES + 1];
+} BCountContext;
+
+/**
+ * Encode the downscaled frames with j B-frames between P-frames and store
+ * the rate-distortion cost in rd[j]. Every trial has its own encoder and
+ * its own references to the downscaled frames, so trials can run in parallel.
+ */
+static int estimate_b_count_trial(AVCodecContext *avctx, void *arg,
+                                  int j, int threadnr)
 {
+    BCountContext *const bc = arg;
+    MPVMainEncContext *const m = bc->m;
     MPVEncContext *const s = &m->s;
+    AVFrame *frames[MPVENC_MAX_B_FRAMES + 2] = { NULL };
+    AVCodecContext *c;
     AVPacket *pkt;
+    int64_t rd = 0;
+    int out_size, ret = 0;
+
+    pkt = av_packet_alloc();
+    c   = avcodec_alloc_context3(NULL);
+    if (!pkt || !c) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    for (int i = 0; i < m->max_b_frames + 2; i++) {
+        frames[i] = av_frame_alloc();
+        if (!frames[i]) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        ret = av_frame_ref(frames[i], m->tmp_frames[i]);
+        if (ret < 0)
+            goto fail;
+    }
+
+    c->width        = bc->width;
+    c->height       = bc->height;
+    c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
+    c->flags       |= s->c.avctx->flags & AV_CODEC_FLAG_QPEL;
+    c->mb_decision  = s->c.avctx->mb_decision;
+    c->me_cmp       = s->c.avctx->me_cmp;
+    c->mb_cmp       = s->c.avctx->mb_cmp;
+    c->me_sub_cmp   = s->c.avctx->me_sub_cmp;
+    c->pix_fmt      = AV_PIX_FMT_YUV420P;
+    c->time_base    = s->c.avctx->time_base;
+    c->max_b_frames = m->max_b_frames;
+
+    ret = avcodec_open2(c, s->c.avctx->codec, NULL);
+    if (ret < 0)
+        goto fail;
+
+    frames[0]->pict_type = AV_PICTURE_TYPE_I;
+    frames[0]->quality   = 1 * FF_QP2LAMBDA;
+
+    out_size = encode_frame(c, frames[0], pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+
+    //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
+
+    for (int i = 0; i < m->max_b_frames + 1; i++) {
+        int is_p = i % (j + 1) == j || i == m->max_b_frames;
+
+        frames[i + 1]->pict_type = is_p ?
+                                   AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
+        frames[i + 1]->quality   = is_p ? bc->p_lambda : bc->b_lambda;
+
+        out_size = encode_frame(c, frames[i + 1], pkt);
+        if (out_size < 0) {
+            ret = out_size;
+            goto fail;
+        }
+
+        rd += (out_size * (uint64_t)bc->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    /* get the delayed frames */
+    out_size = encode_frame(c, NULL, pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+    rd += (out_size * (uint64_t)bc->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+
+    rd += c->error[0] + c->error[1] + c->error[2];
+
+    bc->rd[j] = rd;
+
+fail:
+    for (int i = 0; i < FF_ARRAY_ELEMS(frames); i++)
+        av_frame_free(&frames[i]);
+    avcodec_free_context(&c);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static int estimate_best_b_count(MPVMainEncContext *const m)
+{
+    MPVEncContext *const s = &m->s;
     const int scale = m->brd_scale;
-    int width  = s->c.width  >> scale;
-    int height = s->c.height >> scale;
-    int out_size, p_lambda, b_lambda, lambda2;
+    BCountContext bc = {
+        .m      = m,
+        .width  = s->c.width  >> scale,
+        .height = s->c.height >> scale,
+    };
+    int ret[MPVENC_MAX_B_FRAMES + 1];
     int64_t best_rd  = INT64_MAX;
     int best_b_count = -1;
-    int ret = 0;
+    int nb_trials;
 
     av_assert0(scale >= 0 && scale <= 3);
 
-    pkt = av_packet_alloc();
-    if (!pkt)
-        return AVERROR(ENOMEM);
-
-    p_lambda = m->last_lambda_for[AV_PICTURE_TYPE_P];
+    bc.p_lambda = m->last_lambda_for[AV_PICTURE_TYPE_P];
     //p_lambda * FFABS(s->c.avctx->b_quant_factor) + s->c.avctx->b_quant_offset;
-    b_lambda = m->last_lambda_for[AV_PICTURE_TYPE_B];
-    if (!b_lambda) // FIXME we should do this somewhere else
-        b_lambda = p_lambda;
-    lambda2  = (b_lambda * b_lambda + (1 << FF_LAMBDA_SHIFT) / 2) >>
-               FF_LAMBDA_SHIFT;
+    bc.b_lambda = m->last_lambda_for[AV_PICTURE_TYPE_B];
+    if (!bc.b_lambda) // FIXME we should do this somewhere else
+        bc.b_lambda = bc.p_lambda;
+    bc.lambda2  = (bc.b_lambda * bc.b_lambda + (1 << FF_LAMBDA_SHIFT) / 2) >>
+                  FF_LAMBDA_SHIFT;
 
     for (int i = 0; i < m->max_b_frames + 2; i++) {
         const MPVPicture *pre_input_ptr = i ? m->input_picture[i - 1] :
@@ -1530,103 +1682,38 @@ static int estimate_best_b_count(MPVMainEncContext *const m)
                                        m->tmp_frames[i]->linesize[0],
                                        data[0],
                                        pre_input_ptr->f->linesize[0],
-                                       width, height);
+                                       bc.width, bc.height);
             s->mpvencdsp.shrink[scale](m->tmp_frames[i]->data[1],
                                        m->tmp_frames[i]->linesize[1],
                                        data[1],
                                        pre_input_ptr->f->linesize[1],
-                                       width >> 1, height >> 1);
+                                       bc.width >> 1, bc.height >> 1);
             s->mpvencdsp.shrink[scale](m->tmp_frames[i]->data[2],
                                        m->tmp_frames[i]->linesize[2],
                                        data[2],
                                        pre_input_ptr->f->linesize[2],
-                                       width >> 1, height >> 1);
+                                       bc.width >> 1, bc.height >> 1);
         }
     }
 
-    for (int j = 0; j < m->max_b_frames + 1; j++) {
-        AVCodecContext *c;
-        int64_t rd = 0;
-
-        if (!m->input_picture[j])
+    for (nb_trials = 0; nb_trials < m->max_b_frames + 1; nb_trials++)
+        if (!m->input_picture[nb_trials])
             break;
 
-        c = avcodec_alloc_context3(NULL);
-        if (!c) {
-            ret = AVERROR(ENOMEM);
-            goto fail;
-        }
+    /* the trials are independent, run them on the slice threads;
+     * picking the first best in order keeps the result deterministic */
+    if (nb_trials)
+        s->c.avctx->execute2(s->c.avctx, estimate_b_count_trial, &bc, ret, nb_trials);
 
-        c->width        = width;
-        c->height       = height;
-        c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
-        c->flags       |= s->c.avctx->flags & AV_CODEC_FLAG_QPEL;
-        c->mb_decision  = s->c.avctx->mb_decision;
-        c->me_cmp       = s->c.avctx->me_cmp;
-        c->mb_cmp       = s->c.avctx->mb_cmp;
-        c->me_sub_cmp   = s->c.avctx->me_sub_cmp;
-        c->pix_fmt      = AV_PIX_FMT_YUV420P;
-        c->time_base    = s->c.avctx->time_base;
-        c->max_b_frames = m->max_b_frames;
-
-        ret = avcodec_open2(c, s->c.avctx->codec, NULL);
-        if (ret < 0)
-            goto fail;
-
-
-        m->tmp_frames[0]->pict_type = AV_PICTURE_TYPE_I;
-        m->tmp_frames[0]->quality   = 1 * FF_QP2LAMBDA;
-
-        out_size = encode_frame(c, m->tmp_frames[0], pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-
-        //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
-
-        for (int i = 0; i < m->max_b_frames + 1; i++) {
-            int is_p = i % (j + 1) == j || i == m->max_b_frames;
-
-            m->tmp_frames[i + 1]->pict_type = is_p ?
-                                     AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
-            m->tmp_frames[i + 1]->quality   = is_p ? p_lambda : b_lambda;
-
-            out_size = encode_frame(c, m->tmp_frames[i + 1], pkt);
-            if (out_size < 0) {
-                ret = out_size;
-                goto fail;
-            }
-
-            rd += (out_size * (uint64_t)lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
-
-        /* get the delayed frames */
-        out_size = encode_frame(c, NULL, pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-        rd += (out_size * (uint64_t)lambda2) >> (FF_LAMBDA_SHIFT - 3);
-
-        rd += c->error[0] + c->error[1] + c->error[2];
-
-        if (rd < best_rd) {
-            best_rd = rd;
+    for (int j = 0; j < nb_trials; j++) {
+        if (ret[j] < 0)
+            return ret[j];
+        if (bc.rd[j] < best_rd) {
+            best_rd = bc.rd[j];
             best_b_count = j;
         }
-
-fail:
-        avcodec_free_context(&c);
-        av_packet_unref(pkt);
-        if (ret < 0) {
-            best_b_count = ret;
-            break;
-        }
     }
 
-    av_packet_free(&pkt);
-
     return best_b_count;
 }
 
@@ -49,6 +49,17 @@
 #define PNGSIG 0x89504e470d0a1a0a
 #define MNGSIG 0x8a4d4e470d0a1a0a
 
+/**
+ * Private ancillary chunk listing restart points in the IDAT data.
+ * Each row range starts a new deflate block whose back references do not
+ * reach into the previous range (as after Z_FULL_FLUSH) and its first row
+ * does not use the row above for prediction, so ranges can be decoded
+ * independently. Payload: be32 count, then per range be32 first row and
+ * be32 offset of its deflate data in the concatenated IDAT payload.
+ */
+#define PNG_RESTART_TAG MKTAG('f', 'f', 'R', 'S')
+#define PNG_MAX_RESTARTS 256
+
 /* Mask to determine which y pixels are valid in a pass */
 extern const uint8_t ff_png_pass_ymask[NB_PASSES];
 
@@ -60,6 +60,12 @@ enum PNGImageState {
     PNG_ALLIMAGE = 1 << 1,
 };
 
+typedef struct PNGDecSlice {
+    FFZStream zstream;           ///< raw inflate stream
+    uint8_t *buffer;
+    unsigned int buffer_size;
+} PNGDecSlice;
+
 typedef struct PNGDecContext {
     PNGDSPContext dsp;
     AVCodecContext *avctx;
@@ -128,6 +134,24 @@ typedef struct PNGDecContext {
     int y;
     FFZStream zstream;
 
+    /* restart points, the IDAT data is gathered and decoded at once if set */
+    int nb_restarts;
+    uint32_t restart_row[PNG_MAX_RESTARTS];
+    uint32_t restart_offset[PNG_MAX_RESTARTS];
+    uint8_t *idat_buf;
+    unsigned int idat_buf_size;
+    size_t idat_size;
+    PNGDecSlice *slices;
+
+    /* pipelined decoding of the gathered IDAT data without restart points:
+     * one band of rows is inflated while the previous one is unfiltered */
+    uint8_t *band_buf[2];
+    unsigned int band_buf_size[2];
+    int band_nb_rows[2];
+    int band_max_rows;
+    int band_cur;       ///< band being unfiltered
+    int band_y;         ///< number of rows inflated so far
+
     AVBufferRef *exif_data;
 } PNGDecContext;
 
@@ -338,7 +362,8 @@ static int percent_missing(PNGDecContext *s)
 }
 
 /* process exactly one decompressed row */
-static void png_handle_row(PNGDecContext *s, uint8_t *dst, ptrdiff_t dst_stride)
+static void png_handle_row(PNGDecContext *s, const uint8_t *crow,
+                           uint8_t *dst, ptrdiff_t dst_stride)
 {
     uint8_t *ptr, *last_row;
     int got_line;
@@ -350,7 +375,7 @@ static void png_handle_row(PNGDecContext *s, uint8_t *dst, ptrdiff_t dst_stride)
         else
             last_row = ptr - dst_stride;
 
-        ff_png_filter_row(&s->dsp, ptr, s->crow_buf[0], s->crow_buf + 1,
+        ff_png_filter_row(&s->dsp, ptr, crow[0], crow + 1,
                           last_row, s->row_size, s->bpp);
         /* loco lags by 1 row so that it doesn't interfere with top prediction */
         if (s->filter_type == PNG_FILTER_TYPE_LOCO && s->y > 0) {
@@ -384,7 +409,7 @@ static void png_handle_row(PNGDecContext *s, uint8_t *dst, ptrdiff_t dst_stride)
                  * wait for the next one */
                 if (got_line)
                     break;
-                ff_png_filter_row(&s->dsp, s->tmp_row, s->crow_buf[0], s->crow_buf + 1,
+                ff_png_filter_row(&s->dsp, s->tmp_row, crow[0], crow + 1,
                                   s->last_row, s->pass_row_size, s->bpp);
                 FFSWAP(uint8_t *, s->last_row, s->tmp_row);
                 FFSWAP(unsigned int, s->last_row_size, s->tmp_row_size);
@@ -436,7 +461,7 @@ static int png_decode_idat(PNGDecContext *s, GetByteContext *gb,
         }
         if (zstream->avail_out == 0) {
             if (!(s->pic_state & PNG_ALLIMAGE)) {
-                png_handle_row(s, dst, dst_stride);
+                png_handle_row(s, s->crow_buf, dst, dst_stride);
             }
             zstream->avail_out = s->crow_size;
             zstream->next_out  = s->crow_buf;
@@ -450,6 +475,227 @@ static int png_decode_idat(PNGDecContext *s, GetByteContext *gb,
     return 0;
 }
 
+static int png_gather_idat(PNGDecContext *s, GetByteContext *gb)
+{
+    int len = bytestream2_get_bytes_left(gb);
+    uint8_t *buf;
+
+    if (len > INT_MAX - s->idat_size)
+        return AVERROR_INVALIDDATA;
+    buf = av_fast_realloc(s->idat_buf, &s->idat_buf_size, s->idat_size + len);
+    if (!buf)
+        return AVERROR(ENOMEM);
+    s->idat_buf = buf;
+    memcpy(s->idat_buf + s->idat_size, gb->buffer, len);
+    s->idat_size += len;
+    return 0;
+}
+
+static int png_decode_restart_range(AVCodecContext *avctx, void *arg,
+                                    int jobnr, int threadnr)
+{
+    PNGDecContext *const s  = avctx->priv_data;
+    AVFrame *const p        = arg;
+    PNGDecSlice *const sl   = &s->slices[jobnr];
+    z_stream *const zstream = &sl->zstream.zstream;
+    const int last          = jobnr == s->nb_restarts - 1;
+    const int y1            = last ? s->cur_h : s->restart_row[jobnr + 1];
+    const size_t end        = last ? s->idat_size : s->restart_offset[jobnr + 1];
+    const ptrdiff_t stride  = p->linesize[0];
+    uint8_t *crow;
+
+    if (end > s->idat_size || s->restart_offset[jobnr] >= end)
+        return AVERROR_INVALIDDATA;
+
+    av_fast_padded_malloc(&sl->buffer, &sl->buffer_size, s->row_size + 16);
+    if (!sl->buffer)
+        return AVERROR(ENOMEM);
+    /* we want crow+1 to be 16-byte aligned */
+    crow = sl->buffer + 15;
+
+    if (inflateReset(zstream) != Z_OK)
+        return AVERROR_EXTERNAL;
+    zstream->next_in  = s->idat_buf + s->restart_offset[jobnr];
+    zstream->avail_in = end - s->restart_offset[jobnr];
+
+    for (int y = s->restart_row[jobnr]; y < y1; y++) {
+        uint8_t *ptr = p->data[0] + y * stride;
+        int ret;
+
+        zstream->next_out  = crow;
+        zstream->avail_out = s->crow_size;
+        ret = inflate(zstream, Z_SYNC_FLUSH);
+        if ((ret != Z_OK && ret != Z_STREAM_END) || zstream->avail_out)
+            return AVERROR_INVALIDDATA;
+
+        /* the rows above belong to another range */
+        if (y == s->restart_row[jobnr] && jobnr && crow[0] > PNG_FILTER_VALUE_SUB)
+            return AVERROR_INVALIDDATA;
+
+        ff_png_filter_row(&s->dsp, ptr, crow[0], crow + 1,
+                          y ? ptr - stride : s->last_row, s->row_size, s->bpp);
+    }
+    return 0;
+}
+
+/**
+ * Decode the gathered IDAT data, the row ranges of the restart chunk in
+ * parallel. Falls back to decoding the whole stream serially if the restart
+ * points turn out to be unusable.
+ */
+static int png_decode_restarts(AVCodecContext *avctx, PNGDecContext *s, AVFrame *p)
+{
+    size_t byte_depth = s->bit_depth > 8 ? 2 : 1;
+    int ret[PNG_MAX_RESTARTS], err = 0;
+
+    if (!s->slices) {
+        s->slices = av_calloc(PNG_MAX_RESTARTS, sizeof(*s->slices));
+        if (!s->slices)
+            return AVERROR(ENOMEM);
+    }
+    for (int i = 0; i < s->nb_restarts; i++) {
+        if (!s->slices[i].zstream.inited) {
+            err = ff_inflate_init2(&s->slices[i].zstream, -MAX_WBITS, avctx);
+            if (err < 0)
+                return err;
+        }
+    }
+
+    /* set image to non-transparent bpp while decompressing */
+    if (s->has_trns && s->color_type != PNG_COLOR_TYPE_PALETTE)
+        s->bpp -= byte_depth;
+
+    avctx->execute2(avctx, png_decode_restart_range, p, ret, s->nb_restarts);
+    for (int i = 0; i < s->nb_restarts; i++)
+        if (ret[i] < 0)
+            err = ret[i];
+
+    if (err < 0) {
+        GetByteContext gb;
+
+        av_log(avctx, AV_LOG_WARNING, "Unusable restart points, decoding serially\n");
+        bytestream2_init(&gb, s->idat_buf, s->idat_size);
+        s->zstream.zstream.avail_out = s->crow_size;
+        s->zstream.zstream.next_out  = s->crow_buf;
+        err = png_decode_idat(s, &gb, p->data[0], p->linesize[0]);
+    } else {
+        s->y = s->cur_h;
+        s->pic_state |= PNG_ALLIMAGE;
+    }
+
+    if (s->has_trns && s->color_type != PNG_COLOR_TYPE_PALETTE)
+        s->bpp += byte_depth;
+
+    s->idat_size = 0;
+    return err;
+}
+
+/* size of a band of rows in pipelined decoding */
+#define PNG_BAND_SIZE (256 * 1024)
+
+/**
+ * Whether the IDAT data of a PNG without restart points is gathered and
+ * decoded by inflating and unfiltering on separate slice threads.
+ */
+static int png_pipelined(AVCodecContext *avctx, const PNGDecContext *s)
+{
+    return avctx->codec_id == AV_CODEC_ID_PNG &&
+           (avctx->active_thread_type & FF_THREAD_SLICE) &&
+           avctx->thread_count > 1 && !s->interlace_type;
+}
+
+static int png_inflate_band(PNGDecContext *s, int band)
+{
+    z_stream *const zstream = &s->zstream.zstream;
+    const ptrdiff_t stride  = FFALIGN(s->crow_size, 16);
+    int n;
+
+    for (n = 0; n < s->band_max_rows && s->band_y < s->cur_h; n++) {
+        /* we want crow+1 to be 16-byte aligned */
+        zstream->next_out  = s->band_buf[band] + n * stride + 15;
+        zstream->avail_out = s->crow_size;
+        while (zstream->avail_out && zstream->avail_in) {
+            int ret = inflate(zstream, Z_PARTIAL_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END) {
+                av_log(s->avctx, AV_LOG_ERROR, "inflate returned error %d\n", ret);
+                return AVERROR_EXTERNAL;
+            }
+            if (ret == Z_STREAM_END)
+                break;
+        }
+        if (zstream->avail_out)
+            break;
+        s->band_y++;
+    }
+    s->band_nb_rows[band] = n;
+    return 0;
+}
+
+static int png_decode_band(AVCodecContext *avctx, void *arg,
+                           int jobnr, int threadnr)
+{
+    PNGDecContext *const s = avctx->priv_data;
+    AVFrame *const p       = arg;
+    const int band         = s->band_cur;
+    const ptrdiff_t stride = FFALIGN(s->crow_size, 16);
+
+    if (!jobnr)
+        return png_inflate_band(s, !band);
+
+    for (int i = 0; i < s->band_nb_rows[band] && !(s->pic_state & PNG_ALLIMAGE); i++)
+        png_handle_row(s, s->band_buf[band] + i * stride + 15,
+                       p->data[0], p->linesize[0]);
+    return 0;
+}
+
+/**
+ * Decode the gathered IDAT data of a PNG without restart points, inflating
+ * each band of rows while the previous one is unfiltered.
+ */
+static int png_decode_pipelined(AVCodecContext *avctx, PNGDecContext *s, AVFrame *p)
+{
+    z_stream *const zstream = &s->zstream.zstream;
+    const ptrdiff_t stride  = FFALIGN(s->crow_size, 16);
+    size_t byte_depth = s->bit_depth > 8 ? 2 : 1;
+    int ret[2], err;
+
+    s->band_max_rows = av_clip(PNG_BAND_SIZE / stride, 1, s->cur_h);
+    for (int i = 0; i < 2; i++) {
+        av_fast_padded_malloc(&s->band_buf[i], &s->band_buf_size[i],
+                              s->band_max_rows * stride + 16);
+        if (!s->band_buf[i])
+            return AVERROR(ENOMEM);
+    }
+
+    /* set image to non-transparent bpp while decompressing */
+    if (s->has_trns && s->color_type != PNG_COLOR_TYPE_PALETTE)
+        s->bpp -= byte_depth;
+
+    zstream->next_in  = s->idat_buf;
+    zstream->avail_in = s->idat_size;
+    s->band_y   = s->y;
+    s->band_cur = 1;
+    err = png_inflate_band(s, 0);
+
+    while (err >= 0 && s->band_nb_rows[!s->band_cur]) {
+        s->band_cur = !s->band_cur;
+        avctx->execute2(avctx, png_decode_band, p, ret, 2);
+        err = ret[0];
+    }
+
+    if (s->has_trns && s->color_type != PNG_COLOR_TYPE_PALETTE)
+        s->bpp += byte_depth;
+
+    s->idat_size = 0;
+    return err;
+}
+
+static int png_decode_gathered(AVCodecContext *avctx, PNGDecContext *s, AVFrame *p)
+{
+    return s->nb_restarts ? png_decode_restarts(avctx, s, p) :
+                            png_decode_pipelined(avctx, s, p);
+}
+
 /* Hard cap on decompressed zTXt/iCCP payloads to defeat decompression bombs. */
 #define PNG_ZBUF_MAX_DECOMPRESSED (16 * 1024 * 1024)
 
@@ -1064,7 +1310,10 @@ static int decode_idat_chunk(AVCodecContext *avctx, PNGDecContext *s,
     if (s->has_trns && s->color_type != PNG_COLOR_TYPE_PALETTE)
         s->bpp -= byte_depth;
 
-    ret = png_decode_idat(s, gb, p->data[0], p->linesize[0]);
+    if (s->nb_restarts || png_pipelined(avctx, s))
+        ret = png_gather_idat(s, gb);
+    else
+        ret = png_decode_idat(s, gb, p->data[0], p->linesize[0]);
 
     if (s->has_trns && s->color_type != PNG_COLOR_TYPE_PALETTE)
         s->bpp += byte_depth;
@@ -1075,6 +1324,43 @@ static int decode_idat_chunk(AVCodecContext *avctx, PNGDecContext *s,
     return 0;
 }
 
+static int decode_restart_chunk(AVCodecContext *avctx, PNGDecContext *s,
+                                GetByteContext *gb)
+{
+    unsigned n;
+
+    /* only useful with slice threads, and an optional chunk: ignore it
+     * unless it describes independent ranges of a plain PNG */
+    if (avctx->codec_id != AV_CODEC_ID_PNG ||
+        !(avctx->active_thread_type & FF_THREAD_SLICE) ||
+        !(s->hdr_state & PNG_IHDR) || (s->pic_state & PNG_IDAT) ||
+        s->interlace_type || s->filter_type == PNG_FILTER_TYPE_LOCO)
+        return 0;
+
+    n = bytestream2_get_be32(gb);
+    if (n < 2 || n > PNG_MAX_RESTARTS || n > s->cur_h ||
+        bytestream2_get_bytes_left(gb) < 8 * n)
+        goto invalid;
+
+    for (int i = 0; i < n; i++) {
+        s->restart_row[i]    = bytestream2_get_be32u(gb);
+        s->restart_offset[i] = bytestream2_get_be32u(gb);
+        /* the first range starts after the zlib header */
+        if (i ? s->restart_row[i]    <= s->restart_row[i - 1] ||
+                s->restart_offset[i] <= s->restart_offset[i - 1] :
+                s->restart_row[i] != 0 || s->restart_offset[i] < 2)
+            goto invalid;
+    }
+    if (s->restart_row[n - 1] >= s->cur_h)
+        goto invalid;
+
+    s->nb_restarts = n;
+    return 0;
+invalid:
+    av_log(avctx, AV_LOG_WARNING, "Ignoring invalid restart chunk\n");
+    return 0;
+}
+
 static int decode_plte_chunk(AVCodecContext *avctx, PNGDecContext *s,
                              GetByteContext *gb)
 {
@@ -1503,6 +1789,8 @@ static int decode_frame_common(AVCodecContext *avctx, PNGDecContext *s,
 
         length = bytestream2_get_bytes_left(&s->gb);
         if (length <= 0) {
+            if (s->idat_size && (ret = png_decode_gathered(avctx, s, p)) < 0)
+                goto fail;
 
             if (avctx->codec_id == AV_CODEC_ID_PNG &&
                 avctx->skip_frame == AVDISCARD_ALL) {
@@ -1710,7 +1998,13 @@ static int decode_frame_common(AVCodecContext *avctx, PNGDecContext *s,
             if (ret < 0)
                 goto fail;
             break;
+        case PNG_RESTART_TAG:
+            if ((ret = decode_restart_chunk(avctx, s, &gb_chunk)) < 0)
+                goto fail;
+            break;
         case MKTAG('I', 'E', 'N', 'D'):
+            if (s->idat_size && (ret = png_decode_gathered(avctx, s, p)) < 0)
+                goto fail;
             if (!(s->pic_state & PNG_ALLIMAGE))
                 av_log(avctx, AV_LOG_ERROR, "IEND without all image\n");
             if (!(s->pic_state & (PNG_ALLIMAGE|PNG_IDAT))) {
@@ -1898,6 +2192,8 @@ static int decode_frame_png(AVCodecContext *avctx, AVFrame *p,
     s->y = s->has_trns = 0;
     s->hdr_state = 0;
     s->pic_state = 0;
+    s->nb_restarts = 0;
+    s->idat_size   = 0;
 
     /* Reset z_stream */
     ret = inflateReset(&s->zstream.zstream);
@@ -2039,6 +2335,19 @@ static av_cold int png_dec_end(AVCodecContext *avctx)
     s->last_row_size = 0;
     av_freep(&s->tmp_row);
     s->tmp_row_size = 0;
+    av_freep(&s->idat_buf);
+    s->idat_buf_size = 0;
+    if (s->slices) {
+        for (int i = 0; i < PNG_MAX_RESTARTS; i++) {
+            ff_inflate_end(&s->slices[i].zstream);
+            av_freep(&s->slices[i].buffer);
+        }
+        av_freep(&s->slices);
+    }
+    for (int i = 0; i < 2; i++) {
+        av_freep(&s->band_buf[i]);
+        s->band_buf_size[i] = 0;
+    }
 
     av_freep(&s->iccp_data);
     av_buffer_unref(&s->exif_data);
@@ -2077,7 +2386,8 @@ const FFCodec ff_png_decoder = {
     .close          = png_dec_end,
     FF_CODEC_DECODE_CB(decode_frame_png),
     UPDATE_THREAD_CONTEXT(update_thread_context),
-    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal  = FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM |
                       FF_CODEC_CAP_INIT_CLEANUP |
                       FF_CODEC_CAP_USES_PROGRESSFRAMES |
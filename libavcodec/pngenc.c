@@ -52,6 +52,16 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+typedef struct PNGEncSlice {
+    FFZStream zstream;           ///< raw deflate stream
+    uint8_t *crow_base;
+    unsigned int crow_base_size;
+    uint8_t *buf;                ///< compressed data, with room for the zlib header and trailer
+    unsigned int buf_size;
+    int size;                    ///< bytes of deflate data in buf
+    uint32_t adler;              ///< adler32 of the uncompressed rows
+} PNGEncSlice;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -74,6 +84,9 @@ typedef struct PNGEncContext {
 
     AVBufferRef *exif_data;
 
+    PNGEncSlice *slices;         ///< independently compressed row ranges
+    int nb_slices;
+
     // APNG
     uint32_t palette_checksum;   // Used to ensure a single unique palette
     uint32_t sequence_number;
@@ -518,6 +531,123 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int encode_slice(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s        = avctx->priv_data;
+    const AVFrame *const p  = arg;
+    PNGEncSlice *const sl   = &s->slices[jobnr];
+    z_stream *const zstream = &sl->zstream.zstream;
+    const int row_size = (p->width * s->bits_per_pixel + 7) >> 3;
+    const int y0 = p->height *  jobnr      / s->nb_slices;
+    const int y1 = p->height * (jobnr + 1) / s->nb_slices;
+    const uint8_t *top = NULL;
+    uint8_t *crow_buf, *crow;
+    uLong bound;
+    int ret;
+
+    bound = deflateBound(zstream, (uLong)(y1 - y0) * (row_size + 1));
+    if (bound > INT_MAX - 32)
+        return AVERROR(EINVAL);
+    av_fast_malloc(&sl->buf, &sl->buf_size, bound + 32);
+    av_fast_malloc(&sl->crow_base, &sl->crow_base_size,
+                   (row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+    if (!sl->buf || !sl->crow_base)
+        return AVERROR(ENOMEM);
+    // pixel data should be aligned, but there's a control byte before it
+    crow_buf = sl->crow_base + 15;
+
+    /* 2 bytes are reserved for the zlib header */
+    zstream->next_out  = sl->buf + 2;
+    zstream->avail_out = bound + 16;
+    sl->adler          = adler32(0, NULL, 0);
+
+    /* the first row of a range must not predict from the previous range */
+    for (int y = y0; y < y1; y++) {
+        const uint8_t *ptr = p->data[0] + y * p->linesize[0];
+        crow = png_choose_filter(s, crow_buf, ptr, top,
+                                 row_size, s->bits_per_pixel >> 3);
+        sl->adler = adler32(sl->adler, crow, row_size + 1);
+        zstream->next_in  = crow;
+        zstream->avail_in = row_size + 1;
+        if (deflate(zstream, Z_NO_FLUSH) != Z_OK || zstream->avail_in) {
+            ret = AVERROR_EXTERNAL;
+            goto end;
+        }
+        top = ptr;
+    }
+
+    /* only the last range ends the stream, the others end byte-aligned
+     * on a non-final block */
+    ret = deflate(zstream, jobnr == s->nb_slices - 1 ? Z_FINISH : Z_FULL_FLUSH);
+    if (ret != (jobnr == s->nb_slices - 1 ? Z_STREAM_END : Z_OK) ||
+        !zstream->avail_out) {
+        ret = AVERROR_EXTERNAL;
+        goto end;
+    }
+    sl->size = zstream->next_out - (sl->buf + 2);
+    ret = 0;
+
+end:
+    deflateReset(zstream);
+    return ret;
+}
+
+/**
+ * Compress the row ranges in parallel, each as its own raw deflate stream,
+ * and join them into one zlib stream, announced by a restart chunk.
+ */
+static int encode_frame_slices(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s = avctx->priv_data;
+    uint8_t buf[4 + 8 * PNG_MAX_RESTARTS], *ptr = buf;
+    PNGEncSlice *last = &s->slices[s->nb_slices - 1];
+    int level = avctx->compression_level == FF_COMPRESSION_DEFAULT ? 6 :
+                av_clip(avctx->compression_level, 0, 9);
+    uint32_t adler;
+    int header, offset = 2, ret[PNG_MAX_RESTARTS];
+
+    avctx->execute2(avctx, encode_slice, (void *)pict, ret, s->nb_slices);
+    for (int i = 0; i < s->nb_slices; i++)
+        if (ret[i] < 0)
+            return ret[i];
+
+    bytestream_put_be32(&ptr, s->nb_slices);
+    for (int i = 0; i < s->nb_slices; i++) {
+        bytestream_put_be32(&ptr, pict->height * i / s->nb_slices);
+        bytestream_put_be32(&ptr, offset);
+        offset += s->slices[i].size;
+    }
+    png_write_chunk(&s->bytestream, PNG_RESTART_TAG, buf, ptr - buf);
+
+    /* zlib header, with the compression level hint deflate would write */
+    header  = 0x7800 | (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+    header += 31 - header % 31;
+    AV_WB16(s->slices[0].buf, header);
+
+    adler = s->slices[0].adler;
+    for (int i = 1; i < s->nb_slices; i++) {
+        int y0 = pict->height *  i      / s->nb_slices;
+        int y1 = pict->height * (i + 1) / s->nb_slices;
+        int row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
+        adler = adler32_combine(adler, s->slices[i].adler,
+                                (z_off_t)(y1 - y0) * (row_size + 1));
+    }
+    AV_WB32(last->buf + 2 + last->size, adler);
+    last->size += 4;
+
+    for (int i = 0; i < s->nb_slices; i++) {
+        PNGEncSlice *sl = &s->slices[i];
+        if (i)
+            png_write_chunk(&s->bytestream, MKTAG('I', 'D', 'A', 'T'),
+                            sl->buf + 2, sl->size);
+        else
+            png_write_chunk(&s->bytestream, MKTAG('I', 'D', 'A', 'T'),
+                            sl->buf, sl->size + 2);
+    }
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -689,6 +819,9 @@ static int encode_png(AVCodecContext *avctx, AVPacket *pkt,
             enc_row_size +
             12 * (((int64_t)enc_row_size + IOBUF_SIZE - 1) / IOBUF_SIZE) // IDAT * ceil(enc_row_size / IOBUF_SIZE)
         );
+    if (s->nb_slices > 1)
+        max_packet_size += 12 + 4 + 8 * s->nb_slices +  // restart chunk
+                           (12 + 6 + 16) * s->nb_slices; // IDAT and flushes
     if ((ret = add_icc_profile_size(avctx, pict, &max_packet_size)))
         return ret;
     ret = add_exif_profile_size(avctx, pict, &max_packet_size);
@@ -710,7 +843,10 @@ static int encode_png(AVCodecContext *avctx, AVPacket *pkt,
     if (ret < 0)
         return ret;
 
-    ret = encode_frame(avctx, pict);
+    if (s->nb_slices > 1)
+        ret = encode_frame_slices(avctx, pict);
+    else
+        ret = encode_frame(avctx, pict);
     if (ret < 0)
         return ret;
 
@@ -1247,6 +1383,21 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
     compression_level = avctx->compression_level == FF_COMPRESSION_DEFAULT
                       ? Z_DEFAULT_COMPRESSION
                       : av_clip(avctx->compression_level, 0, 9);
+
+    if (avctx->codec_id == AV_CODEC_ID_PNG && avctx->slices > 1 &&
+        !s->is_progressive) {
+        s->nb_slices = FFMIN3(avctx->slices, avctx->height, PNG_MAX_RESTARTS);
+        s->slices    = av_calloc(s->nb_slices, sizeof(*s->slices));
+        if (!s->slices)
+            return AVERROR(ENOMEM);
+        for (int i = 0; i < s->nb_slices; i++) {
+            int ret = ff_deflate_init2(&s->slices[i].zstream, compression_level,
+                                       -MAX_WBITS, avctx);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
     return ff_deflate_init(&s->zstream, compression_level, avctx);
 }
 
@@ -1255,6 +1406,12 @@ static av_cold int png_enc_close(AVCodecContext *avctx)
     PNGEncContext *s = avctx->priv_data;
 
     ff_deflate_end(&s->zstream);
+    for (int i = 0; i < s->nb_slices; i++) {
+        ff_deflate_end(&s->slices[i].zstream);
+        av_freep(&s->slices[i].crow_base);
+        av_freep(&s->slices[i].buf);
+    }
+    av_freep(&s->slices);
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_buffer_unref(&s->exif_data);
@@ -1292,6 +1449,7 @@ const FFCodec ff_png_encoder = {
     .p.type         = AVMEDIA_TYPE_VIDEO,
     .p.id           = AV_CODEC_ID_PNG,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS |
                       AV_CODEC_CAP_ENCODER_REORDERED_OPAQUE,
     .priv_data_size = sizeof(PNGEncContext),
     .init           = png_enc_init,
@@ -1305,7 +1463,7 @@ const FFCodec ff_png_encoder = {
                   AV_PIX_FMT_MONOBLACK),
     .alpha_modes    = AVALPHA_MODE_STRAIGHT,
     .p.priv_class   = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_ICC_PROFILES,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES,
 };
 
 const FFCodec ff_apng_encoder = {
@@ -1326,5 +1484,5 @@ const FFCodec ff_apng_encoder = {
                   AV_PIX_FMT_GRAY16BE, AV_PIX_FMT_YA16BE),
     .alpha_modes    = AVALPHA_MODE_STRAIGHT,
     .p.priv_class   = &pngenc_class,
-    .caps_internal  = FF_CODEC_CAP_ICC_PROFILES,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP | FF_CODEC_CAP_ICC_PROFILES,
 };
@@ -116,9 +116,15 @@ av_cold int ff_slice_thread_init(AVCodecContext *avctx)
 {
     SliceThreadContext *c;
     int thread_count = avctx->thread_count;
+    int caps_internal = ffcodec(avctx->codec)->caps_internal;
     int (*mainfunc)(void *);
+    /* jobs waiting on each other could wait forever for a busy pool thread */
+    int use_pool = avctx->thread_pool &&
+                   !(caps_internal & (FF_CODEC_CAP_SLICE_THREAD_HAS_MF |
+                                      FF_CODEC_CAP_SLICE_THREAD_SYNC));
 
-    if (!thread_count) {
+    /* with a pool, the default is derived from the pool size */
+    if (!thread_count && !use_pool) {
         int nb_cpus = av_cpu_count();
         if  (avctx->height)
             nb_cpus = FFMIN(nb_cpus, (avctx->height+15)/16);
@@ -129,7 +135,7 @@ av_cold int ff_slice_thread_init(AVCodecContext *avctx)
             thread_count = avctx->thread_count = 1;
     }
 
-    if (thread_count <= 1) {
+    if (thread_count == 1) {
         avctx->active_thread_type = 0;
         return 0;
     }
@@ -137,9 +143,14 @@ av_cold int ff_slice_thread_init(AVCodecContext *avctx)
     avctx->internal->thread_ctx = c = av_mallocz(sizeof(*c));
     if (!c)
         return AVERROR(ENOMEM);
-    mainfunc = ffcodec(avctx->codec)->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
-    thread_count = avpriv_slicethread_create2(&c->thread, avctx, worker_func,
-                                              mainfunc, thread_count);
+    mainfunc = caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
+    if (use_pool)
+        thread_count = avpriv_slicethread_create_pool(&c->thread, avctx->thread_pool,
+                                                      avctx, worker_func, mainfunc,
+                                                      thread_count);
+    else
+        thread_count = avpriv_slicethread_create2(&c->thread, avctx, worker_func,
+                                                  mainfunc, thread_count);
     if (thread_count <= 1) {
         ff_slice_thread_free(avctx);
         avctx->thread_count = 1;
@@ -134,6 +134,10 @@ int main(void){
             !(codec->capabilities & AV_CODEC_CAP_SLICE_THREADS))
             ERR("Codec %s wants mainfunction despite not being "
                 "slice-threading capable");
+        if (codec2->caps_internal  & FF_CODEC_CAP_SLICE_THREAD_SYNC &&
+            !(codec->capabilities & AV_CODEC_CAP_SLICE_THREADS))
+            ERR("Codec %s has synchronized slice threading jobs despite not "
+                "being slice-threading capable");
         if (codec2->caps_internal  & FF_CODEC_CAP_AUTO_THREADS &&
             !(codec->capabilities & (AV_CODEC_CAP_FRAME_THREADS |
                                      AV_CODEC_CAP_SLICE_THREADS |
@@ -0,0 +1,185 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Encode a PNG with restart points, then decode it with slice threads after
+ * corrupting its restart chunk. Invalid restart points must be rejected and
+ * the image decoded serially, identical to the intact file.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/crc.h"
+#include "libavutil/frame.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/png.h"
+
+#define WIDTH  64
+#define HEIGHT 64
+#define SLICES 4
+
+static int encode(AVPacket *pkt)
+{
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_PNG);
+    AVCodecContext *avctx = avcodec_alloc_context3(codec);
+    AVFrame *frame = av_frame_alloc();
+    int ret;
+
+    if (!avctx || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    avctx->width   = frame->width  = WIDTH;
+    avctx->height  = frame->height = HEIGHT;
+    avctx->pix_fmt = frame->format = AV_PIX_FMT_RGB24;
+    avctx->time_base = (AVRational){ 1, 25 };
+    avctx->slices  = SLICES;
+
+    if ((ret = avcodec_open2(avctx, codec, NULL)) < 0 ||
+        (ret = av_frame_get_buffer(frame, 0)) < 0)
+        goto end;
+
+    for (int y = 0; y < HEIGHT; y++)
+        for (int x = 0; x < 3 * WIDTH; x++)
+            frame->data[0][y * frame->linesize[0] + x] = x * 7 + y * 13 + (x * y >> 3);
+
+    if ((ret = avcodec_send_frame(avctx, frame)) >= 0)
+        ret = avcodec_receive_packet(avctx, pkt);
+end:
+    av_frame_free(&frame);
+    avcodec_free_context(&avctx);
+    return ret;
+}
+
+static int decode(const AVPacket *pkt, AVFrame *frame)
+{
+    const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_PNG);
+    AVCodecContext *avctx = avcodec_alloc_context3(codec);
+    int ret;
+
+    if (!avctx)
+        return AVERROR(ENOMEM);
+
+    avctx->thread_count = 2;
+    avctx->thread_type  = FF_THREAD_SLICE;
+
+    if ((ret = avcodec_open2(avctx, codec, NULL)) >= 0 &&
+        (ret = avcodec_send_packet(avctx, pkt)) >= 0)
+        ret = avcodec_receive_frame(avctx, frame);
+
+    avcodec_free_context(&avctx);
+    return ret;
+}
+
+/* returns the offset of the data of the restart chunk, or 0 */
+static size_t find_restart_chunk(const AVPacket *pkt)
+{
+    size_t pos = 8;
+
+    while (pos + 12 <= pkt->size) {
+        uint32_t len = AV_RB32(pkt->data + pos);
+
+        if (AV_RL32(pkt->data + pos + 4) == PNG_RESTART_TAG)
+            return pos + 8;
+        pos += 12 + (size_t)len;
+    }
+    return 0;
+}
+
+static int compare(const AVFrame *a, const AVFrame *b)
+{
+    for (int y = 0; y < HEIGHT; y++)
+        if (memcmp(a->data[0] + y * a->linesize[0],
+                   b->data[0] + y * b->linesize[0], 3 * WIDTH))
+            return 1;
+    return 0;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        int         idx;
+        uint32_t    offset;
+    } tests[] = {
+        /* the last range would start past the end of the IDAT data */
+        { "last offset past the data",     SLICES - 1, 0x7fffffff },
+        /* the first range would include the zlib header */
+        { "first offset in the header",    0,          0 },
+    };
+    const AVCRC *crc_table = av_crc_get_table(AV_CRC_32_IEEE_LE);
+    AVPacket *pkt = av_packet_alloc(), *bad = av_packet_alloc();
+    AVFrame *ref = av_frame_alloc(), *frame = av_frame_alloc();
+    size_t restart;
+    int ret = 1;
+
+    av_log_set_level(AV_LOG_ERROR);
+
+    if (!pkt || !bad || !ref || !frame)
+        goto end;
+
+    if (encode(pkt) < 0 || !(restart = find_restart_chunk(pkt))) {
+        fprintf(stderr, "Failed to encode a PNG with restart points\n");
+        goto end;
+    }
+    if (AV_RB32(pkt->data + restart) != SLICES) {
+        fprintf(stderr, "Unexpected number of restart points\n");
+        goto end;
+    }
+    if (decode(pkt, ref) < 0) {
+        fprintf(stderr, "Failed to decode the intact PNG\n");
+        goto end;
+    }
+
+    ret = 0;
+    for (int i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        uint32_t len;
+        int err;
+
+        av_packet_unref(bad);
+        av_frame_unref(frame);
+        if (av_packet_ref(bad, pkt) < 0 || av_packet_make_writable(bad) < 0) {
+            ret = 1;
+            break;
+        }
+
+        len = AV_RB32(bad->data + restart - 8);
+        AV_WB32(bad->data + restart + 4 + 8 * tests[i].idx + 4, tests[i].offset);
+        AV_WB32(bad->data + restart + len,
+                av_crc(crc_table, UINT32_MAX, bad->data + restart - 4, len + 4) ^ UINT32_MAX);
+
+        err = decode(bad, frame);
+        printf("%s: %s\n", tests[i].name,
+               err < 0 ? "decoding failed" : compare(ref, frame) ? "mismatch" : "ok");
+        if (err < 0 || compare(ref, frame))
+            ret = 1;
+    }
+
+end:
+    av_packet_free(&pkt);
+    av_packet_free(&bad);
+    av_frame_free(&ref);
+    av_frame_free(&frame);
+    return ret;
+}
@@ -2207,6 +2207,7 @@ const FFCodec ff_webp_anim_decoder = {
     FF_CODEC_DECODE_CB(webp_anim_decode_frame),
     .close          = webp_anim_decode_close,
     .p.capabilities = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS,
-    .caps_internal  = FF_CODEC_CAP_USES_PROGRESSFRAMES,
+    .caps_internal  = FF_CODEC_CAP_USES_PROGRESSFRAMES |
+                      FF_CODEC_CAP_SLICE_THREAD_SYNC,
 };
 #endif /* CONFIG_WEBP_ANIM_DECODER */
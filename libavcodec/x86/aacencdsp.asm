@@ -22,16 +22,16 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
-float_abs_mask: times 4 dd 0x7fffffff
+float_abs_mask: times 8 dd 0x7fffffff
 
 SECTION .text
 
 ;*******************************************************************
 ;void ff_abs_pow34(float *out, const float *in, const int size);
 ;*******************************************************************
-INIT_XMM sse
+%macro ABS_POW34 0
 cglobal abs_pow34, 3, 3, 3, out, in, size
     mova   m2, [float_abs_mask]
     shl    sized, 2
@@ -39,6 +39,10 @@ cglobal abs_pow34, 3, 3, 3, out, in, size
     add    outq, sizeq
     neg    sizeq
 .loop:
+%if mmsize == 32
+    cmp    sizeq, -16 ; band sizes are multiples of 4, finish an odd half in xmm
+    je    .tail
+%endif
     andps  m0, m2, [inq+sizeq]
     sqrtps m1, m0
     mulps  m0, m1
@@ -47,6 +51,21 @@ cglobal abs_pow34, 3, 3, 3, out, in, size
     add    sizeq, mmsize
     jl    .loop
     RET
+%if mmsize == 32
+.tail:
+    andps  xm0, xm2, [inq+sizeq]
+    sqrtps xm1, xm0
+    mulps  xm0, xm1
+    sqrtps xm0, xm0
+    mova   [outq+sizeq], xm0
+    RET
+%endif
+%endmacro
+
+INIT_XMM sse
+ABS_POW34
+INIT_YMM avx
+ABS_POW34
 
 ;*******************************************************************
 ;void ff_aac_quantize_bands(int *out, const float *in, const float *scaled,
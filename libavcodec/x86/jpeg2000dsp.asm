@@ -29,6 +29,13 @@ pf_ict1: times 8 dd 0.34413
 pf_ict2: times 8 dd 0.71414
 pf_ict3: times 8 dd 1.772
 
+pf_dwt_ndelta: times 4 dd -0.443506852043971
+pf_dwt_ngamma: times 4 dd -0.882911075530934
+pf_dwt_beta:   times 4 dd  0.052980118572961
+pf_dwt_alpha:  times 4 dd  1.586134342059924
+
+pd_2: times 4 dd 2
+
 SECTION .text
 
 ;***********************************************************************
@@ -162,3 +169,77 @@ RCT_INT
 INIT_YMM avx2
 RCT_INT
 %endif
+
+; Each sample position holds one register of 4 interleaved lines, so the
+; lifting steps below run on whole registers. Set up the pointer to sample
+; 2 * (i0 >> 1) and i1q to (i1 >> 1) - (i0 >> 1), the number of iterations
+; of the last lifting step.
+%macro DWT_LIFT_INIT 0
+    sar       i0d, 1
+    sar       i1d, 1
+    sub       i1d, i0d
+    shl       i0d, 5
+    add      srcq, i0q
+%endmacro
+
+; src[n] += coef * (src[n - 1] + src[n + 1]) for every other sample
+%macro LIFT97_STEP 3 ; first sample offset, extra iterations, coefficient
+    lea      dstq, [srcq+%1]
+    lea      lend, [i1q+%2]
+    movaps     m1, [%3]
+%%loop:
+    movaps     m0, [dstq-16]
+    addps      m0, [dstq+16]
+    mulps      m0, m1
+    addps      m0, [dstq]
+    movaps [dstq], m0
+    add      dstq, 32
+    dec      lend
+    jg %%loop
+%endmacro
+
+;***********************************************************************
+; ff_dwt_lift97_float_x4_<opt>(float *src, int i0, int i1)
+;***********************************************************************
+INIT_XMM sse
+cglobal dwt_lift97_float_x4, 3, 5, 2, src, i0, i1, dst, len
+    DWT_LIFT_INIT
+    LIFT97_STEP -32, 3, pf_dwt_ndelta
+    LIFT97_STEP -16, 2, pf_dwt_ngamma
+    LIFT97_STEP   0, 1, pf_dwt_beta
+    LIFT97_STEP  16, 0, pf_dwt_alpha
+    RET
+
+;***********************************************************************
+; ff_dwt_lift53_x4_<opt>(int32_t *src, int i0, int i1)
+;***********************************************************************
+INIT_XMM sse2
+cglobal dwt_lift53_x4, 3, 5, 3, src, i0, i1, dst, len
+    DWT_LIFT_INIT
+    mova       m2, [pd_2]
+    mov      dstq, srcq
+    lea      lend, [i1q+1]
+.loop_even:
+    mova       m0, [dstq-16]
+    paddd      m0, [dstq+16]
+    mova       m1, [dstq]
+    paddd      m0, m2
+    psrad      m0, 2
+    psubd      m1, m0
+    mova   [dstq], m1
+    add      dstq, 32
+    dec      lend
+    jg .loop_even
+
+    lea      dstq, [srcq+16]
+    mov      lend, i1d
+.loop_odd:
+    mova       m0, [dstq-16]
+    paddd      m0, [dstq+16]
+    psrad      m0, 1
+    paddd      m0, [dstq]
+    mova   [dstq], m0
+    add      dstq, 32
+    dec      lend
+    jg .loop_odd
+    RET
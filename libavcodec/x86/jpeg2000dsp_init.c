@@ -30,16 +30,20 @@ void ff_ict_float_fma3(void *src0, void *src1, void *src2, int csize);
 void ff_ict_float_fma4(void *src0, void *src1, void *src2, int csize);
 void ff_rct_int_sse2 (void *src0, void *src1, void *src2, int csize);
 void ff_rct_int_avx2 (void *src0, void *src1, void *src2, int csize);
+void ff_dwt_lift97_float_x4_sse(void *p, int i0, int i1);
+void ff_dwt_lift53_x4_sse2(void *p, int i0, int i1);
 
 av_cold void ff_jpeg2000dsp_init_x86(Jpeg2000DSPContext *c)
 {
     int cpu_flags = av_get_cpu_flags();
     if (EXTERNAL_SSE(cpu_flags)) {
         c->mct_decode[FF_DWT97] = ff_ict_float_sse;
+        c->dwt_lift_x4[FF_DWT97] = ff_dwt_lift97_float_x4_sse;
     }
 
     if (EXTERNAL_SSE2(cpu_flags)) {
         c->mct_decode[FF_DWT53] = ff_rct_int_sse2;
+        c->dwt_lift_x4[FF_DWT53] = ff_dwt_lift53_x4_sse2;
     }
 
     if (EXTERNAL_AVX_FAST(cpu_flags)) {
@@ -39,6 +39,11 @@ static void free_wrapper(void *opaque, void *ptr)
 
 #if CONFIG_INFLATE_WRAPPER
 int ff_inflate_init(FFZStream *z, void *logctx)
+{
+    return ff_inflate_init2(z, MAX_WBITS, logctx);
+}
+
+int ff_inflate_init2(FFZStream *z, int window_bits, void *logctx)
 {
     z_stream *const zstream = &z->zstream;
     int zret;
@@ -50,7 +55,7 @@ int ff_inflate_init(FFZStream *z, void *logctx)
     zstream->zfree    = free_wrapper;
     zstream->opaque   = Z_NULL;
 
-    zret = inflateInit(zstream);
+    zret = inflateInit2(zstream, window_bits);
     if (zret == Z_OK) {
         z->inited = 1;
     } else {
@@ -72,6 +77,11 @@ void ff_inflate_end(FFZStream *z)
 
 #if CONFIG_DEFLATE_WRAPPER
 int ff_deflate_init(FFZStream *z, int level, void *logctx)
+{
+    return ff_deflate_init2(z, level, MAX_WBITS, logctx);
+}
+
+int ff_deflate_init2(FFZStream *z, int level, int window_bits, void *logctx)
 {
     z_stream *const zstream = &z->zstream;
     int zret;
@@ -81,7 +91,8 @@ int ff_deflate_init(FFZStream *z, int level, void *logctx)
     zstream->zfree  = free_wrapper;
     zstream->opaque = Z_NULL;
 
-    zret = deflateInit(zstream, level);
+    zret = deflateInit2(zstream, level, Z_DEFLATED, window_bits,
+                        8, Z_DEFAULT_STRATEGY);
     if (zret == Z_OK) {
         z->inited = 1;
     } else {
@@ -39,6 +39,12 @@ typedef struct FFZStream {
  */
 int ff_inflate_init(FFZStream *zstream, void *logctx);
 
+/**
+ * Wrapper around inflateInit2(), like ff_inflate_init() with custom windowBits
+ * (e.g. negative for raw deflate data without zlib header and trailer).
+ */
+int ff_inflate_init2(FFZStream *zstream, int window_bits, void *logctx);
+
 /**
  * Wrapper around inflateEnd(). It calls inflateEnd() iff
  * zstream->inited is set and resets zstream->inited.
@@ -53,6 +59,11 @@ void ff_inflate_end(FFZStream *zstream);
  */
 int ff_deflate_init(FFZStream *zstream, int level, void *logctx);
 
+/**
+ * Wrapper around deflateInit2(), like ff_deflate_init() with custom windowBits.
+ */
+int ff_deflate_init2(FFZStream *zstream, int level, int window_bits, void *logctx);
+
 /**
  * Wrapper around deflateEnd(). It works analogously to ff_inflate_end().
  */
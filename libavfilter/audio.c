@@ -47,14 +47,17 @@ AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
 {
     AVFrame *frame = NULL;
     FilterLinkInternal *const li = ff_link_internal(link);
+    FFFilterGraph *graphi = fffiltergraph(link->src->graph);
     int channels = link->ch_layout.nb_channels;
     int align = av_cpu_max_align();
 
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_lock(graphi);
     if (ff_frame_pool_audio_reinit(&li->frame_pool, channels, nb_samples,
-                                   link->format, align) < 0)
-        return NULL;
-
-    frame = ff_frame_pool_get(&li->frame_pool);
+                                   link->format, align) >= 0)
+        frame = ff_frame_pool_get(&li->frame_pool);
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_unlock(graphi);
     if (!frame)
         return NULL;
 
@@ -73,14 +76,22 @@ AVFrame *ff_default_get_audio_buffer(AVFilterLink *link, int nb_samples)
 
 AVFrame *ff_get_audio_buffer(AVFilterLink *link, int nb_samples)
 {
+    FFFilterGraph *graphi = fffiltergraph(link->src->graph);
     AVFrame *ret = NULL;
 
+    /* get_buffer callbacks may run on several frame threads */
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_lock(graphi);
+
     if (link->dstpad->get_buffer.audio)
         ret = link->dstpad->get_buffer.audio(link, nb_samples);
 
     if (!ret)
         ret = ff_default_get_audio_buffer(link, nb_samples);
 
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_unlock(graphi);
+
     return ret;
 }
 
@@ -607,6 +607,15 @@ static int set_enable_expr(FFFilterContext *ctxi, const char *expr)
     return 0;
 }
 
+/**
+ * Wait until the filter is done with the frames it filters on frame threads.
+ */
+static void wait_frame_jobs(AVFilterContext *filter)
+{
+    while (fffilterctx(filter)->nb_jobs)
+        ff_graph_frame_thread_reap(fffiltergraph(filter->graph), 1);
+}
+
 int avfilter_process_command(AVFilterContext *filter, const char *cmd, const char *arg, char *res, int res_len, int flags)
 {
     if(!strcmp(cmd, "ping")){
@@ -623,6 +632,7 @@ int avfilter_process_command(AVFilterContext *filter, const char *cmd, const cha
     }else if(!strcmp(cmd, "enable")) {
         return set_enable_expr(fffilterctx(filter), arg);
     }else if (fffilter(filter->filter)->process_command) {
+        wait_frame_jobs(filter);
         return fffilter(filter->filter)->process_command(filter, cmd, arg, res, res_len, flags);
     }
     return AVERROR(ENOSYS);
@@ -806,6 +816,7 @@ void avfilter_free(AVFilterContext *filter)
         return;
     ctxi = fffilterctx(filter);
 
+    wait_frame_jobs(filter);
     if (filter->graph)
         ff_filter_graph_remove_filter(filter->graph, filter);
 
@@ -1056,6 +1067,9 @@ static int filter_frame_framed(AVFilterLink *link, AVFrame *frame)
     if (dstctx->is_disabled &&
         (dstctx->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC))
         filter_frame = default_filter_frame;
+    if (fffiltergraph(dstctx->graph)->frame_thread &&
+        (fffilter(dstctx->filter)->flags_internal & FF_FILTER_FLAG_FRAME_ASYNC))
+        return ff_graph_frame_thread_submit(link, frame, filter_frame);
     ret = filter_frame(link, frame);
     l->frame_count_out++;
     return ret;
@@ -1071,6 +1085,13 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
     int ret;
     FF_TPRINTF_START(NULL, filter_frame); ff_tlog_link(NULL, link, 1); ff_tlog(NULL, " "); tlog_ref(NULL, frame, 1);
 
+    /* Frames filtered on frame threads are sent on once the job completes */
+    if (fffiltergraph(link->src->graph)->frame_thread) {
+        ret = ff_graph_frame_thread_capture(link, frame);
+        if (ret)
+            return FFMIN(ret, 0);
+    }
+
     /* Consistency checks */
     if (link->type == AVMEDIA_TYPE_VIDEO) {
         if (strcmp(link->dst->filter->name, "buffersink") &&
@@ -1225,6 +1246,17 @@ static int filter_frame_to_filter(AVFilterLink *link)
     return ret;
 }
 
+void ff_filter_frame_complete(AVFilterLink *link, int ret)
+{
+    FilterLinkInternal * const li = ff_link_internal(link);
+
+    li->l.frame_count_out++;
+    if (ret < 0 && ret != li->status_out)
+        link_set_out_status(link, ret, AV_NOPTS_VALUE);
+    else
+        ff_filter_set_ready(link->dst, 300);
+}
+
 static int forward_status_change(AVFilterContext *filter, FilterLinkInternal *li_in)
 {
     AVFilterLink *in = &li_in->l.pub;
@@ -1305,6 +1337,43 @@ static int filter_activate_default(AVFilterContext *filter)
     return FFERROR_NOT_READY;
 }
 
+static int frame_thread_can_submit(AVFilterContext *filter)
+{
+    FFFilterContext *ctxi = fffilterctx(filter);
+
+    return (fffilter(filter->filter)->flags_internal & FF_FILTER_FLAG_FRAME_THREADS) &&
+           ctxi->nb_jobs < filter->graph->frame_threads &&
+           !filter->enable_str && !ctxi->command_queue;
+}
+
+/**
+ * Activate a filter while it is filtering frames on frame threads: submit
+ * more frames if it can filter them concurrently, and forward requests on
+ * its outputs to its inputs, as long as not too many frames are waiting
+ * there. Anything else waits for the filter to be done.
+ */
+static int filter_activate_busy(AVFilterContext *filter)
+{
+    int wanted = 0;
+
+    for (unsigned i = 0; i < filter->nb_inputs; i++) {
+        FilterLinkInternal *li = ff_link_internal(filter->inputs[i]);
+        if (samples_ready(li, li->l.min_samples) && frame_thread_can_submit(filter))
+            return filter_frame_to_filter(filter->inputs[i]);
+    }
+    for (unsigned i = 0; i < filter->nb_outputs; i++)
+        wanted |= ff_link_internal(filter->outputs[i])->frame_wanted_out;
+    if (!wanted)
+        return 0;
+    for (unsigned i = 0; i < filter->nb_inputs; i++) {
+        FilterLinkInternal *li = ff_link_internal(filter->inputs[i]);
+        if (!li->status_in && !li->status_out && !li->frame_wanted_out &&
+            ff_framequeue_queued_frames(&li->fifo) < filter->graph->frame_threads)
+            ff_inlink_request_frame(filter->inputs[i]);
+    }
+    return 0;
+}
+
 /*
    Filter scheduling and activation
 
@@ -1458,7 +1527,10 @@ int ff_filter_activate(AVFilterContext *filter)
     av_assert1(!(fi->p.flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  fi->activate));
     ctxi->ready = 0;
-    ret = fi->activate ? fi->activate(filter) : filter_activate_default(filter);
+    if (ctxi->nb_jobs)
+        ret = filter_activate_busy(filter);
+    else
+        ret = fi->activate ? fi->activate(filter) : filter_activate_default(filter);
     if (ret == FFERROR_NOT_READY)
         ret = 0;
     return ret;
@@ -1696,5 +1768,7 @@ int ff_outlink_frame_wanted(AVFilterLink *link)
 int ff_filter_execute(AVFilterContext *ctx, avfilter_action_func *func,
                       void *arg, int *ret, int nb_jobs)
 {
+    if (fffiltergraph(ctx->graph)->frame_thread)
+        return ff_graph_frame_thread_execute(ctx, func, arg, ret, nb_jobs);
     return fffilterctx(ctx)->execute(ctx, func, arg, ret, nb_jobs);
 }
@@ -44,6 +44,7 @@
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/rational.h"
+#include "libavutil/threadpool.h"
 
 #include "libavfilter/version_major.h"
 #ifndef HAVE_AV_CONFIG_H
@@ -616,6 +617,33 @@ typedef struct AVFilterGraph {
      * avfilter_graph_config().
      */
     unsigned max_buffered_frames;
+
+    /**
+     * Thread pool to run slice threading jobs on, instead of creating
+     * dedicated threads for this graph. May be set by the caller before adding
+     * any filters to the filtergraph, the same pool may be shared with other
+     * filtergraphs and codec contexts. When nb_threads is zero, up to the
+     * number of pool threads + 1 threads are used. Filters which cannot run on
+     * the pool, such as the swscale-based scale filter, are single-threaded.
+     *
+     * Libavfilter takes its own reference to the pool when the first filter
+     * is added, the caller may free the pool at any time afterwards.
+     */
+    AVThreadPool *thread_pool;
+
+    /**
+     * Number of worker threads used to filter frames concurrently (frame
+     * threading). Filters which support it filter their input frames on these
+     * threads, so that the filters of a chain work on successive frames at
+     * the same time; filters which are safe for it may also filter several
+     * successive frames at once. The output of every filter keeps the order
+     * of its input. Frames queued on the input of a busy filter are limited
+     * to this number, further requests wait for the filter.
+     *
+     * Zero (the default) disables frame threading. This field must be set
+     * before calling avfilter_graph_config().
+     */
+    int frame_threads;
 } AVFilterGraph;
 
 /**
@@ -120,6 +120,12 @@ typedef struct FFFilterContext {
     double *var_values;
 
     struct AVFilterCommand *command_queue;
+
+    /**
+     * Frames being filtered on frame threads, oldest first.
+     */
+    struct FrameJob *jobs;
+    unsigned nb_jobs;
 } FFFilterContext;
 
 static inline FFFilterContext *fffilterctx(AVFilterContext *ctx)
@@ -149,6 +155,8 @@ typedef struct FFFilterGraph {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    struct FrameThreadContext *frame_thread;
 } FFFilterGraph;
 
 static inline FFFilterGraph *fffiltergraph(AVFilterGraph *graph)
@@ -196,6 +204,56 @@ int ff_graph_thread_init(FFFilterGraph *graph);
 
 void ff_graph_thread_free(FFFilterGraph *graph);
 
+/**
+ * Start the frame threads of a graph if AVFilterGraph.frame_threads is set.
+ */
+int ff_graph_frame_thread_init(FFFilterGraph *graph);
+
+/**
+ * Wait for all frames being filtered on frame threads, discard their output
+ * and stop the threads.
+ */
+void ff_graph_frame_thread_free(FFFilterGraph *graph);
+
+/**
+ * Filter a frame on a frame thread. The frames sent to the outputs of the
+ * filter are held back until the job is completed by
+ * ff_graph_frame_thread_reap(), which then calls ff_filter_frame_complete().
+ */
+int ff_graph_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                 int (*filter_frame)(AVFilterLink *, AVFrame *));
+
+/**
+ * Hold back a frame sent by a filter running on a frame thread.
+ *
+ * @return 1 if the frame was taken, 0 if the calling thread is not a frame
+ *         thread, a negative error code on failure
+ */
+int ff_graph_frame_thread_capture(AVFilterLink *link, AVFrame *frame);
+
+/**
+ * Complete the frame jobs which are done, in order for every filter.
+ *
+ * @param wait  wait until at least one job can be completed
+ * @return the number of completed jobs, AVERROR(EAGAIN) if wait is set but no
+ *         job is in progress
+ */
+int ff_graph_frame_thread_reap(FFFilterGraph *graph, int wait);
+
+/**
+ * Run the slice jobs of a filter in a graph using frame threads: on the
+ * slice threads if they are idle, on the calling thread otherwise.
+ */
+int ff_graph_frame_thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                                  void *arg, int *ret, int nb_jobs);
+
+/**
+ * Serialize the frame allocations of a graph using frame threads.
+ * May be nested.
+ */
+void ff_graph_frame_thread_lock(FFFilterGraph *graph);
+void ff_graph_frame_thread_unlock(FFFilterGraph *graph);
+
 /**
  * Negotiate the media format, dimensions, etc of all inputs to a filter.
  *
@@ -226,4 +284,12 @@ int ff_filter_graph_run_once(AVFilterGraph *graph);
  */
 int ff_inlink_process_commands(AVFilterLink *link, const AVFrame *frame);
 
+/**
+ * Finish filtering a frame on a link after its job on a frame thread is
+ * completed.
+ *
+ * @param ret  return value of the filter_frame() callback
+ */
+void ff_filter_frame_complete(AVFilterLink *link, int ret);
+
 #endif /* AVFILTER_AVFILTER_INTERNAL_H */
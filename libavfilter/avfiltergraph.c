@@ -58,6 +58,8 @@ static const AVOption filtergraph_options[] = {
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
     {"max_buffered_frames"  , "maximum number of buffered frames allowed", OFFSET(max_buffered_frames),
         AV_OPT_TYPE_UINT,   {.i64 = 0}, 0, UINT_MAX, F|V|A },
+    {"frame_threads"        , "number of threads filtering frames concurrently", OFFSET(frame_threads),
+        AV_OPT_TYPE_INT,    {.i64 = 0}, 0, INT_MAX, F|V|A },
     { NULL },
 };
 
@@ -80,6 +82,46 @@ int ff_graph_thread_init(FFFilterGraph *graph)
     graph->p.nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_frame_thread_init(FFFilterGraph *graph)
+{
+    return 0;
+}
+
+void ff_graph_frame_thread_free(FFFilterGraph *graph)
+{
+}
+
+int ff_graph_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                 int (*filter_frame)(AVFilterLink *, AVFrame *))
+{
+    av_frame_free(&frame);
+    return AVERROR(ENOSYS);
+}
+
+int ff_graph_frame_thread_capture(AVFilterLink *link, AVFrame *frame)
+{
+    return 0;
+}
+
+int ff_graph_frame_thread_reap(FFFilterGraph *graph, int wait)
+{
+    return wait ? AVERROR(EAGAIN) : 0;
+}
+
+int ff_graph_frame_thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                                  void *arg, int *ret, int nb_jobs)
+{
+    return fffilterctx(ctx)->execute(ctx, func, arg, ret, nb_jobs);
+}
+
+void ff_graph_frame_thread_lock(FFFilterGraph *graph)
+{
+}
+
+void ff_graph_frame_thread_unlock(FFFilterGraph *graph)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -124,6 +166,8 @@ void avfilter_graph_free(AVFilterGraph **graphp)
     if (!graph)
         return;
 
+    ff_graph_frame_thread_free(graphi);
+
     while (graph->nb_filters)
         avfilter_free(graph->filters[0]);
 
@@ -1447,6 +1491,8 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
+    if ((ret = ff_graph_frame_thread_init(fffiltergraph(graphctx))) < 0)
+        return ret;
 
     return 0;
 }
@@ -1613,12 +1659,31 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+static int frame_thread_inputs_full(AVFilterGraph *graph)
+{
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        if (!fffilterctx(filter)->nb_jobs)
+            continue;
+        for (unsigned j = 0; j < filter->nb_inputs; j++) {
+            FilterLinkInternal *li = ff_link_internal(filter->inputs[j]);
+            if (ff_framequeue_queued_frames(&li->fifo) >= graph->frame_threads)
+                return 1;
+        }
+    }
+    return 0;
+}
+
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
+    FFFilterGraph *graphi = fffiltergraph(graph);
     FFFilterContext *ctxi;
     unsigned i;
 
     av_assert0(graph->nb_filters);
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_reap(graphi, 0);
     ctxi = fffilterctx(graph->filters[0]);
     for (i = 1; i < graph->nb_filters; i++) {
         FFFilterContext *ctxi_other = fffilterctx(graph->filters[i]);
@@ -1627,7 +1692,13 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
             ctxi = ctxi_other;
     }
 
-    if (!ctxi->ready)
+    if (!ctxi->ready) {
+        /* Bound the frames queued for filters busy on frame threads. */
+        if (graphi->frame_thread && frame_thread_inputs_full(graph)) {
+            int ret = ff_graph_frame_thread_reap(graphi, 1);
+            return ret < 0 ? ret : 0;
+        }
         return AVERROR(EAGAIN);
+    }
     return ff_filter_activate(&ctxi->p);
 }
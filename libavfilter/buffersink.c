@@ -69,6 +69,9 @@ typedef struct BufferSinkContext {
     unsigned          nb_channel_layouts;
 
     AVFrame *peeked_frame;
+
+    int (*get_buffer)(void *opaque, AVFrame *frame);
+    void *get_buffer_opaque;
 } BufferSinkContext;
 
 int attribute_align_arg av_buffersink_get_frame(AVFilterContext *ctx, AVFrame *frame)
@@ -95,10 +98,11 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
     BufferSinkContext *buf = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
     FilterLinkInternal *li = ff_link_internal(inlink);
+    FFFilterGraph *graphi = fffiltergraph(ctx->graph);
     int status, ret;
     AVFrame *cur_frame;
     int64_t pts;
-    int buffersrc_empty = 0;
+    int buffersrc_empty = 0, requested = 0;
 
     if (buf->peeked_frame)
         return return_or_keep_frame(buf, frame, buf->peeked_frame, flags);
@@ -122,7 +126,15 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
             } else if (ret == AVERROR(EAGAIN)) {
                 if (buffersrc_empty)
                     return ret;
-                ff_inlink_request_frame(inlink);
+                if (!requested || !graphi->frame_thread) {
+                    ff_inlink_request_frame(inlink);
+                    requested = 1;
+                } else {
+                    /* the request waits for filters busy on frame threads */
+                    ret = ff_graph_frame_thread_reap(graphi, 1);
+                    if (ret < 0)
+                        return ret;
+                }
             } else if (ret < 0) {
                 return ret;
             }
@@ -232,6 +244,46 @@ void av_buffersink_set_frame_size(AVFilterContext *ctx, unsigned frame_size)
     }
 }
 
+void av_buffersink_set_get_video_buffer(AVFilterContext *ctx,
+                                        int (*get_buffer)(void *opaque, AVFrame *frame),
+                                        void *opaque)
+{
+    BufferSinkContext *buf = ctx->priv;
+
+    av_assert0(fffilter(ctx->filter)->activate == activate);
+    buf->get_buffer        = get_buffer;
+    buf->get_buffer_opaque = opaque;
+}
+
+static AVFrame *get_video_buffer(AVFilterLink *inlink, int w, int h)
+{
+    BufferSinkContext *buf = inlink->dst->priv;
+    FilterLink *l = ff_filter_link(inlink);
+    AVFrame *frame;
+
+    if (!buf->get_buffer || l->hw_frames_ctx)
+        return NULL;
+
+    frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+
+    frame->format = inlink->format;
+    frame->width  = w;
+    frame->height = h;
+    if (buf->get_buffer(buf->get_buffer_opaque, frame) < 0) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+
+    frame->sample_aspect_ratio = inlink->sample_aspect_ratio;
+    frame->colorspace          = inlink->colorspace;
+    frame->color_range         = inlink->color_range;
+    frame->alpha_mode          = inlink->alpha_mode;
+
+    return frame;
+}
+
 #define MAKE_AVFILTERLINK_ACCESSOR(type, field) \
 type av_buffersink_get_##field(const AVFilterContext *ctx) { \
     av_assert0(fffilter(ctx->filter)->activate == activate); \
@@ -379,6 +431,14 @@ static const AVOption abuffersink_options[] = {
 AVFILTER_DEFINE_CLASS(buffersink);
 AVFILTER_DEFINE_CLASS(abuffersink);
 
+static const AVFilterPad inputs_video[] = {
+    {
+        .name             = "default",
+        .type             = AVMEDIA_TYPE_VIDEO,
+        .get_buffer.video = get_video_buffer,
+    },
+};
+
 const FFFilter ff_vsink_buffer = {
     .p.name        = "buffersink",
     .p.description = NULL_IF_CONFIG_SMALL("Buffer video frames, and make them available to the end of the filter graph."),
@@ -388,7 +448,7 @@ const FFFilter ff_vsink_buffer = {
     .init          = init_video,
     .uninit        = uninit,
     .activate      = activate,
-    FILTER_INPUTS(ff_video_default_filterpad),
+    FILTER_INPUTS(inputs_video),
     FILTER_QUERY_FUNC2(vsink_query_formats),
 };
 
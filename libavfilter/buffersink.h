@@ -100,6 +100,29 @@ int av_buffersink_get_frame_flags(AVFilterContext *ctx, AVFrame *frame, int flag
  */
 void av_buffersink_set_frame_size(AVFilterContext *ctx, unsigned frame_size);
 
+/**
+ * Set a callback allocating the video frames output into a buffer sink.
+ *
+ * Filters that produce their output in a newly allocated frame, like scale
+ * or format conversions, request that frame from the link they output to.
+ * When this link leads to the sink, the request is forwarded to get_buffer,
+ * so that the last filter writes directly into memory provided by the caller,
+ * e.g. input buffers of an encoder from avcodec_get_encoder_frame_pool().
+ *
+ * get_buffer is called from the thread running the filtergraph with format,
+ * width and height set in frame. On success, it must set up frame->buf,
+ * frame->data and frame->linesize and return 0. On failure, or to decline
+ * a request, it returns a negative AVERROR code and the frame is allocated
+ * by libavfilter as usual.
+ *
+ * @param ctx        pointer to a buffersink filter context
+ * @param get_buffer the callback, or NULL to use the default allocator
+ * @param opaque     user data passed to get_buffer
+ */
+void av_buffersink_set_get_video_buffer(AVFilterContext *ctx,
+                                        int (*get_buffer)(void *opaque, AVFrame *frame),
+                                        void *opaque);
+
 /**
  * @defgroup lavfi_buffersink_accessors Buffer sink accessors
  * Get the properties of the stream
@@ -207,6 +207,22 @@ static inline FilterLink* ff_filter_link(AVFilterLink *link)
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter_frame() callbacks of the filter may run on a frame thread while
+ * other filters of the graph are activated. They must only use the private
+ * context of the filter, the frame they are given, ff_get_video_buffer(),
+ * ff_get_audio_buffer(), ff_filter_execute() and ff_filter_frame() on the
+ * outputs of the filter. The filter is not activated until they return.
+ */
+#define FF_FILTER_FLAG_FRAME_ASYNC (1 << 1)
+
+/**
+ * In addition to FF_FILTER_FLAG_FRAME_ASYNC, the filter_frame() callbacks do
+ * not modify the private context nor use the frame counters of the links, so
+ * that they may run for successive frames concurrently.
+ */
+#define FF_FILTER_FLAG_FRAME_THREADS (1 << 2)
+
 /**
  * Find the index of a link.
  *
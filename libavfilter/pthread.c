@@ -23,14 +23,26 @@
 
 #include <stddef.h>
 
+#include "config.h"
+
+#include "libavutil/avassert.h"
 #include "libavutil/error.h"
+#include "libavutil/frame.h"
 #include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
 
 #include "avfilter.h"
 #include "avfilter_internal.h"
 
+#if HAVE_THREAD_LOCAL
+#define THREAD_LOCAL _Thread_local
+#else
+/* frame threading is never started without thread-local storage */
+#define THREAD_LOCAL
+#endif
+
 typedef struct ThreadContext {
     AVFilterGraph *graph;
     AVSliceThread *thread;
@@ -72,9 +84,13 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     return 0;
 }
 
-static int thread_init_internal(ThreadContext *c, int nb_threads)
+static int thread_init_internal(ThreadContext *c, AVThreadPool *pool, int nb_threads)
 {
-    nb_threads = avpriv_slicethread_create2(&c->thread, c, worker_func, NULL, nb_threads);
+    if (pool)
+        nb_threads = avpriv_slicethread_create_pool(&c->thread, pool, c, worker_func,
+                                                    NULL, nb_threads);
+    else
+        nb_threads = avpriv_slicethread_create2(&c->thread, c, worker_func, NULL, nb_threads);
     if (nb_threads <= 1)
         avpriv_slicethread_free(&c->thread);
     return FFMAX(nb_threads, 1);
@@ -94,7 +110,8 @@ int ff_graph_thread_init(FFFilterGraph *graphi)
     if (!graphi->thread)
         return AVERROR(ENOMEM);
 
-    ret = thread_init_internal(graphi->thread, graph->nb_threads);
+    ret = thread_init_internal(graphi->thread, graph->thread_pool,
+                               graph->nb_threads);
     if (ret <= 1) {
         av_freep(&graphi->thread);
         graph->thread_type = 0;
@@ -114,3 +131,340 @@ void ff_graph_thread_free(FFFilterGraph *graph)
         slice_thread_uninit(graph->thread);
     av_freep(&graph->thread);
 }
+
+typedef struct FrameJobOutput {
+    AVFilterLink *link;
+    AVFrame *frame;
+} FrameJobOutput;
+
+typedef struct FrameJob {
+    AVFilterLink *link;
+    AVFrame *frame;
+    int (*filter_frame)(AVFilterLink *link, AVFrame *frame);
+    int ret;
+    int done;
+
+    /* frames sent to the outputs of the filter, in order */
+    FrameJobOutput *out;
+    unsigned nb_out;
+    unsigned out_size;
+
+    struct FrameJob *next;          ///< next job of the same filter
+    struct FrameJob *next_queued;   ///< next job waiting for a thread
+} FrameJob;
+
+typedef struct FrameThreadContext {
+    pthread_t *threads;
+    int nb_threads;
+
+    /* protects all fields below as well as FrameJob.done */
+    AVMutex lock;
+    AVCond  job_cond;
+    AVCond  done_cond;
+    FrameJob  *queue;
+    FrameJob **queue_tail;
+    unsigned nb_jobs;
+    int execute_busy;
+    int exit;
+
+    AVMutex buffer_lock;
+} FrameThreadContext;
+
+/* job run by the calling thread if it is a frame thread */
+static THREAD_LOCAL FrameJob *current_job;
+/* nesting level of ff_graph_frame_thread_lock() on the calling thread */
+static THREAD_LOCAL int buffer_lock_depth;
+
+static void *attribute_align_arg frame_worker(void *arg)
+{
+    FrameThreadContext *c = arg;
+
+    ff_mutex_lock(&c->lock);
+    while (1) {
+        FrameJob *job;
+
+        while (!c->queue && !c->exit)
+            ff_cond_wait(&c->job_cond, &c->lock);
+        if (!c->queue)
+            break;
+
+        job = c->queue;
+        c->queue = job->next_queued;
+        if (!c->queue)
+            c->queue_tail = &c->queue;
+        ff_mutex_unlock(&c->lock);
+
+        current_job = job;
+        job->ret = job->filter_frame(job->link, job->frame);
+        current_job = NULL;
+
+        ff_mutex_lock(&c->lock);
+        job->done = 1;
+        ff_cond_signal(&c->done_cond);
+    }
+    ff_mutex_unlock(&c->lock);
+
+    return NULL;
+}
+
+static void job_free(FrameJob *job)
+{
+    for (unsigned i = 0; i < job->nb_out; i++)
+        av_frame_free(&job->out[i].frame);
+    av_freep(&job->out);
+    av_free(job);
+}
+
+int ff_graph_frame_thread_init(FFFilterGraph *graphi)
+{
+    AVFilterGraph *graph = &graphi->p;
+    FrameThreadContext *c;
+    int ret;
+
+    if (!HAVE_THREAD_LOCAL || graph->frame_threads <= 0 || graphi->frame_thread)
+        return 0;
+
+    c = av_mallocz(sizeof(*c));
+    if (!c)
+        return AVERROR(ENOMEM);
+    c->threads = av_calloc(graph->frame_threads, sizeof(*c->threads));
+    if (!c->threads) {
+        av_free(c);
+        return AVERROR(ENOMEM);
+    }
+    c->queue_tail = &c->queue;
+
+    if ((ret = ff_mutex_init(&c->lock, NULL))) {
+        av_free(c->threads);
+        av_free(c);
+        return AVERROR(ret);
+    }
+    if ((ret = ff_mutex_init(&c->buffer_lock, NULL)))
+        goto fail_lock;
+    if ((ret = ff_cond_init(&c->job_cond, NULL)))
+        goto fail_buffer_lock;
+    if ((ret = ff_cond_init(&c->done_cond, NULL)))
+        goto fail_job_cond;
+
+    graphi->frame_thread = c;
+
+    for (int i = 0; i < graph->frame_threads; i++) {
+        ret = pthread_create(&c->threads[i], NULL, frame_worker, c);
+        if (ret) {
+            ff_graph_frame_thread_free(graphi);
+            return AVERROR(ret);
+        }
+        c->nb_threads++;
+    }
+
+    return 0;
+
+fail_job_cond:
+    ff_cond_destroy(&c->job_cond);
+fail_buffer_lock:
+    ff_mutex_destroy(&c->buffer_lock);
+fail_lock:
+    ff_mutex_destroy(&c->lock);
+    av_free(c->threads);
+    av_free(c);
+    return AVERROR(ret);
+}
+
+void ff_graph_frame_thread_free(FFFilterGraph *graphi)
+{
+    AVFilterGraph *graph = &graphi->p;
+    FrameThreadContext *c = graphi->frame_thread;
+
+    if (!c)
+        return;
+
+    ff_mutex_lock(&c->lock);
+    c->exit = 1;
+    ff_cond_broadcast(&c->job_cond);
+    ff_mutex_unlock(&c->lock);
+    for (int i = 0; i < c->nb_threads; i++)
+        pthread_join(c->threads[i], NULL);
+
+    /* the threads only exit once all queued jobs are done */
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        FFFilterContext *ctxi = fffilterctx(graph->filters[i]);
+
+        while (ctxi->jobs) {
+            FrameJob *job = ctxi->jobs;
+            ctxi->jobs = job->next;
+            job_free(job);
+        }
+        ctxi->nb_jobs = 0;
+    }
+
+    ff_cond_destroy(&c->done_cond);
+    ff_cond_destroy(&c->job_cond);
+    ff_mutex_destroy(&c->buffer_lock);
+    ff_mutex_destroy(&c->lock);
+    av_freep(&c->threads);
+    av_freep(&graphi->frame_thread);
+}
+
+int ff_graph_frame_thread_submit(AVFilterLink *link, AVFrame *frame,
+                                 int (*filter_frame)(AVFilterLink *, AVFrame *))
+{
+    FFFilterContext *ctxi = fffilterctx(link->dst);
+    FrameThreadContext *c = fffiltergraph(link->dst->graph)->frame_thread;
+    FrameJob *job, **tail;
+
+    job = av_mallocz(sizeof(*job));
+    if (!job) {
+        av_frame_free(&frame);
+        return AVERROR(ENOMEM);
+    }
+    job->link         = link;
+    job->frame        = frame;
+    job->filter_frame = filter_frame;
+
+    for (tail = &ctxi->jobs; *tail; tail = &(*tail)->next)
+        ;
+    *tail = job;
+    ctxi->nb_jobs++;
+
+    ff_mutex_lock(&c->lock);
+    *c->queue_tail = job;
+    c->queue_tail  = &job->next_queued;
+    c->nb_jobs++;
+    ff_cond_signal(&c->job_cond);
+    ff_mutex_unlock(&c->lock);
+
+    return 0;
+}
+
+int ff_graph_frame_thread_capture(AVFilterLink *link, AVFrame *frame)
+{
+    FrameJob *job = current_job;
+    FrameJobOutput *out;
+
+    if (!job)
+        return 0;
+    av_assert1(link->src == job->link->dst);
+
+    out = av_fast_realloc(job->out, &job->out_size,
+                          (job->nb_out + 1) * sizeof(*job->out));
+    if (!out) {
+        av_frame_free(&frame);
+        return AVERROR(ENOMEM);
+    }
+    job->out = out;
+    job->out[job->nb_out].link  = link;
+    job->out[job->nb_out].frame = frame;
+    job->nb_out++;
+
+    return 1;
+}
+
+static int job_done(FrameThreadContext *c, FrameJob *job)
+{
+    int done;
+
+    ff_mutex_lock(&c->lock);
+    done = job->done;
+    ff_mutex_unlock(&c->lock);
+
+    return done;
+}
+
+/* must be called with the lock held */
+static int can_reap(FFFilterGraph *graphi)
+{
+    for (unsigned i = 0; i < graphi->p.nb_filters; i++) {
+        FFFilterContext *ctxi = fffilterctx(graphi->p.filters[i]);
+        if (ctxi->jobs && ctxi->jobs->done)
+            return 1;
+    }
+    return 0;
+}
+
+int ff_graph_frame_thread_reap(FFFilterGraph *graphi, int wait)
+{
+    AVFilterGraph *graph = &graphi->p;
+    FrameThreadContext *c = graphi->frame_thread;
+    int nb_reaped = 0;
+
+    if (wait) {
+        ff_mutex_lock(&c->lock);
+        if (!c->nb_jobs) {
+            ff_mutex_unlock(&c->lock);
+            return AVERROR(EAGAIN);
+        }
+        while (!can_reap(graphi))
+            ff_cond_wait(&c->done_cond, &c->lock);
+        ff_mutex_unlock(&c->lock);
+    }
+
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        FFFilterContext *ctxi = fffilterctx(graph->filters[i]);
+
+        while (ctxi->jobs && job_done(c, ctxi->jobs)) {
+            FrameJob *job = ctxi->jobs;
+            int ret = job->ret;
+
+            ctxi->jobs = job->next;
+            ctxi->nb_jobs--;
+            ff_mutex_lock(&c->lock);
+            c->nb_jobs--;
+            ff_mutex_unlock(&c->lock);
+
+            for (unsigned j = 0; j < job->nb_out; j++) {
+                AVFrame *frame = job->out[j].frame;
+                job->out[j].frame = NULL;
+                if (ret >= 0)
+                    ret = ff_filter_frame(job->out[j].link, frame);
+                else
+                    av_frame_free(&frame);
+            }
+            ff_filter_frame_complete(job->link, ret);
+            job_free(job);
+            nb_reaped++;
+        }
+    }
+
+    return nb_reaped;
+}
+
+int ff_graph_frame_thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                                  void *arg, int *ret, int nb_jobs)
+{
+    FrameThreadContext *c = fffiltergraph(ctx->graph)->frame_thread;
+    int busy, r;
+
+    ff_mutex_lock(&c->lock);
+    busy = c->execute_busy;
+    c->execute_busy = 1;
+    ff_mutex_unlock(&c->lock);
+
+    if (busy) {
+        for (int i = 0; i < nb_jobs; i++) {
+            r = func(ctx, arg, i, nb_jobs);
+            if (ret)
+                ret[i] = r;
+        }
+        return 0;
+    }
+
+    r = fffilterctx(ctx)->execute(ctx, func, arg, ret, nb_jobs);
+
+    ff_mutex_lock(&c->lock);
+    c->execute_busy = 0;
+    ff_mutex_unlock(&c->lock);
+
+    return r;
+}
+
+void ff_graph_frame_thread_lock(FFFilterGraph *graph)
+{
+    if (!buffer_lock_depth++)
+        ff_mutex_lock(&graph->frame_thread->buffer_lock);
+}
+
+void ff_graph_frame_thread_unlock(FFFilterGraph *graph)
+{
+    if (!--buffer_lock_depth)
+        ff_mutex_unlock(&graph->frame_thread->buffer_lock);
+}
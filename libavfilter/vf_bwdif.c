@@ -229,6 +229,7 @@ const FFFilter ff_vf_bwdif = {
     .p.description = NULL_IF_CONFIG_SMALL("Deinterlace the input image."),
     .p.priv_class  = &bwdif_class,
     .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
+    .flags_internal = FF_FILTER_FLAG_FRAME_ASYNC,
     .priv_size     = sizeof(BWDIFContext),
     .uninit        = ff_yadif_uninit,
     FILTER_INPUTS(avfilter_vf_bwdif_inputs),
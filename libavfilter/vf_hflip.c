@@ -150,6 +150,7 @@ const FFFilter ff_vf_hflip = {
     .p.name        = "hflip",
     .p.description = NULL_IF_CONFIG_SMALL("Horizontally flip the input video."),
     .p.flags       = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags_internal = FF_FILTER_FLAG_FRAME_ASYNC | FF_FILTER_FLAG_FRAME_THREADS,
     .priv_size     = sizeof(FlipContext),
     FILTER_INPUTS(avfilter_vf_hflip_inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
@@ -596,6 +596,8 @@ static const AVFilterPad inputs[] = {
         .p.priv_class  = &priv_class_ ## _class,                        \
         .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |       \
                          AVFILTER_FLAG_SLICE_THREADS,                   \
+        .flags_internal = FF_FILTER_FLAG_FRAME_ASYNC |                  \
+                          FF_FILTER_FLAG_FRAME_THREADS,                 \
         .priv_size     = sizeof(LutContext),                            \
         .init          = name_##_init,                                  \
         .uninit        = uninit,                                        \
@@ -361,6 +361,7 @@ const FFFilter ff_vf_negate = {
     .p.description = NULL_IF_CONFIG_SMALL("Negate input video."),
     .p.priv_class  = &negate_class,
     .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
+    .flags_internal = FF_FILTER_FLAG_FRAME_ASYNC | FF_FILTER_FLAG_FRAME_THREADS,
     .priv_size     = sizeof(NegateContext),
     FILTER_INPUTS(inputs),
     FILTER_OUTPUTS(ff_video_default_filterpad),
@@ -421,9 +421,10 @@ static av_cold int init(AVFilterContext *ctx)
     scale->sws->dst_h_chr_pos = scale->out_h_chr_pos;
     scale->sws->dst_v_chr_pos = scale->out_v_chr_pos;
 
-    // use generic thread-count if the user did not set it explicitly
+    // use generic thread-count if the user did not set it explicitly; swscale
+    // cannot run on the graph's shared thread pool and would start its own
     if (!scale->sws->threads)
-        scale->sws->threads = ff_filter_get_nb_threads(ctx);
+        scale->sws->threads = ctx->graph->thread_pool ? 1 : ff_filter_get_nb_threads(ctx);
 
     if (!IS_SCALE2REF(ctx) && scale->uses_ref) {
         AVFilterPad pad = {
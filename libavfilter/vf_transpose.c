@@ -412,6 +412,7 @@ const FFFilter ff_vf_transpose = {
     .p.description = NULL_IF_CONFIG_SMALL("Transpose input video."),
     .p.priv_class  = &transpose_class,
     .p.flags       = AVFILTER_FLAG_SLICE_THREADS,
+    .flags_internal = FF_FILTER_FLAG_FRAME_ASYNC | FF_FILTER_FLAG_FRAME_THREADS,
     .priv_size     = sizeof(TransContext),
     FILTER_INPUTS(avfilter_vf_transpose_inputs),
     FILTER_OUTPUTS(avfilter_vf_transpose_outputs),
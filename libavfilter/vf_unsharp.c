@@ -399,6 +399,7 @@ const FFFilter ff_vf_unsharp = {
     .p.description = NULL_IF_CONFIG_SMALL("Sharpen or blur the input video."),
     .p.priv_class  = &unsharp_class,
     .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
+    .flags_internal = FF_FILTER_FLAG_FRAME_ASYNC,
     .priv_size     = sizeof(UnsharpContext),
     .init          = init,
     .uninit        = uninit,
@@ -327,6 +327,7 @@ const FFFilter ff_vf_yadif = {
     .p.description = NULL_IF_CONFIG_SMALL("Deinterlace the input image."),
     .p.priv_class  = &yadif_class,
     .p.flags       = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
+    .flags_internal = FF_FILTER_FLAG_FRAME_ASYNC,
     .priv_size     = sizeof(YADIFContext),
     .uninit        = ff_yadif_uninit,
     FILTER_INPUTS(avfilter_vf_yadif_inputs),
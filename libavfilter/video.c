@@ -49,6 +49,7 @@ AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
 AVFrame *ff_default_get_video_buffer2(AVFilterLink *link, int w, int h, int align)
 {
     FilterLinkInternal *const li = ff_link_internal(link);
+    FFFilterGraph *graphi = fffiltergraph(link->src->graph);
     AVFrame *frame = NULL;
 
     if (li->l.hw_frames_ctx &&
@@ -66,10 +67,12 @@ AVFrame *ff_default_get_video_buffer2(AVFilterLink *link, int w, int h, int alig
         return frame;
     }
 
-    if (ff_frame_pool_video_reinit(&li->frame_pool, w, h, link->format, align) < 0)
-        return NULL;
-
-    frame = ff_frame_pool_get(&li->frame_pool);
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_lock(graphi);
+    if (ff_frame_pool_video_reinit(&li->frame_pool, w, h, link->format, align) >= 0)
+        frame = ff_frame_pool_get(&li->frame_pool);
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_unlock(graphi);
     if (!frame)
         return NULL;
 
@@ -88,15 +91,23 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
 
 AVFrame *ff_get_video_buffer(AVFilterLink *link, int w, int h)
 {
+    FFFilterGraph *graphi = fffiltergraph(link->src->graph);
     AVFrame *ret = NULL;
 
     FF_TPRINTF_START(NULL, get_video_buffer); ff_tlog_link(NULL, link, 1);
 
+    /* get_buffer callbacks may run on several frame threads */
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_lock(graphi);
+
     if (link->dstpad->get_buffer.video)
         ret = link->dstpad->get_buffer.video(link, w, h);
 
     if (!ret)
         ret = ff_default_get_video_buffer(link, w, h);
 
+    if (graphi->frame_thread)
+        ff_graph_frame_thread_unlock(graphi);
+
     return ret;
 }
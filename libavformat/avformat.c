@@ -67,6 +67,7 @@ void ff_free_stream(AVStream **pst)
 
     if (sti->info) {
         av_freep(&sti->info->duration_error);
+        av_packet_free(&sti->info->probe_pkt);
         av_freep(&sti->info);
     }
 
@@ -1248,6 +1248,26 @@ typedef struct AVStreamGroup {
 
 struct AVCodecParserContext *av_stream_get_parser(const AVStream *s);
 
+/**
+ * Cost of probing a stream in avformat_find_stream_info().
+ *
+ * New fields may be added to the end with minor version bumps, the size of
+ * this struct is not part of the public ABI.
+ */
+typedef struct AVStreamProbeStats {
+    int64_t nb_packets;     ///< number of packets analyzed
+    int64_t bytes;          ///< total size of the analyzed packets
+    int64_t nb_frames;      ///< number of frames decoded
+    int64_t decode_time;    ///< time spent decoding in microseconds
+} AVStreamProbeStats;
+
+/**
+ * Get the probing statistics of a stream, filled by the last call to
+ * avformat_find_stream_info(). All fields are zero if the stream was not
+ * probed.
+ */
+const AVStreamProbeStats *av_stream_get_probe_stats(const AVStream *st);
+
 #define AV_PROGRAM_RUNNING 1
 
 /**
@@ -1987,6 +2007,54 @@ typedef struct AVFormatContext {
      * - demuxing: Set by user
      */
     int recursion_limit;
+
+    /**
+     * Number of threads used by avformat_find_stream_info() to decode
+     * packets of different streams in parallel. 0 selects the number
+     * automatically, 1 decodes all streams on the calling thread.
+     *
+     * - demuxing: Set by user
+     */
+    int probe_threads;
+
+    /**
+     * If nonzero, read the input into refcounted buffers of this size, and
+     * let demuxers that support it return packets referencing these
+     * buffers instead of copies of the data. Larger packets are copied as
+     * usual.
+     *
+     * Only supported for inputs opened by libavformat.
+     *
+     * - demuxing: Set by user
+     */
+    int zerocopy_buffer_size;
+
+    /**
+     * If nonzero, avformat_find_stream_info() applies probesize and
+     * max_analyze_duration to every stream on its own: while other streams are
+     * still being probed, the packets of streams whose parameters are complete
+     * do not count towards probesize, and their duration does not end probing.
+     * Probing is then bounded by probe_total_size and probe_total_duration.
+     *
+     * - demuxing: Set by user
+     */
+    int probe_per_stream;
+
+    /**
+     * Maximum number of bytes read by avformat_find_stream_info() in total
+     * when probe_per_stream is set.
+     *
+     * - demuxing: Set by user
+     */
+    int64_t probe_total_size;
+
+    /**
+     * Maximum duration in AV_TIME_BASE units analyzed by
+     * avformat_find_stream_info() in any stream when probe_per_stream is set.
+     *
+     * - demuxing: Set by user
+     */
+    int64_t probe_total_duration;
 } AVFormatContext;
 
 /**
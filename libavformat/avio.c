@@ -694,7 +694,11 @@ int avio_close(AVIOContext *s)
     h         = s->opaque;
     s->opaque = NULL;
 
-    av_freep(&s->buffer);
+    if (ctx->buffer_ref) {
+        av_buffer_unref(&ctx->buffer_ref);
+        s->buffer = NULL;
+    } else
+        av_freep(&s->buffer);
     if (s->write_flag)
         av_log(s, AV_LOG_VERBOSE,
                "Statistics: %"PRId64" bytes written, %d seeks, %d writeouts\n",
@@ -21,6 +21,7 @@
 
 #include "avio.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/log.h"
 
 typedef struct AVFormatContext AVFormatContext;
@@ -78,6 +79,17 @@ typedef struct FFIOContext {
      * is updated each time a successful writeout ends up further position-wise
      */
     int64_t written_output_size;
+
+    /**
+     * Pool of refcounted read buffers, see ffio_set_buffer_pool()
+     */
+    AVBufferPool *buffer_pool;
+    int pool_buffer_size;
+
+    /**
+     * Reference owning the buffer, NULL if it was allocated with av_malloc()
+     */
+    AVBufferRef *buffer_ref;
 } FFIOContext;
 
 static av_always_inline FFIOContext *ffiocontext(AVIOContext *ctx)
@@ -121,6 +133,28 @@ void ffio_init_write_context(FFIOContext *s, uint8_t *buffer, int buffer_size);
  */
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data);
 
+/**
+ * Read into refcounted buffers of buf_size bytes from now on, so that data
+ * can be returned by reference with ffio_read_ref().
+ * Only supported for read-only contexts opened by ffio_fdopen().
+ *
+ * @return 0 on success, a negative AVERROR code otherwise
+ */
+int ffio_set_buffer_pool(AVIOContext *s, int buf_size);
+
+/**
+ * Read size bytes from AVIOContext without copying them, if possible.
+ * On success, *buf is a new reference to the underlying buffer and *data
+ * points to the data within it, which is followed by
+ * AV_INPUT_BUFFER_PADDING_SIZE zeroed bytes. The buffer must not be
+ * written to.
+ *
+ * @return size on success, 0 if the data could not be read by reference and
+ *         must be read with avio_read() instead, a negative AVERROR code
+ *         on failure
+ */
+int ffio_read_ref(AVIOContext *s, int size, AVBufferRef **buf, uint8_t **data);
+
 void ffio_fill(AVIOContext *s, int b, int64_t count);
 
 static av_always_inline void ffio_wfourcc(AVIOContext *pb, const uint8_t *s)
@@ -129,6 +129,8 @@ void avio_context_free(AVIOContext **ps)
     if (s) {
         av_freep(&s->protocol_whitelist);
         av_freep(&s->protocol_blacklist);
+        av_buffer_unref(&ffiocontext(s)->buffer_ref);
+        av_buffer_pool_uninit(&ffiocontext(s)->buffer_pool);
     }
     av_freep(ps);
 }
@@ -509,6 +511,51 @@ static int read_packet_wrapper(AVIOContext *s, uint8_t *buf, int size)
     return ret;
 }
 
+/**
+ * Allocate a buffer of size bytes, taken from the buffer pool if one is set.
+ * *ref is set to the reference owning the buffer, if any.
+ */
+static uint8_t *alloc_buffer(AVIOContext *s, int size, AVBufferRef **ref)
+{
+    FFIOContext *const ctx = ffiocontext(s);
+
+    *ref = NULL;
+    if (!ctx->buffer_pool)
+        return av_malloc(size);
+
+    if (size == ctx->pool_buffer_size)
+        *ref = av_buffer_pool_get(ctx->buffer_pool);
+    else
+        *ref = av_buffer_alloc(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    return *ref ? (*ref)->data : NULL;
+}
+
+/**
+ * Replace the buffer, releasing the current one. Its data stays valid
+ * as long as packets reference it.
+ */
+static void replace_buffer(AVIOContext *s, uint8_t *buffer, AVBufferRef *ref)
+{
+    FFIOContext *const ctx = ffiocontext(s);
+
+    if (ctx->buffer_ref)
+        av_buffer_unref(&ctx->buffer_ref);
+    else
+        av_free(s->buffer);
+    s->buffer       = buffer;
+    ctx->buffer_ref = ref;
+}
+
+/**
+ * Whether the data in the buffer is referenced by packets, in which case
+ * it must not be overwritten.
+ */
+static int buffer_shared(AVIOContext *s)
+{
+    FFIOContext *const ctx = ffiocontext(s);
+    return ctx->buffer_ref && !av_buffer_is_writable(ctx->buffer_ref);
+}
+
 /* Input stream */
 
 static void fill_buffer(AVIOContext *s)
@@ -548,6 +595,27 @@ static void fill_buffer(AVIOContext *s)
         len = ctx->orig_buffer_size;
     }
 
+    /* start over in a buffer from the pool if the current one is not from
+     * it or too little of it is left after data referenced by packets */
+    if (ctx->buffer_pool && dst == s->buffer &&
+        (!ctx->buffer_ref || s->buffer_size < max_buffer_size)) {
+        AVBufferRef *ref;
+        uint8_t *buffer = alloc_buffer(s, ctx->pool_buffer_size, &ref);
+        if (!buffer) {
+            s->eof_reached = 1;
+            s->error       = AVERROR(ENOMEM);
+            return;
+        }
+        replace_buffer(s, buffer, ref);
+        s->buffer_size  = ctx->pool_buffer_size;
+        s->checksum_ptr = s->buf_ptr = s->buf_end = dst = s->buffer;
+        len = s->buffer_size;
+    }
+    /* read ahead as usual, larger packets are read by ffio_read_ref() into
+     * the rest of the buffer */
+    if (ctx->buffer_pool)
+        len = FFMIN(len, max_buffer_size);
+
     len = read_packet_wrapper(s, dst, len);
     if (len == AVERROR_EOF) {
         /* do not modify buffer if EOF reached so that a seek back can
@@ -1042,17 +1110,18 @@ int ffio_ensure_seekback(AVIOContext *s, int64_t buf_size)
         return 0;
     av_assert0(!s->write_flag);
 
-    if (buf_size <= s->buffer_size) {
+    if (buf_size <= s->buffer_size && !buffer_shared(s)) {
         update_checksum(s);
         memmove(s->buffer, s->buf_ptr, filled);
     } else {
-        buffer = av_malloc(buf_size);
+        AVBufferRef *ref;
+        buf_size = FFMAX(buf_size, s->buffer_size);
+        buffer = alloc_buffer(s, buf_size, &ref);
         if (!buffer)
             return AVERROR(ENOMEM);
         update_checksum(s);
         memcpy(buffer, s->buf_ptr, filled);
-        av_free(s->buffer);
-        s->buffer = buffer;
+        replace_buffer(s, buffer, ref);
         s->buffer_size = buf_size;
     }
     s->buf_ptr = s->buffer;
@@ -1061,6 +1130,111 @@ int ffio_ensure_seekback(AVIOContext *s, int64_t buf_size)
     return 0;
 }
 
+int ffio_set_buffer_pool(AVIOContext *s, int buf_size)
+{
+    FFIOContext *const ctx = ffiocontext(s);
+
+    if (s->write_flag || !ffio_geturlcontext(s))
+        return AVERROR(ENOSYS);
+    if (buf_size <= 0 || buf_size > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE)
+        return AVERROR(EINVAL);
+
+    av_buffer_pool_uninit(&ctx->buffer_pool);
+    ctx->buffer_pool = av_buffer_pool_init(buf_size + AV_INPUT_BUFFER_PADDING_SIZE, NULL);
+    if (!ctx->buffer_pool)
+        return AVERROR(ENOMEM);
+    ctx->pool_buffer_size =
+    ctx->orig_buffer_size = buf_size;
+
+    return 0;
+}
+
+/**
+ * Let the buffer start after the data handed out by reference and its
+ * padding, so that they are never overwritten by later reads. The space
+ * left until the end of the allocation is used for the following data.
+ */
+static void skip_referenced(AVIOContext *s)
+{
+    uint8_t *end   = s->buffer + s->buffer_size;
+    uint8_t *start = FFMIN(s->buf_end + AV_INPUT_BUFFER_PADDING_SIZE, end);
+
+    update_checksum(s);
+    s->buffer_size = end - start;
+    s->buffer      = s->checksum_ptr = s->buf_ptr = s->buf_end = start;
+}
+
+int ffio_read_ref(AVIOContext *s, int size, AVBufferRef **buf, uint8_t **data)
+{
+    FFIOContext *const ctx = ffiocontext(s);
+    int filled = s->buf_end - s->buf_ptr;
+
+    /* The data must end where the buffered data ends, so that the padding
+     * after it can be zeroed. Packets followed by already buffered data are
+     * copied, as are small ones, which are better read with read-ahead than
+     * one by one. */
+    if (!ctx->buffer_pool || size <= 0 || size > ctx->pool_buffer_size ||
+        filled > size || (filled < size && size < IO_BUFFER_SIZE) ||
+        (filled == size && !ctx->buffer_ref))
+        return 0;
+
+    if (filled < size) {
+        /* move the buffered start of the data to the start of a buffer with
+         * room for all of it */
+        if (!ctx->buffer_ref || s->buffer + s->buffer_size - s->buf_ptr < size) {
+            if (ctx->buffer_ref && s->buffer_size >= size) {
+                update_checksum(s);
+                memmove(s->buffer, s->buf_ptr, filled);
+            } else {
+                AVBufferRef *ref;
+                uint8_t *buffer = alloc_buffer(s, ctx->pool_buffer_size, &ref);
+                if (!buffer)
+                    return AVERROR(ENOMEM);
+                update_checksum(s);
+                memcpy(buffer, s->buf_ptr, filled);
+                replace_buffer(s, buffer, ref);
+                s->buffer_size = ctx->pool_buffer_size;
+            }
+            s->checksum_ptr = s->buf_ptr = s->buffer;
+            s->buf_end = s->buffer + filled;
+        }
+
+        /* read exactly up to the end of the data */
+        while (s->buf_end - s->buf_ptr < size && !s->eof_reached) {
+            int len = read_packet_wrapper(s, s->buf_end,
+                                          size - (s->buf_end - s->buf_ptr));
+            if (len == AVERROR_EOF) {
+                s->eof_reached = 1;
+            } else if (len < 0) {
+                s->eof_reached = 1;
+                s->error       = len;
+            } else if (!len) {
+                break;
+            } else {
+                s->pos     += len;
+                s->buf_end += len;
+                ctx->bytes_read += len;
+                s->bytes_read    = ctx->bytes_read;
+            }
+        }
+        /* let avio_read() deal with the end of the stream */
+        if (s->buf_end - s->buf_ptr < size)
+            return 0;
+    }
+
+    *buf = av_buffer_ref(ctx->buffer_ref);
+    if (!*buf)
+        return AVERROR(ENOMEM);
+    *data       = s->buf_ptr;
+    s->buf_ptr += size;
+
+    /* buffers always have room for the padding after buffer_size bytes */
+    memset(s->buf_end, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    skip_referenced(s);
+
+    return size;
+}
+
 int ffio_limit(AVIOContext *s, int size)
 {
     FFIOContext *const ctx = ffiocontext(s);
@@ -1089,13 +1263,13 @@ int ffio_limit(AVIOContext *s, int size)
 
 static int set_buf_size(AVIOContext *s, int buf_size)
 {
+    AVBufferRef *ref;
     uint8_t *buffer;
-    buffer = av_malloc(buf_size);
+    buffer = alloc_buffer(s, buf_size, &ref);
     if (!buffer)
         return AVERROR(ENOMEM);
 
-    av_free(s->buffer);
-    s->buffer = buffer;
+    replace_buffer(s, buffer, ref);
     ffiocontext(s)->orig_buffer_size =
     s->buffer_size = buf_size;
     s->buf_ptr = s->buf_ptr_max = buffer;
@@ -1105,6 +1279,7 @@ static int set_buf_size(AVIOContext *s, int buf_size)
 
 int ffio_realloc_buf(AVIOContext *s, int buf_size)
 {
+    AVBufferRef *ref;
     uint8_t *buffer;
     int data_size;
 
@@ -1114,15 +1289,14 @@ int ffio_realloc_buf(AVIOContext *s, int buf_size)
     if (buf_size <= s->buffer_size)
         return 0;
 
-    buffer = av_malloc(buf_size);
+    buffer = alloc_buffer(s, buf_size, &ref);
     if (!buffer)
         return AVERROR(ENOMEM);
 
     data_size = s->write_flag ? (s->buf_ptr - s->buffer) : (s->buf_end - s->buf_ptr);
     if (data_size > 0)
         memcpy(buffer, s->write_flag ? s->buffer : s->buf_ptr, data_size);
-    av_free(s->buffer);
-    s->buffer = buffer;
+    replace_buffer(s, buffer, ref);
     ffiocontext(s)->orig_buffer_size = buf_size;
     s->buffer_size = buf_size;
     s->buf_ptr = s->write_flag ? (s->buffer + data_size) : s->buffer;
@@ -1181,8 +1355,8 @@ int ffio_rewind_with_probe_data(AVIOContext *s, unsigned char **bufp, int buf_si
         buf_size = new_size;
     }
 
-    av_free(s->buffer);
-    s->buf_ptr = s->buffer = buf;
+    replace_buffer(s, buf, NULL);
+    s->buf_ptr = buf;
     s->buffer_size = alloc_size;
     s->pos = buf_size;
     s->buf_end = s->buf_ptr + buf_size;
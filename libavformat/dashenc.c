@@ -53,6 +53,7 @@
 #include "os_support.h"
 #include "url.h"
 #include "dash.h"
+#include "writequeue.h"
 
 typedef enum {
     SEGMENT_TYPE_AUTO = 0,
@@ -82,6 +83,7 @@ typedef struct Segment {
     double prog_date_time;
     int64_t duration;
     int n;
+    uint64_t queue_pos; /* with async_io, written once the write queue has done this many operations */
 } Segment;
 
 typedef struct AdaptationSet {
@@ -143,6 +145,8 @@ typedef struct OutputStream {
     int64_t gop_size;
     AVRational sar;
     int coding_dependency;
+    FFWriteQueue *write_queue; /* segment output, with async_io */
+    int nb_segments_pending; /* still being written when the manifest was last written */
 } OutputStream;
 
 typedef struct DASHContext {
@@ -187,6 +191,7 @@ typedef struct DASHContext {
     int global_sidx;
     SegmentType segment_type_option;  /* segment type as specified in options */
     int ignore_io_errors;
+    int async_io;
     int lhls;
     int ldash;
     int master_publish_rate;
@@ -496,6 +501,9 @@ static void dash_free(AVFormatContext *s)
             else
                 ff_format_io_close(s, &os->ctx->pb);
         }
+        if (os->write_queue && !c->streaming)
+            ffio_free_dyn_buf(&os->out);
+        ff_write_queue_free(&os->write_queue);
         ff_format_io_close(s, &os->out);
         avformat_free_context(os->ctx);
         avcodec_free_context(&os->parser_avctx);
@@ -1326,6 +1334,11 @@ static int dash_init(AVFormatContext *s)
         c->write_prft = 0;
     }
 
+    if (c->async_io && c->http_persistent) {
+        av_log(s, AV_LOG_WARNING, "http_persistent is not supported with async_io, disabling it.\n");
+        c->http_persistent = 0;
+    }
+
     if (c->ldash && !c->write_prft) {
         av_log(s, AV_LOG_WARNING, "Low Latency mode enabled without Producer Reference Time element option! Resulting manifest may not be complaint\n");
     }
@@ -1605,6 +1618,18 @@ static int dash_init(AVFormatContext *s)
     if (!c->has_video && c->frag_type == FRAG_TYPE_PFRAMES)
         av_log(s, AV_LOG_WARNING, "no video stream and P-frame fragmentation set\n");
 
+    if (c->async_io && !c->single_file) {
+        for (i = 0; i < s->nb_streams; i++) {
+            ret = ff_write_queue_alloc(&c->streams[i].write_queue, s);
+            if (ret == AVERROR(ENOSYS)) {
+                av_log(s, AV_LOG_WARNING, "async_io is not supported without threads.\n");
+                break;
+            } else if (ret < 0) {
+                return ret;
+            }
+        }
+    }
+
     c->nr_of_streams_flushed = 0;
     c->target_latency_refid = -1;
 
@@ -1757,10 +1782,11 @@ static void dashenc_delete_file(AVFormatContext *s, char *filename) {
     }
 }
 
-static int dashenc_delete_segment_file(AVFormatContext *s, const char* file)
+static int dashenc_delete_segment_file(AVFormatContext *s, OutputStream *os, const char* file)
 {
     DASHContext *c = s->priv_data;
     AVBPrint buf;
+    int ret = 0;
 
     av_bprint_init(&buf, 0, AV_BPRINT_SIZE_UNLIMITED);
 
@@ -1771,16 +1797,31 @@ static int dashenc_delete_segment_file(AVFormatContext *s, const char* file)
         return AVERROR(ENOMEM);
     }
 
-    dashenc_delete_file(s, buf.str);
+    if (os->write_queue) {
+        AVDictionary *http_opts = NULL;
+
+        if (ff_is_http_proto(buf.str)) {
+            set_http_options(&http_opts, c);
+            av_dict_set(&http_opts, "method", "DELETE", 0);
+        }
+        ret = ff_write_queue_delete(os->write_queue, buf.str, http_opts);
+        av_dict_free(&http_opts);
+    } else {
+        dashenc_delete_file(s, buf.str);
+    }
 
     av_bprint_finalize(&buf, NULL);
-    return 0;
+    return ret;
 }
 
-static inline void dashenc_delete_media_segments(AVFormatContext *s, OutputStream *os, int remove_count)
+static inline int dashenc_delete_media_segments(AVFormatContext *s, OutputStream *os, int remove_count)
 {
+    int ret = 0;
+
     for (int i = 0; i < remove_count; ++i) {
-        dashenc_delete_segment_file(s, os->segments[i]->file);
+        int err = dashenc_delete_segment_file(s, os, os->segments[i]->file);
+        if (err < 0 && !ret)
+            ret = err;
 
         // Delete the segment regardless of whether the file was successfully deleted
         av_free(os->segments[i]);
@@ -1788,6 +1829,112 @@ static inline void dashenc_delete_media_segments(AVFormatContext *s, OutputStrea
 
     os->nb_segments -= remove_count;
     memmove(os->segments, os->segments + remove_count, os->nb_segments * sizeof(*os->segments));
+    return ret;
+}
+
+/* Hand the finished segment over to the write queue of the representation. */
+static int dash_queue_segment(AVFormatContext *s, OutputStream *os, int use_rename)
+{
+    DASHContext *c = s->priv_data;
+    const char *final_path = use_rename ? os->full_path : NULL;
+    AVDictionary *opts = NULL;
+    uint8_t *buf;
+    int size, ret;
+
+    if (!os->out)
+        return 0;
+    if (c->streaming)
+        return ff_write_queue_close(os->write_queue, &os->out, os->temp_path, final_path);
+
+    size = avio_close_dyn_buf(os->out, &buf);
+    os->out = NULL;
+    set_http_options(&opts, c);
+    ret = ff_write_queue_write(os->write_queue, os->temp_path, opts, buf, size, final_path);
+    av_dict_free(&opts);
+    return ret;
+}
+
+/* Check for failures of the queued output of all representations,
+ * optionally waiting for it to be done. */
+static int dash_check_write_queues(AVFormatContext *s, int wait)
+{
+    DASHContext *c = s->priv_data;
+    int ret = 0;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        OutputStream *os = &c->streams[i];
+        int err;
+
+        if (!os->write_queue)
+            continue;
+        err = wait ? ff_write_queue_wait(os->write_queue) :
+                     ff_write_queue_error(os->write_queue);
+        if (err < 0 && !ret && !c->ignore_io_errors)
+            ret = err;
+    }
+    return ret;
+}
+
+/* Number of the most recent segments of a representation that are still
+ * being written by its write queue. */
+static int dash_segments_pending(OutputStream *os)
+{
+    uint64_t done;
+    int nb = 0;
+
+    if (!os->write_queue)
+        return 0;
+
+    done = ff_write_queue_done(os->write_queue);
+    while (nb < os->nb_segments &&
+           os->segments[os->nb_segments - 1 - nb]->queue_pos > done)
+        nb++;
+    return nb;
+}
+
+/* Write the manifest, announcing only the segments that have been written
+ * completely. Each representation lists its segments as they complete,
+ * without waiting for the others. */
+static int dash_write_manifest(AVFormatContext *s, int final)
+{
+    DASHContext *c = s->priv_data;
+    int ret;
+
+    if (c->streaming)
+        return write_manifest(s, final);
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        OutputStream *os = &c->streams[i];
+
+        os->nb_segments_pending = dash_segments_pending(os);
+        os->nb_segments        -= os->nb_segments_pending;
+        os->segment_index      -= os->nb_segments_pending;
+    }
+
+    ret = write_manifest(s, final);
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        OutputStream *os = &c->streams[i];
+
+        os->nb_segments   += os->nb_segments_pending;
+        os->segment_index += os->nb_segments_pending;
+    }
+    return ret;
+}
+
+/* Update the manifest if segments left out of it have been written since. */
+static int dash_announce_segments(AVFormatContext *s)
+{
+    DASHContext *c = s->priv_data;
+
+    for (int i = 0; i < s->nb_streams; i++) {
+        OutputStream *os = &c->streams[i];
+
+        if (os->nb_segments_pending &&
+            dash_segments_pending(os) < os->nb_segments_pending)
+            return dash_write_manifest(s, 0);
+    }
+    return 0;
 }
 
 static int dash_flush(AVFormatContext *s, int final, int stream)
@@ -1818,6 +1965,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         OutputStream *os = &c->streams[i];
         AVStream *st = s->streams[i];
         int range_length, index_length = 0;
+        uint64_t queue_pos = 0;
         int64_t duration;
 
         if (!os->packets_written)
@@ -1848,6 +1996,11 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
 
         if (c->single_file) {
             find_index_range(s, os->full_path, os->pos, &index_length);
+        } else if (os->write_queue) {
+            ret = dash_queue_segment(s, os, use_rename);
+            if (ret < 0)
+                break;
+            queue_pos = ff_write_queue_queued(os->write_queue);
         } else {
             dashenc_io_close(s, &os->out, os->temp_path);
 
@@ -1870,7 +2023,10 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (!os->bit_rate && !os->first_segment_bit_rate) {
             os->first_segment_bit_rate = (int64_t) range_length * 8 * AV_TIME_BASE / duration;
         }
-        add_segment(os, os->filename, os->start_pts, os->max_pts - os->start_pts, os->pos, range_length, index_length, next_exp_index);
+        ret = add_segment(os, os->filename, os->start_pts, os->max_pts - os->start_pts, os->pos, range_length, index_length, next_exp_index);
+        if (ret < 0)
+            break;
+        os->segments[os->nb_segments - 1]->queue_pos = queue_pos;
         av_log(s, AV_LOG_VERBOSE, "Representation %d media segment %d written to: %s\n", i, os->segment_index, os->full_path);
 
         os->pos += range_length;
@@ -1880,8 +2036,9 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         for (i = 0; i < s->nb_streams; i++) {
             OutputStream *os = &c->streams[i];
             int remove_count = os->nb_segments - c->window_size - c->extra_window_size;
-            if (remove_count > 0)
-                dashenc_delete_media_segments(s, os, remove_count);
+            if (remove_count > 0 &&
+                (ret = dashenc_delete_media_segments(s, os, remove_count)) < 0)
+                return ret;
         }
     }
 
@@ -1918,8 +2075,11 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         }
         // In streaming mode the manifest is written at the beginning
         // of the segment instead
-        if (!c->streaming || final)
-            ret = write_manifest(s, final);
+        if (!c->streaming || final) {
+            ret = dash_check_write_queues(s, final);
+            if (ret >= 0)
+                ret = dash_write_manifest(s, final);
+        }
     }
     return ret;
 }
@@ -1963,6 +2123,11 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
     if (ret < 0)
         return ret;
 
+    // with async_io, announce segments written in the background since
+    ret = dash_announce_segments(s);
+    if (ret < 0)
+        return ret;
+
     // Fill in a heuristic guess of the packet duration, if none is available.
     // The mp4 muxer will do something similar (for the last packet in a fragment)
     // if nothing is set (setting it for the other packets doesn't hurt).
@@ -2144,7 +2309,11 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
         snprintf(os->temp_path, sizeof(os->temp_path),
                  use_rename ? "%s.tmp" : "%s", os->full_path);
         set_http_options(&opts, c);
-        ret = dashenc_io_open(s, &os->out, os->temp_path, &opts);
+        // with async_io, non-streaming segments are collected in memory
+        if (os->write_queue && !c->streaming)
+            ret = avio_open_dyn_buf(&os->out);
+        else
+            ret = dashenc_io_open(s, &os->out, os->temp_path, &opts);
         av_dict_free(&opts);
         if (ret < 0) {
             return handle_io_open_error(s, ret, os->temp_path);
@@ -2198,11 +2367,14 @@ static int dash_write_trailer(AVFormatContext *s)
     }
     dash_flush(s, 1, -1);
 
+    for (i = 0; i < s->nb_streams; i++)
+        ff_write_queue_free(&c->streams[i].write_queue);
+
     if (c->remove_at_exit) {
         for (i = 0; i < s->nb_streams; ++i) {
             OutputStream *os = &c->streams[i];
             dashenc_delete_media_segments(s, os, os->nb_segments);
-            dashenc_delete_segment_file(s, os->initfile);
+            dashenc_delete_segment_file(s, os, os->initfile);
             if (c->hls_playlist && os->segment_type == SEGMENT_TYPE_MP4) {
                 char filename[1024];
                 get_hls_playlist_name(filename, sizeof(filename), c->dirname, i);
@@ -2265,6 +2437,7 @@ static const AVOption options[] = {
     { "http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
     { "http_user_agent", "override User-Agent field in HTTP header", OFFSET(user_agent), AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, E},
     { "ignore_io_errors", "Ignore IO errors during open and write. Useful for long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "async_io", "Write the segments of each representation on a separate thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "index_correction", "Enable/Disable segment index correction logic", OFFSET(index_correction), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { "init_seg_name", "DASH-templated name to used for the initialization segment", OFFSET(init_seg_name), AV_OPT_TYPE_STRING, {.str = "init-stream$RepresentationID$.$ext$"}, 0, 0, E },
     { "ldash", "Enable Low-latency dash. Constrains the value of a few elements", OFFSET(ldash), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
@@ -32,6 +32,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -289,6 +290,14 @@ int avformat_open_input(AVFormatContext **ps, const char *filename,
         goto fail;
     }
 
+    if (s->zerocopy_buffer_size && s->pb) {
+        ret = ffio_set_buffer_pool(s->pb, s->zerocopy_buffer_size);
+        if (ret == AVERROR(ENOSYS))
+            av_log(s, AV_LOG_WARNING, "Zero-copy reading is not supported for this input\n");
+        else if (ret < 0)
+            goto fail;
+    }
+
     avio_skip(s->pb, s->skip_initial_bytes);
 
     /* Check filename in case an image number is expected. */
@@ -2147,6 +2156,7 @@ static int try_decode_frame(AVFormatContext *s, AVStream *st,
     int do_skip_frame = 0;
     enum AVDiscard skip_frame;
     int pkt_to_send = pkt->size > 0;
+    int64_t start_time = av_gettime_relative();
 
     if (!frame)
         return AVERROR(ENOMEM);
@@ -2222,8 +2232,10 @@ static int try_decode_frame(AVFormatContext *s, AVStream *st,
                 pkt_to_send = 0;
         }
         if (ret >= 0) {
-            if (got_picture)
+            if (got_picture) {
                 sti->nb_decoded_frames++;
+                sti->probe_stats.nb_frames++;
+            }
             ret       = got_picture;
         }
     }
@@ -2234,6 +2246,7 @@ fail:
     }
 
     av_frame_free(&frame);
+    sti->probe_stats.decode_time += av_gettime_relative() - start_time;
     return ret;
 }
 
@@ -2603,11 +2616,208 @@ fail:
     return ret;
 }
 
+typedef struct ProbeThreadContext {
+    AVFormatContext *ic;
+    AVDictionary   **options;
+    unsigned         orig_nb_streams;
+
+    AVSliceThread   *thread;
+    int              nb_threads;
+
+    /* number of streams with a queued packet */
+    int              nb_pending;
+
+    /* indices of the streams to process in an execution */
+    unsigned        *jobs;
+    unsigned         nb_jobs;
+    int              flush;
+} ProbeThreadContext;
+
+static int probe_thread_worker(void *priv, int jobnr, int threadnr,
+                               int nb_jobs, int nb_threads)
+{
+    ProbeThreadContext *const pt = priv;
+    unsigned stream_index = pt->jobs[jobnr];
+    AVStream *const st  = pt->ic->streams[stream_index];
+    FFStream *const sti = ffstream(st);
+    AVDictionary **options = (pt->options && stream_index < pt->orig_nb_streams) ?
+                             &pt->options[stream_index] : NULL;
+    int nb_frames;
+
+    if (pt->flush) {
+        AVPacket *const empty_pkt = ffformatcontext(pt->ic)->pkt;
+        if (try_decode_frame(pt->ic, st, empty_pkt, options) < 0)
+            av_log(pt->ic, AV_LOG_INFO, "decoding for stream %d failed\n", st->index);
+        return 0;
+    }
+
+    /* decode with the packet count seen when decoding on the calling thread */
+    nb_frames = sti->codec_info_nb_frames;
+    sti->codec_info_nb_frames = sti->info->probe_pkt_nb_frames;
+    try_decode_frame(pt->ic, st, sti->info->probe_pkt, options);
+    sti->codec_info_nb_frames = nb_frames;
+
+    av_packet_unref(sti->info->probe_pkt);
+    sti->info->probe_pkt_pending = 0;
+
+    return 0;
+}
+
+static int probe_thread_init(ProbeThreadContext *pt, AVFormatContext *ic,
+                             AVDictionary **options, unsigned orig_nb_streams)
+{
+    int ret;
+
+    pt->ic              = ic;
+    pt->options         = options;
+    pt->orig_nb_streams = orig_nb_streams;
+
+    if (ic->probe_threads == 1)
+        return 0;
+
+    ret = avpriv_slicethread_create2(&pt->thread, pt, probe_thread_worker,
+                                     NULL, ic->probe_threads);
+    if (ret == AVERROR(ENOSYS))
+        return 0;
+    if (ret < 0)
+        return ret;
+    if (ret <= 1) {
+        avpriv_slicethread_free(&pt->thread);
+        return 0;
+    }
+    pt->nb_threads = ret;
+
+    return 0;
+}
+
+static void probe_thread_uninit(ProbeThreadContext *pt)
+{
+    avpriv_slicethread_free(&pt->thread);
+    av_freep(&pt->jobs);
+}
+
+/**
+ * Decode the queued packets of all streams in parallel.
+ */
+static int probe_thread_execute(ProbeThreadContext *pt)
+{
+    AVFormatContext *const ic = pt->ic;
+    unsigned *jobs;
+
+    if (!pt->nb_pending)
+        return 0;
+
+    jobs = av_realloc_array(pt->jobs, ic->nb_streams, sizeof(*pt->jobs));
+    if (!jobs)
+        return AVERROR(ENOMEM);
+    pt->jobs = jobs;
+
+    pt->nb_jobs = 0;
+    for (unsigned i = 0; i < ic->nb_streams; i++)
+        if (ffstream(ic->streams[i])->info->probe_pkt_pending)
+            pt->jobs[pt->nb_jobs++] = i;
+
+    avpriv_slicethread_execute2(pt->thread, pt->nb_jobs, 0);
+    pt->nb_jobs    = 0;
+    pt->nb_pending = 0;
+
+    return 0;
+}
+
+/**
+ * Queue a packet for decoding on a worker thread. Each stream has at most
+ * one packet queued, so the decoders see the same sequence of packets as
+ * when decoding on the calling thread, one interleaving cycle later.
+ */
+static int probe_thread_queue(ProbeThreadContext *pt, AVStream *st,
+                              const AVPacket *pkt)
+{
+    FFStream *const sti = ffstream(st);
+    AVCodecContext *const avctx = sti->avctx;
+    int ret;
+
+    /* Nothing is left to decode for this stream: try_decode_frame()
+     * would return immediately. */
+    if (!sti->info->probe_pkt_pending && avcodec_is_open(avctx) &&
+        has_codec_parameters(st, NULL) && has_decode_delay_been_guessed(st) &&
+        (sti->codec_info_nb_frames || !(avctx->codec->capabilities & AV_CODEC_CAP_CHANNEL_CONF)))
+        return 0;
+
+    if (sti->info->probe_pkt_pending) {
+        ret = probe_thread_execute(pt);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (!sti->info->probe_pkt) {
+        sti->info->probe_pkt = av_packet_alloc();
+        if (!sti->info->probe_pkt)
+            return AVERROR(ENOMEM);
+    }
+    ret = av_packet_ref(sti->info->probe_pkt, pkt);
+    if (ret < 0)
+        return ret;
+    sti->info->probe_pkt_pending   = 1;
+    sti->info->probe_pkt_nb_frames = sti->codec_info_nb_frames;
+
+    if (++pt->nb_pending >= pt->nb_threads)
+        return probe_thread_execute(pt);
+    return 0;
+}
+
+/**
+ * Check whether probing has found everything needed for a stream.
+ */
+static int stream_info_complete(AVFormatContext *ic, AVStream *st)
+{
+    FFStream *const sti = ffstream(st);
+    int fps_analyze_framecount = 20;
+    int count;
+
+    if (!has_codec_parameters(st, NULL))
+        return 0;
+    /* If the timebase is coarse (like the usual millisecond precision
+     * of mkv), we need to analyze more frames to reliably arrive at
+     * the correct fps. */
+    if (av_q2d(st->time_base) > 0.0005)
+        fps_analyze_framecount *= 2;
+    if (!tb_unreliable(ic, st))
+        fps_analyze_framecount = 0;
+    if (ic->fps_probe_size >= 0)
+        fps_analyze_framecount = ic->fps_probe_size;
+    if (st->disposition & AV_DISPOSITION_ATTACHED_PIC)
+        fps_analyze_framecount = 0;
+    /* variable fps and no guess at the real fps */
+    count = (ic->iformat->flags & AVFMT_NOTIMESTAMPS) ?
+               sti->info->codec_info_duration_fields/2 :
+               sti->info->duration_count;
+    if (!(st->r_frame_rate.num && st->avg_frame_rate.num) &&
+        st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+        if (count < fps_analyze_framecount)
+            return 0;
+    }
+    // Look at the first 3 frames if there is evidence of frame delay
+    // but the decoder delay is not set.
+    if (sti->info->frame_delay_evidence && count < 2 && sti->avctx->has_b_frames == 0)
+        return 0;
+    if (!sti->avctx->extradata &&
+        (!sti->extract_extradata.inited || sti->extract_extradata.bsf) &&
+        extract_extradata_check(st))
+        return 0;
+    if (sti->first_dts == AV_NOPTS_VALUE &&
+        (!(ic->iformat->flags & AVFMT_NOTIMESTAMPS) || sti->need_parsing == AVSTREAM_PARSE_FULL_RAW) &&
+        sti->codec_info_nb_frames < ((st->disposition & AV_DISPOSITION_ATTACHED_PIC) ? 1 : ic->max_ts_probe) &&
+        (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
+         st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO))
+        return 0;
+    return 1;
+}
+
 int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 {
     FFFormatContext *const si = ffformatcontext(ic);
     int count = 0, ret = 0, err;
-    int64_t read_size;
+    int64_t read_size, total_read_size;
     AVPacket *pkt1 = si->pkt;
     int64_t old_offset  = avio_tell(ic->pb);
     // new streams might appear, no options for those
@@ -2618,6 +2828,10 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     int64_t max_subtitle_analyze_duration;
     int64_t probesize = ic->probesize;
     int eof_reached = 0;
+    ProbeThreadContext pt = { 0 };
+    /* streams whose parameters are complete stop counting towards the
+     * limits of the others */
+    const int per_stream_limits = ic->probe_per_stream;
 
     flush_codecs = probesize > 0;
 
@@ -2648,6 +2862,8 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         FFStream *const sti = ffstream(st);
         AVCodecContext *const avctx = sti->avctx;
 
+        memset(&sti->probe_stats, 0, sizeof(sti->probe_stats));
+
         /* check if the caller has overridden the codec id */
         // only for the split stuff
         if (!sti->parser && !(ic->flags & AVFMT_FLAG_NOPARSE) && sti->request_probe <= 0) {
@@ -2697,13 +2913,18 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             av_dict_free(&thread_opt);
     }
 
-    read_size = 0;
+    ret = probe_thread_init(&pt, ic, options, orig_nb_streams);
+    if (ret < 0)
+        goto find_stream_info_err;
+
+    read_size = total_read_size = 0;
     for (;;) {
         const AVPacket *pkt;
         AVStream *st;
         FFStream *sti;
         AVCodecContext *avctx;
         int analyzed_all_streams;
+        unsigned nb_incomplete;
         unsigned i;
         if (ff_check_interrupt(&ic->interrupt_callback)) {
             ret = AVERROR_EXIT;
@@ -2719,51 +2940,20 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             goto unref_then_goto_end;
 
         /* check if one codec still needs to be handled */
+        nb_incomplete = 0;
         for (i = 0; i < ic->nb_streams; i++) {
-            AVStream *const st  = ic->streams[i];
-            FFStream *const sti = ffstream(st);
-            int fps_analyze_framecount = 20;
-            int count;
+            FFStream *const sti = ffstream(ic->streams[i]);
 
-            if (!has_codec_parameters(st, NULL))
-                break;
-            /* If the timebase is coarse (like the usual millisecond precision
-             * of mkv), we need to analyze more frames to reliably arrive at
-             * the correct fps. */
-            if (av_q2d(st->time_base) > 0.0005)
-                fps_analyze_framecount *= 2;
-            if (!tb_unreliable(ic, st))
-                fps_analyze_framecount = 0;
-            if (ic->fps_probe_size >= 0)
-                fps_analyze_framecount = ic->fps_probe_size;
-            if (st->disposition & AV_DISPOSITION_ATTACHED_PIC)
-                fps_analyze_framecount = 0;
-            /* variable fps and no guess at the real fps */
-            count = (ic->iformat->flags & AVFMT_NOTIMESTAMPS) ?
-                       sti->info->codec_info_duration_fields/2 :
-                       sti->info->duration_count;
-            if (!(st->r_frame_rate.num && st->avg_frame_rate.num) &&
-                st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-                if (count < fps_analyze_framecount)
+            sti->info->probe_complete = stream_info_complete(ic, ic->streams[i]);
+            if (!sti->info->probe_complete) {
+                nb_incomplete++;
+                /* without per-stream limits, one stream is enough */
+                if (!per_stream_limits)
                     break;
             }
-            // Look at the first 3 frames if there is evidence of frame delay
-            // but the decoder delay is not set.
-            if (sti->info->frame_delay_evidence && count < 2 && sti->avctx->has_b_frames == 0)
-                break;
-            if (!sti->avctx->extradata &&
-                (!sti->extract_extradata.inited || sti->extract_extradata.bsf) &&
-                extract_extradata_check(st))
-                break;
-            if (sti->first_dts == AV_NOPTS_VALUE &&
-                (!(ic->iformat->flags & AVFMT_NOTIMESTAMPS) || sti->need_parsing == AVSTREAM_PARSE_FULL_RAW) &&
-                sti->codec_info_nb_frames < ((st->disposition & AV_DISPOSITION_ATTACHED_PIC) ? 1 : ic->max_ts_probe) &&
-                (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
-                 st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO))
-                break;
         }
         analyzed_all_streams = 0;
-        if (i == ic->nb_streams && !si->missing_streams) {
+        if (!nb_incomplete && !si->missing_streams) {
             analyzed_all_streams = 1;
             /* NOTE: If the format has no header, then we need to read some
              * packets to get most of the streams, so we cannot stop here. */
@@ -2775,8 +2965,11 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
                 break;
             }
         }
-        /* We did not get all the codec info, but we read too much data. */
-        if (read_size >= probesize) {
+        /* We did not get all the codec info, but we read too much data.
+         * With per-stream limits, the complete streams are not counted in
+         * read_size, the whole input is bounded by probe_total_size. */
+        if (read_size >= probesize ||
+            per_stream_limits && total_read_size >= ic->probe_total_size) {
             ret = count;
             av_log(ic, AV_LOG_DEBUG,
                    "Probe buffer size limit of %"PRId64" bytes reached\n", probesize);
@@ -2819,8 +3012,13 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 
         st  = ic->streams[pkt->stream_index];
         sti = ffstream(st);
-        if (!(st->disposition & AV_DISPOSITION_ATTACHED_PIC))
-            read_size += pkt->size;
+        if (!(st->disposition & AV_DISPOSITION_ATTACHED_PIC)) {
+            total_read_size += pkt->size;
+            if (!per_stream_limits || analyzed_all_streams || !sti->info->probe_complete)
+                read_size += pkt->size;
+        }
+        sti->probe_stats.nb_packets++;
+        sti->probe_stats.bytes += pkt->size;
 
         avctx = sti->avctx;
         if (!sti->avctx_inited) {
@@ -2889,6 +3087,9 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
             if (analyzed_all_streams)                                limit = max_analyze_duration;
             else if (avctx->codec_type == AVMEDIA_TYPE_SUBTITLE) limit = max_subtitle_analyze_duration;
             else                                                     limit = max_stream_analyze_duration;
+            /* a complete stream only ends probing the others at the global limit */
+            if (per_stream_limits && !analyzed_all_streams && sti->info->probe_complete)
+                limit = ic->probe_total_duration;
 
             if (t >= limit) {
                 av_log(ic, AV_LOG_VERBOSE, "max_analyze_duration %"PRId64" reached at %"PRId64" microseconds st:%d\n",
@@ -2932,8 +3133,13 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
          * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+        if (pt.thread) {
+            ret = probe_thread_queue(&pt, st, pkt);
+            if (ret < 0)
+                goto unref_then_goto_end;
+        } else
+            try_decode_frame(ic, st, pkt,
+                             (options && i < orig_nb_streams) ? &options[i] : NULL);
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt1);
@@ -2942,6 +3148,14 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         count++;
     }
 
+    if (pt.thread) {
+        err = probe_thread_execute(&pt);
+        if (err < 0) {
+            ret = err;
+            goto find_stream_info_err;
+        }
+    }
+
     if (eof_reached) {
         for (unsigned stream_index = 0; stream_index < ic->nb_streams; stream_index++) {
             AVStream *const st = ic->streams[stream_index];
@@ -2967,7 +3181,24 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         }
     }
 
-    if (flush_codecs) {
+    if (flush_codecs && pt.thread) {
+        unsigned *jobs = av_realloc_array(pt.jobs, ic->nb_streams, sizeof(*pt.jobs));
+        if (!jobs) {
+            ret = AVERROR(ENOMEM);
+            goto find_stream_info_err;
+        }
+        pt.jobs = jobs;
+        av_packet_unref(si->pkt);
+
+        /* flush the decoders */
+        for (unsigned i = 0; i < ic->nb_streams; i++)
+            if (ffstream(ic->streams[i])->info->found_decoder == 1)
+                pt.jobs[pt.nb_jobs++] = i;
+        pt.flush = 1;
+        if (pt.nb_jobs)
+            avpriv_slicethread_execute2(pt.thread, pt.nb_jobs, 0);
+        pt.nb_jobs = 0;
+    } else if (flush_codecs) {
         AVPacket *empty_pkt = si->pkt;
         int err = 0;
         av_packet_unref(empty_pkt);
@@ -3182,6 +3413,7 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     }
 
 find_stream_info_err:
+    probe_thread_uninit(&pt);
     for (unsigned i = 0; i < ic->nb_streams; i++) {
         AVStream *const st  = ic->streams[i];
         FFStream *const sti = ffstream(st);
@@ -3189,6 +3421,7 @@ find_stream_info_err:
 
         if (sti->info) {
             av_freep(&sti->info->duration_error);
+            av_packet_free(&sti->info->probe_pkt);
             av_freep(&sti->info);
         }
 
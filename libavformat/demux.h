@@ -215,6 +215,20 @@ typedef struct FFStreamInfo {
     int     fps_first_dts_idx;
     int64_t fps_last_dts;
     int     fps_last_dts_idx;
+
+    /**
+     * Packet waiting to be decoded on a worker thread, used when
+     * avformat_find_stream_info() decodes streams in parallel.
+     */
+    AVPacket *probe_pkt;
+    int       probe_pkt_pending;
+    int       probe_pkt_nb_frames; ///< codec_info_nb_frames when queued
+
+    /**
+     * Everything needed for this stream has been found, used by
+     * avformat_find_stream_info() with AVFormatContext.probe_per_stream.
+     */
+    int probe_complete;
 } FFStreamInfo;
 
 /**
@@ -38,6 +38,11 @@ struct AVCodecParserContext *av_stream_get_parser(const AVStream *st)
     return cffstream(st)->parser;
 }
 
+const AVStreamProbeStats *av_stream_get_probe_stats(const AVStream *st)
+{
+    return &cffstream(st)->probe_stats;
+}
+
 void avpriv_stream_set_need_parsing(AVStream *st, enum AVStreamParseType type)
 {
     ffstream(st)->need_parsing = type;
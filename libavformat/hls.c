@@ -52,6 +52,7 @@
 
 #define MAX_FIELD_LEN 64
 #define MAX_CHARACTERISTICS_LEN 512
+#define MAX_PREFETCH_SEGMENTS 16
 
 #define MPEG_TIME_BASE 90000
 #define MPEG_TIME_BASE_Q (AVRational){1, MPEG_TIME_BASE}
@@ -106,8 +107,11 @@ struct playlist {
     AVIOContext *input;
     int input_read_done;
     int input_reuse;
-    AVIOContext *input_next;
-    int input_next_requested;
+    /* requests opened ahead for upcoming segments, ordered by sequence number */
+    AVIOContext *input_next[MAX_PREFETCH_SEGMENTS];
+    int64_t input_next_seq_no[MAX_PREFETCH_SEGMENTS];
+    int n_input_next;
+    AVIOContext *input_spare; /* finished persistent connection, reused for the next request */
     AVFormatContext *parent;
     int index;
     AVFormatContext *ctx;
@@ -245,6 +249,7 @@ typedef struct HLSContext {
     int http_persistent;
     int http_multiple;
     int http_seekable;
+    int prefetch_segments;
     int seg_max_retry;
     AVIOContext *playlist_pb;
     HLSCryptoContext  crypto_ctx;
@@ -279,6 +284,14 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+static void close_input_next(AVFormatContext *s, struct playlist *pls)
+{
+    for (int i = 0; i < pls->n_input_next; i++)
+        ff_format_io_close(s, &pls->input_next[i]);
+    pls->n_input_next = 0;
+    ff_format_io_close(s, &pls->input_spare);
+}
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
@@ -298,8 +311,7 @@ static void free_playlist_list(HLSContext *c)
         ff_format_io_close(c->ctx, &pls->input);
         pls->input_read_done = 0;
         pls->input_reuse = 0;
-        ff_format_io_close(c->ctx, &pls->input_next);
-        pls->input_next_requested = 0;
+        close_input_next(c->ctx, pls);
         if (pls->ctx) {
             pls->ctx->pb = NULL;
             avformat_close_input(&pls->ctx);
@@ -674,6 +686,16 @@ static int is_native_http(AVIOContext *pb)
 #endif
 }
 
+static int is_libcurl(AVIOContext *pb)
+{
+#if !CONFIG_LIBCURL_PROTOCOL
+    return 0;
+#else
+    URLContext *uc = ffio_geturlcontext(pb);
+    return uc && !strcmp(uc->prot->name, "libcurl");
+#endif
+}
+
 static int open_url_keepalive(AVFormatContext *s, AVIOContext **pb,
                               const char *url, AVDictionary **options)
 {
@@ -1201,6 +1223,17 @@ static struct segment *next_segment(struct playlist *pls)
     return pls->segments[n];
 }
 
+/* A request opened ahead with libcurl only learns from its reply whether it
+ * is seekable, after its AVIOContext was created. */
+static int input_seekable(AVIOContext *in)
+{
+    URLContext *uc = ffio_geturlcontext(in);
+
+    if (is_libcurl(in))
+        return !uc->is_streamed;
+    return in->seekable & AVIO_SEEKABLE_NORMAL;
+}
+
 /* True if 'next' can be reached by seeking the open 'in' instead of reopening.
  * An unencrypted, contiguous byte range directly following 'cur' in the same
  * seekable resource (i.e. consecutive EXT-X-BYTERANGE segments). */
@@ -1208,7 +1241,7 @@ static int segment_reusable(AVIOContext *in, const struct segment *cur,
                             const struct segment *next)
 {
     return in && cur && next &&
-           (in->seekable & AVIO_SEEKABLE_NORMAL) &&
+           input_seekable(in) &&
            cur->size >= 0 && next->size >= 0 &&
            next->url_offset == cur->url_offset + cur->size &&
            cur->key_type == KEY_NONE && next->key_type == KEY_NONE &&
@@ -1473,7 +1506,7 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg,
     /* Reuse a kept-open connection to the same resource by seeking instead of
      * reopening. For contiguous ranges the seek is a no-op and issues no request. */
     if (*in && pls->input_reuse && seg->key_type == KEY_NONE &&
-        ((*in)->seekable & AVIO_SEEKABLE_NORMAL)) {
+        input_seekable(*in)) {
         int64_t seek_ret = avio_seek(*in, seg->url_offset, SEEK_SET);
         pls->input_reuse = 0;
         if (seek_ret >= 0) {
@@ -1492,6 +1525,11 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg,
     if (c->http_persistent)
         av_dict_set(&opts, "multiple_requests", "1", 0);
 
+    /* With libcurl, segments requested ahead are transferred in the
+     * background, don't wait for their replies. */
+    if (seg != current_segment(pls) && is_libcurl(pls->input))
+        av_dict_set(&opts, "defer_open", "1", 0);
+
     if (seg->size >= 0) {
         /* Restrict the request to the wanted byte range. The end is extended
          * across following contiguous segments of the same resource so one
@@ -1758,6 +1796,80 @@ reload:
     return ret;
 }
 
+/* Drop the requests of segments that have been skipped, and switch to the
+ * request of the current segment if it was opened ahead. */
+static int take_input_next(struct playlist *pls)
+{
+    int n = 0, found = 0;
+
+    while (n < pls->n_input_next && pls->input_next_seq_no[n] < pls->cur_seq_no)
+        ff_format_io_close(pls->parent, &pls->input_next[n++]);
+
+    if (n < pls->n_input_next && pls->input_next_seq_no[n] == pls->cur_seq_no) {
+        ff_format_io_close(pls->parent, &pls->input_spare);
+        pls->input_spare = pls->input;
+        pls->input = pls->input_next[n++];
+        found = 1;
+    }
+
+    pls->n_input_next -= n;
+    memmove(pls->input_next, pls->input_next + n,
+            pls->n_input_next * sizeof(*pls->input_next));
+    memmove(pls->input_next_seq_no, pls->input_next_seq_no + n,
+            pls->n_input_next * sizeof(*pls->input_next_seq_no));
+    memset(pls->input_next + pls->n_input_next, 0,
+           n * sizeof(*pls->input_next));
+
+    return found;
+}
+
+/* Request up to prefetch_segments upcoming segments, so that they are
+ * transferred while the current one is being demuxed. Segments that are
+ * read by seeking the connection of the previous one are not requested. */
+static int open_input_next(HLSContext *c, struct playlist *pls)
+{
+    struct segment *prev = current_segment(pls);
+    int64_t seq_no = pls->cur_seq_no;
+    int i = 0;
+
+    while (seq_no - pls->cur_seq_no < c->prefetch_segments) {
+        int64_t n = ++seq_no - pls->start_seq_no;
+        struct segment *seg;
+        int ret;
+
+        if (n < 0 || n >= pls->n_segments)
+            break;
+        seg = pls->segments[n];
+
+        if (i < pls->n_input_next && pls->input_next_seq_no[i] == seq_no) {
+            i++;
+        } else if (seg->key_type != KEY_NONE || !av_strstart(seg->url, "http", NULL) ||
+                   i < pls->n_input_next) {
+            break;
+        } else if (!segment_reusable(pls->input, prev, seg)) {
+            AVIOContext **in = &pls->input_next[pls->n_input_next];
+
+            /* only a native HTTP connection can serve another request */
+            if (c->http_persistent && is_native_http(pls->input_spare))
+                FFSWAP(AVIOContext *, *in, pls->input_spare);
+            ret = open_input(c, pls, seg, in);
+            if (ret < 0) {
+                ff_format_io_close(pls->parent, in);
+                if (ff_check_interrupt(c->interrupt_callback))
+                    return AVERROR_EXIT;
+                av_log(pls->parent, AV_LOG_WARNING, "Failed to open segment %"PRId64" of playlist %d\n",
+                       seq_no, pls->index);
+                break;
+            }
+            pls->input_next_seq_no[pls->n_input_next++] = seq_no;
+            i++;
+        }
+        prev = seg;
+    }
+
+    return 0;
+}
+
 static int read_data_continuous(void *opaque, uint8_t *buf, int buf_size)
 {
     struct playlist *v = opaque;
@@ -1789,10 +1901,8 @@ restart:
         if (ret)
             return ret;
 
-        if (c->http_multiple == 1 && v->input_next_requested) {
-            FFSWAP(AVIOContext *, v->input, v->input_next);
+        if (c->http_multiple == 1 && take_input_next(v)) {
             v->cur_seg_offset = 0;
-            v->input_next_requested = 0;
             ret = 0;
         } else {
             ret = open_input(c, v, seg, &v->input);
@@ -1820,7 +1930,11 @@ restart:
             v->first_read_seq_no = v->cur_seq_no;
     }
 
-    if (c->http_multiple == -1) {
+    if (c->http_multiple == -1 && is_libcurl(v->input)) {
+        /* libcurl keeps a connection pool shared by all the requests of
+         * this demuxer, so requesting ahead costs no extra handshakes. */
+        c->http_multiple = 1;
+    } else if (c->http_multiple == -1) {
         uint8_t *http_version_opt = NULL;
         int r = av_opt_get(v->input, "http_version", AV_OPT_SEARCH_CHILDREN, &http_version_opt);
         if (r >= 0) {
@@ -1829,20 +1943,10 @@ restart:
         }
     }
 
-    seg = next_segment(v);
-    if (c->http_multiple == 1 && !v->input_next_requested &&
-        seg && seg->key_type == KEY_NONE && av_strstart(seg->url, "http", NULL) &&
-        !segment_reusable(v->input, current_segment(v), seg)) {
-        ret = open_input(c, v, seg, &v->input_next);
-        if (ret < 0) {
-            if (ff_check_interrupt(c->interrupt_callback))
-                return AVERROR_EXIT;
-            av_log(v->parent, AV_LOG_WARNING, "Failed to open segment %"PRId64" of playlist %d\n",
-                   v->cur_seq_no + 1,
-                   v->index);
-        } else {
-            v->input_next_requested = 1;
-        }
+    if (c->http_multiple == 1) {
+        ret = open_input_next(c, v);
+        if (ret < 0)
+            return ret;
     }
 
     if (v->init_sec_buf_read_offset < v->init_sec_data_len) {
@@ -1864,6 +1968,9 @@ restart:
 
         return ret;
     }
+    if (ret < 0 && ret != AVERROR_EOF && ret != AVERROR_EXIT)
+        av_log(v->parent, AV_LOG_WARNING, "Failed to read segment %"PRId64" of playlist %d: %s\n",
+               v->cur_seq_no, v->index, av_err2str(ret));
     if (ret == 0 && segment_reusable(v->input, seg, next_segment(v))) {
         /* Clean boundary, and the next segment continues this resource. Keep
          * the connection open and read it as a whole. Note that splitting
@@ -2471,9 +2578,7 @@ static int hls_read_header(AVFormatContext *s)
             pls->input = NULL;
             pls->input_read_done = 0;
             pls->input_reuse = 0;
-            ff_format_io_close(pls->parent, &pls->input_next);
-            pls->input_next = NULL;
-            pls->input_next_requested = 0;
+            close_input_next(pls->parent, pls);
             pls->cur_seg_offset = 0;
             pls->cur_init_section = NULL;
             /* Reset EOF flag */
@@ -2644,8 +2749,7 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             ff_format_io_close(pls->parent, &pls->input);
             pls->input_read_done = 0;
             pls->input_reuse = 0;
-            ff_format_io_close(pls->parent, &pls->input_next);
-            pls->input_next_requested = 0;
+            close_input_next(pls->parent, pls);
             if (pls->is_subtitle)
                 avformat_close_input(&pls->ctx);
             pls->needed = 0;
@@ -3031,8 +3135,7 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         pls->input_read_done = 0;
         pls->first_read_seq_no = -1;
         pls->input_reuse = 0;
-        ff_format_io_close(pls->parent, &pls->input_next);
-        pls->input_next_requested = 0;
+        close_input_next(pls->parent, pls);
         av_packet_unref(pls->pkt);
         pb->eof_reached = 0;
         /* Clear any buffered data */
@@ -3161,6 +3264,8 @@ static const AVOption hls_options[] = {
         OFFSET(http_multiple), AV_OPT_TYPE_BOOL, {.i64 = -1}, -1, 1, FLAGS},
     {"http_seekable", "Use HTTP partial requests, 0 = disable, 1 = enable, -1 = auto",
         OFFSET(http_seekable), AV_OPT_TYPE_BOOL, { .i64 = -1}, -1, 1, FLAGS},
+    {"prefetch_segments", "Number of upcoming segments to request ahead when http_multiple is enabled",
+        OFFSET(prefetch_segments), AV_OPT_TYPE_INT, {.i64 = 1}, 1, MAX_PREFETCH_SEGMENTS, FLAGS},
     {"seg_format_options", "Set options for segment demuxer",
         OFFSET(seg_format_opts), AV_OPT_TYPE_DICT, {.str = NULL}, 0, 0, FLAGS},
     {"seg_max_retry", "Maximum number of times to reload a segment on error.",
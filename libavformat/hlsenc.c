@@ -58,6 +58,7 @@
 #endif
 #include "os_support.h"
 #include "url.h"
+#include "writequeue.h"
 
 typedef enum {
     HLS_START_SEQUENCE_AS_START_NUMBER = 0,
@@ -192,6 +193,8 @@ typedef struct VariantStream {
     const char *ccgroup;  /* closed caption group name */
     const char *varname;  /* variant name */
     const char *subtitle_varname;  /* subtitle variant name */
+    FFWriteQueue *write_queue; /* segment and playlist output, with async_io */
+    int vtt_in_memory; /* vtt_avf->pb is a dynamic buffer, with async_io */
 } VariantStream;
 
 typedef struct ClosedCaptionsStream {
@@ -262,6 +265,7 @@ typedef struct HLSContext {
     AVIOContext *http_delete;
     int64_t timeout;
     int ignore_io_errors;
+    int async_io;
     char *headers;
     int has_default_key; /* has DEFAULT field of var_stream_map */
     int has_video_m3u8; /* has video stream m3u8 list */
@@ -505,10 +509,21 @@ static void reflush_dynbuf(VariantStream *vs, int *range_length)
     avio_write(vs->out, vs->temp_buffer, *range_length);
 }
 
-static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
+static int hls_delete_file(HLSContext *hls, VariantStream *vs, AVFormatContext *avf,
                            char *path, const char *proto)
 {
-    if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
+    if (vs->write_queue) {
+        AVDictionary *opt = NULL;
+        int ret;
+
+        if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
+            set_http_options(avf, &opt, hls);
+            av_dict_set(&opt, "method", "DELETE", 0);
+        }
+        ret = ff_write_queue_delete(vs->write_queue, path, opt);
+        av_dict_free(&opt);
+        return ret;
+    } else if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
         AVDictionary *opt = NULL;
         int ret;
 
@@ -606,7 +621,7 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
         }
 
         proto = avio_find_protocol_name(s->url);
-        if (ret = hls_delete_file(hls, s, path.str, proto))
+        if (ret = hls_delete_file(hls, vs, s, path.str, proto))
             goto fail;
 
         if ((segment->sub_filename[0] != '\0')) {
@@ -622,7 +637,7 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
                 goto fail;
             }
 
-            if (ret = hls_delete_file(hls, s, path.str, proto))
+            if (ret = hls_delete_file(hls, vs, s, path.str, proto))
                 goto fail;
         }
         av_bprint_clear(&path);
@@ -991,11 +1006,14 @@ static int sls_flag_check_duration_size(HLSContext *hls, VariantStream *vs)
     return ret;
 }
 
-static void sls_flag_file_rename(HLSContext *hls, VariantStream *vs, char *old_filename) {
+static int sls_flag_file_rename(HLSContext *hls, VariantStream *vs, char *old_filename) {
     if ((hls->flags & (HLS_SECOND_LEVEL_SEGMENT_SIZE | HLS_SECOND_LEVEL_SEGMENT_DURATION)) &&
         strlen(vs->current_segment_final_filename_fmt)) {
+        if (vs->write_queue)
+            return ff_write_queue_rename(vs->write_queue, old_filename, vs->avf->url);
         ff_rename(old_filename, vs->avf->url, hls);
     }
+    return 0;
 }
 
 static int sls_flag_use_localtime_filename(AVFormatContext *oc, HLSContext *c, VariantStream *vs)
@@ -1312,7 +1330,7 @@ static void hls_free_segments(HLSSegment *p)
     }
 }
 
-static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
+static int hls_rename_temp_file(AVFormatContext *s, VariantStream *vs, AVFormatContext *oc)
 {
     size_t len = strlen(oc->url);
     char *final_filename = av_strdup(oc->url);
@@ -1321,7 +1339,10 @@ static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
     if (!final_filename)
         return AVERROR(ENOMEM);
     final_filename[len-4] = '\0';
-    ret = ff_rename(oc->url, final_filename, s);
+    if (vs->write_queue)
+        ret = ff_write_queue_rename(vs->write_queue, oc->url, final_filename);
+    else
+        ret = ff_rename(oc->url, final_filename, s);
     oc->url[len-4] = '\0';
     av_freep(&final_filename);
     return ret;
@@ -1544,6 +1565,49 @@ fail:
     return ret;
 }
 
+/* Hand the WebVTT segment collected in memory over to the write queue, or
+ * write it directly once the queue is gone. */
+static int hls_vtt_flush(AVFormatContext *s, VariantStream *vs)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *vtt_oc = vs->vtt_avf;
+    AVDictionary *options = NULL;
+    AVIOContext *pb = NULL;
+    uint8_t *buf;
+    int size, ret;
+
+    size = avio_close_dyn_buf(vtt_oc->pb, &buf);
+    vtt_oc->pb = NULL;
+    vs->vtt_in_memory = 0;
+
+    set_http_options(s, &options, hls);
+    if (vs->write_queue) {
+        ret = ff_write_queue_write(vs->write_queue, vtt_oc->url, options,
+                                   buf, size, NULL);
+    } else {
+        ret = hlsenc_io_open(s, &pb, vtt_oc->url, &options);
+        if (ret >= 0) {
+            avio_write(pb, buf, size);
+            ret = hlsenc_io_close(s, &pb, vtt_oc->url);
+        }
+        av_free(buf);
+    }
+    av_dict_free(&options);
+    return ret;
+}
+
+/* Queue the playlist written to the dynamic buffer *pb. */
+static int hls_queue_playlist(VariantStream *vs, AVIOContext **pb, const char *filename,
+                              AVDictionary *options, const char *final_filename)
+{
+    uint8_t *buf;
+    int size = avio_close_dyn_buf(*pb, &buf);
+
+    *pb = NULL;
+    return ff_write_queue_write(vs->write_queue, filename, options,
+                                buf, size, final_filename);
+}
+
 static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 {
     HLSContext *hls = s->priv_data;
@@ -1563,6 +1627,9 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     double prog_date_time = vs->initial_prog_date_time;
     double *prog_date_time_p = (hls->flags & HLS_PROGRAM_DATE_TIME) ? &prog_date_time : NULL;
     int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+    AVIOContext *dyn_pb = NULL, *sub_dyn_pb = NULL;
+    AVIOContext **out = byterange_mode ? &hls->m3u8_out : &vs->out;
+    AVIOContext **sub_out = &hls->sub_m3u8_out;
 
     hls->version = 2;
     if (!(hls->flags & HLS_ROUND_DURATIONS)) {
@@ -1591,7 +1658,13 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_temp_file ? "%s.tmp" : "%s", vs->m3u8_name);
-    ret = hlsenc_io_open(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options);
+    if (vs->write_queue) {
+        /* the playlist is queued behind the segments it references */
+        out = &dyn_pb;
+        ret = avio_open_dyn_buf(out);
+    } else {
+        ret = hlsenc_io_open(s, out, temp_filename, &options);
+    }
     av_dict_free(&options);
     if (ret < 0) {
         goto fail;
@@ -1603,33 +1676,33 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     }
 
     vs->discontinuity_set = 0;
-    ff_hls_write_playlist_header(byterange_mode ? hls->m3u8_out : vs->out, hls->version, hls->allowcache,
+    ff_hls_write_playlist_header(*out, hls->version, hls->allowcache,
                                  target_duration, sequence, hls->pl_type, hls->flags & HLS_I_FRAMES_ONLY);
 
     if ((hls->flags & HLS_DISCONT_START) && sequence==hls->start_sequence && vs->discontinuity_set==0) {
-        avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-DISCONTINUITY\n");
+        avio_printf(*out, "#EXT-X-DISCONTINUITY\n");
         vs->discontinuity_set = 1;
     }
     if (vs->has_video && (hls->flags & HLS_INDEPENDENT_SEGMENTS)) {
-        avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-INDEPENDENT-SEGMENTS\n");
+        avio_printf(*out, "#EXT-X-INDEPENDENT-SEGMENTS\n");
     }
     for (en = vs->segments; en; en = en->next) {
         if ((hls->encrypt || hls->key_info_file) && (!key_uri || strcmp(en->key_uri, key_uri) ||
                                     av_strcasecmp(en->iv_string, iv_string))) {
-            avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"", en->key_uri);
+            avio_printf(*out, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"", en->key_uri);
             if (*en->iv_string)
-                avio_printf(byterange_mode ? hls->m3u8_out : vs->out, ",IV=0x%s", en->iv_string);
-            avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "\n");
+                avio_printf(*out, ",IV=0x%s", en->iv_string);
+            avio_printf(*out, "\n");
             key_uri = en->key_uri;
             iv_string = en->iv_string;
         }
 
         if ((hls->segment_type == SEGMENT_TYPE_FMP4) && (en == vs->segments)) {
-            ff_hls_write_init_file(byterange_mode ? hls->m3u8_out : vs->out, (hls->flags & HLS_SINGLE_FILE) ? en->filename : vs->fmp4_init_filename,
+            ff_hls_write_init_file(*out, (hls->flags & HLS_SINGLE_FILE) ? en->filename : vs->fmp4_init_filename,
                                    hls->flags & HLS_SINGLE_FILE, vs->init_range_length, 0);
         }
 
-        ret = ff_hls_write_file_entry(byterange_mode ? hls->m3u8_out : vs->out, en->discont, byterange_mode,
+        ret = ff_hls_write_file_entry(*out, en->discont, byterange_mode,
                                       en->duration, hls->flags & HLS_ROUND_DURATIONS,
                                       en->size, en->pos, hls->baseurl,
                                       en->filename,
@@ -1643,20 +1716,25 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     }
 
     if (last && (hls->flags & HLS_OMIT_ENDLIST)==0)
-        ff_hls_write_end_list(byterange_mode ? hls->m3u8_out : vs->out);
+        ff_hls_write_end_list(*out);
 
     if (vs->vtt_m3u8_name) {
         set_http_options(vs->vtt_avf, &options, hls);
         snprintf(temp_vtt_filename, sizeof(temp_vtt_filename), use_temp_file ? "%s.tmp" : "%s", vs->vtt_m3u8_name);
-        ret = hlsenc_io_open(s, &hls->sub_m3u8_out, temp_vtt_filename, &options);
+        if (vs->write_queue) {
+            sub_out = &sub_dyn_pb;
+            ret = avio_open_dyn_buf(sub_out);
+        } else {
+            ret = hlsenc_io_open(s, sub_out, temp_vtt_filename, &options);
+        }
         av_dict_free(&options);
         if (ret < 0) {
             goto fail;
         }
-        ff_hls_write_playlist_header(hls->sub_m3u8_out, hls->version, hls->allowcache,
+        ff_hls_write_playlist_header(*sub_out, hls->version, hls->allowcache,
                                      target_duration, sequence, PLAYLIST_TYPE_NONE, 0);
         for (en = vs->segments; en; en = en->next) {
-            ret = ff_hls_write_file_entry(hls->sub_m3u8_out, en->discont, byterange_mode,
+            ret = ff_hls_write_file_entry(*sub_out, en->discont, byterange_mode,
                                           en->duration, 0, en->size, en->pos,
                                           hls->baseurl, en->sub_filename, NULL, 0);
             if (ret < 0) {
@@ -1665,18 +1743,37 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
         }
 
         if (last && !(hls->flags & HLS_OMIT_ENDLIST))
-            ff_hls_write_end_list(hls->sub_m3u8_out);
+            ff_hls_write_end_list(*sub_out);
 
     }
 
 fail:
     av_dict_free(&options);
-    ret = hlsenc_io_close(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename);
-    if (ret < 0) {
-        return ret;
+    if (vs->write_queue) {
+        if (dyn_pb) {
+            set_http_options(s, &options, hls);
+            ret = hls_queue_playlist(vs, &dyn_pb, temp_filename, options,
+                                     use_temp_file ? vs->m3u8_name : NULL);
+            av_dict_free(&options);
+        }
+        if (ret >= 0 && sub_dyn_pb) {
+            set_http_options(vs->vtt_avf, &options, hls);
+            ret = hls_queue_playlist(vs, &sub_dyn_pb, temp_vtt_filename, options,
+                                     use_temp_file ? vs->vtt_m3u8_name : NULL);
+            av_dict_free(&options);
+        }
+        ffio_free_dyn_buf(&dyn_pb);
+        ffio_free_dyn_buf(&sub_dyn_pb);
+        if (ret < 0)
+            return ret;
+    } else {
+        ret = hlsenc_io_close(s, out, temp_filename);
+        if (ret < 0) {
+            return ret;
+        }
+        hlsenc_io_close(s, sub_out, vs->vtt_m3u8_name);
     }
-    hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
-    if (use_temp_file) {
+    if (use_temp_file && !vs->write_queue) {
         ff_rename(temp_filename, vs->m3u8_name, s);
         if (vs->vtt_m3u8_name)
             ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
@@ -1852,7 +1949,13 @@ static int hls_start(AVFormatContext *s, VariantStream *vs)
     }
     if (vs->vtt_basename) {
         set_http_options(s, &options, c);
-        if ((err = hlsenc_io_open(s, &vtt_oc->pb, vtt_oc->url, &options)) < 0) {
+        /* with async_io, the subtitle segment is collected in memory too */
+        vs->vtt_in_memory = vs->write_queue && !(c->flags & HLS_SINGLE_FILE) && c->max_seg_size <= 0;
+        if (vs->vtt_in_memory)
+            err = avio_open_dyn_buf(&vtt_oc->pb);
+        else
+            err = hlsenc_io_open(s, &vtt_oc->pb, vtt_oc->url, &options);
+        if (err < 0) {
             if (c->ignore_io_errors)
                 err = 0;
             goto fail;
@@ -2523,6 +2626,14 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
         double cur_duration;
 
+        if (vs->write_queue) {
+            /* failures of earlier output of this variant */
+            ret = ff_write_queue_error(vs->write_queue);
+            if (ret < 0 && !hls->ignore_io_errors)
+                return ret;
+            ret = 0;
+        }
+
 #if CONFIG_MP4_MUXER
         if (hls->segment_type == SEGMENT_TYPE_FMP4 && is_ref_pkt &&
             pkt->dts != AV_NOPTS_VALUE)
@@ -2550,7 +2661,12 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             }
         }
         if (!byterange_mode) {
-            if (vs->vtt_avf) {
+            if (vs->vtt_in_memory) {
+                ret = hls_vtt_flush(s, vs);
+                if (ret < 0 && !hls->ignore_io_errors)
+                    return ret;
+                ret = 0;
+            } else if (vs->vtt_avf) {
                 hlsenc_io_close(s, &vs->vtt_avf->pb, vs->vtt_avf->url);
             }
         }
@@ -2592,7 +2708,12 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
 
                 set_http_options(s, &options, hls);
 
-                ret = hlsenc_io_open(s, &vs->out, filename, &options);
+                /* with async_io, the segment is collected in memory and
+                 * handed over to the write queue of the variant */
+                if (vs->write_queue)
+                    ret = avio_open_dyn_buf(&vs->out);
+                else
+                    ret = hlsenc_io_open(s, &vs->out, filename, &options);
                 if (ret < 0) {
                     av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
                            "Failed to open file '%s'\n", filename);
@@ -2605,20 +2726,31 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                 }
                 ret = flush_dynbuf(vs, &range_length);
                 if (ret < 0) {
+                    if (vs->write_queue)
+                        ffio_free_dyn_buf(&vs->out);
                     av_freep(&filename);
                     av_dict_free(&options);
                     return ret;
                 }
                 vs->size = range_length;
-                ret = hlsenc_io_close(s, &vs->out, filename);
-                if (ret < 0) {
-                    av_log(s, AV_LOG_WARNING, "upload segment failed,"
-                           " will retry with a new http session.\n");
-                    ff_format_io_close(s, &vs->out);
-                    ret = hlsenc_io_open(s, &vs->out, filename, &options);
-                    if (ret >= 0) {
-                        reflush_dynbuf(vs, &range_length);
-                        ret = hlsenc_io_close(s, &vs->out, filename);
+                if (vs->write_queue) {
+                    uint8_t *buf;
+                    int size = avio_close_dyn_buf(vs->out, &buf);
+
+                    vs->out = NULL;
+                    ret = ff_write_queue_write(vs->write_queue, filename, options,
+                                               buf, size, NULL);
+                } else {
+                    ret = hlsenc_io_close(s, &vs->out, filename);
+                    if (ret < 0) {
+                        av_log(s, AV_LOG_WARNING, "upload segment failed,"
+                               " will retry with a new http session.\n");
+                        ff_format_io_close(s, &vs->out);
+                        ret = hlsenc_io_open(s, &vs->out, filename, &options);
+                        if (ret >= 0) {
+                            reflush_dynbuf(vs, &range_length);
+                            ret = hlsenc_io_close(s, &vs->out, filename);
+                        }
                     }
                 }
                 av_dict_free(&options);
@@ -2627,7 +2759,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             }
 
             if (use_temp_file)
-                hls_rename_temp_file(s, oc);
+                hls_rename_temp_file(s, vs, oc);
         }
 
         if (ret < 0)
@@ -2677,8 +2809,9 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         } else if (hls->max_seg_size > 0) {
             if (vs->size + vs->start_pos >= hls->max_seg_size) {
                 vs->sequence++;
-                sls_flag_file_rename(hls, vs, old_filename);
-                ret = hls_start(s, vs);
+                ret = sls_flag_file_rename(hls, vs, old_filename);
+                if (ret >= 0)
+                    ret = hls_start(s, vs);
                 vs->start_pos = 0;
                 /* When split segment by byte, the duration is short than hls_time,
                  * so it is not enough one segment duration as hls_time, */
@@ -2687,8 +2820,9 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             }
         } else {
             vs->start_pos = 0;
-            sls_flag_file_rename(hls, vs, old_filename);
-            ret = hls_start(s, vs);
+            ret = sls_flag_file_rename(hls, vs, old_filename);
+            if (ret >= 0)
+                ret = hls_start(s, vs);
         }
         vs->number++;
         av_freep(&old_filename);
@@ -2723,6 +2857,8 @@ static void hls_deinit(AVFormatContext *s)
         av_freep(&vs->vtt_basename);
         av_freep(&vs->vtt_m3u8_name);
 
+        if (vs->vtt_in_memory)
+            ffio_free_dyn_buf(&vs->vtt_avf->pb);
         avformat_free_context(vs->vtt_avf);
         avformat_free_context(vs->avf);
         if (hls->resend_init_file)
@@ -2731,6 +2867,7 @@ static void hls_deinit(AVFormatContext *s)
         hls_free_segments(vs->old_segments);
         av_freep(&vs->m3u8_name);
         av_freep(&vs->streams);
+        ff_write_queue_free(&vs->write_queue);
     }
 
     ff_format_io_close(s, &hls->m3u8_out);
@@ -2756,6 +2893,19 @@ static int hls_write_trailer(struct AVFormatContext *s)
     AVDictionary *options = NULL;
     int range_length, byterange_mode;
 
+    /* the last segments and playlists are written synchronously */
+    for (i = 0; i < hls->nb_varstreams; i++) {
+        vs = &hls->var_streams[i];
+        if (vs->write_queue) {
+            int err = ff_write_queue_wait(vs->write_queue);
+            ff_write_queue_free(&vs->write_queue);
+            if (err < 0 && !ret && !hls->ignore_io_errors)
+                ret = err;
+        }
+    }
+    if (ret < 0)
+        return ret;
+
     for (i = 0; i < hls->nb_varstreams; i++) {
         char *filename = NULL;
         vs = &hls->var_streams[i];
@@ -2846,7 +2996,7 @@ failed:
 
         // rename that segment from .tmp to the real one
         if (use_temp_file && !(hls->flags & HLS_SINGLE_FILE)) {
-            hls_rename_temp_file(s, oc);
+            hls_rename_temp_file(s, vs, oc);
             av_freep(&old_filename);
             old_filename = av_strdup(oc->url);
 
@@ -2864,7 +3014,10 @@ failed:
             if (vtt_oc->pb)
                 av_write_trailer(vtt_oc);
             vs->size = avio_tell(vs->vtt_avf->pb) - vs->start_pos;
-            ff_format_io_close(s, &vtt_oc->pb);
+            if (vs->vtt_in_memory)
+                hls_vtt_flush(s, vs);
+            else
+                ff_format_io_close(s, &vtt_oc->pb);
         }
         ret = hls_window(s, 1, vs);
         if (ret < 0) {
@@ -2915,6 +3068,11 @@ static int hls_init(AVFormatContext *s)
         av_log(hls, AV_LOG_WARNING, "No HTTP method set, hls muxer defaulting to method PUT.\n");
     }
 
+    if (hls->async_io && hls->http_persistent) {
+        av_log(s, AV_LOG_WARNING, "http_persistent is not supported with async_io, disabling it.\n");
+        hls->http_persistent = 0;
+    }
+
     ret = validate_name(hls->nb_varstreams, s->url);
     if (ret < 0)
         return ret;
@@ -3112,6 +3270,16 @@ static int hls_init(AVFormatContext *s)
                 *p = '.';
         }
 
+        if (hls->async_io) {
+            ret = ff_write_queue_alloc(&vs->write_queue, s);
+            if (ret == AVERROR(ENOSYS)) {
+                av_log(s, AV_LOG_WARNING, "async_io is not supported without threads.\n");
+                hls->async_io = 0;
+            } else if (ret < 0) {
+                return ret;
+            }
+        }
+
         if ((ret = hls_mux_init(s, vs)) < 0)
             return ret;
 
@@ -3194,6 +3362,7 @@ static const AVOption options[] = {
     {"http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    {"async_io", "Write segments and playlists of each variant stream on a separate thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     {"headers", "set custom HTTP headers, can override built in default headers", OFFSET(headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
     { NULL },
 };
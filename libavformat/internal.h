@@ -244,6 +244,11 @@ typedef struct FFStream {
      */
     int nb_decoded_frames;
 
+    /**
+     * Statistics of the last avformat_find_stream_info() call, outlives info.
+     */
+    AVStreamProbeStats probe_stats;
+
     /**
      * Timestamp offset added to timestamps before muxing
      */
@@ -486,6 +491,14 @@ int ff_get_line(AVIOContext *s, char *buf, int maxlen);
  */
 int ff_get_chomp_line(AVIOContext *s, char *buf, int maxlen);
 
+/**
+ * Like av_get_packet(), but the packet may reference the I/O buffer instead
+ * of holding a copy of the data, if enabled by
+ * AVFormatContext.zerocopy_buffer_size. Such packets are not writable, so
+ * demuxers modifying the packet data must make them writable first.
+ */
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size);
+
 #define SPACE_CHARS " \t\r\n"
 
 /**
@@ -241,6 +241,7 @@ typedef struct MOVStreamContext {
     uint32_t tmcd_flags;  ///< tmcd track flags
     uint8_t tmcd_nb_frames;  ///< tmcd number of frames per tick / second
     int64_t track_end;    ///< used for dts generation in fragmented movie files
+    int64_t last_trun_moof; ///< highest moof offset whose trun samples are in the index
     unsigned int rap_group_count;
     MOVSbgp *rap_group;
     unsigned int sync_group_count;
@@ -360,6 +361,8 @@ typedef struct MOVContext {
     int use_mfra_for;
     int has_looked_for_mfra;
     int use_tfdt;
+    int defer_frag_index;   ///< only index fragments as they are read, until the first seek
+    int frag_scan_done;     ///< all remaining fragments were indexed for seeking
     MOVFragmentIndex frag_index;
     int atom_depth;
     unsigned int aax_mode;  ///< 'aax' file has been detected
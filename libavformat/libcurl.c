@@ -121,6 +121,7 @@ struct CurlContext {
     int64_t         request_size;
     int64_t         initial_request_size;
     int             max_retries;
+    int             defer_open;
 
     int64_t         logical_pos; /* next byte url_read() will return, caller side */
 
@@ -967,6 +968,8 @@ static int wait_for_probe(CurlContext *c)
     if (!ret) {
         if (!c->stream_ok)
             ret = c->error ? c->error : AVERROR(EIO);
+        else
+            h->is_streamed = !c->seekable;
     }
     pthread_mutex_unlock(&c->mutex);
 
@@ -1035,14 +1038,18 @@ static int libcurl_open(URLContext *h, const char *url, int flags,
     if (ret < 0)
         goto fail;
 
+    /* Let the transfer start in the background, the reply is checked once the
+     * caller needs it. Until then the stream is assumed not to be seekable,
+     * unless told otherwise; is_streamed is updated from the reply. */
+    if (c->defer_open) {
+        h->is_streamed = c->seekable_opt != 1;
+        return 0;
+    }
+
     ret = wait_for_probe(c);
     if (ret < 0)
         goto fail;
 
-    pthread_mutex_lock(&c->mutex);
-    h->is_streamed = !c->seekable;
-    pthread_mutex_unlock(&c->mutex);
-
     return 0;
 
 fail:
@@ -1063,6 +1070,8 @@ static int libcurl_read(URLContext *h, unsigned char *buf, int size)
         if (avail) {
             int n = FFMIN(avail, (size_t)size);
             int unpause;
+            /* data follows the reply, which a deferred open did not wait for */
+            h->is_streamed = !c->seekable;
             av_fifo_read(c->fifo, buf, n);
             /* Resume a paused transfer once the FIFO is at least half empty. */
             unpause = c->paused && av_fifo_can_write(c->fifo) * 2 >= c->buffer_size;
@@ -1097,6 +1106,14 @@ static int64_t libcurl_seek(URLContext *h, int64_t pos, int whence)
 {
     CurlContext *c = h->priv_data;
     int64_t newpos;
+    int ret;
+
+    /* The seekability of a deferred open is known with the first reply. */
+    pthread_mutex_lock(&c->mutex);
+    const int probed = c->probed;
+    pthread_mutex_unlock(&c->mutex);
+    if (!probed && (ret = wait_for_probe(c)) < 0)
+        return ret;
 
     pthread_mutex_lock(&c->mutex);
     const int64_t content_size = c->content_size;
@@ -1189,6 +1206,7 @@ static const AVOption options[] = {
     { "max_redirects", "maximum number of redirects to follow", OFFSET(max_redirects), AV_OPT_TYPE_INT, { .i64 = 16 }, 0, INT_MAX, D },
     { "multiple_requests", "reuse the connection across requests (HTTP keep-alive)", OFFSET(multiple_requests), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, D | E },
     { "max_retries", "maximum number of retries after a recoverable error", OFFSET(max_retries), AV_OPT_TYPE_INT, { .i64 = 5 }, 0, INT_MAX, D },
+    { "defer_open", "return from open without waiting for the reply, report errors on first read", OFFSET(defer_open), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, D },
     { "buffer_size", "receive buffer size in bytes", OFFSET(buffer_size), AV_OPT_TYPE_INT64, { .i64 = CURL_DEFAULT_BUFFER_SIZE }, CURL_MAX_WRITE_SIZE, INT_MAX, D },
     { "request_size", "split a transfer into ranged requests of at most this many bytes (0 = unlimited)", OFFSET(request_size), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D },
     { "initial_request_size", "size (in bytes) of initial requests made during probing / header parsing", OFFSET(initial_request_size), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D },
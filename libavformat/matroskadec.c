@@ -1256,6 +1256,43 @@ static MatroskaLevel1Element *matroska_find_level1_elem(MatroskaDemuxContext *ma
     return elem;
 }
 
+/*
+ * Peek at the track number of the (Simple)Block at the current position.
+ * If its stream is discarded, return the number of bytes read, so that the
+ * rest of the block can be skipped without reading it. Otherwise return 0
+ * and leave the position unchanged.
+ */
+static int matroska_peek_discarded_block(MatroskaDemuxContext *matroska,
+                                         AVIOContext *pb, uint64_t length)
+{
+    MatroskaTrack *tracks = matroska->tracks.elem;
+    int64_t pos = avio_tell(pb);
+    uint64_t num;
+    int n, read;
+
+    if (length < 4 || ffio_ensure_seekback(pb, 8) < 0)
+        return 0;
+
+    num  = avio_r8(pb);
+    read = 8 - ff_log2_tab[num];
+    if (num && read + 3 <= length) {
+        num ^= 1 << ff_log2_tab[num];
+        for (n = 1; n < read; n++)
+            num = (num << 8) | avio_r8(pb);
+
+        for (n = 0; n < matroska->tracks.nb_elem && !pb->eof_reached; n++) {
+            if (tracks[n].num != num)
+                continue;
+            if (tracks[n].stream && tracks[n].stream->discard >= AVDISCARD_ALL)
+                return read;
+            break;
+        }
+    }
+
+    avio_seek(pb, pos, SEEK_SET);
+    return 0;
+}
+
 static int ebml_parse(MatroskaDemuxContext *matroska,
                       EbmlSyntax *syntax, void *data)
 {
@@ -1493,6 +1530,11 @@ static int ebml_parse(MatroskaDemuxContext *matroska,
         res = ebml_read_ascii(pb, length, syntax->def.s, data);
         break;
     case EBML_BIN:
+        if ((id == MATROSKA_ID_SIMPLEBLOCK || id == MATROSKA_ID_BLOCK) &&
+            (res = matroska_peek_discarded_block(matroska, pb, length))) {
+            length -= res;
+            goto skip;
+        }
         res = ebml_read_binary(pb, length, pos_alt, data);
         break;
     case EBML_LEVEL1:
@@ -6195,7 +6195,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     MOVStreamContext *sc;
     MOVTimeToSample *tts_data;
     uint64_t offset;
-    int64_t dts, pts = AV_NOPTS_VALUE;
+    int64_t dts, pts = AV_NOPTS_VALUE, moof_offset = -1;
     int data_offset = 0;
     unsigned entries, first_sample_flags = frag->flags;
     int flags, distance, i;
@@ -6233,8 +6233,20 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     // A valid index_entry means the trun for the fragment was read
     // and it's samples are in index_entries at the given position.
     // New index entries will be inserted before the index_entry found.
+    //
+    // Fragments are usually read in order, in which case no later fragment
+    // can have one and the new entries are simply appended, so avoid
+    // scanning the rest of a complete fragment index for every trun.
     index_entry_pos = sti->nb_index_entries;
-    for (i = c->frag_index.current + 1; i < c->frag_index.nb_items; i++) {
+    if (c->frag_index.current >= 0 && c->frag_index.current < c->frag_index.nb_items) {
+        moof_offset = c->frag_index.item[c->frag_index.current].moof_offset;
+        if (moof_offset >= sc->last_trun_moof)
+            i = c->frag_index.nb_items;
+        else
+            i = c->frag_index.current + 1;
+    } else
+        i = c->frag_index.current + 1;
+    for (; i < c->frag_index.nb_items; i++) {
         frag_stream_info = get_frag_stream_info(&c->frag_index, i, frag->track_id);
         if (frag_stream_info && frag_stream_info->index_entry >= 0) {
             next_frag_index = i;
@@ -6512,6 +6524,7 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     }
 
     frag->implicit_offset = offset;
+    sc->last_trun_moof = FFMAX(sc->last_trun_moof, moof_offset);
 
     sc->track_end = dts + sc->time_offset;
     if (st->duration < sc->track_end)
@@ -8968,6 +8981,9 @@ static int cenc_filter(MOVContext *mov, AVStream* st, MOVStreamContext *sc, AVPa
         }
 
         if (mov->decryption_keys || mov->decryption_default_key) {
+            ret = av_packet_make_writable(pkt);
+            if (ret < 0)
+                return ret;
             return cenc_decrypt(mov, sc, encrypted_sample, pkt->data, pkt->size);
         } else {
             size_t size;
@@ -10216,10 +10232,12 @@ static int mov_read_default(MOVContext *c, AVIOContext *pb, MOVAtom atom)
                 c->atom_depth --;
                 return err;
             }
+            int lazy_index = !(pb->seekable & AVIO_SEEKABLE_NORMAL) ||
+                             c->fc->flags & AVFMT_FLAG_IGNIDX || c->frag_index.complete ||
+                             (c->defer_frag_index && !c->frag_scan_done);
             if (c->found_moov && c->found_mdat && a.size <= INT64_MAX - start_pos &&
-                ((!(pb->seekable & AVIO_SEEKABLE_NORMAL) || c->fc->flags & AVFMT_FLAG_IGNIDX || c->frag_index.complete) ||
-                 start_pos + a.size == avio_size(pb))) {
-                if (!(pb->seekable & AVIO_SEEKABLE_NORMAL) || c->fc->flags & AVFMT_FLAG_IGNIDX || c->frag_index.complete)
+                (lazy_index || start_pos + a.size == avio_size(pb))) {
+                if (lazy_index)
                     c->next_root_atom = start_pos + a.size;
                 c->atom_depth --;
                 return 0;
@@ -12093,6 +12111,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             mov_current_sample_set(msc, 0);
             msc->tts_index = 0;
 
+            msc->last_trun_moof = 0;
+
             // Discard current index entries
             avsti = ffstream(avst);
             if (avsti->index_entries_allocated_size > 0) {
@@ -12187,7 +12207,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             }
             ret = av_get_packet(sc->pb, pkt, au_size);
         } else
-            ret = av_get_packet(sc->pb, pkt, sample->size);
+            ret = ff_get_packet_ref(sc->pb, pkt, sample->size);
         if (ret < 0) {
             if (should_retry(sc->pb, ret)) {
                 mov_current_sample_dec(sc);
@@ -12229,8 +12249,12 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
     if (st->discard == AVDISCARD_ALL)
         goto retry;
 
-    if (mov->aax_mode)
+    if (mov->aax_mode) {
+        ret = av_packet_make_writable(pkt);
+        if (ret < 0)
+            return ret;
         aax_filter(pkt->data, pkt->size, mov);
+    }
 
     ret = cenc_filter(mov, st, sc, pkt, current_index);
     if (ret < 0) {
@@ -12405,6 +12429,17 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
     if (stream_index >= s->nb_streams)
         return AVERROR_INVALIDDATA;
 
+    /* index the fragments which were skipped at open time */
+    if (mc->defer_frag_index && !mc->frag_scan_done) {
+        mc->frag_scan_done = 1;
+        if (mc->next_root_atom) {
+            int ret = mov_switch_root(s, mc->next_root_atom, -1);
+            if (ret < 0 && ret != AVERROR_EOF)
+                return ret;
+            mc->next_root_atom = 0;
+        }
+    }
+
     st = s->streams[stream_index];
     sti = ffstream(st);
     sample = mov_seek_stream(s, st, sample_time, flags);
@@ -12482,6 +12517,8 @@ static const AVOption mov_options[] = {
         FLAGS, .unit = "use_mfra_for" },
     {"use_tfdt", "use tfdt for fragment timestamps", OFFSET(use_tfdt), AV_OPT_TYPE_BOOL, {.i64 = 1},
         0, 1, FLAGS},
+    {"defer_frag_index", "index fragments only as they are read, until the first seek",
+        OFFSET(defer_frag_index), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS},
     { "export_all", "Export unrecognized metadata entries", OFFSET(export_all),
         AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, .flags = FLAGS },
     { "export_xmp", "Export full XMP metadata", OFFSET(export_xmp),
@@ -3414,6 +3414,63 @@ static void finished_reading_packet(AVFormatContext *s, int raw_packet_size)
         avio_skip(pb, skip);
 }
 
+/* return the number of consecutive packets starting with a sync byte */
+static int count_synced_packets(const uint8_t *buf, int nb_packets)
+{
+    int i = 0;
+
+    /* check sync bytes in groups, without branching on each of them */
+    for (; i + 8 <= nb_packets; i += 8) {
+        const uint8_t *p = buf + i * TS_PACKET_SIZE;
+        unsigned diff = 0;
+        for (int j = 0; j < 8; j++)
+            diff |= p[j * TS_PACKET_SIZE] ^ SYNC_BYTE;
+        if (diff)
+            break;
+    }
+    while (i < nb_packets && buf[i * TS_PACKET_SIZE] == SYNC_BYTE)
+        i++;
+
+    return i;
+}
+
+/**
+ * Handle the TS packets which are already in the I/O buffer in place,
+ * up to the first one which is out of sync. Packets which handle_packet()
+ * would ignore right away, i.e. continuation packets of PIDs which have
+ * no filter or are discarded, are skipped with a single table lookup.
+ *
+ * @param nb_handled set to the number of packets consumed
+ * @return 0 or a negative error code
+ */
+static int handle_buffered_packets(MpegTSContext *ts, int64_t max_packets,
+                                   int *nb_handled)
+{
+    AVIOContext *pb = ts->stream->pb;
+    const uint8_t *buf = pb->buf_ptr;
+    int64_t pos = avio_tell(pb);
+    int nb_packets = FFMIN((pb->buf_end - buf) / TS_PACKET_SIZE, max_packets);
+    int i, ret = 0;
+
+    nb_packets = count_synced_packets(buf, nb_packets);
+
+    for (i = 0; i < nb_packets && !ts->stop_parse; ) {
+        const uint8_t *packet = buf + i++ * TS_PACKET_SIZE;
+        const MpegTSFilter *tss = ts->pids[AV_RB16(packet + 1) & 0x1fff];
+
+        if (!(packet[1] & 0x40) && (!tss || tss->discard))
+            continue;
+
+        ret = handle_packet(ts, packet, pos + i * TS_PACKET_SIZE);
+        if (ret < 0)
+            break;
+    }
+
+    avio_skip(pb, i * TS_PACKET_SIZE);
+    *nb_handled = i;
+    return ret;
+}
+
 static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
 {
     AVFormatContext *s = ts->stream;
@@ -3455,6 +3512,18 @@ static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
         if (ts->stop_parse > 0)
             break;
 
+        if (ts->raw_packet_size == TS_PACKET_SIZE) {
+            int nb_handled;
+            ret = handle_buffered_packets(ts, nb_packets ? nb_packets - packet_num : INT64_MAX,
+                                          &nb_handled);
+            if (ret != 0)
+                break;
+            if (nb_handled) {
+                packet_num += nb_handled - 1;
+                continue;
+            }
+        }
+
         ret = read_packet(s, packet, ts->raw_packet_size, &data);
         if (ret != 0)
             break;
@@ -243,7 +243,9 @@ enum AVWriteUncodedFrameFlags {
 /**
  * Make shift_size amount of space at read_start by shifting data in the output
  * at read_start until the current IO position. The underlying IO context must
- * be seekable.
+ * be seekable. Local files are shifted in the kernel where supported, without
+ * reading the data back into userspace. The IO position is left at the end of
+ * the shifted data.
  */
 int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size);
 
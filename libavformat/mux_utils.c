@@ -19,15 +19,27 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
+#if HAVE_COPY_FILE_RANGE
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include <unistd.h>
+#endif
+
 #include "libavutil/dict.h"
+#include "libavutil/error.h"
 #include "libavutil/internal.h"
 #include "libavutil/log.h"
 #include "libavutil/mem.h"
 #include "libavutil/parseutils.h"
 #include "avformat.h"
 #include "avio.h"
+#include "avio_internal.h"
 #include "internal.h"
 #include "mux.h"
+#include "url.h"
 
 int avformat_query_codec(const AVOutputFormat *ofmt, enum AVCodecID codec_id,
                          int std_compliance)
@@ -68,21 +80,64 @@ int avformat_query_codec(const AVOutputFormat *ofmt, enum AVCodecID codec_id,
     return AVERROR_PATCHWELCOME;
 }
 
+/**
+ * Shift the data in the kernel, moving chunks of at most shift_size bytes
+ * from the end of the file backwards, so that no chunk overlaps its
+ * destination. *pos_end is updated to the end of the data left unshifted,
+ * which is read_start on full success.
+ */
+static void shift_data_in_kernel(AVFormatContext *s, AVIOContext *read_pb,
+                                 int64_t read_start, int64_t *pos_end,
+                                 int shift_size)
+{
+#if HAVE_COPY_FILE_RANGE
+    int fd_in, fd_out;
+    int64_t end = *pos_end;
+
+    /* All the data written must be in the file before it is copied behind
+     * the back of the AVIOContext. Getting the handles afterwards also makes
+     * protocols that queue their writes submit them. */
+    avio_flush(s->pb);
+    if (s->pb->error < 0)
+        return;
+
+    fd_in  = ffurl_get_file_handle(ffio_geturlcontext(read_pb));
+    fd_out = ffurl_get_file_handle(ffio_geturlcontext(s->pb));
+    if (fd_in < 0 || fd_out < 0)
+        return;
+
+    while (end > read_start) {
+        int64_t chunk = FFMIN(shift_size, end - read_start);
+        int64_t left  = chunk;
+        off_t off_in  = end - chunk;
+        off_t off_out = end - chunk + shift_size;
+
+        while (left > 0) {
+            ssize_t n = copy_file_range(fd_in, &off_in, fd_out, &off_out, left, 0);
+            if (n <= 0) {
+                av_log(s, AV_LOG_DEBUG, "In-kernel data shift stopped at %"PRId64": %s\n",
+                       end, n < 0 ? av_err2str(AVERROR(errno)) : "unexpected EOF");
+                /* the source of the current chunk is still intact */
+                *pos_end = end;
+                return;
+            }
+            left -= n;
+        }
+        end -= chunk;
+    }
+    *pos_end = end;
+#endif
+}
+
 int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
 {
     int ret;
-    int64_t pos, pos_end;
-    uint8_t *buf, *read_buf[2];
+    int64_t pos, pos_end, file_end;
+    uint8_t *buf = NULL, *read_buf[2];
     int read_buf_id = 0;
     int read_size[2];
     AVIOContext *read_pb;
 
-    buf = av_malloc_array(shift_size, 2);
-    if (!buf)
-        return AVERROR(ENOMEM);
-    read_buf[0] = buf;
-    read_buf[1] = buf + shift_size;
-
     /* Shift the data: the AVIO context of the output can only be used for
      * writing, so we re-open the same output, but for reading. It also avoids
      * a read/seek/write/seek back and forth. */
@@ -90,12 +145,27 @@ int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
     ret = s->io_open(s, &read_pb, s->url, AVIO_FLAG_READ, NULL);
     if (ret < 0) {
         av_log(s, AV_LOG_ERROR, "Unable to re-open %s output file for shifting data\n", s->url);
+        return ret;
+    }
+
+    /* mark the end of the shift to up to the last data we wrote */
+    file_end = pos_end = avio_tell(s->pb);
+
+    /* local files can be shifted without copying the data through userspace;
+     * whatever could not be shifted that way is handled below */
+    shift_data_in_kernel(s, read_pb, read_start, &pos_end, shift_size);
+    if (pos_end <= read_start)
+        goto done;
+
+    buf = av_malloc_array(shift_size, 2);
+    if (!buf) {
+        ret = AVERROR(ENOMEM);
         goto end;
     }
+    read_buf[0] = buf;
+    read_buf[1] = buf + shift_size;
 
-    /* mark the end of the shift to up to the last data we wrote, and get ready
-     * for writing */
-    pos_end = avio_tell(s->pb);
+    /* get ready for writing */
     avio_seek(s->pb, read_start + shift_size, SEEK_SET);
 
     avio_seek(read_pb, read_start, SEEK_SET);
@@ -111,15 +181,18 @@ int ff_format_shift_data(AVFormatContext *s, int64_t read_start, int shift_size)
     do {
         int n;
         READ_BLOCK;
-        n = read_size[read_buf_id];
+        n = FFMIN(read_size[read_buf_id], pos_end - pos);
         if (n <= 0)
             break;
         avio_write(s->pb, read_buf[read_buf_id], n);
         pos += n;
     } while (pos < pos_end);
-    ret = ff_format_io_close(s, &read_pb);
 
+done:
+    if (pos_end < file_end)
+        avio_seek(s->pb, file_end + shift_size, SEEK_SET);
 end:
+    ret = FFMIN(ret, ff_format_io_close(s, &read_pb));
     av_free(buf);
     return ret;
 }
@@ -111,6 +111,11 @@ static const AVOption avformat_options[] = {
 {"max_probe_packets", "Maximum number of packets to probe a codec", OFFSET(max_probe_packets), AV_OPT_TYPE_INT, { .i64 = 2500 }, 0, INT_MAX, D },
 {"duration_probesize", "Maximum number of bytes to probe the durations of the streams in estimate_timings_from_pts", OFFSET(duration_probesize), AV_OPT_TYPE_INT64, {.i64 = 0 }, 0, (double)INT64_MAX, D},
 {"recursion_limit", "Maximum number of times a demuxer can recursively be opened", OFFSET(recursion_limit), AV_OPT_TYPE_INT, {.i64 = 10 }, 0, INT_MAX, D},
+{"probe_threads", "Number of threads decoding streams in avformat_find_stream_info()", OFFSET(probe_threads), AV_OPT_TYPE_INT, {.i64 = 1 }, 0, INT_MAX, D},
+{"zerocopy_buffer_size", "Size of the refcounted input buffers packets may reference", OFFSET(zerocopy_buffer_size), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, INT_MAX, D},
+{"probe_per_stream", "Apply probesize and analyzeduration to each stream on its own", OFFSET(probe_per_stream), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, D},
+{"probe_total_size", "Maximum number of bytes probed in total with probe_per_stream", OFFSET(probe_total_size), AV_OPT_TYPE_INT64, {.i64 = 50000000 }, 32, INT64_MAX, D},
+{"probe_total_duration", "Maximum duration probed in any stream with probe_per_stream", OFFSET(probe_total_duration), AV_OPT_TYPE_DURATION, {.i64 = 60000000 }, 0, INT64_MAX, D},
 {NULL},
 };
 
@@ -91,8 +91,12 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
 
     *index_entries = entries;
 
-    index = ff_index_search_timestamp(*index_entries, *nb_index_entries,
-                                      timestamp, AVSEEK_FLAG_ANY);
+    /* entries are usually added in order, no need to search for those */
+    if (!*nb_index_entries || entries[*nb_index_entries - 1].timestamp < timestamp)
+        index = -1;
+    else
+        index = ff_index_search_timestamp(*index_entries, *nb_index_entries,
+                                          timestamp, AVSEEK_FLAG_ANY);
     if (index < 0) {
         index = (*nb_index_entries)++;
         ie    = &entries[index];
@@ -20,10 +20,14 @@
  */
 
 
+#include "config.h"
+
 #include "libavutil/avutil.h"
 #include "libavutil/avstring.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadmessage.h"
 #include "libavcodec/bsf.h"
 #include "internal.h"
 #include "avformat.h"
@@ -37,6 +41,11 @@ typedef enum {
 
 #define DEFAULT_SLAVE_FAILURE_POLICY ON_SLAVE_FAILURE_ABORT
 
+typedef enum {
+    QUEUE_OVERFLOW_BLOCK = 0,
+    QUEUE_OVERFLOW_DROP  = 1,
+} QueueOverflowPolicy;
+
 typedef struct {
     AVFormatContext *avf;
     AVBSFContext **bsfs; ///< bitstream filters per stream
@@ -49,6 +58,21 @@ typedef struct {
      * disabled output streams are set to -1 */
     int *stream_map;
     int header_written;
+
+    int async;
+    int queue_size;
+    QueueOverflowPolicy queue_overflow;
+    /** packets for the slave thread, NULL when writing synchronously */
+    AVThreadMessageQueue *queue;
+#if HAVE_THREADS
+    pthread_t thread;
+#endif
+    int thread_ret;
+    /** per output stream, set when packets were dropped
+     * until the next key frame */
+    uint8_t *need_keyframe;
+    int dropping;
+    int64_t nb_dropped;
 } TeeSlave;
 
 typedef struct TeeContext {
@@ -58,6 +82,9 @@ typedef struct TeeContext {
     TeeSlave *slaves;
     int use_fifo;
     AVDictionary *fifo_options;
+    int async;
+    int queue_size;
+    int queue_overflow;
 } TeeContext;
 
 static const char *const slave_delim     = "|";
@@ -70,6 +97,17 @@ static const AVOption tee_options[] = {
          OFFSET(use_fifo), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
         {"fifo_options", "fifo pseudo-muxer options", OFFSET(fifo_options),
          AV_OPT_TYPE_DICT, {.str = NULL}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM},
+        {"async", "Write each slave from its own thread",
+         OFFSET(async), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, AV_OPT_FLAG_ENCODING_PARAM},
+        {"queue_size", "Maximum number of packets queued for each slave thread",
+         OFFSET(queue_size), AV_OPT_TYPE_INT, {.i64 = 256}, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM},
+        {"queue_overflow", "What to do when the queue of a slave thread is full",
+         OFFSET(queue_overflow), AV_OPT_TYPE_INT, {.i64 = QUEUE_OVERFLOW_BLOCK},
+         QUEUE_OVERFLOW_BLOCK, QUEUE_OVERFLOW_DROP, AV_OPT_FLAG_ENCODING_PARAM, .unit = "queue_overflow"},
+            {"block", "wait for the slave", 0, AV_OPT_TYPE_CONST,
+             {.i64 = QUEUE_OVERFLOW_BLOCK}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, .unit = "queue_overflow"},
+            {"drop", "drop packets until the next key frame", 0, AV_OPT_TYPE_CONST,
+             {.i64 = QUEUE_OVERFLOW_DROP}, 0, 0, AV_OPT_FLAG_ENCODING_PARAM, .unit = "queue_overflow"},
         {NULL}
 };
 
@@ -97,37 +135,191 @@ static inline int parse_slave_failure_policy_option(const char *opt, TeeSlave *t
     return AVERROR(EINVAL);
 }
 
-static int parse_slave_fifo_policy(const char *use_fifo, TeeSlave *tee_slave)
+static int parse_slave_bool_option(const char *opt, int *dst)
 {
     /*TODO - change this to use proper function for parsing boolean
      *       options when there is one */
-    if (av_match_name(use_fifo, "true,y,yes,enable,enabled,on,1")) {
-        tee_slave->use_fifo = 1;
-    } else if (av_match_name(use_fifo, "false,n,no,disable,disabled,off,0")) {
-        tee_slave->use_fifo = 0;
+    if (av_match_name(opt, "true,y,yes,enable,enabled,on,1")) {
+        *dst = 1;
+    } else if (av_match_name(opt, "false,n,no,disable,disabled,off,0")) {
+        *dst = 0;
     } else {
         return AVERROR(EINVAL);
     }
     return 0;
 }
 
+static int parse_slave_queue_size(const char *opt, TeeSlave *tee_slave)
+{
+    char *end;
+    long size = strtol(opt, &end, 10);
+
+    if (*end || end == opt || size <= 0 || size > INT_MAX)
+        return AVERROR(EINVAL);
+    tee_slave->queue_size = size;
+    return 0;
+}
+
+static int parse_slave_queue_overflow(const char *opt, TeeSlave *tee_slave)
+{
+    if (!av_strcasecmp("block", opt)) {
+        tee_slave->queue_overflow = QUEUE_OVERFLOW_BLOCK;
+        return 0;
+    } else if (!av_strcasecmp("drop", opt)) {
+        tee_slave->queue_overflow = QUEUE_OVERFLOW_DROP;
+        return 0;
+    }
+    return AVERROR(EINVAL);
+}
+
 static int parse_slave_fifo_options(const char *fifo_options, TeeSlave *tee_slave)
 {
     return av_dict_parse_string(&tee_slave->fifo_options, fifo_options, "=", ":", 0);
 }
 
+/**
+ * Filter a packet, whose stream_index is already that of the slave,
+ * and write it to the slave.
+ */
+static int write_slave_packet(void *log_ctx, TeeSlave *tee_slave, AVPacket *pkt)
+{
+    AVFormatContext *avf2 = tee_slave->avf;
+    int s2 = pkt->stream_index;
+    AVBSFContext *bsfs = tee_slave->bsfs[s2];
+    int ret;
+
+    ret = av_bsf_send_packet(bsfs, pkt);
+    if (ret < 0) {
+        av_packet_unref(pkt);
+        av_log(log_ctx, AV_LOG_ERROR, "Error while sending packet to bitstream filter: %s\n",
+               av_err2str(ret));
+        return ret;
+    }
+
+    while (1) {
+        ret = av_bsf_receive_packet(bsfs, pkt);
+        if (ret == AVERROR(EAGAIN))
+            return 0;
+        else if (ret < 0)
+            return ret;
+
+        av_packet_rescale_ts(pkt, bsfs->time_base_out,
+                             avf2->streams[s2]->time_base);
+        ret = av_interleaved_write_frame(avf2, pkt);
+        if (ret < 0)
+            return ret;
+    }
+}
+
+#if HAVE_THREADS
+static void *slave_thread(void *arg)
+{
+    TeeSlave *tee_slave = arg;
+    AVPacket *pkt;
+    int ret;
+
+    ff_thread_setname("tee-slave");
+
+    while (1) {
+        ret = av_thread_message_queue_recv(tee_slave->queue, &pkt, 0);
+        if (ret < 0) {
+            if (ret == AVERROR_EOF)
+                ret = 0;
+            break;
+        }
+
+        /* a NULL packet requests flushing the slave */
+        if (pkt)
+            ret = write_slave_packet(tee_slave->avf, tee_slave, pkt);
+        else
+            ret = av_interleaved_write_frame(tee_slave->avf, NULL);
+        av_packet_free(&pkt);
+        if (ret < 0)
+            break;
+    }
+
+    /* make the muxing thread notice the failure */
+    if (ret < 0)
+        av_thread_message_queue_set_err_send(tee_slave->queue, ret);
+    tee_slave->thread_ret = ret;
+
+    return NULL;
+}
+#endif
+
+static void free_queued_packet(void *msg)
+{
+    av_packet_free(msg);
+}
+
+static int start_slave_thread(AVFormatContext *avf, TeeSlave *tee_slave)
+{
+#if HAVE_THREADS
+    int ret;
+
+    tee_slave->need_keyframe = av_calloc(tee_slave->avf->nb_streams,
+                                         sizeof(*tee_slave->need_keyframe));
+    if (!tee_slave->need_keyframe)
+        return AVERROR(ENOMEM);
+
+    ret = av_thread_message_queue_alloc(&tee_slave->queue, tee_slave->queue_size,
+                                        sizeof(AVPacket *));
+    if (ret < 0)
+        return ret;
+    av_thread_message_queue_set_free_func(tee_slave->queue, free_queued_packet);
+
+    ret = pthread_create(&tee_slave->thread, NULL, slave_thread, tee_slave);
+    if (ret) {
+        av_thread_message_queue_free(&tee_slave->queue);
+        return AVERROR(ret);
+    }
+    return 0;
+#else
+    av_log(avf, AV_LOG_WARNING, "async is not supported without threads, "
+           "writing synchronously.\n");
+    return 0;
+#endif
+}
+
+/**
+ * Wait until the slave thread has written all queued packets.
+ *
+ * @return the error the thread stopped with, if any
+ */
+static int stop_slave_thread(TeeSlave *tee_slave)
+{
+    if (!tee_slave->queue)
+        return 0;
+
+#if HAVE_THREADS
+    av_thread_message_queue_set_err_recv(tee_slave->queue, AVERROR_EOF);
+    pthread_join(tee_slave->thread, NULL);
+#endif
+    av_thread_message_queue_free(&tee_slave->queue);
+
+    return tee_slave->thread_ret;
+}
+
 static int close_slave(TeeSlave *tee_slave)
 {
     AVFormatContext *avf;
-    int ret = 0;
+    int ret = 0, ret_thread;
 
     av_dict_free(&tee_slave->fifo_options);
     avf = tee_slave->avf;
     if (!avf)
         return 0;
 
+    ret_thread = stop_slave_thread(tee_slave);
+    av_freep(&tee_slave->need_keyframe);
+    if (tee_slave->nb_dropped)
+        av_log(avf, AV_LOG_WARNING, "%"PRId64" packets were dropped in total\n",
+               tee_slave->nb_dropped);
+
     if (tee_slave->header_written)
         ret = av_write_trailer(avf);
+    if (ret_thread < 0)
+        ret = ret_thread;
 
     if (tee_slave->bsfs) {
         for (unsigned i = 0; i < avf->nb_streams; ++i)
@@ -193,11 +385,21 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
                    av_log(avf, AV_LOG_ERROR, "Invalid onfail option value, "
                           "valid options are 'abort' and 'ignore'\n"););
     PROCESS_OPTION("use_fifo",
-                   parse_slave_fifo_policy(value, tee_slave),
+                   parse_slave_bool_option(value, &tee_slave->use_fifo),
                    av_log(avf, AV_LOG_ERROR, "Error parsing fifo options: %s\n",
                           av_err2str(ret)););
     PROCESS_OPTION("fifo_options",
                    parse_slave_fifo_options(value, tee_slave), ;);
+    PROCESS_OPTION("async",
+                   parse_slave_bool_option(value, &tee_slave->async),
+                   av_log(avf, AV_LOG_ERROR, "Invalid async option value '%s'\n", value););
+    PROCESS_OPTION("queue_size",
+                   parse_slave_queue_size(value, tee_slave),
+                   av_log(avf, AV_LOG_ERROR, "Invalid queue_size option value '%s'\n", value););
+    PROCESS_OPTION("queue_overflow",
+                   parse_slave_queue_overflow(value, tee_slave),
+                   av_log(avf, AV_LOG_ERROR, "Invalid queue_overflow option value, "
+                          "valid options are 'block' and 'drop'\n"););
     entry = NULL;
     while ((entry = av_dict_get(options, "bsfs", NULL, AV_DICT_IGNORE_SUFFIX))) {
         /* trim out strlen("bsfs") characters from key */
@@ -231,6 +433,13 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
         options = tee_slave->fifo_options;
         tee_slave->fifo_options = NULL;
     }
+#ifdef TEE_TEST
+    /* This exists for the tee_muxer test tool. */
+    if (format && !strcmp(format, "tee_test")) {
+        extern const FFOutputFormat ff_tee_test_muxer;
+        ret = avformat_alloc_output_context2(&avf2, &ff_tee_test_muxer.p, NULL, filename);
+    } else
+#endif
     ret = avformat_alloc_output_context2(&avf2, NULL,
                                          tee_slave->use_fifo ? "fifo" :format, filename);
     if (ret < 0)
@@ -406,6 +615,12 @@ static int open_slave(AVFormatContext *avf, char *slave, TeeSlave *tee_slave)
         goto end;
     }
 
+    if (tee_slave->async && (ret = start_slave_thread(avf, tee_slave)) < 0) {
+        av_log(avf, AV_LOG_ERROR, "Slave '%s': error starting thread: %s\n",
+               slave, av_err2str(ret));
+        goto end;
+    }
+
 end:
     av_free(format);
     av_free(select);
@@ -488,6 +703,9 @@ static int tee_write_header(AVFormatContext *avf)
     for (unsigned i = 0; i < nb_slaves; i++) {
 
         tee->slaves[i].use_fifo = tee->use_fifo;
+        tee->slaves[i].async          = tee->async;
+        tee->slaves[i].queue_size     = tee->queue_size;
+        tee->slaves[i].queue_overflow = tee->queue_overflow;
         ret = av_dict_copy(&tee->slaves[i].fifo_options, tee->fifo_options, 0);
         if (ret < 0)
             goto fail;
@@ -538,6 +756,59 @@ static int tee_write_trailer(AVFormatContext *avf)
     return ret_all;
 }
 
+/**
+ * Pass a reference to the packet to the slave thread, or drop it if the
+ * thread is lagging behind and the slave allows dropping.
+ */
+static int queue_slave_packet(AVFormatContext *avf, unsigned slave_idx, const AVPacket *pkt)
+{
+    TeeContext *tee = avf->priv_data;
+    TeeSlave *tee_slave = &tee->slaves[slave_idx];
+    int drop = tee_slave->queue_overflow == QUEUE_OVERFLOW_DROP;
+    AVPacket *pkt2 = NULL;
+    int s2 = -1, ret;
+
+    if (pkt) {
+        s2 = tee_slave->stream_map[pkt->stream_index];
+        if (s2 < 0)
+            return 0;
+        /* decoding of the slave output resumes at the next key frame */
+        if (tee_slave->need_keyframe[s2] && !(pkt->flags & AV_PKT_FLAG_KEY)) {
+            tee_slave->nb_dropped++;
+            return 0;
+        }
+
+        pkt2 = av_packet_clone(pkt);
+        if (!pkt2)
+            return AVERROR(ENOMEM);
+        pkt2->stream_index = s2;
+    }
+
+    ret = av_thread_message_queue_send(tee_slave->queue, &pkt2,
+                                       drop ? AV_THREAD_MESSAGE_NONBLOCK : 0);
+    if (ret == AVERROR(EAGAIN) && drop) {
+        av_packet_free(&pkt2);
+        if (!pkt)
+            return 0;
+        if (!tee_slave->dropping)
+            av_log(avf, AV_LOG_WARNING, "Slave muxer #%u is too slow, dropping packets.\n",
+                   slave_idx);
+        tee_slave->dropping = 1;
+        tee_slave->need_keyframe[s2] = 1;
+        tee_slave->nb_dropped++;
+        return 0;
+    } else if (ret < 0) {
+        av_packet_free(&pkt2);
+        return ret;
+    }
+
+    if (pkt) {
+        tee_slave->dropping = 0;
+        tee_slave->need_keyframe[s2] = 0;
+    }
+    return 0;
+}
+
 static int tee_write_packet(AVFormatContext *avf, AVPacket *pkt)
 {
     TeeContext *tee = avf->priv_data;
@@ -548,61 +819,30 @@ static int tee_write_packet(AVFormatContext *avf, AVPacket *pkt)
 
     for (unsigned i = 0; i < tee->nb_slaves; i++) {
         AVFormatContext *avf2 = tee->slaves[i].avf;
-        AVBSFContext *bsfs;
 
         if (!avf2)
             continue;
 
-        /* Flush slave if pkt is NULL*/
-        if (!pkt) {
+        if (tee->slaves[i].queue) {
+            ret = queue_slave_packet(avf, i, pkt);
+        } else if (!pkt) {
+            /* Flush slave if pkt is NULL*/
             ret = av_interleaved_write_frame(avf2, NULL);
-            if (ret < 0) {
-                ret = tee_process_slave_failure(avf, i, ret);
-                if (!ret_all && ret < 0)
+        } else {
+            s = pkt->stream_index;
+            s2 = tee->slaves[i].stream_map[s];
+            if (s2 < 0)
+                continue;
+
+            if ((ret = av_packet_ref(pkt2, pkt)) < 0) {
+                if (!ret_all)
                     ret_all = ret;
+                continue;
             }
-            continue;
+            pkt2->stream_index = s2;
+            ret = write_slave_packet(avf, &tee->slaves[i], pkt2);
         }
 
-        s = pkt->stream_index;
-        s2 = tee->slaves[i].stream_map[s];
-        if (s2 < 0)
-            continue;
-
-        if ((ret = av_packet_ref(pkt2, pkt)) < 0) {
-            if (!ret_all)
-                ret_all = ret;
-            continue;
-        }
-        bsfs = tee->slaves[i].bsfs[s2];
-        pkt2->stream_index = s2;
-
-        ret = av_bsf_send_packet(bsfs, pkt2);
-        if (ret < 0) {
-            av_packet_unref(pkt2);
-            av_log(avf, AV_LOG_ERROR, "Error while sending packet to bitstream filter: %s\n",
-                   av_err2str(ret));
-            ret = tee_process_slave_failure(avf, i, ret);
-            if (!ret_all && ret < 0)
-                ret_all = ret;
-        }
-
-        while(1) {
-            ret = av_bsf_receive_packet(bsfs, pkt2);
-            if (ret == AVERROR(EAGAIN)) {
-                ret = 0;
-                break;
-            } else if (ret < 0) {
-                break;
-            }
-
-            av_packet_rescale_ts(pkt2, bsfs->time_base_out,
-                                 avf2->streams[s2]->time_base);
-            ret = av_interleaved_write_frame(avf2, pkt2);
-            if (ret < 0)
-                break;
-        };
-
         if (ret < 0) {
             ret = tee_process_slave_failure(avf, i, ret);
             if (!ret_all && ret < 0)
@@ -0,0 +1,277 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Serve an HLS stream from a local HTTP server and read it with upcoming
+ * segments requested ahead, checking that the packets are the same as when
+ * reading the playlist from the file system.
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/crc.h"
+#include "libavutil/dict.h"
+#include "libavutil/error.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/random_seed.h"
+#include "libavutil/thread.h"
+
+#include "libavformat/avformat.h"
+
+#define MAX_CLIENTS 256
+#define MAX_PACKETS 4096
+
+typedef struct PacketInfo {
+    int      stream_index;
+    int64_t  pts, dts;
+    int      size;
+    uint32_t crc;
+} PacketInfo;
+
+typedef struct Server {
+    AVIOContext *listener;
+    char         dir[1024];
+    pthread_t    thread;
+    pthread_t    clients[MAX_CLIENTS];
+    int          nb_clients;
+    atomic_int   quit;
+} Server;
+
+typedef struct Client {
+    Server      *srv;
+    AVIOContext *pb;
+} Client;
+
+static PacketInfo file_pkts[MAX_PACKETS], http_pkts[MAX_PACKETS];
+
+static int interrupt_cb(void *opaque)
+{
+    Server *srv = opaque;
+    return atomic_load(&srv->quit);
+}
+
+static void *serve_client(void *arg)
+{
+    Client *cl = arg;
+    AVIOContext *in = NULL;
+    uint8_t *resource = NULL;
+    uint8_t buf[4096];
+    char path[2048];
+    int ret;
+
+    while ((ret = avio_handshake(cl->pb)) > 0) {
+        av_opt_get(cl->pb, "resource", AV_OPT_SEARCH_CHILDREN, &resource);
+        if (resource && resource[0])
+            break;
+        av_freep(&resource);
+    }
+    if (ret < 0)
+        goto end;
+
+    ret = AVERROR_HTTP_NOT_FOUND;
+    if (resource && resource[0] == '/' && !strchr(resource + 1, '/')) {
+        snprintf(path, sizeof(path), "%s/%s", cl->srv->dir, resource + 1);
+        if (avio_open(&in, path, AVIO_FLAG_READ) >= 0)
+            ret = 200;
+    }
+    if (av_opt_set_int(cl->pb, "reply_code", ret, AV_OPT_SEARCH_CHILDREN) < 0)
+        goto end;
+    while ((ret = avio_handshake(cl->pb)) > 0);
+    if (ret < 0 || !in)
+        goto end;
+
+    while ((ret = avio_read(in, buf, sizeof(buf))) > 0)
+        avio_write(cl->pb, buf, ret);
+
+end:
+    avio_flush(cl->pb);
+    avio_closep(&cl->pb);
+    avio_closep(&in);
+    av_free(resource);
+    av_free(cl);
+    return NULL;
+}
+
+/* every connection is served by its own thread, so that requests made
+ * ahead do not wait for the ones before them to be read */
+static void *serve(void *arg)
+{
+    Server *srv = arg;
+
+    while (srv->nb_clients < MAX_CLIENTS) {
+        Client *cl = av_mallocz(sizeof(*cl));
+        if (!cl)
+            break;
+        cl->srv = srv;
+        if (avio_accept(srv->listener, &cl->pb) < 0) {
+            av_free(cl);
+            break;
+        }
+        if (pthread_create(&srv->clients[srv->nb_clients], NULL, serve_client, cl)) {
+            avio_closep(&cl->pb);
+            av_free(cl);
+            break;
+        }
+        srv->nb_clients++;
+    }
+
+    return NULL;
+}
+
+static int server_start(Server *srv, int *port)
+{
+    AVIOInterruptCB int_cb = { interrupt_cb, srv };
+    uint32_t seed = av_get_random_seed();
+    int ret = AVERROR(EADDRINUSE);
+
+    for (int i = 0; i < 32 && ret < 0; i++) {
+        AVDictionary *opts = NULL;
+        char url[64];
+
+        *port = 20000 + (seed + i * 997) % 30000;
+        snprintf(url, sizeof(url), "http://127.0.0.1:%d", *port);
+        av_dict_set(&opts, "listen", "2", 0);
+        ret = avio_open2(&srv->listener, url, AVIO_FLAG_WRITE, &int_cb, &opts);
+        av_dict_free(&opts);
+    }
+    if (ret < 0)
+        return ret;
+
+    if ((ret = pthread_create(&srv->thread, NULL, serve, srv))) {
+        avio_closep(&srv->listener);
+        return AVERROR(ret);
+    }
+    return 0;
+}
+
+static void server_stop(Server *srv)
+{
+    atomic_store(&srv->quit, 1);
+    pthread_join(srv->thread, NULL);
+    for (int i = 0; i < srv->nb_clients; i++)
+        pthread_join(srv->clients[i], NULL);
+    avio_closep(&srv->listener);
+}
+
+static int read_packets(const char *url, AVDictionary **opts, PacketInfo *pkts)
+{
+    const AVCRC *crc_table = av_crc_get_table(AV_CRC_32_IEEE_LE);
+    AVFormatContext *s = NULL;
+    AVPacket *pkt = av_packet_alloc();
+    int nb_pkts = 0, ret;
+
+    if (!pkt)
+        return AVERROR(ENOMEM);
+
+    if ((ret = avformat_open_input(&s, url, NULL, opts)) < 0)
+        goto end;
+
+    while ((ret = av_read_frame(s, pkt)) >= 0) {
+        if (nb_pkts == MAX_PACKETS) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        pkts[nb_pkts].stream_index = pkt->stream_index;
+        pkts[nb_pkts].pts          = pkt->pts;
+        pkts[nb_pkts].dts          = pkt->dts;
+        pkts[nb_pkts].size         = pkt->size;
+        pkts[nb_pkts].crc          = av_crc(crc_table, 0, pkt->data, pkt->size);
+        nb_pkts++;
+        av_packet_unref(pkt);
+    }
+    if (ret == AVERROR_EOF)
+        ret = nb_pkts;
+
+end:
+    av_packet_free(&pkt);
+    avformat_close_input(&s);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static Server srv;
+    AVDictionary *opts = NULL;
+    const char *name;
+    char url[1024];
+    int nb_file, nb_http, port, ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <playlist> [option=value ...]\n", argv[0]);
+        return 1;
+    }
+
+    av_log_set_level(AV_LOG_ERROR);
+    avformat_network_init();
+
+    nb_file = read_packets(argv[1], NULL, file_pkts);
+    if (nb_file < 0) {
+        fprintf(stderr, "reading %s failed: %s\n", argv[1], av_err2str(nb_file));
+        return 1;
+    }
+    printf("packets: %d\n", nb_file);
+
+    name = strrchr(argv[1], '/');
+    snprintf(srv.dir, sizeof(srv.dir), "%.*s",
+             name ? (int)(name - argv[1]) : 1, name ? argv[1] : ".");
+    name = name ? name + 1 : argv[1];
+
+    ret = server_start(&srv, &port);
+    if (ret < 0) {
+        fprintf(stderr, "starting the server failed: %s\n", av_err2str(ret));
+        return 1;
+    }
+
+    av_dict_set(&opts, "http_multiple", "1", 0);
+    av_dict_set(&opts, "prefetch_segments", "4", 0);
+    for (int i = 2; i < argc; i++)
+        av_dict_parse_string(&opts, argv[i], "=", ":", 0);
+
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/%s", port, name);
+    nb_http = read_packets(url, &opts, http_pkts);
+    av_dict_free(&opts);
+    server_stop(&srv);
+
+    if (nb_http < 0) {
+        fprintf(stderr, "reading %s failed: %s\n", url, av_err2str(nb_http));
+        return 1;
+    }
+    if (nb_http != nb_file) {
+        fprintf(stderr, "read %d packets over http, %d from the file system\n",
+                nb_http, nb_file);
+        return 1;
+    }
+    for (int i = 0; i < nb_file; i++) {
+        const PacketInfo *a = &file_pkts[i], *b = &http_pkts[i];
+        if (a->stream_index != b->stream_index || a->pts != b->pts ||
+            a->dts != b->dts || a->size != b->size || a->crc != b->crc) {
+            fprintf(stderr, "packet %d differs: stream %d pts %"PRId64" size %d\n",
+                    i, http_pkts[i].stream_index, http_pkts[i].pts, http_pkts[i].size);
+            return 1;
+        }
+    }
+    printf("http: ok\n");
+
+    avformat_network_deinit();
+    return 0;
+}
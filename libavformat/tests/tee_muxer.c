@@ -0,0 +1,278 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Overflow the queue of an async tee slave whose muxer is held inside
+ * write_packet() until the test releases it, and check which packets
+ * the slave receives with queue_overflow=drop and queue_overflow=block.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+#include "libavformat/mux.h"
+
+/*
+ * Include tee.c directly to override libavformat/tee.c and thereby prevent
+ * libavformat/tee.o from being pulled in when linking. This relies on
+ * libavformat always being linked statically to its test tools (like this
+ * one). Due to TEE_TEST, our tee muxer allows selecting the tee_test muxer
+ * below for a slave, even though it is not accessible via the API.
+ */
+#define TEE_TEST
+#include "libavformat/tee.c"
+
+#define QUEUE_SIZE  2
+#define NB_PACKETS  10
+#define KEY_PERIOD  4
+
+/* State of the tee_test muxer, shared with the slave thread */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cond = PTHREAD_COND_INITIALIZER;
+static int     gate_open;   /* write_packet() may return */
+static int     nb_entered;  /* number of write_packet() calls so far */
+static int     nb_written;
+static int64_t pts_written[NB_PACKETS];
+
+static int tee_test_packet(AVFormatContext *avf, AVPacket *pkt)
+{
+    pthread_mutex_lock(&lock);
+    nb_entered++;
+    pthread_cond_broadcast(&cond);
+    while (!gate_open)
+        pthread_cond_wait(&cond, &lock);
+    if (nb_written < NB_PACKETS)
+        pts_written[nb_written++] = pkt->pts;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+    return 0;
+}
+
+const FFOutputFormat ff_tee_test_muxer = {
+    .p.name         = "tee_test",
+    .p.long_name    = NULL_IF_CONFIG_SMALL("Tee test muxer"),
+    .write_packet   = tee_test_packet,
+    .p.flags        = AVFMT_NOFILE,
+};
+
+static void reset_muxer(void)
+{
+    gate_open  = 0;
+    nb_entered = 0;
+    nb_written = 0;
+}
+
+static void open_gate(void)
+{
+    pthread_mutex_lock(&lock);
+    gate_open = 1;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+}
+
+static void wait_for(int *counter, int value)
+{
+    pthread_mutex_lock(&lock);
+    while (*counter < value)
+        pthread_cond_wait(&cond, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+static int get_written(void)
+{
+    int ret;
+    pthread_mutex_lock(&lock);
+    ret = nb_written;
+    pthread_mutex_unlock(&lock);
+    return ret;
+}
+
+static int write_packet(AVFormatContext *oc, AVPacket *pkt, int64_t pts)
+{
+    int ret = av_new_packet(pkt, 16);
+    if (ret < 0)
+        return ret;
+
+    pkt->pts = pkt->dts = pts;
+    pkt->duration = 1;
+    pkt->flags = pts % KEY_PERIOD ? 0 : AV_PKT_FLAG_KEY;
+    ret = av_write_frame(oc, pkt);
+    av_packet_unref(pkt);
+    return ret;
+}
+
+static void *release_gate(void *arg)
+{
+    av_usleep(20000);
+    open_gate();
+    return NULL;
+}
+
+/*
+ * The slave is held inside the first packet while the next ones are sent.
+ * Two of them fit into the queue and the rest is dropped, including the key
+ * frame among them. Once the slave has caught up, packets are dropped until
+ * the next key frame.
+ */
+static int overflow_drop_test(AVFormatContext *oc, AVPacket *pkt)
+{
+    TeeContext *tee = oc->priv_data;
+    int64_t pts = 0;
+    int ret;
+
+    if ((ret = write_packet(oc, pkt, pts++)) < 0)
+        return ret;
+    wait_for(&nb_entered, 1);
+
+    while (pts < NB_PACKETS / 2 + 1) {
+        if ((ret = write_packet(oc, pkt, pts++)) < 0)
+            return ret;
+    }
+
+    open_gate();
+    wait_for(&nb_written, QUEUE_SIZE + 1);
+
+    while (pts < NB_PACKETS) {
+        if ((ret = write_packet(oc, pkt, pts++)) < 0)
+            return ret;
+    }
+
+    printf("dropped: %"PRId64"\n", tee->slaves[0].nb_dropped);
+    return 0;
+}
+
+/*
+ * The slave is held inside the first packet and released from another
+ * thread. Sending a packet must wait whenever the queue is full, so no
+ * packet can be sent before the slave has written all but the packets
+ * that fit into the queue and the muxer.
+ */
+static int overflow_block_test(AVFormatContext *oc, AVPacket *pkt)
+{
+    TeeContext *tee = oc->priv_data;
+    pthread_t thread;
+    int64_t pts = 0;
+    int ret;
+
+    if ((ret = write_packet(oc, pkt, pts++)) < 0)
+        return ret;
+    wait_for(&nb_entered, 1);
+
+    ret = pthread_create(&thread, NULL, release_gate, NULL);
+    if (ret)
+        return AVERROR(ret);
+
+    while (pts < NB_PACKETS) {
+        if ((ret = write_packet(oc, pkt, pts++)) < 0)
+            break;
+        if (pts - get_written() > QUEUE_SIZE + 1) {
+            fprintf(stderr, "Packet %"PRId64" was queued beyond the queue size\n",
+                    pts - 1);
+            ret = AVERROR_BUG;
+            break;
+        }
+    }
+
+    pthread_join(thread, NULL);
+    if (ret < 0)
+        return ret;
+
+    printf("dropped: %"PRId64"\n", tee->slaves[0].nb_dropped);
+    return 0;
+}
+
+typedef struct TestCase {
+    int (*test_func)(AVFormatContext *oc, AVPacket *pkt);
+    const char *test_name;
+    const char *overflow;
+} TestCase;
+
+static int run_test(const TestCase *test)
+{
+    AVFormatContext *oc = NULL;
+    AVPacket *pkt = NULL;
+    AVStream *st;
+    char slaves[128];
+    int ret;
+
+    reset_muxer();
+
+    snprintf(slaves, sizeof(slaves),
+             "[f=tee_test:async=1:queue_size=%d:queue_overflow=%s]-",
+             QUEUE_SIZE, test->overflow);
+    ret = avformat_alloc_output_context2(&oc, NULL, "tee", slaves);
+    if (ret < 0)
+        goto end;
+
+    st  = avformat_new_stream(oc, NULL);
+    pkt = av_packet_alloc();
+    if (!st || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    st->codecpar->codec_type = AVMEDIA_TYPE_DATA;
+    st->time_base = (AVRational){ 1, 25 };
+
+    ret = avformat_write_header(oc, NULL);
+    if (ret < 0)
+        goto end;
+
+    ret = test->test_func(oc, pkt);
+    if (ret < 0) {
+        open_gate();
+        av_write_trailer(oc);
+        goto end;
+    }
+
+    ret = av_write_trailer(oc);
+    if (ret < 0)
+        goto end;
+
+    printf("pts written:");
+    for (int i = 0; i < nb_written; i++)
+        printf("%s%"PRId64, i ? "," : " ", pts_written[i]);
+    printf("\n");
+
+end:
+    printf("%s: %s\n", test->test_name, ret < 0 ? "fail" : "ok");
+    avformat_free_context(oc);
+    av_packet_free(&pkt);
+    return ret;
+}
+
+static const TestCase tests[] = {
+    { overflow_drop_test,  "overflow with packet dropping", "drop"  },
+    { overflow_block_test, "overflow with blocking",        "block" },
+    { NULL }
+};
+
+int main(void)
+{
+    int ret, ret_all = 0;
+
+    for (int i = 0; tests[i].test_func; i++) {
+        ret = run_test(&tests[i]);
+        if (!ret_all && ret < 0)
+            ret_all = ret;
+    }
+
+    return ret_all < 0;
+}
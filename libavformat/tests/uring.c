@@ -0,0 +1,176 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Write a file through the uring protocol with small blocks, patching it
+ * after a seek back, then read it back sequentially and at random
+ * positions, checking every byte.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/error.h"
+#include "libavutil/lfg.h"
+#include "libavutil/macros.h"
+
+#include "libavformat/avio.h"
+
+/* not a multiple of the block size, so the last block is partial */
+#define FILE_SIZE  100003
+#define PATCH_POS  10
+#define PATCH_SIZE 16
+
+static uint8_t expected[FILE_SIZE];
+
+static int open_uring(AVIOContext **pb, const char *path, int flags)
+{
+    AVDictionary *opts = NULL;
+    char url[1024];
+    int ret;
+
+    snprintf(url, sizeof(url), "uring:%s", path);
+    av_dict_set(&opts, "block_size", "4096", 0);
+    av_dict_set(&opts, "queue_depth", "3", 0);
+    ret = avio_open2(pb, url, flags, NULL, &opts);
+    av_dict_free(&opts);
+    return ret;
+}
+
+static int test_write(const char *path, AVLFG *lfg)
+{
+    AVIOContext *pb;
+    int pos = 0, ret;
+
+    for (int i = 0; i < FILE_SIZE; i++)
+        expected[i] = i * 7 + (i >> 8);
+
+    if ((ret = open_uring(&pb, path, AVIO_FLAG_WRITE)) < 0)
+        return ret;
+
+    while (pos < FILE_SIZE) {
+        int n = FFMIN(av_lfg_get(lfg) % 3000 + 1, FILE_SIZE - pos);
+        avio_write(pb, expected + pos, n);
+        pos += n;
+    }
+
+    /* patch the start, as muxers do with their header */
+    for (int i = 0; i < PATCH_SIZE; i++)
+        expected[PATCH_POS + i] = 0xA0 + i;
+    if (avio_seek(pb, PATCH_POS, SEEK_SET) != PATCH_POS)
+        ret = AVERROR(EIO);
+    avio_write(pb, expected + PATCH_POS, PATCH_SIZE);
+
+    if (pb->error < 0 && ret >= 0)
+        ret = pb->error;
+    if ((pos = avio_closep(&pb)) < 0 && ret >= 0)
+        ret = pos;
+    return ret;
+}
+
+static int check_read(AVIOContext *pb, int pos, int size)
+{
+    uint8_t buf[4096];
+    int ret = avio_read(pb, buf, size);
+
+    if (ret != FFMIN(size, FILE_SIZE - pos)) {
+        fprintf(stderr, "read of %d bytes at %d returned %d\n", size, pos, ret);
+        return AVERROR(EIO);
+    }
+    if (memcmp(buf, expected + pos, ret)) {
+        fprintf(stderr, "mismatch in %d bytes read at %d\n", size, pos);
+        return AVERROR(EIO);
+    }
+    return ret;
+}
+
+static int test_read(const char *path, AVLFG *lfg)
+{
+    AVIOContext *pb;
+    uint8_t buf[16];
+    int pos = 0, ret;
+
+    if ((ret = open_uring(&pb, path, AVIO_FLAG_READ)) < 0)
+        return ret;
+
+    if (avio_size(pb) != FILE_SIZE) {
+        fprintf(stderr, "unexpected file size %"PRId64"\n", avio_size(pb));
+        ret = AVERROR(EIO);
+        goto end;
+    }
+
+    while (pos < FILE_SIZE) {
+        ret = check_read(pb, pos, av_lfg_get(lfg) % 4096 + 1);
+        if (ret < 0)
+            goto end;
+        pos += ret;
+    }
+    if (avio_read(pb, buf, sizeof(buf)) != AVERROR_EOF || !avio_feof(pb)) {
+        fprintf(stderr, "no end of file after the last byte\n");
+        ret = AVERROR(EIO);
+        goto end;
+    }
+    printf("sequential read: ok\n");
+
+    for (int i = 0; i < 200; i++) {
+        pos = av_lfg_get(lfg) % FILE_SIZE;
+        if (avio_seek(pb, pos, SEEK_SET) != pos) {
+            fprintf(stderr, "seek to %d failed\n", pos);
+            ret = AVERROR(EIO);
+            goto end;
+        }
+        ret = check_read(pb, pos, av_lfg_get(lfg) % 4096 + 1);
+        if (ret < 0)
+            goto end;
+    }
+    printf("random read: ok\n");
+    ret = 0;
+
+end:
+    avio_closep(&pb);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    AVLFG lfg;
+    int ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <temporary file>\n", argv[0]);
+        return 1;
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    ret = test_write(argv[1], &lfg);
+    if (ret < 0) {
+        fprintf(stderr, "writing failed: %s\n", av_err2str(ret));
+        return 1;
+    }
+    printf("write: ok\n");
+
+    ret = test_read(argv[1], &lfg);
+    if (ret < 0) {
+        fprintf(stderr, "reading failed: %s\n", av_err2str(ret));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,735 @@
+/*
+ * io_uring file protocol
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Local file access through an io_uring submission queue.
+ *
+ * Reads are served from a window of queue_depth blocks which are kept in
+ * flight ahead of the read position. Writes are collected in blocks which
+ * are submitted as soon as they are full, so that the caller can fill the
+ * next block while the kernel writes the previous ones. All requests use
+ * explicit file offsets, so the file position of the descriptor is unused.
+ *
+ * If io_uring is not available, e.g. disabled by the system or not
+ * supported by the kernel, plain pread()/pwrite() calls are used instead.
+ */
+
+#include "config.h"
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/error.h"
+#include "libavutil/file_open.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "avio.h"
+#include "url.h"
+
+/* alignment of buffers, offsets and sizes for O_DIRECT */
+#define DIRECT_ALIGN 4096
+
+typedef struct URingBlock {
+    uint8_t *buf;
+    int64_t  pos;       ///< file offset of buf[0]
+    int      size;      ///< bytes to read, or bytes filled for writing
+    int      done;      ///< bytes transferred so far
+    int      result;    ///< negative error code of the last read request
+    int      busy;      ///< opcode of the request in flight, 0 if none
+} URingBlock;
+
+typedef struct URingContext {
+    const AVClass *class;
+    int queue_depth;
+    int block_size;
+    int direct;
+    int trunc;
+
+    int fd;
+    int flags;
+    int fallback;                   ///< io_uring is unavailable, use pread()/pwrite()
+
+    /* rings shared with the kernel */
+    int ring_fd;
+    void  *sq_ring, *cq_ring;
+    size_t sq_ring_size, cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    atomic_uint *sq_tail;
+    atomic_uint *cq_head, *cq_tail;
+    unsigned *sq_array;
+    unsigned  sq_mask, cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned  nb_queued;            ///< entries not yet passed to the kernel
+
+    URingBlock *blocks;
+    uint8_t    *pool;
+    int         nb_blocks;
+
+    int64_t pos;                    ///< logical position
+
+    /* read-ahead window: nb_window blocks starting at index first,
+     * covering consecutive file ranges up to next_read_pos */
+    int     first;
+    int     nb_window;
+    int64_t next_read_pos;
+
+    /* write-behind: block being filled and its fill level */
+    int cur;
+    int fill;
+    int write_error;                ///< first error of any write request
+} URingContext;
+
+#define OFFSET(x) offsetof(URingContext, x)
+#define D AV_OPT_FLAG_DECODING_PARAM
+#define E AV_OPT_FLAG_ENCODING_PARAM
+static const AVOption uring_options[] = {
+    { "queue_depth", "number of requests kept in flight", OFFSET(queue_depth), AV_OPT_TYPE_INT, { .i64 = 4 }, 1, 256, D|E },
+    { "block_size", "size of a request in bytes", OFFSET(block_size), AV_OPT_TYPE_INT, { .i64 = 1 << 20 }, DIRECT_ALIGN, 1 << 28, D|E },
+    { "direct", "bypass the page cache (O_DIRECT)", OFFSET(direct), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, D|E },
+    { "truncate", "truncate existing files on write", OFFSET(trunc), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, E },
+    { NULL }
+};
+
+static const AVClass uring_class = {
+    .class_name = "uring",
+    .item_name  = av_default_item_name,
+    .option     = uring_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
+static int ring_setup(URLContext *h, unsigned entries)
+{
+    URingContext *c = h->priv_data;
+    struct io_uring_params p = { 0 };
+    uint8_t *sq, *cq;
+
+    c->ring_fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (c->ring_fd < 0)
+        return AVERROR(errno);
+    /* IORING_OP_READ/WRITE were added together with this feature */
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        av_log(h, AV_LOG_VERBOSE, "io_uring lacks read/write support, kernel too old\n");
+        return AVERROR(ENOSYS);
+    }
+
+    c->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    c->cq_ring_size = p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        c->sq_ring_size = c->cq_ring_size = FFMAX(c->sq_ring_size, c->cq_ring_size);
+    c->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    c->sq_ring = mmap(NULL, c->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_SQ_RING);
+    if (c->sq_ring == MAP_FAILED) {
+        c->sq_ring = NULL;
+        return AVERROR(errno);
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        c->cq_ring = c->sq_ring;
+    } else {
+        c->cq_ring = mmap(NULL, c->cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_CQ_RING);
+        if (c->cq_ring == MAP_FAILED) {
+            c->cq_ring = NULL;
+            return AVERROR(errno);
+        }
+    }
+    c->sqes = mmap(NULL, c->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, c->ring_fd, IORING_OFF_SQES);
+    if (c->sqes == MAP_FAILED) {
+        c->sqes = NULL;
+        return AVERROR(errno);
+    }
+
+    sq = c->sq_ring;
+    cq = c->cq_ring;
+    c->sq_tail  = (atomic_uint *)(sq + p.sq_off.tail);
+    c->sq_mask  = *(unsigned *)(sq + p.sq_off.ring_mask);
+    c->sq_array =  (unsigned *)(sq + p.sq_off.array);
+    c->cq_head  = (atomic_uint *)(cq + p.cq_off.head);
+    c->cq_tail  = (atomic_uint *)(cq + p.cq_off.tail);
+    c->cq_mask  = *(unsigned *)(cq + p.cq_off.ring_mask);
+    c->cqes     =  (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    return 0;
+}
+
+static void ring_free(URingContext *c)
+{
+    if (c->sqes)
+        munmap(c->sqes, c->sqes_size);
+    if (c->cq_ring && c->cq_ring != c->sq_ring)
+        munmap(c->cq_ring, c->cq_ring_size);
+    if (c->sq_ring)
+        munmap(c->sq_ring, c->sq_ring_size);
+    if (c->ring_fd >= 0)
+        close(c->ring_fd);
+    c->sqes    = NULL;
+    c->cq_ring = c->sq_ring = NULL;
+    c->ring_fd = -1;
+}
+
+/**
+ * Queue a read or write request for the not yet transferred part of a block.
+ * There is at most one request per block in flight, so the queue cannot
+ * overflow.
+ */
+static void queue_request(URingContext *c, int idx, int opcode)
+{
+    URingBlock *b = &c->blocks[idx];
+    unsigned tail = atomic_load_explicit(c->sq_tail, memory_order_relaxed);
+    unsigned slot = tail & c->sq_mask;
+    struct io_uring_sqe *sqe = &c->sqes[slot];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = opcode;
+    sqe->fd        = c->fd;
+    sqe->addr      = (uintptr_t)(b->buf + b->done);
+    sqe->len       = b->size - b->done;
+    sqe->off       = b->pos + b->done;
+    sqe->user_data = idx;
+    c->sq_array[slot] = slot;
+    atomic_store_explicit(c->sq_tail, tail + 1, memory_order_release);
+
+    b->busy = opcode;
+    c->nb_queued++;
+}
+
+static int ring_enter(URingContext *c, unsigned min_complete)
+{
+    while (c->nb_queued || min_complete) {
+        int ret = syscall(__NR_io_uring_enter, c->ring_fd, c->nb_queued, min_complete,
+                          min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        c->nb_queued -= ret;
+        if (min_complete || !ret)
+            break;
+    }
+    return 0;
+}
+
+/**
+ * Handle all available completions. Short transfers are continued with
+ * a new request, a read returning no data means end of file.
+ */
+static void reap_completions(URingContext *c)
+{
+    unsigned head = atomic_load_explicit(c->cq_head, memory_order_relaxed);
+
+    while (head != atomic_load_explicit(c->cq_tail, memory_order_acquire)) {
+        const struct io_uring_cqe *cqe = &c->cqes[head & c->cq_mask];
+        URingBlock *b = &c->blocks[cqe->user_data];
+        int opcode = b->busy;
+
+        b->busy = 0;
+        if (opcode == IORING_OP_READ) {
+            if (cqe->res < 0) {
+                b->result = cqe->res;
+            } else if (!cqe->res) {
+                b->size = b->done;
+            } else {
+                b->done += cqe->res;
+                if (b->done < b->size)
+                    queue_request(c, cqe->user_data, opcode);
+            }
+        } else if (cqe->res <= 0) {
+            if (!c->write_error)
+                c->write_error = cqe->res ? cqe->res : AVERROR(EIO);
+        } else {
+            b->done += cqe->res;
+            if (b->done < b->size)
+                queue_request(c, cqe->user_data, opcode);
+        }
+        head++;
+    }
+    atomic_store_explicit(c->cq_head, head, memory_order_release);
+}
+
+static int wait_block(URingContext *c, URingBlock *b)
+{
+    int ret = ring_enter(c, 0);
+    if (ret < 0)
+        return ret;
+
+    reap_completions(c);
+    while (b->busy) {
+        ret = ring_enter(c, 1);
+        if (ret < 0)
+            return ret;
+        reap_completions(c);
+    }
+    return 0;
+}
+
+static int wait_all(URingContext *c)
+{
+    int ret = 0;
+    for (int i = 0; i < c->nb_blocks; i++) {
+        int err = wait_block(c, &c->blocks[i]);
+        if (err < 0)
+            ret = err;
+    }
+    return ret;
+}
+
+/**
+ * Requests which do not satisfy the O_DIRECT alignment constraints, e.g.
+ * small header updates after a seek or the tail of the file, make the
+ * context switch to buffered I/O.
+ */
+static int check_direct(URLContext *h, int64_t pos, int size)
+{
+    URingContext *c = h->priv_data;
+    int ret;
+
+    if (!c->direct || !((pos | size) & (DIRECT_ALIGN - 1)))
+        return 0;
+
+    ret = wait_all(c);
+    if (ret < 0)
+        return ret;
+    if (fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) & ~O_DIRECT) < 0)
+        return AVERROR(errno);
+    av_log(h, AV_LOG_VERBOSE, "Unaligned access at %"PRId64", "
+           "switching to buffered I/O\n", pos);
+    c->direct = 0;
+    return 0;
+}
+
+/* read-ahead */
+
+static int window_reset(URingContext *c)
+{
+    int ret = wait_all(c);
+    c->first     = 0;
+    c->nb_window = 0;
+    return ret;
+}
+
+static void window_fill(URingContext *c)
+{
+    while (c->nb_window < c->nb_blocks) {
+        int idx = (c->first + c->nb_window) % c->nb_blocks;
+        URingBlock *b = &c->blocks[idx];
+
+        b->pos    = c->next_read_pos;
+        b->size   = c->block_size;
+        b->done   = 0;
+        b->result = 0;
+        queue_request(c, idx, IORING_OP_READ);
+
+        c->next_read_pos += c->block_size;
+        c->nb_window++;
+    }
+}
+
+static void window_advance(URingContext *c)
+{
+    c->first = (c->first + 1) % c->nb_blocks;
+    c->nb_window--;
+}
+
+static int write_flush(URLContext *h);
+
+static int fallback_read(URingContext *c, unsigned char *buf, int size)
+{
+    ssize_t n;
+
+    do {
+        n = pread(c->fd, buf, size, c->pos);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return AVERROR(errno);
+    if (!n)
+        return AVERROR_EOF;
+    c->pos += n;
+    return n;
+}
+
+static int uring_read(URLContext *h, unsigned char *buf, int size)
+{
+    URingContext *c = h->priv_data;
+    int ret;
+
+    if (c->fallback)
+        return fallback_read(c, buf, size);
+
+    if (c->flags & AVIO_FLAG_WRITE) {
+        ret = write_flush(h);
+        if (ret < 0)
+            return ret;
+    }
+
+    for (;;) {
+        URingBlock *b;
+        int n;
+
+        /* drop the blocks before the read position, or the whole window
+         * if the read position is outside of it */
+        while (c->nb_window) {
+            b = &c->blocks[c->first];
+            if (c->pos < b->pos ||
+                c->pos >= b->pos + (int64_t)c->nb_window * c->block_size) {
+                ret = window_reset(c);
+                if (ret < 0)
+                    return ret;
+                break;
+            }
+            if (c->pos < b->pos + c->block_size)
+                break;
+            ret = wait_block(c, b);
+            if (ret < 0)
+                return ret;
+            window_advance(c);
+        }
+        if (!c->nb_window)
+            c->next_read_pos = c->pos & ~(int64_t)(DIRECT_ALIGN - 1);
+
+        window_fill(c);
+        b = &c->blocks[c->first];
+        ret = wait_block(c, b);
+        if (ret < 0)
+            return ret;
+
+        if (b->result < 0) {
+            ret = b->result;
+            window_reset(c);
+            return ret;
+        }
+        if (c->pos >= b->pos + b->size) {
+            if (b->size < c->block_size) {
+                /* end of file; start over on the next call, in case the
+                 * file is still growing */
+                ret = window_reset(c);
+                return ret < 0 ? ret : AVERROR_EOF;
+            }
+            window_advance(c);
+            continue;
+        }
+
+        n = FFMIN(size, b->pos + b->size - c->pos);
+        memcpy(buf, b->buf + (c->pos - b->pos), n);
+        c->pos += n;
+        return n;
+    }
+}
+
+/* write-behind */
+
+static int submit_write(URLContext *h)
+{
+    URingContext *c = h->priv_data;
+    URingBlock *b = &c->blocks[c->cur];
+    int ret;
+
+    if (!c->fill)
+        return 0;
+
+    ret = check_direct(h, b->pos, c->fill);
+    if (ret < 0)
+        return ret;
+
+    b->size = c->fill;
+    b->done = 0;
+    queue_request(c, c->cur, IORING_OP_WRITE);
+    c->cur  = (c->cur + 1) % c->nb_blocks;
+    c->fill = 0;
+
+    return ring_enter(c, 0);
+}
+
+/**
+ * Submit the partially filled block and wait until all data has been
+ * written, returning the first error of any write request.
+ */
+static int write_flush(URLContext *h)
+{
+    URingContext *c = h->priv_data;
+    int ret;
+
+    if (c->fallback)
+        return 0;
+
+    ret = submit_write(h);
+
+    if (ret >= 0)
+        ret = wait_all(c);
+    if (ret < 0 && !c->write_error)
+        c->write_error = ret;
+    return c->write_error;
+}
+
+static int fallback_write(URingContext *c, const unsigned char *buf, int size)
+{
+    ssize_t n;
+
+    do {
+        n = pwrite(c->fd, buf, size, c->pos);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+        return AVERROR(errno);
+    c->pos += n;
+    return n;
+}
+
+static int uring_write(URLContext *h, const unsigned char *buf, int size)
+{
+    URingContext *c = h->priv_data;
+    int written = 0;
+    int ret;
+
+    if (c->fallback)
+        return fallback_write(c, buf, size);
+
+    if (c->write_error)
+        return c->write_error;
+    if (c->nb_window) {
+        ret = window_reset(c);
+        if (ret < 0)
+            return ret;
+    }
+
+    while (written < size) {
+        URingBlock *b = &c->blocks[c->cur];
+        int n;
+
+        if (!c->fill) {
+            /* reuse the block once its previous request has finished */
+            ret = wait_block(c, b);
+            if (ret < 0)
+                return ret;
+            if (c->write_error)
+                return c->write_error;
+            b->pos = c->pos;
+        }
+
+        n = FFMIN(size - written, c->block_size - c->fill);
+        memcpy(b->buf + c->fill, buf + written, n);
+        c->fill += n;
+        c->pos  += n;
+        written += n;
+
+        if (c->fill == c->block_size) {
+            ret = submit_write(h);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    return written;
+}
+
+static int64_t uring_seek(URLContext *h, int64_t pos, int whence)
+{
+    URingContext *c = h->priv_data;
+    struct stat st;
+    int ret;
+
+    /* pending writes must land before the file size is queried, and before
+     * writing elsewhere, which might overlap them */
+    if (c->flags & AVIO_FLAG_WRITE) {
+        ret = write_flush(h);
+        if (ret < 0)
+            return ret;
+    }
+
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return fstat(c->fd, &st) < 0 ? AVERROR(errno) : st.st_size;
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        pos += c->pos;
+        break;
+    case SEEK_END:
+        if (fstat(c->fd, &st) < 0)
+            return AVERROR(errno);
+        pos += st.st_size;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    c->pos = pos;
+    return pos;
+}
+
+static int uring_get_handle(URLContext *h)
+{
+    URingContext *c = h->priv_data;
+
+    /* the caller may access the file directly */
+    if (c->flags & AVIO_FLAG_WRITE) {
+        int ret = write_flush(h);
+        if (ret < 0)
+            return ret;
+    }
+    return c->fd;
+}
+
+static int uring_close(URLContext *h)
+{
+    URingContext *c = h->priv_data;
+    int ret = 0;
+
+    if (c->sqes) {
+        if (c->flags & AVIO_FLAG_WRITE) {
+            ret = write_flush(h);
+        } else {
+            int err = wait_all(c);
+            if (err < 0)
+                ret = err;
+        }
+    }
+
+    ring_free(c);
+    if (c->fd >= 0 && close(c->fd) < 0 && ret >= 0)
+        ret = AVERROR(errno);
+    av_freep(&c->pool);
+    av_freep(&c->blocks);
+    return ret;
+}
+
+static int uring_open(URLContext *h, const char *filename, int flags)
+{
+    URingContext *c = h->priv_data;
+    uint8_t *pool;
+    struct stat st;
+    int access;
+    int ret;
+
+    c->fd      = -1;
+    c->ring_fd = -1;
+    c->flags   = flags;
+
+    av_strstart(filename, "uring:", &filename);
+
+    if (flags & AVIO_FLAG_WRITE && flags & AVIO_FLAG_READ) {
+        access = O_CREAT | O_RDWR;
+        if (c->trunc)
+            access |= O_TRUNC;
+    } else if (flags & AVIO_FLAG_WRITE) {
+        access = O_CREAT | O_WRONLY;
+        if (c->trunc)
+            access |= O_TRUNC;
+    } else {
+        access = O_RDONLY;
+    }
+    if (c->direct)
+        access |= O_DIRECT;
+
+    c->fd = avpriv_open(filename, access, 0666);
+    if (c->fd == -1) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+    if (fstat(c->fd, &st) < 0) {
+        ret = AVERROR(errno);
+        goto fail;
+    }
+    if (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode)) {
+        av_log(h, AV_LOG_ERROR, "%s is not a regular file or block device\n", filename);
+        ret = AVERROR(EINVAL);
+        goto fail;
+    }
+
+    c->block_size = FFALIGN(c->block_size, DIRECT_ALIGN);
+    c->nb_blocks  = c->queue_depth;
+    c->blocks = av_calloc(c->nb_blocks, sizeof(*c->blocks));
+    c->pool   = av_malloc((size_t)c->nb_blocks * c->block_size + DIRECT_ALIGN);
+    if (!c->blocks || !c->pool) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    pool = (uint8_t *)FFALIGN((uintptr_t)c->pool, DIRECT_ALIGN);
+    for (int i = 0; i < c->nb_blocks; i++)
+        c->blocks[i].buf = pool + (size_t)i * c->block_size;
+
+    ret = ring_setup(h, c->nb_blocks);
+    if (ret == AVERROR(ENOMEM)) {
+        /* The rings are charged to RLIMIT_MEMLOCK on older kernels. Running
+         * out of memory is an error of its own, never a reason to fall back */
+        av_log(h, AV_LOG_ERROR, "Not enough memory for an io_uring with %d "
+               "entries, lower queue_depth or raise RLIMIT_MEMLOCK\n", c->nb_blocks);
+        goto fail;
+    }
+    if (ret == AVERROR(EPERM) || ret == AVERROR(ENOSYS)) {
+        /* io_uring disabled by the system, or not supported by the kernel */
+        av_log(h, AV_LOG_WARNING, "io_uring is not available (%s), "
+               "falling back to plain reads and writes\n", av_err2str(ret));
+        ring_free(c);
+        if (c->direct &&
+            fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) & ~O_DIRECT) < 0) {
+            ret = AVERROR(errno);
+            goto fail;
+        }
+        c->direct   = 0;
+        c->fallback = 1;
+        return 0;
+    }
+    if (ret < 0) {
+        av_log(h, AV_LOG_ERROR, "io_uring_setup() failed: %s\n", av_err2str(ret));
+        goto fail;
+    }
+
+    h->max_packet_size = c->block_size;
+    if (flags & AVIO_FLAG_WRITE)
+        h->min_packet_size = h->max_packet_size;
+
+    return 0;
+
+fail:
+    uring_close(h);
+    return ret;
+}
+
+const URLProtocol ff_uring_protocol = {
+    .name                = "uring",
+    .url_open            = uring_open,
+    .url_read            = uring_read,
+    .url_write           = uring_write,
+    .url_seek            = uring_seek,
+    .url_close           = uring_close,
+    .url_get_file_handle = uring_get_handle,
+    .priv_data_size      = sizeof(URingContext),
+    .priv_data_class     = &uring_class,
+    .default_whitelist   = "uring,file,crypto,data",
+};
@@ -111,6 +111,26 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size)
+{
+    int64_t pos = avio_tell(s);
+    AVBufferRef *buf;
+    uint8_t *data;
+    int ret;
+
+    ret = ffio_read_ref(s, size, &buf, &data);
+    if (ret <= 0)
+        return ret < 0 ? ret : av_get_packet(s, pkt, size);
+
+    av_packet_unref(pkt);
+    pkt->buf  = buf;
+    pkt->data = data;
+    pkt->size = size;
+    pkt->pos  = pos;
+
+    return size;
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
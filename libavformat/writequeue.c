@@ -0,0 +1,383 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/error.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+#include "internal.h"
+#include "url.h"
+#include "writequeue.h"
+
+/* queueing blocks while this many operations are pending */
+#define MAX_PENDING_JOBS 32
+
+enum JobType {
+    JOB_WRITE,
+    JOB_CLOSE,
+    JOB_RENAME,
+    JOB_DELETE,
+};
+
+typedef struct WriteJob {
+    enum JobType     type;
+    char            *url;
+    char            *rename_to;
+    AVDictionary    *options;
+    uint8_t         *data;
+    size_t           size;
+    AVIOContext     *pb;
+    struct WriteJob *next;
+} WriteJob;
+
+#if HAVE_THREADS
+
+struct FFWriteQueue {
+    AVFormatContext *s;
+    pthread_t        thread;
+
+    pthread_mutex_t  lock;
+    pthread_cond_t   cond;
+    WriteJob        *head, **tail;
+    int              nb_jobs;   /* queued or running */
+    uint64_t         nb_queued; /* since the queue was allocated */
+    uint64_t         nb_done;
+    int              finished;
+    int              error;
+};
+
+static void free_job(WriteJob *job)
+{
+    av_freep(&job->url);
+    av_freep(&job->rename_to);
+    av_dict_free(&job->options);
+    av_freep(&job->data);
+    av_free(job);
+}
+
+static int write_file(AVFormatContext *s, WriteJob *job)
+{
+    AVDictionary *options = NULL;
+    AVIOContext *pb = NULL;
+    int ret, err;
+
+    av_dict_copy(&options, job->options, 0);
+    ret = s->io_open(s, &pb, job->url, AVIO_FLAG_WRITE, &options);
+    av_dict_free(&options);
+    if (ret < 0)
+        return ret;
+
+    avio_write(pb, job->data, job->size);
+    avio_flush(pb);
+    ret = pb->error;
+    err = ff_format_io_close(s, &pb);
+    return ret < 0 ? ret : err;
+}
+
+static int run_job(AVFormatContext *s, WriteJob *job)
+{
+    AVDictionary *options = NULL;
+    int ret = 0;
+
+    switch (job->type) {
+    case JOB_WRITE:
+        ret = write_file(s, job);
+        if (ret < 0 && ret != AVERROR_EXIT && ff_is_http_proto(job->url)) {
+            av_log(s, AV_LOG_WARNING, "upload of '%s' failed, "
+                   "will retry with a new http session.\n", job->url);
+            ret = write_file(s, job);
+        }
+        break;
+    case JOB_CLOSE:
+        ret = ff_format_io_close(s, &job->pb);
+        break;
+    case JOB_RENAME:
+        break;
+    case JOB_DELETE:
+        if (job->options) {
+            AVIOContext *pb = NULL;
+            av_dict_copy(&options, job->options, 0);
+            ret = s->io_open(s, &pb, job->url, AVIO_FLAG_WRITE, &options);
+            av_dict_free(&options);
+            if (ret >= 0)
+                ret = ff_format_io_close(s, &pb);
+        } else {
+            ret = ffurl_delete(job->url);
+            /* already gone is fine */
+            if (ret == AVERROR(ENOENT))
+                ret = 0;
+        }
+        if (ret < 0) {
+            av_log(s, AV_LOG_ERROR, "failed to delete %s: %s\n",
+                   job->url, av_err2str(ret));
+            return ret;
+        }
+        break;
+    }
+
+    if (ret < 0) {
+        av_log(s, AV_LOG_ERROR, "Failed to write '%s': %s\n",
+               job->url, av_err2str(ret));
+        return ret;
+    }
+
+    if (job->rename_to)
+        ret = ff_rename(job->url, job->rename_to, s);
+
+    return ret;
+}
+
+static void *write_queue_worker(void *arg)
+{
+    FFWriteQueue *q = arg;
+
+    ff_thread_setname("writequeue");
+
+    pthread_mutex_lock(&q->lock);
+    while (1) {
+        WriteJob *job;
+        int ret;
+
+        while (!q->head && !q->finished)
+            pthread_cond_wait(&q->cond, &q->lock);
+        if (!q->head)
+            break;
+
+        /* the job stays at the head while running, so that the tail pointer
+         * remains valid for producers */
+        job = q->head;
+        pthread_mutex_unlock(&q->lock);
+
+        ret = run_job(q->s, job);
+
+        pthread_mutex_lock(&q->lock);
+        if (ret < 0 && !q->error)
+            q->error = ret;
+        q->head = job->next;
+        if (!q->head)
+            q->tail = &q->head;
+        q->nb_jobs--;
+        q->nb_done++;
+        pthread_cond_broadcast(&q->cond);
+        free_job(job);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return NULL;
+}
+
+int ff_write_queue_alloc(FFWriteQueue **pq, AVFormatContext *s)
+{
+    FFWriteQueue *q;
+    int ret;
+
+    *pq = NULL;
+
+    q = av_mallocz(sizeof(*q));
+    if (!q)
+        return AVERROR(ENOMEM);
+    q->s    = s;
+    q->tail = &q->head;
+
+    if ((ret = pthread_mutex_init(&q->lock, NULL))) {
+        av_free(q);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&q->cond, NULL))) {
+        pthread_mutex_destroy(&q->lock);
+        av_free(q);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&q->thread, NULL, write_queue_worker, q))) {
+        pthread_cond_destroy(&q->cond);
+        pthread_mutex_destroy(&q->lock);
+        av_free(q);
+        return AVERROR(ret);
+    }
+
+    *pq = q;
+    return 0;
+}
+
+void ff_write_queue_free(FFWriteQueue **pq)
+{
+    FFWriteQueue *q = *pq;
+
+    if (!q)
+        return;
+
+    pthread_mutex_lock(&q->lock);
+    q->finished = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->thread, NULL);
+
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    av_freep(pq);
+}
+
+static int queue_job(FFWriteQueue *q, enum JobType type, const char *url,
+                     AVDictionary *options, uint8_t *data, size_t size,
+                     AVIOContext **pb, const char *rename_to)
+{
+    WriteJob *job = av_mallocz(sizeof(*job));
+
+    if (!job) {
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+    job->type = type;
+    job->data = data;
+    job->size = size;
+    job->url  = av_strdup(url);
+    if (rename_to)
+        job->rename_to = av_strdup(rename_to);
+    if (!job->url || (rename_to && !job->rename_to) ||
+        av_dict_copy(&job->options, options, 0) < 0) {
+        free_job(job);
+        return AVERROR(ENOMEM);
+    }
+    if (pb) {
+        job->pb = *pb;
+        *pb = NULL;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    while (q->nb_jobs >= MAX_PENDING_JOBS)
+        pthread_cond_wait(&q->cond, &q->lock);
+    *q->tail = job;
+    q->tail  = &job->next;
+    q->nb_jobs++;
+    q->nb_queued++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+
+    return 0;
+}
+
+int ff_write_queue_error(FFWriteQueue *q)
+{
+    int ret;
+
+    pthread_mutex_lock(&q->lock);
+    ret = q->error;
+    q->error = 0;
+    pthread_mutex_unlock(&q->lock);
+
+    return ret;
+}
+
+uint64_t ff_write_queue_queued(FFWriteQueue *q)
+{
+    uint64_t ret;
+
+    pthread_mutex_lock(&q->lock);
+    ret = q->nb_queued;
+    pthread_mutex_unlock(&q->lock);
+
+    return ret;
+}
+
+uint64_t ff_write_queue_done(FFWriteQueue *q)
+{
+    uint64_t ret;
+
+    pthread_mutex_lock(&q->lock);
+    ret = q->nb_done;
+    pthread_mutex_unlock(&q->lock);
+
+    return ret;
+}
+
+int ff_write_queue_wait(FFWriteQueue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->nb_jobs)
+        pthread_cond_wait(&q->cond, &q->lock);
+    pthread_mutex_unlock(&q->lock);
+
+    return ff_write_queue_error(q);
+}
+
+#else /* HAVE_THREADS */
+
+int ff_write_queue_alloc(FFWriteQueue **q, AVFormatContext *s)
+{
+    *q = NULL;
+    return AVERROR(ENOSYS);
+}
+
+void ff_write_queue_free(FFWriteQueue **q)
+{
+}
+
+static int queue_job(FFWriteQueue *q, enum JobType type, const char *url,
+                     AVDictionary *options, uint8_t *data, size_t size,
+                     AVIOContext **pb, const char *rename_to)
+{
+    av_free(data);
+    return AVERROR(ENOSYS);
+}
+
+int ff_write_queue_error(FFWriteQueue *q)
+{
+    return 0;
+}
+
+uint64_t ff_write_queue_queued(FFWriteQueue *q)
+{
+    return 0;
+}
+
+uint64_t ff_write_queue_done(FFWriteQueue *q)
+{
+    return 0;
+}
+
+int ff_write_queue_wait(FFWriteQueue *q)
+{
+    return 0;
+}
+
+#endif /* HAVE_THREADS */
+
+int ff_write_queue_write(FFWriteQueue *q, const char *url, AVDictionary *options,
+                         uint8_t *data, size_t size, const char *rename_to)
+{
+    return queue_job(q, JOB_WRITE, url, options, data, size, NULL, rename_to);
+}
+
+int ff_write_queue_close(FFWriteQueue *q, AVIOContext **pb, const char *url,
+                         const char *rename_to)
+{
+    return queue_job(q, JOB_CLOSE, url, NULL, NULL, 0, pb, rename_to);
+}
+
+int ff_write_queue_rename(FFWriteQueue *q, const char *url, const char *rename_to)
+{
+    return queue_job(q, JOB_RENAME, url, NULL, NULL, 0, NULL, rename_to);
+}
+
+int ff_write_queue_delete(FFWriteQueue *q, const char *url, AVDictionary *options)
+{
+    return queue_job(q, JOB_DELETE, url, options, NULL, 0, NULL, NULL);
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_WRITEQUEUE_H
+#define AVFORMAT_WRITEQUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/dict.h"
+
+#include "avformat.h"
+#include "avio.h"
+
+/**
+ * @file
+ * Output I/O of segmenting muxers, run on a background thread.
+ *
+ * A write queue owns one thread that executes the queued operations in
+ * order, opening and closing files through the io_open()/io_close2()
+ * callbacks of the muxer's AVFormatContext. A muxer typically uses one
+ * queue per variant stream, so that a slow upload of one variant does not
+ * hold up the others, while the files of each variant still complete in
+ * the order they were queued.
+ *
+ * Queueing blocks while a bounded number of operations is pending.
+ * Failures are reported by ff_write_queue_error() and ff_write_queue_wait().
+ */
+
+typedef struct FFWriteQueue FFWriteQueue;
+
+/**
+ * Allocate a write queue and start its thread.
+ *
+ * @param s the muxer context, whose io_open() and io_close2() callbacks
+ *          must be callable from another thread
+ * @return 0 on success, AVERROR(ENOSYS) if threads are not available,
+ *         another negative AVERROR code on failure
+ */
+int ff_write_queue_alloc(FFWriteQueue **q, AVFormatContext *s);
+
+/**
+ * Wait for all pending operations and free the queue.
+ */
+void ff_write_queue_free(FFWriteQueue **q);
+
+/**
+ * Queue writing data to a new file.
+ *
+ * @param url       file to open for writing
+ * @param options   options for io_open(), copied, may be NULL
+ * @param data      av_malloc()ed data, the queue takes ownership of it,
+ *                  also on failure
+ * @param rename_to if not NULL, rename url to this name once written
+ */
+int ff_write_queue_write(FFWriteQueue *q, const char *url, AVDictionary *options,
+                         uint8_t *data, size_t size, const char *rename_to);
+
+/**
+ * Queue closing an output, which the queue takes ownership of.
+ *
+ * @param url       name pb was opened with, used for logging and renaming
+ * @param rename_to if not NULL, rename url to this name once closed
+ */
+int ff_write_queue_close(FFWriteQueue *q, AVIOContext **pb, const char *url,
+                         const char *rename_to);
+
+/**
+ * Queue renaming a file.
+ */
+int ff_write_queue_rename(FFWriteQueue *q, const char *url, const char *rename_to);
+
+/**
+ * Queue deleting a file.
+ *
+ * @param options if not NULL (copied), the file is deleted by opening it for writing
+ *                with these options (e.g. an HTTP DELETE request),
+ *                otherwise with ffurl_delete()
+ */
+int ff_write_queue_delete(FFWriteQueue *q, const char *url, AVDictionary *options);
+
+/**
+ * @return the error of the first operation that failed since the last call,
+ *         or 0; does not wait
+ */
+int ff_write_queue_error(FFWriteQueue *q);
+
+/**
+ * @return the number of operations queued so far; as operations run in
+ *         order, the n-th one is done once ff_write_queue_done() returns
+ *         at least n
+ */
+uint64_t ff_write_queue_queued(FFWriteQueue *q);
+
+/**
+ * @return the number of operations that are done, successfully or not;
+ *         does not wait
+ */
+uint64_t ff_write_queue_done(FFWriteQueue *q);
+
+/**
+ * Wait until all queued operations are done.
+ *
+ * @return the same as ff_write_queue_error()
+ */
+int ff_write_queue_wait(FFWriteQueue *q);
+
+#endif /* AVFORMAT_WRITEQUEUE_H */
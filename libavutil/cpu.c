@@ -38,7 +38,7 @@
 #if HAVE_GETPROCESSAFFINITYMASK || HAVE_WINRT
 #include <windows.h>
 #endif
-#if HAVE_SYSCTL
+#if HAVE_SYSCTL || HAVE_SYSCTLBYNAME
 #if HAVE_SYS_PARAM_H
 #include <sys/param.h>
 #endif
@@ -305,6 +305,30 @@ size_t av_cpu_max_align(void)
     return 8;
 }
 
+size_t avpriv_cpu_cache_size(int level)
+{
+    long size = 0;
+#if HAVE_SYSCONF && defined(_SC_LEVEL1_DCACHE_SIZE)
+    switch (level) {
+    case 1: size = sysconf(_SC_LEVEL1_DCACHE_SIZE); break;
+    case 2: size = sysconf(_SC_LEVEL2_CACHE_SIZE);  break;
+    case 3: size = sysconf(_SC_LEVEL3_CACHE_SIZE);  break;
+    }
+#elif HAVE_SYSCTLBYNAME
+    static const char *const names[] = {
+        "hw.l1dcachesize", "hw.l2cachesize", "hw.l3cachesize",
+    };
+    int64_t val = 0;
+    size_t len = sizeof(val);
+
+    if (level >= 1 && level <= 3 &&
+        !sysctlbyname(names[level - 1], &val, &len, NULL, 0))
+        size = val;
+#endif
+
+    return size > 0 ? size : 0;
+}
+
 #if !ARCH_X86
 unsigned long ff_getauxval(unsigned long type)
 {
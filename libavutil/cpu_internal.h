@@ -63,4 +63,16 @@ size_t ff_get_cpu_max_align_loongarch(void);
 
 unsigned long ff_getauxval(unsigned long type);
 
+/**
+ * Get the size of a level of the CPU's data cache, as reported by the
+ * operating system.
+ *
+ * The returned size is that of a single cache instance, which may be shared
+ * by several cores.
+ *
+ * @param level cache level, starting at 1 for the L1 data cache
+ * @return the size of the cache in bytes, or 0 if it is unknown
+ */
+size_t avpriv_cpu_cache_size(int level);
+
 #endif /* AVUTIL_CPU_INTERNAL_H */
@@ -22,6 +22,7 @@
 #include "slicethread.h"
 #include "mem.h"
 #include "thread.h"
+#include "threadpool_internal.h"
 #include "avassert.h"
 
 #define MAX_AUTO_THREADS 16
@@ -50,6 +51,9 @@ struct AVSliceThread {
     int             finished;
     atomic_int      error;
 
+    AVThreadPool       *pool;
+    FFThreadPoolClient  client;
+
     void            *priv;
     int            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     int            (*main_func)(void *priv);
@@ -84,6 +88,30 @@ static int run_jobs(AVSliceThread *ctx)
     return current_job == nb_jobs + nb_active_threads - 1;
 }
 
+/*
+ * Pool threads may take their ticket late or not at all, so jobs are
+ * handed out strictly in order instead of reserving one per thread.
+ */
+static void run_jobs_pool(void *opaque, int threadnr)
+{
+    AVSliceThread *ctx = opaque;
+    unsigned nb_jobs   = ctx->nb_jobs;
+    unsigned jobnr;
+
+    while ((jobnr = atomic_fetch_add_explicit(&ctx->current_job, 1, memory_order_acq_rel)) < nb_jobs) {
+        int ret = atomic_load_explicit(&ctx->error, memory_order_relaxed);
+        if (ret)
+            continue;
+        ret = ctx->worker_func(ctx->priv, jobnr, threadnr, nb_jobs, ctx->nb_active_threads);
+        if (ret) {
+            int prev = 0;
+            atomic_compare_exchange_strong_explicit(&ctx->error, &prev, ret,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed);
+        }
+    }
+}
+
 static void *attribute_align_arg thread_worker(void *v)
 {
     WorkerContext *w = v;
@@ -203,6 +231,64 @@ int avpriv_slicethread_create2(AVSliceThread **pctx, void *priv,
     return nb_threads;
 }
 
+av_cold
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool, void *priv,
+                                   int (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   int (*main_func)(void *priv),
+                                   int nb_threads)
+{
+    AVSliceThread *ctx;
+
+    av_assert0(nb_threads >= 0);
+    if (!nb_threads)
+        nb_threads = av_thread_pool_get_nb_threads(pool) + 1;
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx)
+        return AVERROR(ENOMEM);
+
+    ctx->pool           = ff_thread_pool_ref(pool);
+    ctx->client.opaque  = ctx;
+    ctx->client.run     = run_jobs_pool;
+    ctx->priv           = priv;
+    ctx->worker_func    = worker_func;
+    ctx->main_func      = main_func;
+    ctx->nb_threads     = nb_threads;
+
+    atomic_init(&ctx->first_job, 0);
+    atomic_init(&ctx->current_job, 0);
+    atomic_init(&ctx->error, 0);
+
+    return nb_threads;
+}
+
+static int execute_pool(AVSliceThread *ctx, int execute_main)
+{
+    int ret = 0;
+
+    atomic_store_explicit(&ctx->current_job, 0, memory_order_relaxed);
+
+    if (ctx->main_func && execute_main) {
+        int threadnr;
+
+        ff_thread_pool_submit(ctx->pool, &ctx->client, ctx->nb_active_threads, 0);
+        ret = ctx->main_func(ctx->priv);
+        threadnr = ff_thread_pool_take(ctx->pool, &ctx->client);
+        if (threadnr >= 0)
+            run_jobs_pool(ctx, threadnr);
+    } else {
+        ff_thread_pool_submit(ctx->pool, &ctx->client, ctx->nb_active_threads - 1, 1);
+        run_jobs_pool(ctx, 0);
+    }
+
+    ff_thread_pool_wait(ctx->pool, &ctx->client);
+
+    if (!ret)
+        ret = atomic_load_explicit(&ctx->error, memory_order_relaxed);
+
+    return ret;
+}
+
 int avpriv_slicethread_execute2(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     int nb_workers, i, is_last = 0, ret = 0;
@@ -211,6 +297,8 @@ int avpriv_slicethread_execute2(AVSliceThread *ctx, int nb_jobs, int execute_mai
     ctx->nb_jobs           = nb_jobs;
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
     atomic_store_explicit(&ctx->error, 0, memory_order_relaxed);
+    if (ctx->pool)
+        return execute_pool(ctx, execute_main);
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
     atomic_store_explicit(&ctx->current_job, ctx->nb_active_threads, memory_order_relaxed);
     nb_workers             = ctx->nb_active_threads;
@@ -252,6 +340,12 @@ av_cold void avpriv_slicethread_free(AVSliceThread **pctx)
     if (!ctx)
         return;
 
+    if (ctx->pool) {
+        av_thread_pool_free(&ctx->pool);
+        av_freep(pctx);
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
@@ -289,6 +383,15 @@ int avpriv_slicethread_create2(AVSliceThread **pctx, void *priv,
     return AVERROR(ENOSYS);
 }
 
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool, void *priv,
+                                   int (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   int (*main_func)(void *priv),
+                                   int nb_threads)
+{
+    *pctx = NULL;
+    return AVERROR(ENOSYS);
+}
+
 int avpriv_slicethread_execute2(AVSliceThread *ctx, int nb_jobs, int execute_main)
 {
     av_assert0(0);
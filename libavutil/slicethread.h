@@ -23,6 +23,7 @@
 #include "version.h"
 
 typedef struct AVSliceThread AVSliceThread;
+typedef struct AVThreadPool AVThreadPool;
 
 /**
  * Create slice threading context.
@@ -38,6 +39,28 @@ int avpriv_slicethread_create2(AVSliceThread **pctx, void *priv,
                                int (*main_func)(void *priv),
                                int nb_threads);
 
+/**
+ * Create slice threading context running its jobs on the threads of a
+ * shared pool instead of dedicated threads. The calling thread of
+ * avpriv_slicethread_execute2() always takes part in running the jobs.
+ * Jobs are started in order, but are not bound to a particular threadnr.
+ *
+ * Pool threads may all be busy with other contexts, so nothing but the
+ * calling thread is guaranteed to run. A job may wait on jobs with a lower
+ * jobnr, but neither on later jobs nor on main_func, and main_func must not
+ * wait on jobs; callers that need this must use avpriv_slicethread_create2().
+ *
+ * @param pool thread pool, a reference to it is held by the context
+ * @param nb_threads maximum number of threads running the jobs of one
+ *                   execution (including the calling thread),
+ *                   0 for the pool size + 1, must be >= 0
+ * @see avpriv_slicethread_create2() for the other parameters
+ */
+int avpriv_slicethread_create_pool(AVSliceThread **pctx, AVThreadPool *pool, void *priv,
+                                   int (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                                   int (*main_func)(void *priv),
+                                   int nb_threads);
+
 /**
  * Execute slice threading. If any job returns a nonzero value,
  * all remaining jobs will be aborted and that value returned.
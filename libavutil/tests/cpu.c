@@ -21,6 +21,7 @@
 #include "config.h"
 
 #include "libavutil/cpu.h"
+#include "libavutil/cpu_internal.h"
 #include "libavutil/avstring.h"
 
 #if ARCH_AARCH64
@@ -178,6 +179,8 @@ int main(int argc, char **argv)
     print_cpu_flags(cpu_flags_raw, "raw");
     print_cpu_flags(cpu_flags_eff, "effective");
     printf("threads = %s (cpu_count = %d)\n", threads, cpu_count);
+    for (int level = 1; level <= 3; level++)
+        printf("L%d cache size = %zu\n", level, avpriv_cpu_cache_size(level));
 #if ARCH_AARCH64 && HAVE_SVE
     if (cpu_flags_raw & AV_CPU_FLAG_SVE)
         printf("sve_vector_length = %d\n", 8 * ff_aarch64_sve_length());
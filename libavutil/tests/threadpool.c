@@ -0,0 +1,155 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program runs several slice threading contexts sharing one
+ * thread pool concurrently, and checks that every job of every execution
+ * is run exactly once, with a valid thread number.
+ *
+ * The jobs of some contexts wait for the previous job to finish, like rows
+ * of a wavefront decoder, with more jobs than pool threads and the pool
+ * busy with the other contexts; this must not deadlock.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "libavutil/slicethread.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadpool.h"
+
+#define NB_USERS      6
+#define NB_EXECUTIONS 200
+#define MAX_JOBS      37
+
+typedef struct User {
+    pthread_t      thread;
+    AVThreadPool  *pool;
+    AVSliceThread *slicethread;
+    int            nb_threads;
+    int            use_main;
+    int            dependent;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    atomic_int     runs[MAX_JOBS];
+    atomic_int     main_runs;
+    int            errors;
+} User;
+
+static int worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    User *u = priv;
+
+    if (threadnr < 0 || threadnr >= nb_threads || nb_threads > u->nb_threads)
+        return -1;
+    if (!u->dependent) {
+        atomic_fetch_add(&u->runs[jobnr], 1);
+        return 0;
+    }
+
+    pthread_mutex_lock(&u->lock);
+    while (jobnr && !atomic_load(&u->runs[jobnr - 1]))
+        pthread_cond_wait(&u->cond, &u->lock);
+    atomic_fetch_add(&u->runs[jobnr], 1);
+    pthread_cond_broadcast(&u->cond);
+    pthread_mutex_unlock(&u->lock);
+    return 0;
+}
+
+static int main_func(void *priv)
+{
+    User *u = priv;
+    atomic_fetch_add(&u->main_runs, 1);
+    return 0;
+}
+
+static void *user_thread(void *arg)
+{
+    User *u = arg;
+
+    for (int i = 0; i < NB_EXECUTIONS; i++) {
+        int nb_jobs = 1 + i % MAX_JOBS;
+
+        for (int j = 0; j < MAX_JOBS; j++)
+            atomic_store(&u->runs[j], 0);
+        atomic_store(&u->main_runs, 0);
+
+        if (avpriv_slicethread_execute2(u->slicethread, nb_jobs, u->use_main)) {
+            u->errors++;
+            continue;
+        }
+
+        for (int j = 0; j < MAX_JOBS; j++)
+            if (atomic_load(&u->runs[j]) != (j < nb_jobs))
+                u->errors++;
+        if (atomic_load(&u->main_runs) != u->use_main)
+            u->errors++;
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    static User users[NB_USERS];
+    AVThreadPool *pool;
+    int ret = 0;
+
+    if (av_thread_pool_alloc(&pool, 2) < 0) {
+        fprintf(stderr, "Failed to allocate thread pool\n");
+        return 1;
+    }
+
+    for (int i = 0; i < NB_USERS; i++) {
+        User *u = &users[i];
+
+        u->use_main   = i & 1;
+        u->dependent  = i >= 4;
+        pthread_mutex_init(&u->lock, NULL);
+        pthread_cond_init(&u->cond, NULL);
+        u->nb_threads = avpriv_slicethread_create_pool(&u->slicethread, pool, u, worker,
+                                                       u->use_main ? main_func : NULL,
+                                                       i ? i + 1 : 0);
+        if (u->nb_threads < 0) {
+            fprintf(stderr, "Failed to create slice threading context\n");
+            return 1;
+        }
+    }
+
+    /* the slice threading contexts keep the pool alive */
+    av_thread_pool_free(&pool);
+
+    for (int i = 0; i < NB_USERS; i++)
+        if (pthread_create(&users[i].thread, NULL, user_thread, &users[i])) {
+            fprintf(stderr, "Failed to create thread\n");
+            return 1;
+        }
+
+    for (int i = 0; i < NB_USERS; i++) {
+        pthread_join(users[i].thread, NULL);
+        if (users[i].errors) {
+            fprintf(stderr, "User %d: %d errors\n", i, users[i].errors);
+            ret = 1;
+        }
+        avpriv_slicethread_free(&users[i].slicethread);
+        pthread_cond_destroy(&users[i].cond);
+        pthread_mutex_destroy(&users[i].lock);
+    }
+
+    return ret;
+}
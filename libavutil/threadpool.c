@@ -0,0 +1,266 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdatomic.h>
+
+#include "avassert.h"
+#include "cpu.h"
+#include "error.h"
+#include "internal.h"
+#include "mem.h"
+#include "thread.h"
+#include "threadpool.h"
+#include "threadpool_internal.h"
+
+#if HAVE_THREADS
+
+struct AVThreadPool {
+    pthread_t          *threads;
+    int                 nb_threads;
+
+    pthread_mutex_t     lock;
+    pthread_cond_t      cond;
+    pthread_cond_t      done_cond;
+
+    /* clients with outstanding tickets, served round-robin */
+    FFThreadPoolClient *head;
+    FFThreadPoolClient *tail;
+    int                 finished;
+
+    atomic_int          refcount;
+};
+
+static void queue_append(AVThreadPool *pool, FFThreadPoolClient *c)
+{
+    c->next   = NULL;
+    c->queued = 1;
+    if (pool->tail)
+        pool->tail->next = c;
+    else
+        pool->head = c;
+    pool->tail = c;
+}
+
+static void queue_remove(AVThreadPool *pool, FFThreadPoolClient *c)
+{
+    FFThreadPoolClient **p = &pool->head, *prev = NULL;
+
+    while (*p != c) {
+        prev = *p;
+        p    = &(*p)->next;
+    }
+    *p = c->next;
+    if (pool->tail == c)
+        pool->tail = prev;
+    c->next   = NULL;
+    c->queued = 0;
+}
+
+/* must be called with the lock held and c->nb_tickets > 0 */
+static int take_ticket(AVThreadPool *pool, FFThreadPoolClient *c)
+{
+    queue_remove(pool, c);
+    if (--c->nb_tickets)
+        queue_append(pool, c);
+    return c->next_threadnr++;
+}
+
+static void *attribute_align_arg pool_worker(void *arg)
+{
+    AVThreadPool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        FFThreadPoolClient *c;
+        int threadnr;
+
+        while (!pool->head && !pool->finished)
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        if (!pool->head)
+            break;
+
+        c = pool->head;
+        threadnr = take_ticket(pool, c);
+        c->nb_running++;
+        pthread_mutex_unlock(&pool->lock);
+
+        c->run(c->opaque, threadnr);
+
+        pthread_mutex_lock(&pool->lock);
+        if (!--c->nb_running && !c->nb_tickets)
+            pthread_cond_broadcast(&pool->done_cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static void pool_destroy(AVThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->finished = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->nb_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    av_freep(&pool->threads);
+    av_free(pool);
+}
+
+int av_thread_pool_alloc(AVThreadPool **ppool, int nb_threads)
+{
+    AVThreadPool *pool;
+    int ret;
+
+    *ppool = NULL;
+
+    if (nb_threads < 0)
+        return AVERROR(EINVAL);
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return AVERROR(ENOMEM);
+
+    pool->threads = av_calloc(nb_threads, sizeof(*pool->threads));
+    if (!pool->threads) {
+        av_free(pool);
+        return AVERROR(ENOMEM);
+    }
+    atomic_init(&pool->refcount, 1);
+
+    if ((ret = pthread_mutex_init(&pool->lock, NULL))) {
+        av_free(pool->threads);
+        av_free(pool);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&pool->cond, NULL))) {
+        pthread_mutex_destroy(&pool->lock);
+        av_free(pool->threads);
+        av_free(pool);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&pool->done_cond, NULL))) {
+        pthread_cond_destroy(&pool->cond);
+        pthread_mutex_destroy(&pool->lock);
+        av_free(pool->threads);
+        av_free(pool);
+        return AVERROR(ret);
+    }
+
+    for (; pool->nb_threads < nb_threads; pool->nb_threads++) {
+        ret = pthread_create(&pool->threads[pool->nb_threads], NULL,
+                             pool_worker, pool);
+        if (ret) {
+            pool_destroy(pool);
+            return AVERROR(ret);
+        }
+    }
+
+    *ppool = pool;
+    return 0;
+}
+
+int av_thread_pool_get_nb_threads(const AVThreadPool *pool)
+{
+    return pool->nb_threads;
+}
+
+AVThreadPool *ff_thread_pool_ref(AVThreadPool *pool)
+{
+    atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
+    return pool;
+}
+
+void av_thread_pool_free(AVThreadPool **ppool)
+{
+    AVThreadPool *pool = *ppool;
+
+    if (!pool)
+        return;
+    *ppool = NULL;
+
+    if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
+        pool_destroy(pool);
+}
+
+void ff_thread_pool_submit(AVThreadPool *pool, FFThreadPoolClient *c,
+                           int nb_tickets, int first_threadnr)
+{
+    pthread_mutex_lock(&pool->lock);
+    av_assert1(!c->queued && !c->nb_running);
+    c->nb_tickets    = nb_tickets;
+    c->next_threadnr = first_threadnr;
+    if (nb_tickets > 0) {
+        queue_append(pool, c);
+        if (nb_tickets == 1)
+            pthread_cond_signal(&pool->cond);
+        else
+            pthread_cond_broadcast(&pool->cond);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int ff_thread_pool_take(AVThreadPool *pool, FFThreadPoolClient *c)
+{
+    int threadnr = -1;
+
+    pthread_mutex_lock(&pool->lock);
+    if (c->nb_tickets > 0)
+        threadnr = take_ticket(pool, c);
+    pthread_mutex_unlock(&pool->lock);
+
+    return threadnr;
+}
+
+void ff_thread_pool_wait(AVThreadPool *pool, FFThreadPoolClient *c)
+{
+    pthread_mutex_lock(&pool->lock);
+    if (c->queued)
+        queue_remove(pool, c);
+    c->nb_tickets = 0;
+    while (c->nb_running)
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#else /* HAVE_THREADS */
+
+int av_thread_pool_alloc(AVThreadPool **pool, int nb_threads)
+{
+    *pool = NULL;
+    return AVERROR(ENOSYS);
+}
+
+int av_thread_pool_get_nb_threads(const AVThreadPool *pool)
+{
+    return 0;
+}
+
+void av_thread_pool_free(AVThreadPool **pool)
+{
+    av_assert0(!*pool);
+}
+
+#endif /* HAVE_THREADS */
@@ -0,0 +1,76 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_THREADPOOL_H
+#define AVUTIL_THREADPOOL_H
+
+/**
+ * @file
+ * @ingroup lavu_threadpool
+ * Shareable pool of worker threads.
+ */
+
+/**
+ * @defgroup lavu_threadpool Thread pool
+ * @ingroup lavu_data
+ *
+ * A set of worker threads which can be shared by several codec contexts
+ * and filtergraphs, instead of each of them creating its own threads.
+ *
+ * The threads are created once in av_thread_pool_alloc() and stay alive
+ * until the pool is freed and no user references it anymore. Work submitted
+ * by different users is served in a round-robin fashion, one job batch
+ * participant at a time, so that a single busy user cannot starve the others.
+ *
+ * The thread which submits work always takes part in running it, so work
+ * makes progress even if all threads of the pool are busy.
+ *
+ * @{
+ */
+
+typedef struct AVThreadPool AVThreadPool;
+
+/**
+ * Allocate a thread pool and start its threads.
+ *
+ * @param pool       pointer to the allocated pool
+ * @param nb_threads number of worker threads, 0 for one thread per CPU
+ * @return  >=0 for success; <0 for error, in particular AVERROR(ENOSYS) if
+ *          lavu was built without thread support
+ */
+int av_thread_pool_alloc(AVThreadPool **pool, int nb_threads);
+
+/**
+ * Get the number of worker threads of a pool.
+ */
+int av_thread_pool_get_nb_threads(const AVThreadPool *pool);
+
+/**
+ * Release the caller's reference to a thread pool and set *pool to NULL.
+ *
+ * Codec contexts and filtergraphs the pool is attached to hold their own
+ * references, so this may be called while they are still in use; the threads
+ * are stopped once the last of them is freed.
+ */
+void av_thread_pool_free(AVThreadPool **pool);
+
+/**
+ * @}
+ */
+
+#endif /* AVUTIL_THREADPOOL_H */
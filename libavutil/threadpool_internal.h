@@ -0,0 +1,65 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_THREADPOOL_INTERNAL_H
+#define AVUTIL_THREADPOOL_INTERNAL_H
+
+#include "threadpool.h"
+
+/**
+ * A user of a thread pool, e.g. a slice threading context.
+ *
+ * Work is submitted as a number of tickets; every ticket is taken by one
+ * pool thread, which calls run() with a distinct thread number.
+ * All fields are owned by the pool while tickets are outstanding.
+ */
+typedef struct FFThreadPoolClient {
+    void  *opaque;
+    void (*run)(void *opaque, int threadnr);
+
+    struct FFThreadPoolClient *next;
+    int queued;
+    int nb_tickets;
+    int nb_running;
+    int next_threadnr;
+} FFThreadPoolClient;
+
+AVThreadPool *ff_thread_pool_ref(AVThreadPool *pool);
+
+/**
+ * Queue nb_tickets tickets of client, with thread numbers starting at
+ * first_threadnr. The client must not have tickets outstanding.
+ */
+void ff_thread_pool_submit(AVThreadPool *pool, FFThreadPoolClient *client,
+                           int nb_tickets, int first_threadnr);
+
+/**
+ * Take one of the client's outstanding tickets for the calling thread.
+ *
+ * @return the ticket's thread number, or a negative value if all tickets
+ *         have already been taken
+ */
+int ff_thread_pool_take(AVThreadPool *pool, FFThreadPoolClient *client);
+
+/**
+ * Withdraw the client's outstanding tickets and wait until all pool threads
+ * that took one have returned from run().
+ */
+void ff_thread_pool_wait(AVThreadPool *pool, FFThreadPoolClient *client);
+
+#endif /* AVUTIL_THREADPOOL_INTERNAL_H */
@@ -20,10 +20,12 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/cpu.h"
+#include "libavutil/cpu_internal.h"
 #include "libavutil/error.h"
 #include "libavutil/hwcontext.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/macros.h"
+#include "libavutil/mathematics.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
@@ -214,6 +216,7 @@ int ff_sws_graph_add_pass(SwsGraph *graph, enum AVPixelFormat fmt,
     pass->format = fmt;
     pass->lines  = lines;
     pass->input  = input;
+    pass->slice_align = align;
     pass->output = av_refstruct_alloc_ext(sizeof(*pass->output), 0, NULL, free_buffer);
     if (!pass->output) {
         ret = AVERROR(ENOMEM);
@@ -482,6 +485,7 @@ static int init_legacy_subpass(SwsGraph *graph, SwsContext *sws,
             sws_free_context(&sws);
             return ret;
         }
+        input->tileable = input->row_local = true;
     }
 
     if (c->srcXYZ && !(c->dstXYZ && unscaled)) {
@@ -491,6 +495,7 @@ static int init_legacy_subpass(SwsGraph *graph, SwsContext *sws,
             sws_free_context(&sws);
             return ret;
         }
+        input->tileable = input->row_local = true;
     }
 
     ret = ff_sws_graph_add_pass(graph, sws->dst_format, dst_w, dst_h, input, 0, align,
@@ -548,6 +553,7 @@ static int init_legacy_subpass(SwsGraph *graph, SwsContext *sws,
                                     0, 1, run_rgb2xyz, NULL, c, NULL, &pass);
         if (ret < 0)
             return ret;
+        pass->tileable = pass->row_local = true;
     }
 
     *output = pass;
@@ -683,6 +689,7 @@ static int add_legacy_3dlut_pass(SwsGraph *graph, const SwsFormat *src,
                                 output);
     if (ret < 0)
         return ret;
+    (*output)->tileable = (*output)->row_local = true;
 
     return 0;
 }
@@ -786,6 +793,9 @@ static int generate_3dlut(SwsGraph *graph, SwsFormat *src, SwsFormat *dst)
     if (src->hw_format != AV_PIX_FMT_NONE || dst->hw_format != AV_PIX_FMT_NONE)
         return AVERROR(ENOTSUP);
 
+    if (graph->lut3d)
+        return 0; /* shared with another graph */
+
     graph->lut3d = ff_sws_lut3d_alloc();
     if (!graph->lut3d)
         return AVERROR(ENOMEM);
@@ -823,8 +833,12 @@ static int init_passes(SwsGraph *graph)
             graph->plane_copy[i] = i;
 
         /* Add threaded memcpy pass */
-        return ff_sws_graph_add_pass(graph, dst.format, dst.width, dst.height,
+        ret = ff_sws_graph_add_pass(graph, dst.format, dst.width, dst.height,
                                     pass, 0, 1, run_copy, NULL, NULL, NULL, &pass);
+        if (ret < 0)
+            return ret;
+        pass->tileable = pass->row_local = true;
+        return 0;
     }
 
     /* Compute end-to-end plane copy map */
@@ -851,10 +865,139 @@ static int init_passes(SwsGraph *graph)
     return 0;
 }
 
+/*************************************
+ * Tiled execution of pass sequences *
+ *************************************/
+
+/* Default cache budget if the cache size of the CPU is unknown */
+#define TILE_CACHE_SIZE_DEFAULT (256 << 10)
+
+static size_t tile_cache_size(void)
+{
+    size_t size = avpriv_cpu_cache_size(2);
+    if (!size)
+        size = avpriv_cpu_cache_size(1);
+    if (!size)
+        size = TILE_CACHE_SIZE_DEFAULT;
+
+    /* Leave room for filter coefficients, LUTs and other data */
+    return size / 2;
+}
+
+/* Bytes of image data per line, summed over all planes */
+static size_t line_bytes(enum AVPixelFormat fmt, int width)
+{
+    int linesize[4];
+    size_t bytes = 0;
+
+    if (av_image_fill_linesizes(linesize, fmt, width) < 0)
+        return 0;
+    for (int i = 0; i < 4; i++)
+        bytes += linesize[i] >> ff_fmt_vshift(fmt, i);
+    return bytes;
+}
+
+static int tile_align(const SwsGraph *graph, const SwsPass *pass)
+{
+    const enum AVPixelFormat in_fmt = pass->input ? pass->input->format
+                                                  : graph->src.format;
+    const int sub_y = FFMAX(ff_fmt_vshift(pass->format, 1),
+                            ff_fmt_vshift(in_fmt, 1));
+    const int align = pass->slice_align;
+    return align / av_gcd(align, 1 << sub_y) << sub_y;
+}
+
+/**
+ * Partition the passes into groups. A tileable pass starts a group, which
+ * is extended by all directly following row-local passes of the same size.
+ * The tile size is chosen such that the lines of all buffers touched by one
+ * tile fit into the cache.
+ */
+static int init_groups(SwsGraph *graph)
+{
+    const size_t cache_size = tile_cache_size();
+
+    graph->groups = av_calloc(graph->num_passes, sizeof(*graph->groups));
+    if (!graph->groups)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < graph->num_passes;) {
+        SwsPassGroup *group = &graph->groups[graph->num_groups++];
+        const SwsPass *head = graph->passes[i++];
+        group->first      = i - 1;
+        group->num_passes = 1;
+        group->tile_h     = head->slice_h;
+        group->num_tiles  = head->num_slices;
+        if (!head->tileable || !head->slice_align)
+            continue;
+
+        int align = tile_align(graph, head);
+        size_t bytes = line_bytes(head->format, head->output->width);
+        if (head->input)
+            bytes += line_bytes(head->input->format, head->input->output->width);
+        else
+            bytes += line_bytes(graph->src.format, graph->src.width);
+
+        for (; i < graph->num_passes; i++) {
+            const SwsPass *pass = graph->passes[i];
+            if (!pass->tileable || !pass->row_local || !pass->slice_align ||
+                pass->lines != head->lines)
+                break;
+            const int pass_align = tile_align(graph, pass);
+            align = align / av_gcd(align, pass_align) * pass_align;
+            bytes += line_bytes(pass->format, pass->output->width);
+            group->num_passes++;
+        }
+
+        if (group->num_passes == 1)
+            continue;
+
+        /* Make sure that every thread gets at least one tile */
+        const int max_h = (head->lines + graph->num_threads - 1) / graph->num_threads;
+        int tile_h = bytes ? FFMIN(cache_size / bytes, max_h) : max_h;
+        tile_h = FFMAX(tile_h / align, 1) * align;
+
+        group->tile_h    = tile_h;
+        group->num_tiles = (head->lines + tile_h - 1) / tile_h;
+        av_log(graph->ctx, AV_LOG_DEBUG, "Running passes %d-%d in %d tiles "
+               "of %d lines\n", group->first, i - 1, group->num_tiles, tile_h);
+    }
+
+    return 0;
+}
+
+static inline const SwsFrame *pass_input(const SwsGraph *graph,
+                                         const SwsPass *pass)
+{
+    return pass->input ? &pass->input->output->frame : &graph->exec.src;
+}
+
+static inline const SwsFrame *pass_output(const SwsGraph *graph,
+                                          const SwsPass *pass)
+{
+    return pass->output->avframe ? &pass->output->frame : &graph->exec.dst;
+}
+
+static void run_tile(const SwsGraph *graph, const SwsPassGroup *group, int tile)
+{
+    const int y = tile * group->tile_h;
+
+    for (int i = 0; i < group->num_passes; i++) {
+        const SwsPass *pass = graph->passes[group->first + i];
+        const int h = FFMIN(group->tile_h, pass->lines - y);
+        pass->run(pass_output(graph, pass), pass_input(graph, pass), y, h, pass);
+    }
+}
+
 static int sws_graph_worker(void *priv, int jobnr, int threadnr, int nb_jobs,
                             int nb_threads)
 {
     SwsGraph *graph = priv;
+    if (graph->exec.group) {
+        run_tile(graph, graph->exec.group, jobnr);
+        return 0;
+    }
+
     const SwsPass *pass = graph->exec.pass;
     const int slice_y = jobnr * pass->slice_h;
     const int slice_h = FFMIN(pass->slice_h, pass->lines - slice_y);
@@ -875,6 +1018,7 @@ static void graph_uninit(SwsGraph *graph)
     for (int i = 0; i < graph->num_passes; i++)
         pass_free(graph->passes[i]);
     av_free(graph->passes);
+    av_free(graph->groups);
 
     av_refstruct_unref(&graph->lut3d);
 
@@ -925,6 +1069,10 @@ int ff_sws_graph_init(SwsGraph *graph, SwsContext *ctx, const SwsFormat *dst,
             goto error;
     }
 
+    ret = init_groups(graph);
+    if (ret < 0)
+        goto error;
+
     return 0;
 
 error:
@@ -984,6 +1132,21 @@ int ff_sws_graph_reinit(SwsGraph *graph, SwsContext *ctx, const SwsFormat *dst,
     return ff_sws_graph_init(graph, ctx, dst, src);
 }
 
+int ff_sws_graph_reinit_shared(SwsGraph *graph, SwsContext *ctx,
+                               const SwsGraph *ref)
+{
+    if (graph->ctx && graph->lut3d == ref->lut3d &&
+        ff_fmt_equal(&graph->src, &ref->src) &&
+        ff_fmt_equal(&graph->dst, &ref->dst) &&
+        opts_equal(ctx, &graph->opts_copy))
+        return 0;
+
+    graph_uninit(graph);
+    if (ref->lut3d)
+        graph->lut3d = av_refstruct_ref(ref->lut3d);
+    return ff_sws_graph_init(graph, ctx, &ref->dst, &ref->src);
+}
+
 void ff_sws_graph_update_metadata(SwsGraph *graph, const SwsColor *color)
 {
     if (!color)
@@ -1028,20 +1191,37 @@ int ff_sws_graph_run(SwsGraph *graph, const AVFrame *dst, const AVFrame *src)
     av_assert0(dst->format == graph->dst.hw_format || dst->format == graph->dst.format);
     av_assert0(src->format == graph->src.hw_format || src->format == graph->src.format);
 
-    SwsFrame src_field, dst_field;
-    get_field(graph, &graph->dst, dst, &dst_field);
-    get_field(graph, &graph->src, src, &src_field);
+    get_field(graph, &graph->dst, dst, &graph->exec.dst);
+    get_field(graph, &graph->src, src, &graph->exec.src);
+
+    for (int g = 0; g < graph->num_groups; g++) {
+        const SwsPassGroup *group = &graph->groups[g];
+        for (int i = 0; i < group->num_passes; i++) {
+            const SwsPass *pass = graph->passes[group->first + i];
+            if (pass->setup) {
+                int ret = pass->setup(pass_output(graph, pass),
+                                      pass_input(graph, pass), pass);
+                if (ret < 0)
+                    return ret;
+            }
+        }
+
+        if (group->num_passes > 1) {
+            graph->exec.group = group;
+            if (!graph->slicethread) {
+                for (int tile = 0; tile < group->num_tiles; tile++)
+                    run_tile(graph, group, tile);
+            } else {
+                avpriv_slicethread_execute2(graph->slicethread, group->num_tiles, 0);
+            }
+            graph->exec.group = NULL;
+            continue;
+        }
 
-    for (int i = 0; i < graph->num_passes; i++) {
-        const SwsPass *pass = graph->passes[i];
+        const SwsPass *pass = graph->passes[group->first];
         graph->exec.pass   = pass;
-        graph->exec.input  = pass->input ? &pass->input->output->frame : &src_field;
-        graph->exec.output = pass->output->avframe ? &pass->output->frame : &dst_field;
-        if (pass->setup) {
-            int ret = pass->setup(graph->exec.output, graph->exec.input, pass);
-            if (ret < 0)
-                return ret;
-        }
+        graph->exec.input  = pass_input(graph, pass);
+        graph->exec.output = pass_output(graph, pass);
 
         if (pass->num_slices == 1) {
             pass->run(graph->exec.output, graph->exec.input, 0, pass->lines, pass);
@@ -95,8 +95,23 @@ struct SwsPass {
     enum AVPixelFormat format; /* new pixel format */
     int lines;         /* pass dispatch size */
     int slice_h;       /* filter granularity */
+    int slice_align;   /* alignment of `slice_h`, or 0 if not threaded */
     int num_slices;
 
+    /**
+     * Set by the creator of the pass if `run` may be called on any range of
+     * lines aligned to `slice_align`, rather than only on the slices derived
+     * from `slice_h`.
+     */
+    bool tileable;
+
+    /**
+     * Set by the creator of the pass if every output line only depends on the
+     * input line at the same position, i.e. there is no vertical filtering.
+     * Only meaningful for tileable passes.
+     */
+    bool row_local;
+
     /**
      * Filter input. This pass's output will be resolved to form this pass's.
      * input. If NULL, the original input image is used.
@@ -126,6 +141,19 @@ struct SwsPass {
  */
 int ff_sws_pass_aligned_width(const SwsPass *pass, int width);
 
+/**
+ * A run of consecutive filter passes which are executed tile by tile: every
+ * pass of the group processes one tile of lines before the next tile is
+ * started, so the lines written by one pass are still in cache when the next
+ * pass reads them back. A group of a single pass is run slice by slice.
+ */
+typedef struct SwsPassGroup {
+    int first;       /* index of the first pass in SwsGraph.passes */
+    int num_passes;
+    int tile_h;      /* lines per tile, aligned to all passes of the group */
+    int num_tiles;
+} SwsPassGroup;
+
 /**
  * Filter graph, which represents a 'baked' pixel format conversion.
  */
@@ -153,6 +181,10 @@ typedef struct SwsGraph {
     SwsPass **passes;
     int num_passes;
 
+    /** Partition of `passes` into groups, set at the end of init() */
+    SwsPassGroup *groups;
+    int num_groups;
+
     /**
      * Cached copy of the public options that were used to construct this
      * SwsGraph. Used only to detect when the graph needs to be reinitialized.
@@ -174,9 +206,11 @@ typedef struct SwsGraph {
      * data to worker threads.
      */
     struct {
+        const SwsPassGroup *group; /* current group, if run tile by tile */
         const SwsPass *pass; /* current filter pass */
         const SwsFrame *input; /* current filter pass input/output */
         const SwsFrame *output;
+        SwsFrame src, dst; /* graph input/output, for the current field */
     } exec;
 } SwsGraph;
 
@@ -253,6 +287,15 @@ void ff_sws_graph_update_metadata(SwsGraph *graph, const SwsColor *color);
 int ff_sws_graph_reinit(SwsGraph *graph, SwsContext *ctx, const SwsFormat *dst,
                         const SwsFormat *src);
 
+/**
+ * Like ff_sws_graph_reinit(), but for the same conversion as `ref`, which
+ * must be initialized. Precomputed state which does not depend on `ctx`
+ * (currently the 3DLUT) is shared with `ref` instead of being generated
+ * again, so any metadata updates on `ref` also apply to `graph`.
+ */
+int ff_sws_graph_reinit_shared(SwsGraph *graph, SwsContext *ctx,
+                               const SwsGraph *ref);
+
 /**
  * Dispatch the filter graph on a single field of the given frames. Internally
  * threaded.
@@ -21,14 +21,18 @@
 
 #include "config.h"
 
+/* Must be defined before any system header is included */
+#if HAVE_MMAP && HAVE_MPROTECT
+#   define _DEFAULT_SOURCE
+#   define _SVID_SOURCE // needed for MAP_ANONYMOUS
+#   define _DARWIN_C_SOURCE // needed for MAP_ANON
+#endif
+
 #include "libavutil/error.h"
 
 #include "jit.h"
 
 #if HAVE_MMAP && HAVE_MPROTECT
-#   define _DEFAULT_SOURCE
-#   define _SVID_SOURCE // needed for MAP_ANONYMOUS
-#   define _DARWIN_C_SOURCE // needed for MAP_ANON
 #   include <sys/mman.h>
 #   if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
 #       define MAP_ANONYMOUS MAP_ANON
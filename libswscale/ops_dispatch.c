@@ -690,6 +690,9 @@ static int compile_single(const CompileArgs *args, const SwsOpList *ops,
     if (ret < 0)
         return ret;
 
+    /* op_pass_run() handles arbitrary line ranges */
+    (*output)->tileable  = true;
+    (*output)->row_local = !p->offsets_y;
     (*output)->backend = comp->backend->flags;
     op_list_get_plane_copy(ops, *output);
     ff_sws_pass_link_output(*output, link);
@@ -30,6 +30,7 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
+#include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/hwcontext.h"
 #include "config.h"
@@ -1402,9 +1403,71 @@ int sws_receive_slice(SwsContext *sws, unsigned int slice_start,
                           dst, c->frame_dst->linesize, slice_start, slice_height);
 }
 
+/**
+ * Prepare `dst` for running the scaling graph on it, after sws_frame_setup().
+ * Returns 1 if the graph needs to be run, 0 if there is nothing left to do,
+ * or a negative error code. Sets `*allocated` if the buffers of `dst` were
+ * allocated here.
+ */
+static int frame_prepare(SwsContext *sws, AVFrame *dst, const AVFrame *src,
+                         int *allocated)
+{
+    SwsInternal *c = sws_internal(sws);
+    int ret;
+
+    *allocated = 0;
+    if (!src->data[0])
+        return 0;
+
+    const SwsGraph *top = c->graph[FIELD_TOP];
+    const SwsGraph *bot = c->graph[FIELD_BOTTOM];
+    if (dst->data[0]) /* user-provided buffers */
+        return 1;
+
+    /* Sanity */
+    memset(dst->buf, 0, sizeof(dst->buf));
+    memset(dst->data, 0, sizeof(dst->data));
+    memset(dst->linesize, 0, sizeof(dst->linesize));
+    dst->extended_data = dst->data;
+
+    if (src->buf[0]) {
+        /* Determine end-to-end plane copy map */
+        int plane_copy[FF_ARRAY_ELEMS(top->plane_copy)];
+        memcpy(plane_copy, top->plane_copy, sizeof(plane_copy));
+        for (int i = 0; bot && i < FF_ARRAY_ELEMS(plane_copy); i++) {
+            if (bot->plane_copy[i] != plane_copy[i])
+                plane_copy[i] = -1;
+        }
+
+        ret = frame_ref(dst, src, plane_copy);
+        if (ret < 0)
+            return ret;
+    }
+
+    /* Allocate any missing buffers not yet ref'd */
+    ret = frame_alloc_buffers(sws, dst);
+    if (ret <= 0)
+        return ret; /* error, or no buffers allocated, no-op (all ref'd) */
+
+    *allocated = 1;
+    return 1;
+}
+
+static int frame_process(SwsGraph *const graph[2], AVFrame *dst,
+                         const AVFrame *src)
+{
+    for (int field = 0; field < 2 && graph[field]; field++) {
+        int ret = ff_sws_graph_run(graph[field], dst, src);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 int sws_scale_frame(SwsContext *sws, AVFrame *dst, const AVFrame *src)
 {
-    int ret, allocated = 0;
+    int ret, allocated;
     SwsInternal *c = sws_internal(sws);
     if (!src || !dst)
         return AVERROR(EINVAL);
@@ -1429,54 +1492,197 @@ int sws_scale_frame(SwsContext *sws, AVFrame *dst, const AVFrame *src)
     if (ret < 0)
         return ret;
 
-    if (!src->data[0])
-        return 0;
+    ret = frame_prepare(sws, dst, src, &allocated);
+    if (ret <= 0)
+        return ret;
 
-    const SwsGraph *top = c->graph[FIELD_TOP];
-    const SwsGraph *bot = c->graph[FIELD_BOTTOM];
-    if (dst->data[0]) /* user-provided buffers */
-        goto process_frame;
+    ret = frame_process(c->graph, dst, src);
+    if (ret < 0 && allocated)
+        av_frame_unref(dst);
+    return ret;
+}
 
-    /* Sanity */
-    memset(dst->buf, 0, sizeof(dst->buf));
-    memset(dst->data, 0, sizeof(dst->data));
-    memset(dst->linesize, 0, sizeof(dst->linesize));
-    dst->extended_data = dst->data;
+typedef struct SwsBatchFrame {
+    AVFrame *dst;
+    const AVFrame *src;
+    int run;        /* graph needs to be run on this frame */
+    int allocated;  /* dst buffers were allocated by us */
+    int ret;
+} SwsBatchFrame;
 
-    if (src->buf[0]) {
-        /* Determine end-to-end plane copy map */
-        int plane_copy[FF_ARRAY_ELEMS(top->plane_copy)];
-        memcpy(plane_copy, top->plane_copy, sizeof(plane_copy));
-        for (int i = 0; bot && i < FF_ARRAY_ELEMS(plane_copy); i++) {
-            if (bot->plane_copy[i] != plane_copy[i])
-                plane_copy[i] = -1;
+static int batch_worker(void *priv, int jobnr, int threadnr, int nb_jobs,
+                        int nb_threads)
+{
+    SwsInternal *c = sws_internal(priv);
+    SwsBatchFrame *f = &c->batch_frames[jobnr];
+    const SwsInternal *t = sws_internal(c->batch_ctx[threadnr]);
+
+    if (f->run)
+        f->ret = frame_process(t->graph, f->dst, f->src);
+    return 0;
+}
+
+/**
+ * Set up one single-threaded context per thread, with graphs sharing the
+ * precomputed state of the main context's graphs. Returns the number of
+ * threads to use for the batch, or a negative error code.
+ */
+static int batch_init(SwsContext *sws, int nb_frames)
+{
+    SwsInternal *c = sws_internal(sws);
+    const int nb_threads = c->graph[FIELD_TOP]->num_threads;
+    int ret;
+
+    /* Splitting frames into slices is more efficient for small batches */
+    if (nb_threads <= 1 || nb_frames < nb_threads)
+        return 1;
+
+    if (c->nb_batch_ctx != nb_threads) {
+        avpriv_slicethread_free(&c->batch_thread);
+        for (int i = 0; i < c->nb_batch_ctx; i++)
+            sws_freeContext(c->batch_ctx[i]);
+        av_freep(&c->batch_ctx);
+        c->nb_batch_ctx = 0;
+
+        ret = avpriv_slicethread_create2(&c->batch_thread, (void *) sws,
+                                         batch_worker, NULL, nb_threads);
+        if (ret < 0)
+            return ret;
+
+        c->batch_ctx = av_calloc(nb_threads, sizeof(*c->batch_ctx));
+        if (!c->batch_ctx)
+            return AVERROR(ENOMEM);
+
+        for (; c->nb_batch_ctx < nb_threads; c->nb_batch_ctx++) {
+            SwsContext *t = sws_alloc_context();
+            if (!t)
+                return AVERROR(ENOMEM);
+            sws_internal(t)->parent = sws;
+            c->batch_ctx[c->nb_batch_ctx] = t;
         }
+    }
 
-        ret = frame_ref(dst, src, plane_copy);
+    for (int i = 0; i < c->nb_batch_ctx; i++) {
+        SwsContext *t = c->batch_ctx[i];
+        SwsInternal *ti = sws_internal(t);
+
+        ret = av_opt_copy(t, sws);
         if (ret < 0)
             return ret;
+        t->threads = 1;
+
+        for (int field = 0; field < FF_ARRAY_ELEMS(c->graph); field++) {
+            if (!c->graph[field]) {
+                ff_sws_graph_free(&ti->graph[field]);
+                continue;
+            }
+
+            if (!ti->graph[field]) {
+                ti->graph[field] = ff_sws_graph_alloc();
+                if (!ti->graph[field])
+                    return AVERROR(ENOMEM);
+            }
+
+            ret = ff_sws_graph_reinit_shared(ti->graph[field], t, c->graph[field]);
+            if (ret < 0) {
+                ff_sws_graph_free(&ti->graph[field]);
+                return ret;
+            }
+        }
     }
 
-    /* Allocate any missing buffers not yet ref'd */
-    ret = frame_alloc_buffers(sws, dst);
+    return nb_threads;
+}
+
+/* Tests whether two frames can be processed by the same scaling graph */
+static int frame_props_equal(const AVFrame *a, const AVFrame *b)
+{
+    const SwsFormat fmt_a = ff_fmt_from_frame(a, 0);
+    const SwsFormat fmt_b = ff_fmt_from_frame(b, 0);
+
+    return ff_fmt_equal(&fmt_a, &fmt_b) &&
+           fmt_a.hw_format == fmt_b.hw_format &&
+           ff_q_equal(fmt_a.color.frame_peak, fmt_b.color.frame_peak) &&
+           ff_q_equal(fmt_a.color.frame_avg,  fmt_b.color.frame_avg);
+}
+
+int sws_scale_frames(SwsContext *sws, AVFrame *const *dst,
+                     const AVFrame *const *src, int nb_frames)
+{
+    SwsInternal *c = sws_internal(sws);
+    int ret;
+
+    if (!dst || !src || nb_frames <= 0)
+        return AVERROR(EINVAL);
+
+    for (int i = 0; i < nb_frames; i++) {
+        if (!dst[i] || !src[i] || !src[i]->data[0])
+            return AVERROR(EINVAL);
+        if (!frame_props_equal(src[i], src[0]) ||
+            !frame_props_equal(dst[i], dst[0])) {
+            av_log(sws, AV_LOG_ERROR, "All frames of a batch must have "
+                   "identical properties.\n");
+            return AVERROR(EINVAL);
+        }
+    }
+
+    if (c->is_legacy_init || src[0]->hw_frames_ctx) {
+        /* Process the frames one by one */
+        for (int i = 0; i < nb_frames; i++) {
+            ret = sws_scale_frame(sws, dst[i], src[i]);
+            if (ret < 0)
+                return ret;
+        }
+        return 0;
+    }
+
+    ret = sws_frame_setup(sws, dst[0], src[0]);
     if (ret < 0)
         return ret;
-    else if (!ret)
-        return 0; /* no buffers allocated, no-op (all ref'd) */
-    else
-        allocated = 1;
 
-process_frame:
-    for (int field = 0; field < (bot ? 2 : 1); field++) {
-        ret = ff_sws_graph_run(c->graph[field], dst, src);
-        if (ret < 0) {
-            if (allocated)
-                av_frame_unref(dst);
-            return ret;
+    const int nb_threads = batch_init(sws, nb_frames);
+    if (nb_threads < 0)
+        return nb_threads;
+
+    av_fast_malloc(&c->batch_frames, &c->batch_frames_size,
+                   nb_frames * sizeof(*c->batch_frames));
+    if (!c->batch_frames)
+        return AVERROR(ENOMEM);
+
+    int nb_prepared;
+    for (nb_prepared = 0; nb_prepared < nb_frames; nb_prepared++) {
+        SwsBatchFrame *f = &c->batch_frames[nb_prepared];
+        *f = (SwsBatchFrame) {
+            .dst = dst[nb_prepared],
+            .src = src[nb_prepared],
+        };
+
+        ret = frame_prepare(sws, f->dst, f->src, &f->allocated);
+        if (ret < 0)
+            goto fail;
+        f->run = ret;
+    }
+
+    if (nb_threads > 1) {
+        avpriv_slicethread_execute2(c->batch_thread, nb_frames, 0);
+    } else {
+        for (int i = 0; i < nb_frames; i++) {
+            SwsBatchFrame *f = &c->batch_frames[i];
+            if (f->run)
+                f->ret = frame_process(c->graph, f->dst, f->src);
         }
     }
 
-    return 0;
+    ret = 0;
+    for (int i = 0; i < nb_frames && !ret; i++)
+        ret = c->batch_frames[i].ret;
+
+fail:
+    for (int i = 0; ret < 0 && i < nb_prepared; i++) {
+        if (c->batch_frames[i].allocated)
+            av_frame_unref(dst[i]);
+    }
+    return ret;
 }
 
 static int validate_params(SwsContext *ctx)
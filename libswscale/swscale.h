@@ -115,7 +115,7 @@ typedef enum SwsBackend {
     /* Unstable backends (auto-selected only if SWS_UNSTABLE is enabled) */
     SWS_BACKEND_C           = (1 << 1), ///< Template-based C reference implementation
     SWS_BACKEND_MEMCPY      = (1 << 2), ///< Fast path using libc memcpy() / memset()
-    SWS_BACKEND_X86         = (1 << 3), ///< Chained x86 SIMD kernels
+    SWS_BACKEND_X86         = (1 << 3), ///< x86 SIMD kernels (chained or JIT-compiled)
     SWS_BACKEND_AARCH64     = (1 << 4), ///< Chained AArch64 NEON kernels
     SWS_BACKEND_SPIRV       = (1 << 5), ///< Vulkan SPIR-V backend
     SWS_BACKEND_UNSTABLE    = SWS_BACKEND_C |
@@ -438,6 +438,35 @@ int sws_is_noop(const AVFrame *dst, const AVFrame *src);
  */
 int sws_scale_frame(SwsContext *c, AVFrame *dst, const AVFrame *src);
 
+/**
+ * Scale a batch of frames with identical properties.
+ *
+ * The result is the same as calling `sws_scale_frame()` on every pair of
+ * frames in turn, but the scaling graph is only checked and set up once for
+ * the whole batch, and the frames are distributed over the available threads
+ * as a whole rather than split into slices. Precomputed state such as filter
+ * coefficients and lookup tables is shared between the threads and preserved
+ * across calls.
+ *
+ * All source frames must have the same properties (dimensions, format,
+ * colorspace etc.), and likewise all destination frames. Contexts which were
+ * explicitly initialized, as well as hardware frames, are processed
+ * sequentially.
+ *
+ * @note Error diffusion dithering state is kept per thread, so without
+ *       `SWS_BITEXACT` the output may differ from sequential processing.
+ *
+ * @param ctx       The scaling context.
+ * @param dst       Array of `nb_frames` destination frames. See
+ *                  `sws_scale_frame()` for buffer allocation.
+ * @param src       Array of `nb_frames` source frames, all with data.
+ * @param nb_frames Number of frames in the batch.
+ * @return >= 0 on success, a negative AVERROR code on failure. On failure,
+ *         the contents of the destination frames are unspecified.
+ */
+int sws_scale_frames(SwsContext *ctx, AVFrame *const *dst,
+                     const AVFrame *const *src, int nb_frames);
+
 /**
  * Filter kernel cut-off value. Values below this (absolute) magnitude
  * are cut off from the main filter kernel. Note that the window is
@@ -703,6 +703,13 @@ struct SwsInternal {
     int is_legacy_init;
 
     FFFramePool frame_pool; /* for sws_scale_frame() data allocations */
+
+    /* Frame-parallel processing for sws_scale_frames() */
+    AVSliceThread         *batch_thread;
+    SwsContext           **batch_ctx; /* single-threaded, one per thread */
+    int                 nb_batch_ctx;
+    struct SwsBatchFrame  *batch_frames;
+    unsigned int           batch_frames_size;
 };
 //FIXME check init (where 0)
 
@@ -40,6 +40,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/macros.h"
 #include "libavutil/hwcontext.h"
+#include "libavutil/imgutils.h"
 
 #include "libswscale/swscale.h"
 #include "libswscale/format.h"
@@ -55,6 +56,7 @@ struct options {
     int dst_w;
     int dst_h;
     int threads;
+    int batch;
     int iters;
     int bench;
     int flags;
@@ -245,6 +247,94 @@ static int checked_sws_scale_frame(SwsContext *c, AVFrame *dst, const AVFrame *s
     return ret;
 }
 
+static int frames_equal(const AVFrame *a, const AVFrame *b)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->format);
+    for (int p = 0; p < 4 && a->data[p]; p++) {
+        const int linesize = av_image_get_linesize(a->format, a->width, p);
+        const int is_chroma = p == 1 || p == 2;
+        const int h = is_chroma ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h)
+                                : a->height;
+        for (int y = 0; y < h; y++) {
+            if (memcmp(a->data[p] + y * a->linesize[p],
+                       b->data[p] + y * b->linesize[p], linesize))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* Whether the conversion to `dst_fmt` carries error diffusion state over
+ * from one frame to the next, which makes the output depend on the order
+ * in which frames are converted */
+static int uses_error_diffusion(const struct mode *mode, enum AVPixelFormat dst_fmt)
+{
+    const int rgb8 = dst_fmt == AV_PIX_FMT_BGR4_BYTE || dst_fmt == AV_PIX_FMT_RGB4_BYTE ||
+                     dst_fmt == AV_PIX_FMT_BGR8      || dst_fmt == AV_PIX_FMT_RGB8;
+
+    /* the state is reset for every frame in bitexact mode */
+    if (mode->flags & SWS_BITEXACT)
+        return 0;
+    if (mode->dither == SWS_DITHER_ED)
+        return 1;
+    if (mode->dither == SWS_DITHER_AUTO && (mode->flags & SWS_ERROR_DIFFUSION))
+        return 1;
+    /* low depth RGB with full chroma interpolation falls back to it */
+    return rgb8 && (mode->flags & SWS_FULL_CHR_H_INT) &&
+           (mode->dither == SWS_DITHER_AUTO || mode->dither == SWS_DITHER_BAYER);
+}
+
+/* Converts several copies of `src` at once and checks them against `ref` */
+static int check_batch(const AVFrame *ref, const AVFrame *src,
+                       const struct mode *mode, const struct options *opts)
+{
+    AVFrame *dst[16] = {0};
+    const AVFrame *srcs[16];
+    const int nb_frames = FFMIN(opts->batch, FF_ARRAY_ELEMS(dst));
+    int ret = 0;
+
+    if (ref->hw_frames_ctx)
+        return 0;
+
+    for (int i = 0; i < nb_frames; i++) {
+        dst[i] = av_frame_alloc();
+        if (!dst[i]) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        ret = av_frame_copy_props(dst[i], ref);
+        if (ret < 0)
+            goto end;
+        dst[i]->format = ref->format;
+        dst[i]->width  = ref->width;
+        dst[i]->height = ref->height;
+        srcs[i] = src;
+    }
+
+    ret = sws_scale_frames(sws_src_dst, dst, srcs, nb_frames);
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_ERROR, "Failed batch %s ---> %s\n",
+               av_get_pix_fmt_name(src->format), av_get_pix_fmt_name(ref->format));
+        goto end;
+    }
+
+    const int stateful = uses_error_diffusion(mode, ref->format);
+    for (int i = 0; !stateful && i < nb_frames; i++) {
+        if (!frames_equal(ref, dst[i])) {
+            av_log(NULL, AV_LOG_ERROR, "Batch output %d mismatch %s ---> %s\n",
+                   i, av_get_pix_fmt_name(src->format),
+                   av_get_pix_fmt_name(ref->format));
+            ret = AVERROR(EINVAL);
+            goto end;
+        }
+    }
+
+end:
+    for (int i = 0; i < nb_frames; i++)
+        av_frame_free(&dst[i]);
+    return ret;
+}
+
 static int scale_new(AVFrame *dst, const AVFrame *src,
                      const struct mode *mode, const struct options *opts,
                      int64_t *out_time)
@@ -276,6 +366,9 @@ static int scale_new(AVFrame *dst, const AVFrame *src,
     }
     *out_time = av_gettime_relative() - time;
 
+    if (ret >= 0 && opts->batch > 1)
+        ret = check_batch(dst, src, mode, opts);
+
     return ret;
 }
 
@@ -972,6 +1065,8 @@ static int parse_options(int argc, char **argv, struct options *opts, FILE **fp)
                     "       Use Vulkan hardware acceleration on the specified device for the main conversion\n"
                     "   -threads <threads>\n"
                     "       Use the specified number of threads\n"
+                    "   -batch <frames>\n"
+                    "       Additionally convert this many frames at once with the batch API and check the results\n"
                     "   -cpuflags <cpuflags>\n"
                     "       Uses the specified cpuflags in the tests\n"
                     "   -pretty <1 or 0>\n"
@@ -1093,6 +1188,8 @@ static int parse_options(int argc, char **argv, struct options *opts, FILE **fp)
             }
         } else if (!strcmp(argv[i], "-threads")) {
             opts->threads = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-batch")) {
+            opts->batch = atoi(argv[i + 1]);
         } else if (!strcmp(argv[i], "-p")) {
             opts->prob = atof(argv[i + 1]);
         } else if (!strcmp(argv[i], "-pretty")) {
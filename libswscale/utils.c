@@ -2264,6 +2264,12 @@ void sws_freeContext(SwsContext *sws)
         sws_freeContext(c->slice_ctx[i]);
     av_freep(&c->slice_ctx);
 
+    avpriv_slicethread_free(&c->batch_thread);
+    for (i = 0; i < c->nb_batch_ctx; i++)
+        sws_freeContext(c->batch_ctx[i]);
+    av_freep(&c->batch_ctx);
+    av_freep(&c->batch_frames);
+
     avpriv_slicethread_free(&c->slicethread);
 
     for (i = 0; i < 4; i++)
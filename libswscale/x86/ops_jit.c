@@ -0,0 +1,1566 @@
+/**
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Runtime code generator for x86-64 (AVX2, and AVX-512 for packed shuffles).
+ *
+ * Instead of linking together a chain of precompiled kernels, this backend
+ * emits a single function containing the whole loop over all pixel blocks,
+ * with every micro-op inlined into the loop body. Intermediate components
+ * live in YMM registers for the entire duration of the body, so there are
+ * no indirect calls or memory round-trips between operations, and swizzles
+ * reduce to compile-time register renaming.
+ *
+ * The block size is chosen such that one component of the widest pixel type
+ * in the list exactly fills one YMM register. Narrower types only use the
+ * low 16 or 8 bytes of their register.
+ *
+ * Unsupported micro-ops make compilation fail with AVERROR(ENOTSUP), which
+ * transparently falls back to the next backend in the list.
+ *
+ * Op lists that reduce to a single packed shuffle (SWS_UOP_RW_SHUFFLE) are
+ * compiled into a dedicated loop instead, which uses EVEX-encoded ZMM code
+ * where available: vpshufb for lane-aligned shuffles, and vpermb with a
+ * zeroing mask register for shuffles that cross 128-bit lanes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/avassert.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+
+#include "../jit.h"
+#include "../ops_chain.h"
+#include "../uops.h"
+
+enum {
+    GPR_RAX, GPR_RCX, GPR_RDX, GPR_RBX, GPR_RSP, GPR_RBP, GPR_RSI, GPR_RDI,
+    GPR_R8,  GPR_R9,  GPR_R10, GPR_R11, GPR_R12, GPR_R13, GPR_R14, GPR_R15,
+};
+
+/* Condition codes for jcc */
+enum {
+    CC_E  = 0x4,
+    CC_NE = 0x5,
+    CC_L  = 0xC,
+    CC_GE = 0xD,
+};
+
+/**
+ * Encoded VEX/EVEX instruction: opcode map, mandatory prefix, W bit and opcode.
+ */
+#define VOP(map, pp, w, op) ((map) << 11 | (pp) << 9 | (w) << 8 | (op))
+#define VOP_MAP(vop)        ((vop) >> 11)
+#define VOP_PP(vop)         (((vop) >> 9) & 3)
+#define VOP_W(vop)          (((vop) >> 8) & 1)
+#define VOP_OP(vop)         ((vop) & 0xFF)
+
+enum { PP_NONE, PP_66, PP_F3, PP_F2 };
+enum { MAP_0F = 1, MAP_0F38, MAP_0F3A };
+
+enum {
+    VMOVDQU_LD   = VOP(MAP_0F,   PP_F3,   0, 0x6F),
+    VMOVDQU_ST   = VOP(MAP_0F,   PP_F3,   0, 0x7F),
+    VMOVDQA      = VOP(MAP_0F,   PP_66,   0, 0x6F),
+    VMOVQ_LD     = VOP(MAP_0F,   PP_F3,   0, 0x7E),
+    VMOVQ_ST     = VOP(MAP_0F,   PP_66,   0, 0xD6),
+    VMOVD_LD     = VOP(MAP_0F,   PP_66,   0, 0x6E),
+    VMOVD_ST     = VOP(MAP_0F,   PP_66,   0, 0x7E),
+    VMOVDQU8_LD  = VOP(MAP_0F,   PP_F2,   0, 0x6F), /* EVEX only */
+    VMOVDQU8_ST  = VOP(MAP_0F,   PP_F2,   0, 0x7F), /* EVEX only */
+    VPERMB       = VOP(MAP_0F38, PP_66,   0, 0x8D), /* EVEX only */
+    KMOVQ_LD     = VOP(MAP_0F,   PP_NONE, 1, 0x90),
+    VPSHUFB      = VOP(MAP_0F38, PP_66,   0, 0x00),
+    VPERMD       = VOP(MAP_0F38, PP_66,   0, 0x36),
+    VPERMQ       = VOP(MAP_0F3A, PP_66,   1, 0x00),
+    VINSERTI128  = VOP(MAP_0F3A, PP_66,   0, 0x38),
+    VEXTRACTI128 = VOP(MAP_0F3A, PP_66,   0, 0x39),
+    VPUNPCKLDQ   = VOP(MAP_0F,   PP_66,   0, 0x62),
+    VPUNPCKHDQ   = VOP(MAP_0F,   PP_66,   0, 0x6A),
+    VPUNPCKLQDQ  = VOP(MAP_0F,   PP_66,   0, 0x6C),
+    VPUNPCKHQDQ  = VOP(MAP_0F,   PP_66,   0, 0x6D),
+    VPADDB       = VOP(MAP_0F,   PP_66,   0, 0xFC),
+    VPADDW       = VOP(MAP_0F,   PP_66,   0, 0xFD),
+    VPADDD       = VOP(MAP_0F,   PP_66,   0, 0xFE),
+    VPMULLW      = VOP(MAP_0F,   PP_66,   0, 0xD5),
+    VPMULLD      = VOP(MAP_0F38, PP_66,   0, 0x40),
+    VPMINUB      = VOP(MAP_0F,   PP_66,   0, 0xDA),
+    VPMINUW      = VOP(MAP_0F38, PP_66,   0, 0x3A),
+    VPMINUD      = VOP(MAP_0F38, PP_66,   0, 0x3B),
+    VPMAXUB      = VOP(MAP_0F,   PP_66,   0, 0xDE),
+    VPMAXUW      = VOP(MAP_0F38, PP_66,   0, 0x3E),
+    VPMAXUD      = VOP(MAP_0F38, PP_66,   0, 0x3F),
+    VPAND        = VOP(MAP_0F,   PP_66,   0, 0xDB),
+    VPOR         = VOP(MAP_0F,   PP_66,   0, 0xEB), /* vpord with EVEX */
+    VPXOR        = VOP(MAP_0F,   PP_66,   0, 0xEF),
+    VPCMPEQB     = VOP(MAP_0F,   PP_66,   0, 0x74),
+    VPCMPEQW     = VOP(MAP_0F,   PP_66,   0, 0x75),
+    VPCMPEQD     = VOP(MAP_0F,   PP_66,   0, 0x76),
+    VPSHIFTW     = VOP(MAP_0F,   PP_66,   0, 0x71), /* /6 = sll, /2 = srl */
+    VPSHIFTD     = VOP(MAP_0F,   PP_66,   0, 0x72),
+    VPMOVZXBW    = VOP(MAP_0F38, PP_66,   0, 0x30),
+    VPMOVZXBD    = VOP(MAP_0F38, PP_66,   0, 0x31),
+    VPMOVZXWD    = VOP(MAP_0F38, PP_66,   0, 0x33),
+    VPACKUSWB    = VOP(MAP_0F,   PP_66,   0, 0x67),
+    VPACKUSDW    = VOP(MAP_0F38, PP_66,   0, 0x2B),
+    VADDPS       = VOP(MAP_0F,   PP_NONE, 0, 0x58),
+    VMULPS       = VOP(MAP_0F,   PP_NONE, 0, 0x59),
+    VMINPS       = VOP(MAP_0F,   PP_NONE, 0, 0x5D),
+    VMAXPS       = VOP(MAP_0F,   PP_NONE, 0, 0x5F),
+    VXORPS       = VOP(MAP_0F,   PP_NONE, 0, 0x57),
+    VCVTDQ2PS    = VOP(MAP_0F,   PP_NONE, 0, 0x5B),
+    VCVTTPS2DQ   = VOP(MAP_0F,   PP_F3,   0, 0x5B),
+};
+
+enum { SHIFT_RIGHT = 2, SHIFT_LEFT = 6 };
+
+typedef struct JitMem {
+    int8_t  base;
+    int8_t  index;  /* -1 if none */
+    uint8_t shift;  /* index scale, log2 */
+    int32_t disp;
+} JitMem;
+
+#define MEM(b, d)           ((JitMem) { .base = (b), .index = -1, .disp = (d) })
+#define MEMX(b, i, s, d)    ((JitMem) { .base = (b), .index = (i), .shift = (s), .disp = (d) })
+
+/**
+ * Private data for the generated function. `consts` must remain the first
+ * pointer-sized field, because the function prologue loads it from there.
+ */
+typedef struct JitPriv {
+    uint8_t *consts;
+    void    *code;
+    size_t   code_size;
+} JitPriv;
+
+typedef struct JitContext {
+    uint8_t *code;
+    unsigned code_size;
+    unsigned code_alloc;
+
+    uint8_t *consts;
+    unsigned consts_size;
+    unsigned consts_alloc;
+
+    int err;
+    int block_size;
+    int cpu_flags;
+
+    /* Register state */
+    int8_t   comp[4];   /* vector register holding each component, or -1 */
+    uint16_t temps;     /* vector registers currently used as temporaries */
+    int8_t   in[4];     /* GPR holding each input plane pointer */
+    int8_t   out[4];    /* GPR holding each output plane pointer */
+
+    int over_read[4];
+    int over_write[4];
+} JitContext;
+
+/* Registers with fixed roles inside the generated function */
+#define REG_EXEC    GPR_RDI
+#define REG_CONSTS  GPR_RSI
+#define REG_BX      GPR_RAX
+#define REG_Y       GPR_RCX
+#define REG_TMP0    GPR_RDX
+#define REG_TMP1    GPR_R11
+
+/* Stack slots for loop bounds */
+#define SLOT_BX_START 0
+#define SLOT_BX_END   4
+#define SLOT_Y_END    8
+#define LOCALS_SIZE   16
+
+/*********************************************************************/
+/* Low-level instruction encoding */
+
+static void emit(JitContext *s, uint8_t byte)
+{
+    if (s->err)
+        return;
+
+    if (s->code_size >= s->code_alloc) {
+        uint8_t *code = av_fast_realloc(s->code, &s->code_alloc, s->code_size + 1);
+        if (!code) {
+            s->err = AVERROR(ENOMEM);
+            return;
+        }
+        s->code = code;
+    }
+
+    s->code[s->code_size++] = byte;
+}
+
+static void emit32(JitContext *s, uint32_t val)
+{
+    for (int i = 0; i < 4; i++)
+        emit(s, val >> (8 * i));
+}
+
+static void emit_modrm_mem(JitContext *s, int reg, JitMem m)
+{
+    /* Always use the disp32 form, which also covers rbp/r13 bases */
+    const int sib = m.index >= 0 || (m.base & 7) == GPR_RSP;
+    emit(s, 0x80 | (reg & 7) << 3 | (sib ? GPR_RSP : m.base & 7));
+    if (sib) {
+        const int index = m.index >= 0 ? m.index : GPR_RSP; /* no index */
+        emit(s, m.shift << 6 | (index & 7) << 3 | (m.base & 7));
+    }
+    emit32(s, m.disp);
+}
+
+static void emit_modrm_reg(JitContext *s, int reg, int rm)
+{
+    emit(s, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+static void emit_vex(JitContext *s, int vop, int l, int reg, int vvvv,
+                     int index, int base)
+{
+    emit(s, 0xC4);
+    emit(s, (~reg & 8) << 4 | (~index & 8) << 3 | (~base & 8) << 2 | VOP_MAP(vop));
+    emit(s, VOP_W(vop) << 7 | (~vvvv & 15) << 3 | l << 2 | VOP_PP(vop));
+    emit(s, VOP_OP(vop));
+}
+
+static void vex_rr(JitContext *s, int vop, int l, int reg, int vvvv, int rm)
+{
+    emit_vex(s, vop, l, reg, vvvv, 0, rm);
+    emit_modrm_reg(s, reg, rm);
+}
+
+static void vex_rm(JitContext *s, int vop, int l, int reg, int vvvv, JitMem m)
+{
+    emit_vex(s, vop, l, reg, vvvv, m.index >= 0 ? m.index : 0, m.base);
+    emit_modrm_mem(s, reg, m);
+}
+
+/* Only registers 0-15 are supported, so EVEX.R', EVEX.V' and EVEX.b are unused */
+static void emit_evex(JitContext *s, int vop, int ll, int reg, int vvvv,
+                      int index, int base, int k, int z)
+{
+    emit(s, 0x62);
+    emit(s, (~reg & 8) << 4 | (~index & 8) << 3 | (~base & 8) << 2 | 0x10 | VOP_MAP(vop));
+    emit(s, VOP_W(vop) << 7 | (~vvvv & 15) << 3 | 0x04 | VOP_PP(vop));
+    emit(s, z << 7 | ll << 5 | 0x08 | k);
+    emit(s, VOP_OP(vop));
+}
+
+/* 512-bit operations, with optional {k} masking and {z} zeroing */
+static void evex_rr(JitContext *s, int vop, int reg, int vvvv, int rm, int k, int z)
+{
+    emit_evex(s, vop, 2, reg, vvvv, 0, rm, k, z);
+    emit_modrm_reg(s, reg, rm);
+}
+
+/* Memory operands always use disp32, which is not scaled by EVEX (unlike disp8) */
+static void evex_rm(JitContext *s, int vop, int reg, int vvvv, JitMem m, int k, int z)
+{
+    emit_evex(s, vop, 2, reg, vvvv, m.index >= 0 ? m.index : 0, m.base, k, z);
+    emit_modrm_mem(s, reg, m);
+}
+
+static void emit_rex(JitContext *s, int w, int reg, int index, int base)
+{
+    const int rex = w << 3 | (reg & 8) >> 1 | (index & 8) >> 2 | (base & 8) >> 3;
+    if (rex)
+        emit(s, 0x40 | rex);
+}
+
+static void gpr_rm(JitContext *s, int w, int op, int reg, JitMem m)
+{
+    emit_rex(s, w, reg, m.index >= 0 ? m.index : 0, m.base);
+    if (op > 0xFF)
+        emit(s, op >> 8);
+    emit(s, op & 0xFF);
+    emit_modrm_mem(s, reg, m);
+}
+
+static void gpr_rr(JitContext *s, int w, int op, int reg, int rm)
+{
+    emit_rex(s, w, reg, 0, rm);
+    if (op > 0xFF)
+        emit(s, op >> 8);
+    emit(s, op & 0xFF);
+    emit_modrm_reg(s, reg, rm);
+}
+
+/* General purpose instructions */
+#define mov_ld64(s, dst, m)     gpr_rm(s, 1, 0x8B, dst, m)
+#define mov_ld32(s, dst, m)     gpr_rm(s, 0, 0x8B, dst, m)
+#define mov_st32(s, m, src)     gpr_rm(s, 0, 0x89, src, m)
+#define mov_rr64(s, dst, src)   gpr_rr(s, 1, 0x89, src, dst)
+#define mov_rr32(s, dst, src)   gpr_rr(s, 0, 0x89, src, dst)
+#define add_ld64(s, dst, m)     gpr_rm(s, 1, 0x03, dst, m)
+#define add_rr64(s, dst, src)   gpr_rr(s, 1, 0x01, src, dst)
+#define imul_ld64(s, dst, m)    gpr_rm(s, 1, 0x0FAF, dst, m)
+#define movsxd_ld(s, dst, m)    gpr_rm(s, 1, 0x63, dst, m)
+#define cmp_ld32(s, reg, m)     gpr_rm(s, 0, 0x3B, reg, m)
+#define test_rr64(s, a, b)      gpr_rr(s, 1, 0x85, b, a)
+#define inc32(s, reg)           gpr_rr(s, 0, 0xFF, 0, reg)
+#define lea64(s, dst, m)        gpr_rm(s, 1, 0x8D, dst, m)
+
+static void op_imm32(JitContext *s, int w, int ext, int reg, int32_t imm)
+{
+    gpr_rr(s, w, 0x81, ext, reg);
+    emit32(s, imm);
+}
+
+#define add_imm64(s, reg, imm) op_imm32(s, 1, 0, reg, imm)
+#define sub_imm64(s, reg, imm) op_imm32(s, 1, 5, reg, imm)
+#define and_imm32(s, reg, imm) op_imm32(s, 0, 4, reg, imm)
+
+static void shl_imm32(JitContext *s, int reg, int imm)
+{
+    gpr_rr(s, 0, 0xC1, 4, reg);
+    emit(s, imm);
+}
+
+static void imul_imm32(JitContext *s, int dst, int src, int32_t imm)
+{
+    gpr_rr(s, 0, 0x69, dst, src);
+    emit32(s, imm);
+}
+
+static void push(JitContext *s, int reg)
+{
+    if (reg & 8)
+        emit(s, 0x41);
+    emit(s, 0x50 + (reg & 7));
+}
+
+static void pop(JitContext *s, int reg)
+{
+    if (reg & 8)
+        emit(s, 0x41);
+    emit(s, 0x58 + (reg & 7));
+}
+
+/* Returns the position of the rel32 field, to be patched later */
+static unsigned jcc(JitContext *s, int cc)
+{
+    emit(s, 0x0F);
+    emit(s, 0x80 | cc);
+    emit32(s, 0);
+    return s->code_size - 4;
+}
+
+static unsigned jmp(JitContext *s)
+{
+    emit(s, 0xE9);
+    emit32(s, 0);
+    return s->code_size - 4;
+}
+
+static void patch(JitContext *s, unsigned pos, unsigned target)
+{
+    if (s->err)
+        return;
+    const int32_t rel = (int32_t) target - (int32_t) (pos + 4);
+    memcpy(&s->code[pos], &rel, sizeof(rel));
+}
+
+/* Vector instructions; all operate on full YMM registers unless noted */
+static void v_op(JitContext *s, int vop, int dst, int src1, int src2)
+{
+    vex_rr(s, vop, 1, dst, src1, src2);
+}
+
+static void v_opm(JitContext *s, int vop, int dst, int src1, JitMem m)
+{
+    vex_rm(s, vop, 1, dst, src1, m);
+}
+
+static void v_op_imm(JitContext *s, int vop, int dst, int src1, int src2, int imm)
+{
+    vex_rr(s, vop, 1, dst, src1, src2);
+    emit(s, imm);
+}
+
+static void v_shift(JitContext *s, int vop, int dir, int dst, int src, int imm)
+{
+    vex_rr(s, vop, 1, dir, dst, src);
+    emit(s, imm);
+}
+
+static void v_load(JitContext *s, int dst, JitMem m, int bytes)
+{
+    switch (bytes) {
+    case 64: evex_rm(s, VMOVDQU8_LD, dst, 0, m, 0, 0); break;
+    case 32: vex_rm(s, VMOVDQU_LD, 1, dst, 0, m); break;
+    case 16: vex_rm(s, VMOVDQU_LD, 0, dst, 0, m); break;
+    case  8: vex_rm(s, VMOVQ_LD,   0, dst, 0, m); break;
+    case  4: vex_rm(s, VMOVD_LD,   0, dst, 0, m); break;
+    default: av_unreachable("Invalid vector size");
+    }
+}
+
+static void v_store(JitContext *s, JitMem m, int src, int bytes)
+{
+    switch (bytes) {
+    case 64: evex_rm(s, VMOVDQU8_ST, src, 0, m, 0, 0); break;
+    case 32: vex_rm(s, VMOVDQU_ST, 1, src, 0, m); break;
+    case 16: vex_rm(s, VMOVDQU_ST, 0, src, 0, m); break;
+    case  8: vex_rm(s, VMOVQ_ST,   0, src, 0, m); break;
+    case  4: vex_rm(s, VMOVD_ST,   0, src, 0, m); break;
+    default: av_unreachable("Invalid vector size");
+    }
+}
+
+static void v_insert_hi(JitContext *s, int dst, JitMem m)
+{
+    vex_rm(s, VINSERTI128, 1, dst, dst, m);
+    emit(s, 1);
+}
+
+static void v_extract_hi(JitContext *s, JitMem m, int src)
+{
+    vex_rm(s, VEXTRACTI128, 1, src, 0, m);
+    emit(s, 1);
+}
+
+static void vzeroupper(JitContext *s)
+{
+    emit(s, 0xC5);
+    emit(s, 0xF8);
+    emit(s, 0x77);
+}
+
+/*********************************************************************/
+/* Constant pool and register allocation */
+
+static JitMem const_data(JitContext *s, const void *data, int size)
+{
+    const unsigned offset = FFALIGN(s->consts_size, 32);
+    uint8_t *consts = av_fast_realloc(s->consts, &s->consts_alloc, offset + size);
+    if (!consts) {
+        s->err = AVERROR(ENOMEM);
+        return MEM(REG_CONSTS, 0);
+    }
+
+    s->consts = consts;
+    memset(&consts[s->consts_size], 0, offset - s->consts_size);
+    memcpy(&consts[offset], data, size);
+    s->consts_size = offset + size;
+    return MEM(REG_CONSTS, offset);
+}
+
+static JitMem const_vec32(JitContext *s, uint32_t val)
+{
+    uint32_t vec[8];
+    for (int i = 0; i < 8; i++)
+        vec[i] = val;
+    return const_data(s, vec, sizeof(vec));
+}
+
+static JitMem const_bytes(JitContext *s, const int8_t lane[16])
+{
+    int8_t vec[32];
+    memcpy(&vec[0],  lane, 16);
+    memcpy(&vec[16], lane, 16);
+    return const_data(s, vec, sizeof(vec));
+}
+
+/* Expand pixel value to 32-bits by repeating as necessary */
+static uint32_t expand32(SwsPixelType type, uint32_t value)
+{
+    switch (type) {
+    case SWS_PIXEL_U8:  return (value & 0xFF)   * 0x01010101u;
+    case SWS_PIXEL_U16: return (value & 0xFFFF) * 0x00010001u;
+    default:            return value;
+    }
+}
+
+static JitMem const_pixel(JitContext *s, SwsPixelType type, SwsPixel px)
+{
+    switch (type) {
+    case SWS_PIXEL_U8:  return const_vec32(s, expand32(type, px.u8));
+    case SWS_PIXEL_U16: return const_vec32(s, expand32(type, px.u16));
+    default:            return const_vec32(s, px.u32);
+    }
+}
+
+static uint16_t busy_regs(const JitContext *s)
+{
+    uint16_t busy = s->temps;
+    for (int c = 0; c < 4; c++) {
+        if (s->comp[c] >= 0)
+            busy |= 1 << s->comp[c];
+    }
+    return busy;
+}
+
+static int alloc_reg(JitContext *s)
+{
+    const uint16_t busy = busy_regs(s);
+    for (int r = 0; r < 16; r++) {
+        if (!(busy & (1 << r))) {
+            s->temps |= 1 << r;
+            return r;
+        }
+    }
+
+    s->err = AVERROR(ENOTSUP); /* out of registers */
+    return 0;
+}
+
+static void free_reg(JitContext *s, int reg)
+{
+    s->temps &= ~(1 << reg);
+}
+
+/* Hand over ownership of a temporary register to a component */
+static void set_comp(JitContext *s, int c, int reg)
+{
+    s->comp[c] = reg;
+    free_reg(s, reg);
+}
+
+/* Returns the register holding component `c`, allocating it if needed */
+static int comp_reg(JitContext *s, int c)
+{
+    if (s->comp[c] < 0)
+        set_comp(s, c, alloc_reg(s));
+    return s->comp[c];
+}
+
+static int vec_bytes(const JitContext *s, SwsPixelType type)
+{
+    return s->block_size * ff_sws_pixel_type_size(type);
+}
+
+#define LOOP_MASK(mask, c)              \
+    for (int c = 0; c < 4; c++)         \
+        if (SWS_COMP_TEST(mask, c))
+
+/*********************************************************************/
+/* Micro-op code generation */
+
+static int packed_elems(const SwsUOp *uop)
+{
+    switch (uop->mask) {
+    case SWS_COMP_ELEMS(2): return 2;
+    case SWS_COMP_ELEMS(3): return 3;
+    case SWS_COMP_ELEMS(4): return 4;
+    default:                return 0;
+    }
+}
+
+/**
+ * Packed data is handled in chunks, each of which holds exactly one dword
+ * worth of data per component (4 / pixel_size pixels). Pairs of chunks are
+ * loaded into the two lanes of a YMM register and deinterleaved in-lane with
+ * vpshufb, such that dword j of each lane holds component j.
+ */
+static void packed_shuffle_mask(int8_t mask[16], int elems, int size, bool write)
+{
+    memset(mask, -1, 16);
+    for (int j = 0; j < elems; j++) {
+        for (int k = 0; k < 4; k++) {
+            const int p = k / size, b = k % size;
+            const int packed = (p * elems + j) * size + b;
+            if (write)
+                mask[packed] = j * 4 + k;
+            else
+                mask[j * 4 + k] = packed;
+        }
+    }
+}
+
+static void transpose4(JitContext *s, const int src[4], const int dst[4])
+{
+    int t[4];
+    for (int i = 0; i < 4; i++)
+        t[i] = alloc_reg(s);
+
+    v_op(s, VPUNPCKLDQ,  t[0], src[0], src[1]);
+    v_op(s, VPUNPCKHDQ,  t[1], src[0], src[1]);
+    v_op(s, VPUNPCKLDQ,  t[2], src[2], src[3]);
+    v_op(s, VPUNPCKHDQ,  t[3], src[2], src[3]);
+    v_op(s, VPUNPCKLQDQ, dst[0], t[0], t[2]);
+    v_op(s, VPUNPCKHQDQ, dst[1], t[0], t[2]);
+    v_op(s, VPUNPCKLQDQ, dst[2], t[1], t[3]);
+    v_op(s, VPUNPCKHQDQ, dst[3], t[1], t[3]);
+
+    for (int i = 0; i < 4; i++)
+        free_reg(s, t[i]);
+}
+
+/* Interleave chunks from both lanes: chunk (2i + L) -> dword position */
+static const int32_t chunk_order[8]     = { 0, 4, 1, 5, 2, 6, 3, 7 };
+static const int32_t chunk_order_inv[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+
+static int jit_read_packed(JitContext *s, const SwsUOp *uop)
+{
+    const int elems  = packed_elems(uop);
+    const int size   = ff_sws_pixel_type_size(uop->type);
+    const int bytes  = vec_bytes(s, uop->type);
+    const int chunk  = 4 * elems;
+    const int num    = bytes / 8; /* number of chunk pairs */
+    const int ptr    = s->in[0];
+    if (!elems)
+        return AVERROR(ENOTSUP);
+
+    int8_t shuf[16];
+    packed_shuffle_mask(shuf, elems, size, false);
+    const JitMem shuf_mem  = const_bytes(s, shuf);
+    const JitMem order_mem = const_data(s, chunk_order, sizeof(chunk_order));
+
+    LOOP_MASK(uop->mask, c)
+        s->comp[c] = -1; /* overwritten */
+
+    int p[4];
+    for (int i = 0; i < num; i++) {
+        p[i] = alloc_reg(s);
+        if (chunk == 16) {
+            v_load(s, p[i], MEM(ptr, 32 * i), 32);
+        } else {
+            v_load(s, p[i], MEM(ptr, 2 * i * chunk), 16);
+            v_insert_hi(s, p[i], MEM(ptr, (2 * i + 1) * chunk));
+        }
+        v_opm(s, VPSHUFB, p[i], p[i], shuf_mem);
+    }
+
+    const int order = alloc_reg(s);
+    v_load(s, order, order_mem, 32);
+
+    switch (num) {
+    case 4:
+        /* dword i of p[i] in lane L = chunk (2i + L) for every component */
+        transpose4(s, p, p);
+        for (int j = 0; j < elems; j++) {
+            v_op(s, VPERMD, p[j], order, p[j]);
+            set_comp(s, j, p[j]);
+        }
+        for (int j = elems; j < 4; j++)
+            free_reg(s, p[j]);
+        break;
+    case 2:
+        /* qword j of p[i] = component j of chunks 2i, 2i + 1 */
+        v_op(s, VPERMD, p[0], order, p[0]);
+        v_op(s, VPERMD, p[1], order, p[1]);
+        for (int j = 0; j < elems; j++) {
+            const int a = alloc_reg(s), b = alloc_reg(s);
+            v_op_imm(s, VPERMQ, a, 0, p[0], j);
+            v_op_imm(s, VPERMQ, b, 0, p[1], j);
+            v_op(s, VPUNPCKLQDQ, a, a, b);
+            free_reg(s, b);
+            set_comp(s, j, a);
+        }
+        free_reg(s, p[0]);
+        free_reg(s, p[1]);
+        break;
+    case 1:
+        v_op(s, VPERMD, p[0], order, p[0]);
+        for (int j = 1; j < elems; j++) {
+            const int a = alloc_reg(s);
+            v_op_imm(s, VPERMQ, a, 0, p[0], j);
+            set_comp(s, j, a);
+        }
+        set_comp(s, 0, p[0]);
+        break;
+    }
+
+    free_reg(s, order);
+    add_imm64(s, ptr, bytes * elems);
+    if (chunk < 16)
+        s->over_read[0] = FFMAX(s->over_read[0], 16 - chunk);
+    return 0;
+}
+
+static int jit_write_packed(JitContext *s, const SwsUOp *uop)
+{
+    const int elems  = packed_elems(uop);
+    const int size   = ff_sws_pixel_type_size(uop->type);
+    const int bytes  = vec_bytes(s, uop->type);
+    const int chunk  = 4 * elems;
+    const int num    = bytes / 8;
+    const int ptr    = s->out[0];
+    if (!elems)
+        return AVERROR(ENOTSUP);
+
+    int8_t shuf[16];
+    packed_shuffle_mask(shuf, elems, size, true);
+    const JitMem shuf_mem  = const_bytes(s, shuf);
+    const JitMem order_mem = const_data(s, chunk_order_inv, sizeof(chunk_order_inv));
+
+    int c[4];
+    for (int j = 0; j < 4; j++)
+        c[j] = comp_reg(s, FFMIN(j, elems - 1)); /* pad with garbage */
+
+    const int order = alloc_reg(s);
+    v_load(s, order, order_mem, 32);
+
+    int p[4];
+    for (int i = 0; i < num; i++)
+        p[i] = alloc_reg(s);
+
+    switch (num) {
+    case 4: {
+        int t[4];
+        for (int j = 0; j < 4; j++) {
+            t[j] = alloc_reg(s);
+            v_op(s, VPERMD, t[j], order, c[j]);
+        }
+        transpose4(s, t, p);
+        for (int j = 0; j < 4; j++)
+            free_reg(s, t[j]);
+        break;
+    }
+    case 2:
+    case 1: {
+        const int hi = alloc_reg(s);
+        for (int i = 0; i < num; i++) {
+            const int unpck = i ? VPUNPCKHQDQ : VPUNPCKLQDQ;
+            v_op(s, unpck, p[i], c[0], c[1]);
+            v_op(s, unpck, hi,   c[2], c[3]);
+            v_op_imm(s, VINSERTI128, p[i], p[i], hi, 1);
+            v_op(s, VPERMD, p[i], order, p[i]);
+        }
+        free_reg(s, hi);
+        break;
+    }
+    }
+
+    for (int i = 0; i < num; i++) {
+        v_opm(s, VPSHUFB, p[i], p[i], shuf_mem);
+        switch (chunk) {
+        case 16:
+            v_store(s, MEM(ptr, 32 * i), p[i], 32);
+            break;
+        case 12:
+            /* The garbage tail of each chunk is overwritten by the next one */
+            v_store(s, MEM(ptr, 2 * i * chunk), p[i], 16);
+            v_extract_hi(s, MEM(ptr, (2 * i + 1) * chunk), p[i]);
+            break;
+        case 8:
+            v_store(s, MEM(ptr, 2 * i * chunk), p[i], 8);
+            vex_rr(s, VEXTRACTI128, 1, p[i], 0, p[i]);
+            emit(s, 1);
+            v_store(s, MEM(ptr, (2 * i + 1) * chunk), p[i], 8);
+            break;
+        }
+        free_reg(s, p[i]);
+    }
+
+    free_reg(s, order);
+    add_imm64(s, ptr, bytes * elems);
+    if (chunk == 12)
+        s->over_write[0] = FFMAX(s->over_write[0], 4);
+    return 0;
+}
+
+/* Truncating down-conversion of 32-bit integers */
+static void pack_u32(JitContext *s, int reg, SwsPixelType to)
+{
+    const uint32_t mask = to == SWS_PIXEL_U8 ? 0xFF : 0xFFFF;
+    v_opm(s, VPAND, reg, reg, const_vec32(s, mask));
+    v_op(s, VPACKUSDW, reg, reg, reg);
+    v_op_imm(s, VPERMQ, reg, 0, reg, 0x08);
+    if (to == SWS_PIXEL_U8)
+        v_op(s, VPACKUSWB, reg, reg, reg);
+}
+
+static int jit_convert(JitContext *s, const SwsUOp *uop, SwsPixelType to)
+{
+    const SwsPixelType from = uop->type;
+    if (from == to)
+        return 0;
+
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        switch (from) {
+        case SWS_PIXEL_U8:
+            switch (to) {
+            case SWS_PIXEL_U16: vex_rr(s, VPMOVZXBW, 1, r, 0, r); break;
+            case SWS_PIXEL_U32: vex_rr(s, VPMOVZXBD, 1, r, 0, r); break;
+            case SWS_PIXEL_F32: vex_rr(s, VPMOVZXBD, 1, r, 0, r);
+                                v_op(s, VCVTDQ2PS, r, 0, r); break;
+            }
+            break;
+        case SWS_PIXEL_U16:
+            switch (to) {
+            case SWS_PIXEL_U8:
+                v_opm(s, VPAND, r, r, const_vec32(s, 0x00FF00FF));
+                v_op(s, VPACKUSWB, r, r, r);
+                v_op_imm(s, VPERMQ, r, 0, r, 0x08);
+                break;
+            case SWS_PIXEL_U32: vex_rr(s, VPMOVZXWD, 1, r, 0, r); break;
+            case SWS_PIXEL_F32: vex_rr(s, VPMOVZXWD, 1, r, 0, r);
+                                v_op(s, VCVTDQ2PS, r, 0, r); break;
+            }
+            break;
+        case SWS_PIXEL_U32:
+            if (to == SWS_PIXEL_F32)
+                return AVERROR(ENOTSUP); /* needs unsigned conversion */
+            pack_u32(s, r, to);
+            break;
+        case SWS_PIXEL_F32:
+            if (to == SWS_PIXEL_U32)
+                return AVERROR(ENOTSUP); /* needs unsigned conversion */
+            v_op(s, VCVTTPS2DQ, r, 0, r);
+            pack_u32(s, r, to);
+            break;
+        default:
+            return AVERROR(ENOTSUP);
+        }
+    }
+
+    return 0;
+}
+
+static int jit_arith(JitContext *s, const SwsUOp *uop)
+{
+    static const int ops[][4] = {
+        /*                 U8       U16      U32      F32   */
+        [SWS_UOP_ADD]   = { VPADDB,  VPADDW,  VPADDD,  VADDPS },
+        [SWS_UOP_MIN]   = { VPMINUB, VPMINUW, VPMINUD, VMINPS },
+        [SWS_UOP_MAX]   = { VPMAXUB, VPMAXUW, VPMAXUD, VMAXPS },
+        [SWS_UOP_SCALE] = { 0,       VPMULLW, VPMULLD, VMULPS },
+    };
+
+    const int vop = ops[uop->uop][uop->type - SWS_PIXEL_U8];
+    if (!vop)
+        return AVERROR(ENOTSUP);
+
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        const SwsPixel val = uop->uop == SWS_UOP_SCALE ? uop->data.scalar
+                                                       : uop->data.vec4[c];
+        v_opm(s, vop, r, r, const_pixel(s, uop->type, val));
+    }
+
+    return 0;
+}
+
+static void shift_int(JitContext *s, SwsPixelType type, int dir,
+                      int dst, int src, int amount)
+{
+    const int vop = type == SWS_PIXEL_U32 ? VPSHIFTD : VPSHIFTW;
+    if (!amount) {
+        if (dst != src)
+            v_op(s, VMOVDQA, dst, 0, src);
+        return;
+    }
+
+    v_shift(s, vop, dir, dst, src, amount);
+    if (type == SWS_PIXEL_U8) {
+        /* Mask off bits that crossed over from the neighbouring byte */
+        const uint8_t mask = dir == SHIFT_LEFT ? 0xFF << amount : 0xFF >> amount;
+        v_opm(s, VPAND, dst, dst, const_vec32(s, mask * 0x01010101u));
+    }
+}
+
+static int jit_shift(JitContext *s, const SwsUOp *uop)
+{
+    const int dir = uop->uop == SWS_UOP_LSHIFT ? SHIFT_LEFT : SHIFT_RIGHT;
+    if (!ff_sws_pixel_type_is_int(uop->type))
+        return AVERROR(ENOTSUP);
+
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        shift_int(s, uop->type, dir, r, r, uop->par.shift.amount);
+    }
+
+    return 0;
+}
+
+static void pack_shifts(const SwsPackUOp *pack, int shift[4])
+{
+    int total = 0;
+    for (int i = 0; i < 4; i++)
+        total += pack->pattern[i];
+    for (int i = 0; i < 4; i++) {
+        total -= pack->pattern[i];
+        shift[i] = total;
+    }
+}
+
+static int jit_unpack(JitContext *s, const SwsUOp *uop)
+{
+    if (!ff_sws_pixel_type_is_int(uop->type))
+        return AVERROR(ENOTSUP);
+
+    const int bits = 8 * ff_sws_pixel_type_size(uop->type);
+    const int val = comp_reg(s, 0);
+    int shift[4];
+    pack_shifts(&uop->par.pack, shift);
+
+    /* Component 0 holds the packed value, so process it last */
+    for (int c = 3; c >= 0; c--) {
+        if (!SWS_COMP_TEST(uop->mask, c))
+            continue;
+        const int depth = uop->par.pack.pattern[c];
+        const int r = c ? alloc_reg(s) : val;
+        shift_int(s, uop->type, SHIFT_RIGHT, r, val, shift[c]);
+        if (depth < bits)
+            v_opm(s, VPAND, r, r, const_pixel(s, uop->type,
+                                  (SwsPixel) { .u32 = (1u << depth) - 1 }));
+        if (c)
+            set_comp(s, c, r);
+    }
+
+    return 0;
+}
+
+static int jit_pack(JitContext *s, const SwsUOp *uop)
+{
+    if (!ff_sws_pixel_type_is_int(uop->type))
+        return AVERROR(ENOTSUP);
+
+    int shift[4];
+    pack_shifts(&uop->par.pack, shift);
+
+    const int acc = alloc_reg(s);
+    const int tmp = alloc_reg(s);
+    bool first = true;
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        shift_int(s, uop->type, SHIFT_LEFT, first ? acc : tmp, r, shift[c]);
+        if (!first)
+            v_op(s, VPOR, acc, acc, tmp);
+        first = false;
+    }
+
+    if (first) /* empty pattern */
+        v_op(s, VPXOR, acc, acc, acc);
+
+    free_reg(s, tmp);
+    set_comp(s, 0, acc);
+    return 0;
+}
+
+static int jit_clear(JitContext *s, const SwsUOp *uop)
+{
+    const bool is_int = ff_sws_pixel_type_is_int(uop->type);
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        if (SWS_COMP_TEST(uop->par.clear.one, c)) {
+            if (!is_int)
+                return AVERROR(ENOTSUP);
+            v_op(s, VPCMPEQD, r, r, r);
+        } else if (SWS_COMP_TEST(uop->par.clear.zero, c)) {
+            v_op(s, VPXOR, r, r, r);
+        } else {
+            v_load(s, r, const_pixel(s, uop->type, uop->data.vec4[c]), 32);
+        }
+    }
+
+    return 0;
+}
+
+static int jit_swap_bytes(JitContext *s, const SwsUOp *uop)
+{
+    const int size = ff_sws_pixel_type_size(uop->type);
+    if (!ff_sws_pixel_type_is_int(uop->type))
+        return AVERROR(ENOTSUP);
+    if (size == 1)
+        return 0;
+
+    int8_t shuf[16];
+    for (int i = 0; i < 16; i++)
+        shuf[i] = (i & ~(size - 1)) + (size - 1 - (i & (size - 1)));
+    const JitMem mask = const_bytes(s, shuf);
+
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        v_opm(s, VPSHUFB, r, r, mask);
+    }
+
+    return 0;
+}
+
+static int jit_expand(JitContext *s, const SwsUOp *uop)
+{
+    static const int cmpeq[] = { VPCMPEQB, VPCMPEQW, VPCMPEQD };
+    if (!ff_sws_pixel_type_is_int(uop->type))
+        return AVERROR(ENOTSUP);
+
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        switch (uop->uop) {
+        case SWS_UOP_EXPAND_BIT: {
+            const int zero = alloc_reg(s);
+            v_op(s, VPXOR, zero, zero, zero);
+            v_op(s, cmpeq[uop->type - SWS_PIXEL_U8], r, r, zero);
+            v_op(s, VPCMPEQD, zero, zero, zero);
+            v_op(s, VPXOR, r, r, zero);
+            free_reg(s, zero);
+            break;
+        }
+        case SWS_UOP_EXPAND_PAIR: {
+            const int tmp = alloc_reg(s);
+            vex_rr(s, VPMOVZXBW, 1, r, 0, r);
+            v_shift(s, VPSHIFTW, SHIFT_LEFT, tmp, r, 8);
+            v_op(s, VPOR, r, r, tmp);
+            free_reg(s, tmp);
+            break;
+        }
+        case SWS_UOP_EXPAND_QUAD:
+            vex_rr(s, VPMOVZXBD, 1, r, 0, r);
+            v_opm(s, VPMULLD, r, r, const_vec32(s, 0x01010101));
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static int jit_swizzle(JitContext *s, const SwsUOp *uop)
+{
+    const SwsMoveUOp *move = &uop->par.move;
+    int8_t regs[5] = { -1, s->comp[0], s->comp[1], s->comp[2], s->comp[3] };
+    for (int n = 0; n < move->num_moves; n++)
+        regs[move->dst[n] + 1] = regs[move->src[n] + 1];
+
+    /* Keep all source registers alive until every component is assigned */
+    uint16_t live = 0;
+    for (int c = 0; c < 4; c++) {
+        if (SWS_COMP_TEST(uop->mask, c) && regs[c + 1] >= 0)
+            live |= 1 << regs[c + 1];
+        s->comp[c] = -1;
+    }
+    s->temps |= live;
+
+    /* Pure register renaming; duplicated components need a real copy */
+    uint16_t seen = 0;
+    LOOP_MASK(uop->mask, c) {
+        const int r = regs[c + 1];
+        if (r < 0)
+            continue;
+        if (seen & (1 << r)) {
+            av_assert1(uop->uop == SWS_UOP_COPY);
+            const int copy = alloc_reg(s);
+            v_op(s, VMOVDQA, copy, 0, r);
+            set_comp(s, c, copy);
+        } else {
+            seen |= 1 << r;
+            s->comp[c] = r;
+        }
+    }
+
+    s->temps &= ~live;
+    return 0;
+}
+
+static int jit_linear(JitContext *s, const SwsUOp *uop)
+{
+    const SwsLinearUOp *lin = &uop->par.lin;
+    if (uop->type != SWS_PIXEL_F32)
+        return AVERROR(ENOTSUP);
+
+    /* Make sure all needed inputs are allocated before computing outputs */
+    for (int i = 0; i < 4; i++) {
+        if (!SWS_COMP_TEST(uop->mask, i))
+            continue;
+        for (int j = 0; j < 4; j++) {
+            if (!(lin->zero & SWS_MASK(i, j)))
+                comp_reg(s, j);
+        }
+    }
+
+    /**
+     * Mirrors the evaluation order of the reference implementation, so the
+     * result is bit-exact. For SWS_UOP_LINEAR_FMA, it is always valid to
+     * skip the fusion.
+     */
+    int res[4];
+    const int tmp = alloc_reg(s);
+    LOOP_MASK(uop->mask, i) {
+        const int acc = res[i] = alloc_reg(s);
+        if (lin->zero & SWS_MASK_OFF(i))
+            v_op(s, VXORPS, acc, acc, acc);
+        else
+            v_load(s, acc, const_pixel(s, uop->type, uop->data.mat4[i][4]), 32);
+
+        for (int j = 0; j < 4; j++) {
+            if (lin->zero & SWS_MASK(i, j))
+                continue;
+            if (lin->one & SWS_MASK(i, j)) {
+                v_op(s, VADDPS, acc, acc, s->comp[j]);
+            } else {
+                v_opm(s, VMULPS, tmp, s->comp[j],
+                      const_pixel(s, uop->type, uop->data.mat4[i][j]));
+                v_op(s, VADDPS, acc, acc, tmp);
+            }
+        }
+    }
+
+    free_reg(s, tmp);
+    LOOP_MASK(uop->mask, i)
+        set_comp(s, i, res[i]);
+    return 0;
+}
+
+static int jit_dither(JitContext *s, const SwsUOp *uop)
+{
+    const SwsDitherUOp *dither = &uop->par.dither;
+    const int size   = 1 << dither->size_log2;
+    const int stride = FFMAX(size, s->block_size);
+    const int height = ff_sws_dither_height(dither);
+    if (uop->type != SWS_PIXEL_F32)
+        return AVERROR(ENOTSUP);
+
+    /* Pad rows to multiples of the block size */
+    float *matrix = av_malloc_array(height * stride, sizeof(*matrix));
+    if (!matrix)
+        return AVERROR(ENOMEM);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < stride; x++)
+            matrix[y * stride + x] = uop->data.ptr[y * size + (x & (size - 1))].f32;
+    }
+    const JitMem base = const_data(s, matrix, height * stride * sizeof(*matrix));
+    av_free(matrix);
+
+    /* tmp0 = row offset for the current line and block */
+    mov_rr32(s, REG_TMP0, REG_Y);
+    and_imm32(s, REG_TMP0, size - 1);
+    imul_imm32(s, REG_TMP0, REG_TMP0, stride * sizeof(float));
+    if (size > s->block_size) {
+        mov_rr32(s, REG_TMP1, REG_BX);
+        shl_imm32(s, REG_TMP1, av_log2(s->block_size));
+        and_imm32(s, REG_TMP1, size - 1);
+        lea64(s, REG_TMP0, MEMX(REG_TMP0, REG_TMP1, 2, 0));
+    }
+
+    LOOP_MASK(uop->mask, c) {
+        const int r = comp_reg(s, c);
+        const int off = dither->y_offset[c] * stride * sizeof(float);
+        v_opm(s, VADDPS, r, r, MEMX(REG_CONSTS, REG_TMP0, 0, base.disp + off));
+    }
+
+    return 0;
+}
+
+/* Size of the smallest single load/store covering `bytes` */
+static int mov_size(int bytes)
+{
+    return bytes <= 4  ?  4 :
+           bytes <= 8  ?  8 :
+           bytes <= 16 ? 16 :
+           bytes <= 32 ? 32 : 64;
+}
+
+/**
+ * Packed shuffles load, shuffle and store one vector per block, with the same
+ * vector size and block layout as translate_shuffle() in ops.c. vpshufb can't
+ * cross 128-bit lanes, so shuffles whose groups don't map lanes onto
+ * themselves are limited to XMM unless AVX-512 vpermb is available.
+ */
+static int jit_shuffle(JitContext *s, const SwsUOp *uop)
+{
+    const SwsShuffleUOp *par = &uop->par.shuffle;
+    const int cpu_flags = av_get_cpu_flags();
+    const bool lane_aligned = par->read_size == par->write_size &&
+                              16 % par->read_size == 0;
+    int mmsize = (cpu_flags & AV_CPU_FLAG_AVX512) ? 64 : 32;
+    if (!lane_aligned && !(cpu_flags & AV_CPU_FLAG_AVX512ICL))
+        mmsize = 16;
+    const bool use_vpermb = !lane_aligned && mmsize == 64;
+
+    int8_t mask[64];
+    const int groups = ff_sws_shuffle_mask(uop, mask, lane_aligned ? 16 : mmsize);
+    if (groups < 0)
+        return groups;
+
+    const int num_lanes = lane_aligned ? mmsize / 16 : 1;
+    for (int i = 1; i < num_lanes; i++)
+        memcpy(&mask[16 * i], mask, 16);
+
+    /* Negative indices are zeroed by vpshufb and by the vpermb zeroing mask */
+    uint8_t clear[64];
+    uint64_t keep = 0;
+    for (int i = 0; i < mmsize; i++) {
+        clear[i] = mask[i] < 0 ? par->clear_value : 0;
+        keep |= (uint64_t) (mask[i] >= 0) << i;
+    }
+
+    const int in_total  = num_lanes * groups * par->read_size;
+    const int out_total = num_lanes * groups * par->write_size;
+    const int in_size   = mov_size(in_total);
+    const int out_size  = mov_size(out_total);
+    const JitMem mask_mem = const_data(s, mask, mmsize);
+
+    const int data = alloc_reg(s);
+    v_load(s, data, MEM(s->in[0], 0), in_size);
+    if (use_vpermb) {
+        const int idx = alloc_reg(s);
+        const int k = keep != UINT64_MAX;
+        if (k)
+            vex_rm(s, KMOVQ_LD, 0, k, 0, const_data(s, &keep, sizeof(keep)));
+        v_load(s, idx, mask_mem, 64);
+        evex_rr(s, VPERMB, data, idx, data, k, k);
+        free_reg(s, idx);
+    } else if (mmsize == 64) {
+        evex_rm(s, VPSHUFB, data, data, mask_mem, 0, 0);
+    } else {
+        vex_rm(s, VPSHUFB, mmsize == 32, data, data, mask_mem);
+    }
+
+    if (par->clear_value) {
+        const JitMem clear_mem = const_data(s, clear, mmsize);
+        if (mmsize == 64)
+            evex_rm(s, VPOR, data, data, clear_mem, 0, 0);
+        else
+            vex_rm(s, VPOR, mmsize == 32, data, data, clear_mem);
+    }
+
+    v_store(s, MEM(s->out[0], 0), data, out_size);
+    free_reg(s, data);
+
+    add_imm64(s, s->in[0],  in_total);
+    add_imm64(s, s->out[0], out_total);
+    s->over_read[0]  = in_size  - in_total;
+    s->over_write[0] = out_size - out_total;
+    s->block_size    = groups * uop->data.shuffle.pixels * num_lanes;
+    s->cpu_flags     = use_vpermb   ? AV_CPU_FLAG_AVX512ICL :
+                       mmsize == 64 ? AV_CPU_FLAG_AVX512    : AV_CPU_FLAG_AVX2;
+    return 0;
+}
+
+static int jit_uop(JitContext *s, const SwsUOp *uop)
+{
+    switch (uop->uop) {
+    case SWS_UOP_READ_PLANAR: {
+        const int bytes = vec_bytes(s, uop->type);
+        LOOP_MASK(uop->mask, c) {
+            s->comp[c] = -1; /* overwritten */
+            v_load(s, comp_reg(s, c), MEM(s->in[c], 0), bytes);
+            add_imm64(s, s->in[c], bytes);
+        }
+        return 0;
+    }
+    case SWS_UOP_WRITE_PLANAR: {
+        const int bytes = vec_bytes(s, uop->type);
+        LOOP_MASK(uop->mask, c) {
+            v_store(s, MEM(s->out[c], 0), comp_reg(s, c), bytes);
+            add_imm64(s, s->out[c], bytes);
+        }
+        return 0;
+    }
+    case SWS_UOP_READ_PACKED:   return jit_read_packed(s, uop);
+    case SWS_UOP_WRITE_PACKED:  return jit_write_packed(s, uop);
+    case SWS_UOP_RW_SHUFFLE:    return jit_shuffle(s, uop);
+    case SWS_UOP_PERMUTE:
+    case SWS_UOP_COPY:          return jit_swizzle(s, uop);
+    case SWS_UOP_SWAP_BYTES:    return jit_swap_bytes(s, uop);
+    case SWS_UOP_EXPAND_BIT:
+    case SWS_UOP_EXPAND_PAIR:
+    case SWS_UOP_EXPAND_QUAD:   return jit_expand(s, uop);
+    case SWS_UOP_TO_U8:         return jit_convert(s, uop, SWS_PIXEL_U8);
+    case SWS_UOP_TO_U16:        return jit_convert(s, uop, SWS_PIXEL_U16);
+    case SWS_UOP_TO_U32:        return jit_convert(s, uop, SWS_PIXEL_U32);
+    case SWS_UOP_TO_F32:        return jit_convert(s, uop, SWS_PIXEL_F32);
+    case SWS_UOP_SCALE:
+    case SWS_UOP_ADD:
+    case SWS_UOP_MIN:
+    case SWS_UOP_MAX:           return jit_arith(s, uop);
+    case SWS_UOP_LSHIFT:
+    case SWS_UOP_RSHIFT:        return jit_shift(s, uop);
+    case SWS_UOP_UNPACK:        return jit_unpack(s, uop);
+    case SWS_UOP_PACK:          return jit_pack(s, uop);
+    case SWS_UOP_CLEAR:         return jit_clear(s, uop);
+    case SWS_UOP_LINEAR:
+    case SWS_UOP_LINEAR_FMA:    return jit_linear(s, uop);
+    case SWS_UOP_DITHER:        return jit_dither(s, uop);
+    default:                    return AVERROR(ENOTSUP);
+    }
+}
+
+/*********************************************************************/
+/* Function prologue, loop structure and epilogue */
+
+#if defined(_WIN64)
+static const int callee_saved[] = {
+    GPR_RBX, GPR_RBP, GPR_RDI, GPR_RSI, GPR_R12, GPR_R13, GPR_R14, GPR_R15,
+};
+#define FRAME_SIZE (LOCALS_SIZE + 10 * 16) /* + xmm6-xmm15 */
+#else
+static const int callee_saved[] = {
+    GPR_RBX, GPR_RBP, GPR_R12, GPR_R13, GPR_R14, GPR_R15,
+};
+#define FRAME_SIZE LOCALS_SIZE
+#endif
+
+/* Registers available for plane pointers */
+static const int ptr_regs[] = {
+    GPR_R8, GPR_R9, GPR_R10, GPR_RBX, GPR_RBP, GPR_R12, GPR_R13, GPR_R14, GPR_R15,
+};
+
+static int jit_assemble(JitContext *s, const SwsUOpList *uops)
+{
+    SwsCompMask planes_in = 0, planes_out = 0;
+    for (int i = 0; i < uops->num_ops; i++) {
+        const SwsUOp *uop = &uops->ops[i];
+        switch (uop->uop) {
+        case SWS_UOP_READ_PLANAR:   planes_in  |= uop->mask;   break;
+        case SWS_UOP_READ_PACKED:   planes_in  |= SWS_COMP(0); break;
+        case SWS_UOP_WRITE_PLANAR:  planes_out |= uop->mask;   break;
+        case SWS_UOP_WRITE_PACKED:  planes_out |= SWS_COMP(0); break;
+        case SWS_UOP_RW_SHUFFLE:
+            planes_in  |= SWS_COMP(0);
+            planes_out |= SWS_COMP(0);
+            break;
+        }
+    }
+
+    int num_ptrs = 0;
+    for (int i = 0; i < 4; i++) {
+        s->in[i] = s->out[i] = -1;
+        s->comp[i] = -1;
+    }
+    LOOP_MASK(planes_in, i)
+        s->in[i] = ptr_regs[num_ptrs++];
+    LOOP_MASK(planes_out, i)
+        s->out[i] = ptr_regs[num_ptrs++];
+
+    /* Prologue */
+    for (int i = 0; i < FF_ARRAY_ELEMS(callee_saved); i++)
+        push(s, callee_saved[i]);
+    sub_imm64(s, GPR_RSP, FRAME_SIZE);
+
+#if defined(_WIN64)
+    for (int i = 0; i < 10; i++) /* vmovdqu [rsp + off], xmm(6 + i) */
+        vex_rm(s, VMOVDQU_ST, 0, 6 + i, 0, MEM(GPR_RSP, LOCALS_SIZE + 16 * i));
+    /* Move arguments to their SysV locations */
+    const int args = FRAME_SIZE + 8 * FF_ARRAY_ELEMS(callee_saved) + 8 + 32;
+    mov_rr64(s, GPR_RDI, GPR_RCX);
+    mov_rr64(s, GPR_RSI, GPR_RDX);
+    mov_rr32(s, GPR_RDX, GPR_R8);
+    mov_rr32(s, GPR_RCX, GPR_R9);
+    mov_ld32(s, GPR_R8, MEM(GPR_RSP, args));
+    mov_ld32(s, GPR_R9, MEM(GPR_RSP, args + 8));
+#endif
+
+    /* rdi = exec, rsi = priv, edx = bx_start, ecx = y, r8d = bx_end, r9d = y_end */
+    mov_st32(s, MEM(GPR_RSP, SLOT_BX_START), GPR_RDX);
+    mov_st32(s, MEM(GPR_RSP, SLOT_BX_END),   GPR_R8);
+    mov_st32(s, MEM(GPR_RSP, SLOT_Y_END),    GPR_R9);
+    mov_ld64(s, REG_CONSTS, MEM(GPR_RSI, offsetof(JitPriv, consts)));
+    mov_rr32(s, REG_BX, GPR_RDX);
+
+    cmp_ld32(s, REG_BX, MEM(GPR_RSP, SLOT_BX_END));
+    const unsigned skip_x = jcc(s, CC_GE);
+    cmp_ld32(s, REG_Y, MEM(GPR_RSP, SLOT_Y_END));
+    const unsigned skip_y = jcc(s, CC_GE);
+
+    for (int i = 0; i < 4; i++) {
+        if (s->in[i] >= 0)
+            mov_ld64(s, s->in[i], MEM(REG_EXEC, offsetof(SwsOpExec, in[i])));
+        if (s->out[i] >= 0)
+            mov_ld64(s, s->out[i], MEM(REG_EXEC, offsetof(SwsOpExec, out[i])));
+    }
+
+    /* Loop body */
+    const unsigned loop = s->code_size;
+    for (int i = 0; i < uops->num_ops; i++) {
+        int ret = jit_uop(s, &uops->ops[i]);
+        if (ret < 0)
+            return ret;
+        if (s->err < 0)
+            return s->err;
+    }
+
+    inc32(s, REG_BX);
+    cmp_ld32(s, REG_BX, MEM(GPR_RSP, SLOT_BX_END));
+    patch(s, jcc(s, CC_L), loop);
+
+    /* End of line */
+    inc32(s, REG_Y);
+    cmp_ld32(s, REG_Y, MEM(GPR_RSP, SLOT_Y_END));
+    const unsigned done = jcc(s, CC_GE);
+
+    for (int i = 0; i < 4; i++) {
+        if (s->in[i] >= 0)
+            add_ld64(s, s->in[i], MEM(REG_EXEC, offsetof(SwsOpExec, in_bump[i])));
+        if (s->out[i] >= 0)
+            add_ld64(s, s->out[i], MEM(REG_EXEC, offsetof(SwsOpExec, out_bump[i])));
+    }
+
+    unsigned skip_bump_y = 0;
+    if (planes_in) {
+        /* Conditionally apply the (signed) y bump of the finished line */
+        mov_ld64(s, REG_TMP0, MEM(REG_EXEC, offsetof(SwsOpExec, in_bump_y)));
+        test_rr64(s, REG_TMP0, REG_TMP0);
+        skip_bump_y = jcc(s, CC_E);
+        movsxd_ld(s, REG_TMP0, MEMX(REG_TMP0, REG_Y, 2, -4));
+        LOOP_MASK(planes_in, i) {
+            mov_rr64(s, REG_TMP1, REG_TMP0);
+            imul_ld64(s, REG_TMP1, MEM(REG_EXEC, offsetof(SwsOpExec, in_stride[i])));
+            add_rr64(s, s->in[i], REG_TMP1);
+        }
+        patch(s, skip_bump_y, s->code_size);
+    }
+
+    mov_ld32(s, REG_BX, MEM(GPR_RSP, SLOT_BX_START));
+    patch(s, jmp(s), loop);
+
+    /* Epilogue */
+    patch(s, skip_x, s->code_size);
+    patch(s, skip_y, s->code_size);
+    patch(s, done,   s->code_size);
+    vzeroupper(s);
+#if defined(_WIN64)
+    for (int i = 0; i < 10; i++)
+        vex_rm(s, VMOVDQU_LD, 0, 6 + i, 0, MEM(GPR_RSP, LOCALS_SIZE + 16 * i));
+#endif
+    add_imm64(s, GPR_RSP, FRAME_SIZE);
+    for (int i = FF_ARRAY_ELEMS(callee_saved) - 1; i >= 0; i--)
+        pop(s, callee_saved[i]);
+    emit(s, 0xC3); /* ret */
+
+    return s->err;
+}
+
+/*********************************************************************/
+static void jit_free(void *ptr)
+{
+    JitPriv *priv = ptr;
+    if (!priv)
+        return;
+
+    ff_sws_jit_free(priv->code, priv->code_size);
+    av_free(priv->consts);
+    av_free(priv);
+}
+
+static SwsPixelType uop_output_type(const SwsUOp *uop)
+{
+    switch (uop->uop) {
+    case SWS_UOP_TO_U8:         return SWS_PIXEL_U8;
+    case SWS_UOP_TO_U16:        return SWS_PIXEL_U16;
+    case SWS_UOP_TO_U32:        return SWS_PIXEL_U32;
+    case SWS_UOP_TO_F32:        return SWS_PIXEL_F32;
+    case SWS_UOP_EXPAND_PAIR:   return SWS_PIXEL_U16;
+    case SWS_UOP_EXPAND_QUAD:   return SWS_PIXEL_U32;
+    default:                    return uop->type;
+    }
+}
+
+static int compile_uops_jit(SwsContext *ctx, const SwsUOpList *uops,
+                            SwsCompiledOp *out)
+{
+    const int cpu_flags = av_get_cpu_flags();
+    if (!(cpu_flags & AV_CPU_FLAG_AVX2))
+        return AVERROR(ENOTSUP);
+
+    int pixel_size_max = 1;
+    for (int i = 0; i < uops->num_ops; i++) {
+        const SwsUOp *uop = &uops->ops[i];
+        if (uop->uop == SWS_UOP_RW_SHUFFLE && uops->num_ops > 1)
+            return AVERROR(ENOTSUP); /* sets its own block size */
+        pixel_size_max = FFMAX(pixel_size_max, ff_sws_pixel_type_size(uop->type));
+        pixel_size_max = FFMAX(pixel_size_max,
+                               ff_sws_pixel_type_size(uop_output_type(uop)));
+    }
+
+    JitContext s = {
+        /* One YMM register per component at the widest precision */
+        .block_size = 32 / pixel_size_max,
+        .cpu_flags  = AV_CPU_FLAG_AVX2,
+    };
+
+    JitPriv *priv = NULL;
+    int ret = jit_assemble(&s, uops);
+    if (ret < 0)
+        goto fail;
+
+    priv = av_mallocz(sizeof(*priv));
+    if (!priv) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    if (s.consts_size) {
+        priv->consts = av_memdup(s.consts, s.consts_size);
+        if (!priv->consts) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+    }
+
+    priv->code = ff_sws_jit_alloc(s.code_size);
+    if (!priv->code) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    priv->code_size = s.code_size;
+    memcpy(priv->code, s.code, s.code_size);
+    ret = ff_sws_jit_protect(priv->code, priv->code_size);
+    if (ret < 0)
+        goto fail;
+
+    *out = (SwsCompiledOp) {
+        .func        = (SwsOpFunc) priv->code,
+        .block_size  = s.block_size,
+        .slice_align = 1,
+        .cpu_flags   = s.cpu_flags,
+        .priv        = priv,
+        .free        = jit_free,
+    };
+
+    memcpy(out->over_read,  s.over_read,  sizeof(out->over_read));
+    memcpy(out->over_write, s.over_write, sizeof(out->over_write));
+
+    av_log(ctx, AV_LOG_DEBUG, "Compiled micro-ops into %u bytes of code:\n",
+           s.code_size);
+    for (int i = 0; i < uops->num_ops; i++) {
+        char name[SWS_UOP_NAME_MAX];
+        ff_sws_uop_name(&uops->ops[i], name);
+        av_log(ctx, AV_LOG_DEBUG, "    %s\n", name);
+    }
+
+    av_free(s.code);
+    av_free(s.consts);
+    return 0;
+
+fail:
+    jit_free(priv);
+    av_free(s.code);
+    av_free(s.consts);
+    return ret;
+}
+
+static int compile_jit(SwsContext *ctx, const SwsOpList *ops, SwsCompiledOp *out)
+{
+    SwsUOpList *uops = ff_sws_uop_list_alloc();
+    if (!uops)
+        return AVERROR(ENOMEM);
+
+    int ret = ff_sws_ops_translate(ctx, ops, SWS_UOP_FLAG_PSHUFB, uops);
+    if (ret < 0)
+        goto fail;
+
+    ret = compile_uops_jit(ctx, uops, out);
+
+fail:
+    ff_sws_uop_list_free(&uops);
+    return ret;
+}
+
+const SwsOpBackend backend_x86_jit = {
+    .name           = "x86_jit",
+    .flags          = SWS_BACKEND_X86,
+    .compile        = compile_jit,
+    .compile_uops   = compile_uops_jit,
+    .hw_format      = AV_PIX_FMT_NONE,
+};
@@ -0,0 +1,198 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * fftools thread queue test and throughput benchmark
+ *
+ * For every producer count from 1 to max_producers, sends nb_packets packets
+ * from each producer thread through a single queue, checks that every stream
+ * is received complete and in order, and prints the achieved throughput.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavcodec/packet.h"
+#include "libavutil/error.h"
+#include "libavutil/log.h"
+#include "libavutil/macros.h"
+#include "libavutil/thread.h" // not public
+#include "libavutil/time.h"
+
+#include "fftools/thread_queue.h"
+
+struct producer {
+    pthread_t tid;
+    unsigned int idx;
+    int nb_packets;
+    ThreadQueue *queue;
+    int ret;
+};
+
+static void *producer_thread(void *arg)
+{
+    struct producer *p = arg;
+    AVPacket *pkt = av_packet_alloc();
+    int ret = 0;
+
+    if (!pkt) {
+        ret = AVERROR(ENOMEM);
+        goto finish;
+    }
+
+    for (int i = 0; i < p->nb_packets; i++) {
+        pkt->pts = i;
+        ret = tq_send(p->queue, p->idx, pkt);
+        if (ret < 0)
+            break;
+    }
+
+finish:
+    tq_send_finish(p->queue, p->idx);
+    av_packet_free(&pkt);
+    p->ret = ret;
+    return NULL;
+}
+
+static int run(int nb_producers, int nb_packets, int queue_size)
+{
+    struct producer *producers;
+    int64_t *next_pts;
+    ThreadQueue *queue;
+    AVPacket *pkt;
+    int64_t t0, t1, total = 0;
+    int nb_eof = 0, ret = 0;
+
+    producers = calloc(nb_producers, sizeof(*producers));
+    next_pts  = calloc(nb_producers, sizeof(*next_pts));
+    queue     = tq_alloc(nb_producers, queue_size, THREAD_QUEUE_PACKETS);
+    pkt       = av_packet_alloc();
+    if (!producers || !next_pts || !queue || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    t0 = av_gettime_relative();
+
+    for (int i = 0; i < nb_producers; i++) {
+        struct producer *p = &producers[i];
+
+        p->idx        = i;
+        p->nb_packets = nb_packets;
+        p->queue      = queue;
+        ret = pthread_create(&p->tid, NULL, producer_thread, p);
+        if (ret) {
+            av_log(NULL, AV_LOG_ERROR, "Unable to start producer thread\n");
+            ret = AVERROR(ret);
+            for (int j = i; j < nb_producers; j++)
+                tq_send_finish(queue, j);
+            nb_producers = i;
+            goto join;
+        }
+    }
+
+    while (1) {
+        int stream_idx;
+
+        ret = tq_receive(queue, &stream_idx, pkt, 0);
+        if (ret == AVERROR_EOF && stream_idx < 0) {
+            ret = 0;
+            break;
+        } else if (ret == AVERROR_EOF) {
+            if (next_pts[stream_idx] != nb_packets) {
+                av_log(NULL, AV_LOG_ERROR, "Stream %d: EOF after %"PRId64" "
+                       "of %d packets\n", stream_idx, next_pts[stream_idx],
+                       nb_packets);
+                ret = AVERROR_BUG;
+            }
+            nb_eof++;
+            continue;
+        } else if (ret < 0)
+            break;
+
+        if (pkt->pts != next_pts[stream_idx]) {
+            av_log(NULL, AV_LOG_ERROR, "Stream %d: got packet %"PRId64", "
+                   "expected %"PRId64"\n", stream_idx, pkt->pts,
+                   next_pts[stream_idx]);
+            ret = AVERROR_BUG;
+        }
+        next_pts[stream_idx] = pkt->pts + 1;
+        av_packet_unref(pkt);
+        total++;
+    }
+
+    t1 = av_gettime_relative();
+
+    if (!ret && nb_eof != nb_producers) {
+        av_log(NULL, AV_LOG_ERROR, "Got %d stream EOFs, expected %d\n",
+               nb_eof, nb_producers);
+        ret = AVERROR_BUG;
+    }
+
+    av_log(NULL, AV_LOG_INFO, "%2d producer(s): %"PRId64" packets in %"PRId64" us, "
+           "%.0f packets/s\n", nb_producers, total, t1 - t0,
+           total * 1e6 / FFMAX(t1 - t0, 1));
+
+join:
+    for (int i = 0; i < nb_producers; i++) {
+        pthread_join(producers[i].tid, NULL);
+        if (producers[i].ret < 0 && !ret)
+            ret = producers[i].ret;
+    }
+
+end:
+    av_packet_free(&pkt);
+    tq_free(&queue);
+    free(next_pts);
+    free(producers);
+    return ret;
+}
+
+int main(int ac, char **av)
+{
+    int max_producers, nb_packets, queue_size;
+
+    if (ac != 4) {
+        av_log(NULL, AV_LOG_ERROR, "%s <max_producers> <nb_packets> <queue_size>\n",
+               av[0]);
+        return 1;
+    }
+
+    max_producers = atoi(av[1]);
+    nb_packets    = atoi(av[2]);
+    queue_size    = atoi(av[3]);
+
+    if (max_producers <= 0 || nb_packets < 0 || queue_size <= 0) {
+        av_log(NULL, AV_LOG_ERROR, "Invalid arguments\n");
+        return 1;
+    }
+
+    for (int n = 1; n <= max_producers; n++) {
+        int ret = run(n, nb_packets, queue_size);
+        if (ret < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Test failed with %d producer(s): %s\n",
+                   n, av_err2str(ret));
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -89,6 +89,38 @@ static void check_ict_float(void)
     bench_new(new0, new1, new2, BUF_SIZE);
 }
 
+/* 4 interleaved lines of up to BUF_SIZE samples, extended by 5 on each side */
+#define DWT_SIZE ((BUF_SIZE + 12) * 4)
+
+static void check_dwt_lift(int type)
+{
+    LOCAL_ALIGNED_16(int32_t, src, [DWT_SIZE]);
+    LOCAL_ALIGNED_16(int32_t, ref, [DWT_SIZE]);
+    LOCAL_ALIGNED_16(int32_t, new, [DWT_SIZE]);
+    float *srcf = (float *)src, *reff = (float *)ref, *newf = (float *)new;
+    int i0 = rnd() & 1;
+    int i1 = i0 + 2 + rnd() % (BUF_SIZE - 2);
+    int i;
+
+    declare_func(void, void *p, int i0, int i1);
+
+    for (i = 0; i < DWT_SIZE; i++) {
+        if (type == FF_DWT97)
+            srcf[i] = (float)rnd() / (UINT_MAX >> 5);
+        else
+            src[i] = (int32_t)rnd() >> 8;
+    }
+    memcpy(ref, src, DWT_SIZE * sizeof(*src));
+    memcpy(new, src, DWT_SIZE * sizeof(*src));
+    call_ref(ref + 5 * 4, i0, i1);
+    call_new(new + 5 * 4, i0, i1);
+    if (type == FF_DWT97 ? !float_near_abs_eps_array(reff, newf, 1.0e-4, DWT_SIZE)
+                         : memcmp(ref, new, DWT_SIZE * sizeof(*src)))
+        fail();
+    memcpy(new, src, DWT_SIZE * sizeof(*src));
+    bench_new(new + 5 * 4, 0, BUF_SIZE);
+}
+
 void checkasm_check_jpeg2000dsp(void)
 {
     Jpeg2000DSPContext h;
@@ -101,4 +133,11 @@ void checkasm_check_jpeg2000dsp(void)
         check_ict_float();
 
     report("mct_decode");
+
+    if (check_func(h.dwt_lift_x4[FF_DWT53], "jpeg2000_dwt_lift53_x4"))
+        check_dwt_lift(FF_DWT53);
+    if (check_func(h.dwt_lift_x4[FF_DWT97], "jpeg2000_dwt_lift97_float_x4"))
+        check_dwt_lift(FF_DWT97);
+
+    report("dwt_lift_x4");
 }
@@ -51,6 +51,7 @@ typedef struct Test {
     int          pixel_bits_in;     /* read pixel stride */
     int          pixel_bits_out;    /* write pixel stride */
     unsigned     ranges[NB_PLANES]; /* pixel range to fill */
+    SwsUOpFlags  flags;             /* optimizations for the tested backends */
 } Test;
 
 #define FMT(fmt, ...) tprintf((char[256]) {0}, 256, fmt, __VA_ARGS__)
@@ -161,7 +162,11 @@ static void check_compiled(const Test *test,
     static DECLARE_ALIGNED_64(char, dst0)[NB_PLANES][LINES][PIXELS * sizeof(uint32_t[4])];
     static DECLARE_ALIGNED_64(char, dst1)[NB_PLANES][LINES][PIXELS * sizeof(uint32_t[4])];
 
-    av_assert0(PIXELS % comp_new->block_size == 0);
+    /* Packed shuffles may process a number of pixels that does not divide
+     * the width, so round up to whole blocks like the dispatcher does */
+    av_assert0(PIXELS % comp_ref->block_size == 0);
+    const int num_blocks = (PIXELS + comp_new->block_size - 1) / comp_new->block_size;
+    const int pad = num_blocks * comp_new->block_size - PIXELS;
     for (int p = 0; p < NB_PLANES; p++) {
         void *plane = src0[p];
         if (!SWS_COMP_TEST(test->planes_in, p)) {
@@ -239,8 +244,10 @@ static void check_compiled(const Test *test,
         exec.out[i] = (void *) dst1[i];
         exec.block_size_in[i]  = comp_new->block_size * test->pixel_bits_in  >> 3;
         exec.block_size_out[i] = comp_new->block_size * test->pixel_bits_out >> 3;
+        exec.in_bump[i]  -= pad * test->pixel_bits_in  >> 3;
+        exec.out_bump[i] -= pad * test->pixel_bits_out >> 3;
     }
-    checkasm_call_checked(comp_new->func, &exec, comp_new->priv, 0, 0, PIXELS / comp_new->block_size, LINES);
+    checkasm_call_checked(comp_new->func, &exec, comp_new->priv, 0, 0, num_blocks, LINES);
 
     for (int i = 0; i < NB_PLANES; i++) {
         if (!SWS_COMP_TEST(test->planes_out, i))
@@ -272,7 +279,7 @@ static void check_compiled(const Test *test,
         }
     }
 
-    bench(comp_new->func, &exec, comp_new->priv, 0, 0, PIXELS / comp_new->block_size, LINES);
+    bench(comp_new->func, &exec, comp_new->priv, 0, 0, num_blocks, LINES);
 }
 
 static void run_test(const Test *test)
@@ -309,6 +316,9 @@ static void run_test(const Test *test)
         av_assert0(backend_ref);
     }
 
+    SwsUOpList *optimized = NULL;
+    const SwsUOpList *uops = &oplist;
+
     /* Always compile `ops` using the C backend as a reference */
     SwsCompiledOp comp_ref = {0};
     int ret = backend_ref->compile_uops(ctx, &oplist, &comp_ref);
@@ -321,6 +331,34 @@ static void run_test(const Test *test)
     /* Check with the C backend to establish a reference */
     check_compiled(test, &comp_ref, &comp_ref);
 
+    /* Optimize a copy of the list for the backends under test */
+    if (test->flags) {
+        optimized = ff_sws_uop_list_alloc();
+        if (!optimized) {
+            fail();
+            goto done;
+        }
+
+        for (int i = 0; i < test->num_uops; i++) {
+            SwsUOp uop = test->uops[i];
+            ret = ff_sws_uop_list_append(optimized, &uop);
+            if (ret < 0)
+                break;
+        }
+
+        if (ret >= 0)
+            ret = ff_sws_uop_list_optimize(ctx, test->flags, optimized);
+        if (ret < 0) {
+            fail();
+            goto done;
+        }
+
+        optimized->planes_in      = oplist.planes_in;
+        optimized->planes_out     = oplist.planes_out;
+        optimized->pixel_size_max = oplist.pixel_size_max;
+        uops = optimized;
+    }
+
     /* Iterate over every other backend, and test it against the C reference */
     for (int n = 0; ff_sws_op_backends[n]; n++) {
         const SwsOpBackend *backend = ff_sws_op_backends[n];
@@ -330,7 +368,7 @@ static void run_test(const Test *test)
             continue;
 
         SwsCompiledOp comp_new = {0};
-        int ret = backend->compile_uops(ctx, &oplist, &comp_new);
+        int ret = backend->compile_uops(ctx, uops, &comp_new);
         if (ret == AVERROR(ENOTSUP)) {
             continue;
         } else if (ret < 0) {
@@ -345,6 +383,7 @@ static void run_test(const Test *test)
     }
 
 done:
+    ff_sws_uop_list_free(&optimized);
     ff_sws_compiled_op_unref(&comp_ref);
     sws_free_context(&ctx);
 }
@@ -660,6 +699,80 @@ static void check_lut_3d(const char *name, SwsUOp *uop)
     av_refstruct_unref(&lut3d);
 }
 
+/* Components holding defined values after reading `elems` and running `uop` */
+static SwsCompMask shuffle_defined(const SwsUOp *uop, int elems)
+{
+    SwsCompMask mask = SWS_COMP_ELEMS(elems);
+    if (uop->uop == SWS_UOP_CLEAR)
+        return mask | uop->mask;
+
+    bool tmp = false;
+    for (int i = 0; i < uop->par.move.num_moves; i++) {
+        const int dst = uop->par.move.dst[i];
+        const int src = uop->par.move.src[i];
+        const bool defined = src < 0 ? tmp : SWS_COMP_TEST(mask, src);
+        if (dst < 0)
+            tmp = defined;
+        else if (defined)
+            mask |= SWS_COMP(dst);
+        else
+            mask &= ~SWS_COMP(dst);
+    }
+
+    /* Permutes only keep the components in their mask */
+    return uop->uop == SWS_UOP_PERMUTE ? mask & uop->mask : mask;
+}
+
+static void check_shuffle(const char *name, SwsUOp *uop)
+{
+    if (uop->uop == SWS_UOP_CLEAR) {
+        for (int i = 0; i < 4; i++) {
+            const int val = SWS_COMP_TEST(uop->par.clear.one,  i) ? 0xFF :
+                            SWS_COMP_TEST(uop->par.clear.zero, i) ? 0 : rnd();
+            uop->data.vec4[i] = constpx(uop->type, val & 0xFF);
+        }
+    }
+
+    /* Wrap the uop in packed reads/writes of 3 or 4 components, which the
+     * optimizer fuses into a single SWS_UOP_RW_SHUFFLE for the backends
+     * under test, while the C reference runs the uops as-is */
+    for (int elems_in = 3; elems_in <= 4; elems_in++) {
+        const SwsCompMask defined = shuffle_defined(uop, elems_in);
+        for (int elems_out = 3; elems_out <= 4; elems_out++) {
+            const SwsCompMask mask_out = SWS_COMP_ELEMS(elems_out);
+            if ((defined & mask_out) != mask_out)
+                continue;
+
+            const Test t = {
+                .name           = FMT("shuffle_%s_%d_%d", name, elems_in, elems_out),
+                .num_uops       = 3,
+                .type_in        = SWS_PIXEL_U8,
+                .type_out       = SWS_PIXEL_U8,
+                .planes_in      = SWS_COMP(0),
+                .planes_out     = SWS_COMP(0),
+                .pixel_bits_in  = 8 * elems_in,
+                .pixel_bits_out = 8 * elems_out,
+                .flags          = SWS_UOP_FLAG_PSHUFB,
+                .uops = {
+                    {
+                        .type = SWS_PIXEL_U8,
+                        .uop  = SWS_UOP_READ_PACKED,
+                        .mask = SWS_COMP_ELEMS(elems_in),
+                    },
+                    *uop,
+                    {
+                        .type = SWS_PIXEL_U8,
+                        .uop  = SWS_UOP_WRITE_PACKED,
+                        .mask = mask_out,
+                    },
+                },
+            };
+
+            run_test(&t);
+        }
+    }
+}
+
 #define CHECK_FUNCTION(CHECK, NAME, ...) \
     CHECK(#NAME, &(SwsUOp) { __VA_ARGS__ });
 
@@ -705,4 +818,9 @@ void checkasm_check_sw_ops(void)
     CHECK_FOR(LINEAR,           check_linear);
     CHECK_FOR(DITHER,           check_dither);
     CHECK_FOR(LUT_3D,           check_lut_3d);
+
+    SWS_FOR_STRUCT(U8, PERMUTE, CHECK_FUNCTION, check_shuffle)
+    SWS_FOR_STRUCT(U8, COPY,    CHECK_FUNCTION, check_shuffle)
+    SWS_FOR_STRUCT(U8, CLEAR,   CHECK_FUNCTION, check_shuffle)
+    report("RW_SHUFFLE");
 }
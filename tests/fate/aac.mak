@@ -213,6 +213,20 @@ fate-aac-aref-encode: CMP_TARGET = 596
 fate-aac-aref-encode: SIZE_TOLERANCE = 2464
 fate-aac-aref-encode: FUZZ = 89
 
+# the NMR coder searches the bands of each channel on the slice threads,
+# the bitstream must be the same as with one thread
+AAC_NMR_ENCODE = -c:a aac -aac_coder nmr -b:a 512k -fflags +bitexact -flags +bitexact
+
+tests/data/aac-aref-nmr-encode.md5: TAG = GEN
+tests/data/aac-aref-nmr-encode.md5: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/asynth-44100-2.wav | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav \
+	$(AAC_NMR_ENCODE) -threads 1 -f md5 -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_AAC_ENCODE-$(call ENCMUX, AAC, MD5, WAV_DEMUXER PCM_S16LE_DECODER ARESAMPLE_FILTER PIPE_PROTOCOL) += fate-aac-aref-threads-encode
+fate-aac-aref-threads-encode: tests/data/aac-aref-nmr-encode.md5
+fate-aac-aref-threads-encode: CMD = fmtstdout md5 -auto_conversion_filters -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav $(AAC_NMR_ENCODE) -threads 2 -thread_type slice
+fate-aac-aref-threads-encode: REF = tests/data/aac-aref-nmr-encode.md5
+
 FATE_AAC_ENCODE += fate-aac-ln-encode
 fate-aac-ln-encode: CMD = enc_dec_pcm mp4 wav s16le $(TARGET_SAMPLES)/audio-reference/luckynight_2ch_44kHz_s16.wav -c:a aac -aac_coder fast -aac_is 0 -aac_pns 0 -aac_ms 0 -aac_tns 0 -b:a 512k -fflags +bitexact -flags +bitexact
 fate-aac-ln-encode: CMP = stddev
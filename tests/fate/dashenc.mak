@@ -24,5 +24,24 @@ fate-dash-mpd-timing: tests/data/dash_mpd_timing.mpd
 fate-dash-mpd-timing: CMD = sed -n -e /suggestedPresentationDelay=/p -e /availabilityStartTime=/p $(TARGET_PATH)/tests/data/dash_mpd_timing.mpd
 fate-dash-mpd-timing: CMP = diff
 
+# the same output written with and without async_io, removing segments
+# that leave the window
+tests/data/dash_window_%/out.mpd: TAG = GEN
+tests/data/dash_window_%/out.mpd: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(RM) -r $(TARGET_PATH)/tests/data/dash_window_$*
+	$(M)mkdir -p $(TARGET_PATH)/tests/data/dash_window_$* && \
+	$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin -loglevel error \
+	-f lavfi -i "testsrc2=size=128x72:rate=5:d=5" -f lavfi -i "sine=d=5" -map 0:v -map 1:a \
+	-c:v mpeg4 -g 5 -c:a aac -flags +bitexact -fflags +bitexact \
+	-seg_duration 1 -window_size 2 -extra_window_size 1 -async_io $(if $(filter async,$*),1,0) \
+	-f dash $(TARGET_PATH)/tests/data/dash_window_$*/out.mpd
+
+FATE_DASHENC_LAVFI-$(call ALLYES, TESTSRC2_FILTER SINE_FILTER LAVFI_INDEV MPEG4_ENCODER AAC_ENCODER DASH_MUXER MP4_MUXER FILE_PROTOCOL) += fate-dash-window fate-dash-window-async-io
+fate-dash-window: tests/data/dash_window_sync/out.mpd
+fate-dash-window: CMD = cat $(TARGET_PATH)/tests/data/dash_window_sync/out.mpd && ls $(TARGET_PATH)/tests/data/dash_window_sync
+fate-dash-window-async-io: tests/data/dash_window_async/out.mpd
+fate-dash-window-async-io: CMD = cat $(TARGET_PATH)/tests/data/dash_window_async/out.mpd && ls $(TARGET_PATH)/tests/data/dash_window_async
+fate-dash-window-async-io: REF = $(SRC_PATH)/tests/ref/fate/dash-window
+
 FATE_FFMPEG += $(FATE_DASHENC_LAVFI-yes)
 fate-dashenc: $(FATE_DASHENC_LAVFI-yes)
@@ -23,6 +23,22 @@ fate-force_key_frames: CMD = enc_dec \
   avi "-c mpeg4 -g 240 -qscale 10 -force_key_frames 0.5,0:00:01.5" \
   framecrc "" "-skip_frame nokey"
 
+# restart the encoder midway while the scaler writes into encoder-owned frames
+FATE_FFMPEG-$(call ENCDEC2, MPEG4, RAWVIDEO, AVI, RAWVIDEO_DEMUXER SCALE_FILTER FRAMECRC_MUXER) += fate-ffmpeg-enc-reinit
+fate-ffmpeg-enc-reinit: tests/data/vsynth1.yuv
+fate-ffmpeg-enc-reinit: CMD = framecrc -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+  -frames:v 10 -vf scale=176:144 -sws_flags +accurate_rnd+bitexact -flags +bitexact -threads 1 \
+  -c:v mpeg4 -qscale 10 -reinit_opts "pts=200000|force_reinit=1"
+
+# slice threaded filters and encoders running on the shared pool of
+# the thread budget must produce the same output as single-threaded ones
+FATE_FFMPEG-$(call ENCDEC, MPEG2VIDEO RAWVIDEO, FRAMECRC RAWVIDEO, HFLIP_FILTER SCALE_FILTER) += fate-ffmpeg-threads-budget
+fate-ffmpeg-threads-budget: tests/data/vsynth1.yuv
+fate-ffmpeg-threads-budget: CMD = framecrc -threads_budget 3 \
+  -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+  -frames:v 10 -vf hflip,scale=176:144 -sws_flags +accurate_rnd+bitexact -flags +bitexact \
+  -c:v mpeg2video -slices 4 -qscale 10
+
 # test -force_key_frames source with and without framerate conversion
 # * we don't care about the actual video content, so replace it with
 #   a 2x2 black square to speed up encoding
@@ -248,6 +264,12 @@ fate-ffmpeg-no-overwrite: CMP = null
 fate-ffmpeg-no-overwrite: CMD = out=tests/data/fate/no-overwrite.wav; touch $$out; ffmpeg -f lavfi -i anullsrc -t 0.01 -c:a pcm_u8 -f wav -n $$out; ret=$$?; rm -f $$out; test $$ret -ne 0
 FATE_FFMPEG-$(call ALLYES, LAVFI_INDEV ANULLSRC_FILTER PCM_U8_DECODER PCM_U8_ENCODER WAV_MUXER FILE_PROTOCOL) += fate-ffmpeg-no-overwrite
 
+# -shortest with -low_latency runs without sync queues and ends the output
+# when its first stream ends; the sine input never ends on its own
+fate-ffmpeg-low-latency-shortest: CMD = run_with_temp "$(FFMPEG) -nostdin -hide_banner -loglevel error -low_latency -f lavfi -i testsrc=size=64x64:rate=25:duration=1 -f lavfi -i sine -map 0 -map 1 -c:v rawvideo -c:a pcm_s16le -shortest -f nut -y" "ffprobe$(PROGSSUF)$(EXESUF) -bitexact -select_streams v -count_packets -show_entries stream=codec_type,nb_read_packets -of compact=p=0:nk=1" nut
+FATE_FFMPEG_LOW_LATENCY-$(call ALLYES, LAVFI_INDEV TESTSRC_FILTER SINE_FILTER RAWVIDEO_DECODER RAWVIDEO_ENCODER PCM_S16LE_DECODER PCM_S16LE_ENCODER NUT_MUXER NUT_DEMUXER FILE_PROTOCOL) += fate-ffmpeg-low-latency-shortest
+FATE_FFMPEG_FFPROBE += $(FATE_FFMPEG_LOW_LATENCY-yes)
+
 # test input -bsf
 # use -stream_loop, because it tests flushing bsfs
 fate-ffmpeg-bsf-input: CMD = framecrc -stream_loop 2 -bsf setts=PTS*2 -i $(TARGET_SAMPLES)/hevc/extradata-reload-multi-stsd.mov -c copy
@@ -263,6 +285,22 @@ fate-ffmpeg-filter-in-eof: CMD = framecrc
     -filter_complex "[0][1]concat" -c:v rawvideo
 FATE_FFMPEG-$(call FRAMECRC, RAWVIDEO, RAWVIDEO, CONCAT_FILTER) += fate-ffmpeg-filter-in-eof
 
+# Filter frames on frame threads, the output must match the one of the
+# filtergraph running on a single thread.
+FFMPEG_FILTER_FRAME_THREADS = -f rawvideo -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+    -frames:v 10 -vf scale=176:144,yadif,hflip,negate,unsharp,transpose -sws_flags neighbor+bitexact            \
+    -c:v rawvideo
+
+fate-ffmpeg-filter-frame-threads-serial: tests/data/vsynth1.yuv
+fate-ffmpeg-filter-frame-threads-serial: CMD = framecrc $(FFMPEG_FILTER_FRAME_THREADS)
+
+fate-ffmpeg-filter-frame-threads: tests/data/vsynth1.yuv
+fate-ffmpeg-filter-frame-threads: CMD = framecrc -filter_frame_threads 3 -filter_threads 2 $(FFMPEG_FILTER_FRAME_THREADS)
+fate-ffmpeg-filter-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/ffmpeg-filter-frame-threads-serial
+
+FATE_FFMPEG-$(call FRAMECRC, RAWVIDEO, RAWVIDEO, SCALE_FILTER YADIF_FILTER HFLIP_FILTER NEGATE_FILTER UNSHARP_FILTER TRANSPOSE_FILTER) += \
+    fate-ffmpeg-filter-frame-threads-serial fate-ffmpeg-filter-frame-threads
+
 # Test termination on streamcopy with -t as an output option.
 fate-ffmpeg-streamcopy-t: tests/data/vsynth1.yuv
 fate-ffmpeg-streamcopy-t: CMP = null
@@ -15,6 +15,12 @@ $(FFPROBE_OUTPUT_MODES_TESTS): $(FFPROBE_TEST_FILE)
 $(FFPROBE_OUTPUT_MODES_TESTS): CMD = run $(FFPROBE_COMMAND) -of $(@:fate-ffprobe_%=%)
 FFPROBE_TEST_FILE_TESTS-yes += $(FFPROBE_OUTPUT_MODES_TESTS)
 
+# decoding the streams in parallel must not change the probed parameters
+FFPROBE_TEST_FILE_TESTS-yes += fate-ffprobe_probe_threads
+fate-ffprobe_probe_threads: $(FFPROBE_TEST_FILE)
+fate-ffprobe_probe_threads: CMD = run $(FFPROBE_COMMAND) -probe_threads 3 -of default
+fate-ffprobe_probe_threads: REF = $(SRC_PATH)/tests/ref/fate/ffprobe_default
+
 FFPROBE_TEST_FILE_TESTS-$(HAVE_XMLLINT) += fate-ffprobe_xsd
 fate-ffprobe_xsd: $(FFPROBE_TEST_FILE)
 fate-ffprobe_xsd: CMD = run $(FFPROBE_COMMAND) -noprivate -of xml=q=1:x=1 | \
@@ -24,4 +30,23 @@ FATE_FFPROBE-$(call FILTERDEMDECENCMUX, AEVALSRC TESTSRC ARESAMPLE, FFMETADATA,
                                         FFMPEG LAVFI_INDEV PCM_F64BE_DECODER PCM_F64LE_DECODER PCM_S16LE_ENCODER) \
                                         += $(FFPROBE_TEST_FILE_TESTS-yes)
 
+# the audio stream starts late, after the probe size is used up by the video
+# stream, unless complete streams stop counting towards the limits; the
+# total probe size still bounds the data read
+tests/data/ffprobe-late-audio.ts: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "testsrc2=size=352x288:rate=25:d=4" -itsoffset 2 -f lavfi -i "sine=d=2" \
+        -c:v mpeg2video -g 12 -b:v 4M -c:a mp2 -flags +bitexact -fflags +bitexact \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_FFPROBE_LATE_AUDIO = fate-ffprobe-probe-per-stream fate-ffprobe-probe-total-size
+FATE_FFPROBE-$(call ALLYES, TESTSRC2_FILTER SINE_FILTER LAVFI_INDEV FFMPEG MPEG2VIDEO_ENCODER MP2_ENCODER \
+                            MPEGTS_MUXER MPEGTS_DEMUXER MPEGVIDEO_PARSER MPEGAUDIO_PARSER MPEG2VIDEO_DECODER MP2_DECODER) \
+                            += $(FATE_FFPROBE_LATE_AUDIO)
+$(FATE_FFPROBE_LATE_AUDIO): tests/data/ffprobe-late-audio.ts
+fate-ffprobe-probe-per-stream: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -probesize 400000 -probe_per_stream 1 -probe_threads 2 \
+    -show_entries stream=codec_name,sample_rate,channels -of compact $(TARGET_PATH)/tests/data/ffprobe-late-audio.ts
+fate-ffprobe-probe-total-size: CMD = run ffprobe$(PROGSSUF)$(EXESUF) -probesize 400000 -probe_per_stream 1 -probe_total_size 400000 \
+    -show_entries stream=codec_name,sample_rate,channels -of compact $(TARGET_PATH)/tests/data/ffprobe-late-audio.ts
+
 fate-ffprobe: $(FATE_FFPROBE-yes)
@@ -221,6 +221,18 @@ FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER) +=         \
 
 FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER SETPTS_FILTER) += $(HEVC_TESTS_MULTIVIEW)
 
+# tiles of single-segment pictures are decoded concurrently with slice
+# threads, the output must be the same as with one thread
+HEVC_SAMPLES_TILES = TILES_A_Cisco_2 TILES_B_Cisco_1
+HEVC_TESTS_TILES_THREADS = $(addprefix fate-hevc-tiles-threads-, $(HEVC_SAMPLES_TILES))
+
+$(HEVC_TESTS_TILES_THREADS): CMD = framecrc -i $(TARGET_SAMPLES)/hevc-conformance/$(subst fate-hevc-tiles-threads-,,$(@)).bit -pix_fmt yuv420p
+$(HEVC_TESTS_TILES_THREADS): REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(subst fate-hevc-tiles-threads-,,$(@))
+$(HEVC_TESTS_TILES_THREADS): THREADS = 4
+$(HEVC_TESTS_TILES_THREADS): THREAD_TYPE = slice
+
+FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER) += $(HEVC_TESTS_TILES_THREADS)
+
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -fps_mode passthrough -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC-$(call FRAMECRC, HEVC, HEVC, HEVC_PARSER SCALE_FILTER LARGE_TESTS) += fate-hevc-paramchange-yuv420p-yuv420p10
 
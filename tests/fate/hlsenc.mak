@@ -233,6 +233,46 @@ fate-hls-iframes-single-fmp4: tests/data/hls_iframes_single_fmp4.m3u8
 fate-hls-iframes-single-fmp4: CMD = sed -n -e /^\#EXT-X-MAP:/p -e /^\#EXT-X-BYTERANGE:/p $(TARGET_PATH)/tests/data/hls_iframes_single_fmp4.m3u8
 fate-hls-iframes-single-fmp4: CMP = diff
 
+# the same output written with and without async_io, with WebVTT segments
+tests/data/hls_vtt.srt: | tests/data
+	$(M)printf "1\n00:00:00,500 --> 00:00:01,500\nfirst\n\n2\n00:00:01,800 --> 00:00:02,600\nsecond\n" > $(TARGET_PATH)/$@
+
+tests/data/hls_vtt_%/out.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/hls_vtt.srt | tests/data
+	$(RM) -r $(TARGET_PATH)/tests/data/hls_vtt_$*
+	$(M)mkdir -p $(TARGET_PATH)/tests/data/hls_vtt_$* && \
+	$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "testsrc2=size=128x72:rate=1:d=3" -i $(TARGET_PATH)/tests/data/hls_vtt.srt \
+	-f hls -hls_time 1 -map 0:v -map 1 -hls_list_size 0 -c:v mpeg2video -g 1 -c:s webvtt \
+	-async_io $(if $(filter async,$*),1,0) \
+	-hls_segment_filename $(TARGET_PATH)/tests/data/hls_vtt_$*/out_%d.ts \
+	$(TARGET_PATH)/tests/data/hls_vtt_$*/out.m3u8 2>/dev/null
+
+FATE_HLSENC_LAVFI-$(call ALLYES, TESTSRC2_FILTER LAVFI_INDEV MPEG2VIDEO_ENCODER SRT_DEMUXER SUBRIP_DECODER WEBVTT_ENCODER HLS_MUXER MPEGTS_MUXER WEBVTT_MUXER FILE_PROTOCOL) += fate-hls-vtt fate-hls-vtt-async-io
+fate-hls-vtt: tests/data/hls_vtt_sync/out.m3u8
+fate-hls-vtt: CMD = cat $(TARGET_PATH)/tests/data/hls_vtt_sync/out.m3u8 $(TARGET_PATH)/tests/data/hls_vtt_sync/out_vtt.m3u8 $(TARGET_PATH)/tests/data/hls_vtt_sync/out0.vtt $(TARGET_PATH)/tests/data/hls_vtt_sync/out1.vtt $(TARGET_PATH)/tests/data/hls_vtt_sync/out2.vtt
+fate-hls-vtt-async-io: tests/data/hls_vtt_async/out.m3u8
+fate-hls-vtt-async-io: CMD = cat $(TARGET_PATH)/tests/data/hls_vtt_async/out.m3u8 $(TARGET_PATH)/tests/data/hls_vtt_async/out_vtt.m3u8 $(TARGET_PATH)/tests/data/hls_vtt_async/out0.vtt $(TARGET_PATH)/tests/data/hls_vtt_async/out1.vtt $(TARGET_PATH)/tests/data/hls_vtt_async/out2.vtt
+fate-hls-vtt-async-io: REF = $(SRC_PATH)/tests/ref/fate/hls-vtt
+
+# read a stream from a local HTTP server with segments requested ahead
+tests/data/hls_prefetch/list.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(RM) -r $(TARGET_PATH)/tests/data/hls_prefetch
+	$(M)mkdir -p $(TARGET_PATH)/tests/data/hls_prefetch && \
+	$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "aevalsrc=cos(2*PI*t)*sin(2*PI*(440+4*t)*t):d=5" -f hls -hls_time 0.5 -map 0 \
+	-hls_list_size 0 -codec:a mp2fixed \
+	-hls_segment_filename $(TARGET_PATH)/tests/data/hls_prefetch/seg_%03d.ts \
+	$(TARGET_PATH)/tests/data/hls_prefetch/list.m3u8 2>/dev/null
+
+FATE_HLSENC_LAVFI-$(call ALLYES, AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER HLS_MUXER MPEGTS_MUXER HLS_DEMUXER MPEGTS_DEMUXER HTTP_PROTOCOL FILE_PROTOCOL) += fate-hls-prefetch
+fate-hls-prefetch: tests/data/hls_prefetch/list.m3u8 libavformat/tests/hls_prefetch$(EXESUF)
+fate-hls-prefetch: CMD = run libavformat/tests/hls_prefetch$(EXESUF) $(TARGET_PATH)/tests/data/hls_prefetch/list.m3u8
+
+FATE_HLSENC_LAVFI-$(call ALLYES, AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER HLS_MUXER MPEGTS_MUXER HLS_DEMUXER MPEGTS_DEMUXER HTTP_PROTOCOL LIBCURL_PROTOCOL FILE_PROTOCOL) += fate-hls-prefetch-libcurl
+fate-hls-prefetch-libcurl: tests/data/hls_prefetch/list.m3u8 libavformat/tests/hls_prefetch$(EXESUF)
+fate-hls-prefetch-libcurl: CMD = run libavformat/tests/hls_prefetch$(EXESUF) $(TARGET_PATH)/tests/data/hls_prefetch/list.m3u8 prefer_libcurl=1
+fate-hls-prefetch-libcurl: REF = $(SRC_PATH)/tests/ref/fate/hls-prefetch
+
 FATE_HLSENC_LAVFI-yes := $(if $(call FRAMECRC), $(FATE_HLSENC_LAVFI-yes))
 
 FATE_FFMPEG += $(FATE_HLSENC_LAVFI-yes)
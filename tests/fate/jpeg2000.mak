@@ -63,7 +63,32 @@ fate-jpeg2000dec-p0_16: CMD = framecrc -flags +bitexact -i $(TARGET_SAMPLES)/jpe
 FATE_JPEG2000DEC += fate-jpeg2000dec-ds0_ht_01_b11
 fate-jpeg2000dec-ds0_ht_01_b11: CMD = framecrc -flags +bitexact -i $(TARGET_SAMPLES)/jpeg2000/itu-iso/htj2k_bsets_profile0/ds0_ht_01_b11.j2k
 
+# single-tile images are decoded with code-blocks spread over the slice
+# threads, the output must be the same as with one thread
+FATE_JPEG2000DEC += fate-jpeg2000dec-p0_01-threads
+fate-jpeg2000dec-p0_01-threads: CMD = framecrc -flags +bitexact -i $(TARGET_SAMPLES)/jpeg2000/itu-iso/codestreams_profile0/p0_01.j2k
+fate-jpeg2000dec-p0_01-threads: REF = $(SRC_PATH)/tests/ref/fate/jpeg2000dec-p0_01
+fate-jpeg2000dec-p0_01-threads: THREADS = 4
+fate-jpeg2000dec-p0_01-threads: THREAD_TYPE = slice
+
 FATE_JPEG2000DEC += $(FATE_JPEG2000DEC-yes)
 
 FATE_SAMPLES_FFMPEG-$(call FRAMECRC, IMAGE_J2K_PIPE, JPEG2000) += $(FATE_JPEG2000DEC)
-fate-jpeg2000dec: $(FATE_JPEG2000DEC)
+
+# a single-tile RGB stream, using the 9/7 transform and the MCT
+tests/data/jpeg2000_single_tile.avi: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/vsynth1.yuv | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin -f rawvideo -s 352x288 -pix_fmt yuv420p \
+	-i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 3 -pix_fmt rgb24 \
+	-sws_flags +accurate_rnd+bitexact -c:v jpeg2000 -qscale 7 -tile_width 352 -tile_height 288 -flags +bitexact \
+	-y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_JPEG2000DEC_THREADS-$(call ENCDEC, JPEG2000, AVI, RAWVIDEO_DEMUXER SCALE_FILTER FRAMECRC_MUXER PIPE_PROTOCOL) += \
+    fate-jpeg2000dec-single-tile fate-jpeg2000dec-single-tile-threads
+fate-jpeg2000dec-single-tile fate-jpeg2000dec-single-tile-threads: tests/data/jpeg2000_single_tile.avi
+fate-jpeg2000dec-single-tile fate-jpeg2000dec-single-tile-threads: CMD = framecrc -flags +bitexact -i $(TARGET_PATH)/tests/data/jpeg2000_single_tile.avi
+fate-jpeg2000dec-single-tile-threads: REF = $(SRC_PATH)/tests/ref/fate/jpeg2000dec-single-tile
+fate-jpeg2000dec-single-tile-threads: THREADS = 4
+fate-jpeg2000dec-single-tile-threads: THREAD_TYPE = slice
+
+FATE_FFMPEG += $(FATE_JPEG2000DEC_THREADS-yes)
+fate-jpeg2000dec: $(FATE_JPEG2000DEC) $(FATE_JPEG2000DEC_THREADS-yes)
@@ -37,6 +37,8 @@ FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PGM) += pgm
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += png
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += gray16be.png
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += rgb48be.png
+FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += slices.png
+FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PNG) += threads.png
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         PPM) += ppm
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,         SGI) += sgi
 FATE_LAVF_IMAGES-$(call LAVF_IMAGES,     SUNRAST) += sun
@@ -90,6 +92,8 @@ fate-lavf-gbrpf32le.pfm:   CMD = lavf_image "-pix_fmt gbrpf32le" "-pix_fmt gbrpf
 fate-lavf-gbrpf32be.pfm:   CMD = lavf_image "-pix_fmt gbrpf32be" "-pix_fmt gbrpf32be"
 fate-lavf-gray16be.png: CMD = lavf_image "-pix_fmt gray16be"
 fate-lavf-rgb48be.png: CMD = lavf_image "-pix_fmt rgb48be"
+fate-lavf-slices.png: CMD = lavf_image "-slices 4 -threads 2 -thread_type slice" "-threads 2 -thread_type slice"
+fate-lavf-threads.png: CMD = lavf_image "" "-threads 2 -thread_type slice"
 fate-lavf-rgba.xwd: CMD = lavf_image "-pix_fmt rgba"
 fate-lavf-rgb565be.xwd: CMD = lavf_image "-pix_fmt rgb565be"
 fate-lavf-rgb555be.xwd: CMD = lavf_image "-pix_fmt rgb555be"
@@ -86,6 +86,10 @@ fate-mpeg12framerate: libavcodec/tests/mpeg12framerate$(EXESUF)
 fate-mpeg12framerate: CMD = run libavcodec/tests/mpeg12framerate$(EXESUF)
 fate-mpeg12framerate: REF = /dev/null
 
+FATE_LIBAVCODEC-$(call ALLYES, PNG_ENCODER PNG_DECODER) += fate-png-restart
+fate-png-restart: libavcodec/tests/png_restart$(EXESUF)
+fate-png-restart: CMD = run libavcodec/tests/png_restart$(EXESUF)
+
 FATE_LIBAVCODEC-$(CONFIG_RANGECODER) += fate-rangecoder
 fate-rangecoder: libavcodec/tests/rangecoder$(EXESUF)
 fate-rangecoder: CMD = run libavcodec/tests/rangecoder$(EXESUF)
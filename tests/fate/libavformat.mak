@@ -32,6 +32,10 @@ FATE_LIBAVFORMAT-$(CONFIG_IMF_DEMUXER) += fate-imf
 fate-imf: libavformat/tests/imf$(EXESUF)
 fate-imf: CMD = run libavformat/tests/imf$(EXESUF)
 
+FATE_LIBAVFORMAT-$(CONFIG_URING_PROTOCOL) += fate-uring
+fate-uring: libavformat/tests/uring$(EXESUF)
+fate-uring: CMD = run libavformat/tests/uring$(EXESUF) $(TARGET_PATH)/tests/data/uring.bin
+
 FATE_LIBAVFORMAT += fate-seek_utils
 fate-seek_utils: libavformat/tests/seek_utils$(EXESUF)
 fate-seek_utils: CMD = run libavformat/tests/seek_utils$(EXESUF)
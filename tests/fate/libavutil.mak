@@ -208,6 +208,11 @@ FATE_LIBAVUTIL += fate-tdrdi
 fate-tdrdi: libavutil/tests/tdrdi$(EXESUF)
 fate-tdrdi: CMD = run libavutil/tests/tdrdi$(EXESUF)
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-threadpool
+fate-threadpool: libavutil/tests/threadpool$(EXESUF)
+fate-threadpool: CMD = run libavutil/tests/threadpool$(EXESUF)
+fate-threadpool: CMP = null
+
 FATE_LIBAVUTIL += fate-tree
 fate-tree: libavutil/tests/tree$(EXESUF)
 fate-tree: CMD = run libavutil/tests/tree$(EXESUF)
@@ -41,6 +41,11 @@ FATE_LIBSWSCALE-$(CONFIG_UNSTABLE) += fate-sws-unstable
 fate-sws-unstable: libswscale/tests/swscale$(EXESUF)
 fate-sws-unstable: CMD = run libswscale/tests/swscale$(EXESUF) -backends unstable -p 0.02 -v 16
 
+# Check that batch conversion with frame threading matches single frame output
+FATE_LIBSWSCALE-$(CONFIG_UNSTABLE) += fate-sws-batch
+fate-sws-batch: libswscale/tests/swscale$(EXESUF)
+fate-sws-batch: CMD = run libswscale/tests/swscale$(EXESUF) -backends unstable -p 0.01 -batch 3 -threads 2 -v 16
+
 ifneq ($(HAVE_BIGENDIAN),yes)
 
 # Disable on big endian because big endian platforms generate different op
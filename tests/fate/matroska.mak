@@ -339,8 +339,15 @@ fate-matroska-reenc-delete-metadata-filter-output: CMD = transcode matroska $(TA
 FATE_MATROSKA_FFMPEG_FFPROBE-$(call TRANSCODE, MPEG2VIDEO HEVC, NUT MATROSKA, SCALE_FILTER) += fate-matroska-reenc-chapter-nofilter
 fate-matroska-reenc-chapter-nofilter: CMD = transcode matroska $(TARGET_SAMPLES)/mkv/hdr10tags-both.mkv nut "-map 0:v:0 -vf scale=iw:ih -c:v mpeg2video -bitexact -metadata:c:0 NUMBER_OF_FRAMES=test" "-c copy -t 0.1" "-show_entries chapter_tags" "" "" "" null
 
+# Blocks of discarded tracks are skipped without being read.
+FATE_MATROSKA_FFMPEG-$(call TRANSCODE, PCM_S16LE PCM_S16BE, MATROSKA, WAV_DEMUXER) \
+                += fate-matroska-discard
+fate-matroska-discard: tests/data/asynth-44100-2.wav
+fate-matroska-discard: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-2.wav matroska "-map 0 -map 0 -c:a:0 pcm_s16le -c:a:1 pcm_s16be" "-map 0:a:1 -c copy"
+
 FATE_SAMPLES_AVCONV += $(FATE_MATROSKA-yes)
 FATE_SAMPLES_FFPROBE += $(FATE_MATROSKA_FFPROBE-yes)
 FATE_SAMPLES_FFMPEG_FFPROBE += $(FATE_MATROSKA_FFMPEG_FFPROBE-yes)
+FATE_FFMPEG += $(FATE_MATROSKA_FFMPEG-yes)
 
-fate-matroska: $(FATE_MATROSKA-yes) $(FATE_MATROSKA_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG_FFPROBE-yes)
+fate-matroska: $(FATE_MATROSKA-yes) $(FATE_MATROSKA_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG_FFPROBE-yes) $(FATE_MATROSKA_FFMPEG-yes)
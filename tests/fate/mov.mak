@@ -299,6 +299,16 @@ FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_F32LE, MP4 MOV, WAV_DEMUXER PAN_FILTER) \
 fate-mov-mp4-pcm-float: tests/data/asynth-44100-1.wav
 fate-mov-mp4-pcm-float: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-1.wav mp4 "-af aresample,pan=FR+FL+FR|c0=c0|c1=c0|c2=c0 -c:a pcm_f32le" "-map 0 -c copy -frames:a 0"
 
+# Packets referencing the input buffers must be identical to copied ones
+FATE_MOV_FFMPEG-$(call TRANSCODE, PCM_S16LE, MOV, WAV_DEMUXER) += fate-mov-zerocopy
+fate-mov-zerocopy: tests/data/asynth-44100-2.wav
+fate-mov-zerocopy: CMD = transcode wav $(TARGET_PATH)/tests/data/asynth-44100-2.wav mov "-c:a pcm_s16le" "-c copy" "" "" "-zerocopy_buffer_size 10000"
+
+# Video frames larger than the read-ahead are read by reference
+FATE_MOV_FFMPEG-$(call TRANSCODE, RAWVIDEO, MOV, RAWVIDEO_DEMUXER SCALE_FILTER) += fate-mov-zerocopy-video
+fate-mov-zerocopy-video: tests/data/vsynth1.yuv
+fate-mov-zerocopy-video: CMD = transcode rawvideo $(TARGET_PATH)/tests/data/vsynth1.yuv mov "-vf scale -sws_flags +accurate_rnd+bitexact -c:v rawvideo -pix_fmt uyvy422 -frames:v 10" "-c copy" "" "" "-zerocopy_buffer_size 500000" "-s 352x288 -pix_fmt yuv420p"
+
 fate-mov-pcm-remux: tests/data/asynth-44100-1.wav
 fate-mov-pcm-remux: CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-1.wav -map 0 -c copy -fflags +bitexact -f mp4
 fate-mov-pcm-remux: CMP = oneline
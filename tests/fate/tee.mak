@@ -0,0 +1,30 @@
+# Write the same streams to two slaves, synchronously and from slave threads.
+# Nothing is dropped with queues as large as the input, so the outputs of
+# all of them must match.
+FATE_TEE_MUXER = fate-tee-muxer fate-tee-muxer-async fate-tee-muxer-async-drop
+
+fate-tee-muxer:            TEE_OPTS =
+fate-tee-muxer-async:      TEE_OPTS = :async=1:queue_overflow=block
+fate-tee-muxer-async-drop: TEE_OPTS = :async=1:queue_overflow=drop:queue_size=64
+
+$(FATE_TEE_MUXER): tests/data/vsynth1.yuv tests/data/asynth-44100-2.wav
+$(FATE_TEE_MUXER): OUT = $(TARGET_PATH)/tests/data/fate/$(@:fate-%=%)
+$(FATE_TEE_MUXER): CMD = ffmpeg -f rawvideo -s 352x288 -pix_fmt yuv420p                       \
+    -i $(TARGET_PATH)/tests/data/vsynth1.yuv -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav \
+    -map 0:v -map 1:a -frames:v 20 -t 0.8 -c:v rawvideo -c:a pcm_s16le                       \
+    -flags +bitexact -fflags +bitexact -f tee                                                \
+    "[f=framecrc$(TEE_OPTS)]$(OUT).crc|[f=framemd5$(TEE_OPTS)]$(OUT).md5" &&               \
+    cat $(OUT).crc $(OUT).md5 && rm -f $(OUT).crc $(OUT).md5
+fate-tee-muxer-async fate-tee-muxer-async-drop: REF = $(SRC_PATH)/tests/ref/fate/tee-muxer
+
+FATE_TEE_MUXER-$(call ENCDEC2, RAWVIDEO, PCM_S16LE, RAWVIDEO, WAV_DEMUXER TEE_MUXER FRAMECRC_MUXER FRAMEMD5_MUXER) += $(FATE_TEE_MUXER)
+
+# Overflow a queue of two packets while the slave muxer is stalled, and check
+# which packets are dropped or waited for with either overflow policy.
+fate-tee-muxer-overflow: libavformat/tests/tee_muxer$(EXESUF)
+fate-tee-muxer-overflow: CMD = run libavformat/tests/tee_muxer$(EXESUF)
+TEE_MUXER_OVERFLOW-$(HAVE_THREADS) += fate-tee-muxer-overflow
+FATE_TEE_MUXER_OVERFLOW-$(CONFIG_TEE_MUXER) += $(TEE_MUXER_OVERFLOW-yes)
+
+FATE_FFMPEG += $(FATE_TEE_MUXER-yes) $(FATE_TEE_MUXER_OVERFLOW-yes)
+fate-tee-muxer-all: $(FATE_TEE_MUXER-yes) $(FATE_TEE_MUXER_OVERFLOW-yes)
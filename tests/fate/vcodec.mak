@@ -268,7 +268,9 @@ FATE_MPEG2 := mpeg2                                                     \
              mpeg2-ilace                                                \
              mpeg2-ivlc-qprd                                            \
              mpeg2-thread                                               \
-             mpeg2-thread-ivlc
+             mpeg2-thread-ivlc                                          \
+             mpeg2-bstrategy                                            \
+             mpeg2-bstrategy-thread
 
 FATE_VCODEC-$(call ENCDEC, MPEG2VIDEO, MPEG2VIDEO MPEGVIDEO) += $(FATE_MPEG2)
 
@@ -298,6 +300,13 @@ fate-vsynth%-mpeg2-thread:       ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
 fate-vsynth%-mpeg2-thread-ivlc:  ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -intra_vlc 1 -threads 2 -slices 2
 
+# the b_strategy 2 trials run on the slice threads, the output must be
+# the same as with one thread
+fate-vsynth%-mpeg2-bstrategy:    ENCOPTS = -qscale 10 -bf 2 -b_strategy 2 \
+                                           -threads 1 -slices 2
+fate-vsynth%-mpeg2-bstrategy-thread: ENCOPTS = -qscale 10 -bf 2 -b_strategy 2 \
+                                           -threads 2 -slices 2
+
 FATE_MPEG4_MP4 = mpeg4
 FATE_MPEG4_AVI = mpeg4-rc                                               \
                  mpeg4-adv                                              \
@@ -305,6 +314,8 @@ FATE_MPEG4_AVI = mpeg4-rc                                               \
                  mpeg4-adap                                             \
                  mpeg4-qpel                                             \
                  mpeg4-thread                                           \
+                 mpeg4-bstrategy                                        \
+                 mpeg4-bstrategy-thread                                 \
                  mpeg4-error                                            \
                  mpeg4-nr                                               \
                  mpeg4-nsse
@@ -350,6 +361,11 @@ fate-vsynth%-mpeg4-thread:       ENCOPTS = -b 500k -flags +mv4+aic         \
                                            -mbd bits -ps 200 -bf 2         \
                                            -threads 2 -slices 2
 
+fate-vsynth%-mpeg4-bstrategy:    ENCOPTS = -b 500k -flags +mv4 -bf 2 -b_strategy 2 \
+                                           -threads 1 -slices 2
+fate-vsynth%-mpeg4-bstrategy-thread: ENCOPTS = -b 500k -flags +mv4 -bf 2 -b_strategy 2 \
+                                           -threads 2 -slices 2
+
 FATE_VCODEC-$(call ENCDEC, MSMPEG4V3, AVI) += msmpeg4
 fate-vsynth%-msmpeg4:            ENCOPTS = -qscale 10
 
@@ -505,7 +521,6 @@ FATE_VCODEC += $(FATE_VCODEC-yes)
 FATE_VCODEC := $(if $(call ENCDEC, RAWVIDEO, RAWVIDEO),$(FATE_VCODEC))
 FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%)
 FATE_VSYNTH2 = $(FATE_VCODEC:%=fate-vsynth2-%)
-FATE_VSYNTH_LENA = $(FATE_VCODEC:%=fate-vsynth_lena-%)
 # Redundant tests because they just resize the input
 RESIZE_OFF   = dnxhd-720p dnxhd-720p-rd dnxhd-720p-10bit dnxhd-1080i \
                dv dv-411 dv-50 avui snow snow-hpel snow-ll vc2-420p \
@@ -520,6 +535,13 @@ VSYNTH3_OFF  = $(RESIZE_OFF) $(INC_PAR_OFF)
 FATE_VCODEC3 = $(filter-out $(VSYNTH3_OFF),$(FATE_VCODEC))
 FATE_VSYNTH3 = $(FATE_VCODEC3:%=fate-vsynth3-%)
 
+# No references generated yet for the lena sample
+LENA_OFF     = mpeg2-bstrategy mpeg2-bstrategy-thread \
+               mpeg4-bstrategy mpeg4-bstrategy-thread
+
+FATE_VCODEC_LENA = $(filter-out $(LENA_OFF),$(FATE_VCODEC))
+FATE_VSYNTH_LENA = $(FATE_VCODEC_LENA:%=fate-vsynth_lena-%)
+
 $(FATE_VSYNTH1): tests/data/vsynth1.yuv
 $(FATE_VSYNTH2): tests/data/vsynth2.yuv
 $(FATE_VSYNTH_LENA): tests/data/vsynth_lena.yuv